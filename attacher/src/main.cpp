@@ -9,11 +9,47 @@
 
 import std;
 
-int wmain(const int argc, wchar_t *argv[]) {
+namespace {
+    // 以 launch.exe 为基础生成全部启动器变体，打包时按配置直接选用，不再修改子系统和清单
+    std::expected<std::vector<std::filesystem::path>, std::wstring> buildVariants(
+        const std::filesystem::path &launchExe, const std::filesystem::path &workDir) {
+        std::vector<std::filesystem::path> paths;
+        for (unsigned int i = 0; i < LAUNCHER_VARIANT_COUNT; ++i) {
+            const auto variant = static_cast<LauncherVariant>(i);
+            const bool console = variant == LauncherVariant::Console || variant == LauncherVariant::ConsoleAdmin;
+            const bool requireAdmin = variant == LauncherVariant::GuiAdmin || variant == LauncherVariant::ConsoleAdmin;
+            auto path = workDir / std::format(L"launcher-{}.exe", i);
+
+            std::error_code ec;
+            std::filesystem::copy_file(launchExe, path, std::filesystem::copy_options::overwrite_existing, ec);
+            if (ec) {
+                return std::unexpected(std::format(L"无法复制启动器: {}", path.wstring()));
+            }
+
+            PEModifier modifier(path.wstring());
+            const auto level = requireAdmin ? ExecutionLevel::RequireAdmin : ExecutionLevel::AsInvoker;
+            const WORD subsystem = console ? IMAGE_SUBSYSTEM_WINDOWS_CUI : IMAGE_SUBSYSTEM_WINDOWS_GUI;
+            if (auto res = modifier.apply(nullptr, level, subsystem); !res) {
+                return std::unexpected(res.error());
+            }
+            paths.push_back(std::move(path));
+        }
+        return paths;
+    }
+} // namespace
+
+int wmain(int argc, wchar_t *argv[]) {
     SetConsoleOutputCP(CP_UTF8);
     _setmode(_fileno(stdout), _O_U8TEXT);
+
+    // --variants：附加全部启动器变体及索引
+    const bool variants = argc > 1 && std::wstring_view{argv[1]} == L"--variants";
+    if (variants) {
+        --argc;
+        ++argv;
+    }
     if (argc < 3) {
-        std::wcout << L"用法: Attacher.exe src.exe launch.exe out.exe(可选,不填则代表附加到src.exe源文件中)" << std::endl;
+        std::wcout << L"用法: Attacher.exe [--variants] src.exe launch.exe out.exe(可选,不填则代表附加到src.exe源文件中)" << std::endl;
         return 1;
     }
 
@@ -23,11 +59,34 @@ int wmain(const int argc, wchar_t *argv[]) {
     std::wcout << L"原文件: " << srcExe << std::endl;
     std::wcout << L"启动器: " << launchExe << std::endl;
     std::wcout << L"输出文件: " << outputExe << std::endl;
-    std::wcout << L"将启动器附加到原文件中..."<< std::endl;
 
-    if (const auto attachRes = Attach::attachExe(srcExe, launchExe, outputExe); !attachRes) {
-        std::wcout << attachRes.error() << std::endl;
-        return 1;
+    if (variants) {
+        std::wcout << L"生成启动器变体..." << std::endl;
+        const auto workDir = std::filesystem::temp_directory_path() /
+                             std::format(L"jarpackager-attacher-{}", GetCurrentProcessId());
+        std::error_code ec;
+        std::filesystem::create_directories(workDir, ec);
+        const auto variantsRes = buildVariants(launchExe, workDir);
+        std::expected<std::filesystem::path, std::wstring> attachRes = std::unexpected(std::wstring{});
+        if (variantsRes) {
+            std::wcout << L"将启动器变体附加到原文件中..." << std::endl;
+            attachRes = Attach::attachVariants(srcExe, variantsRes.value(), outputExe);
+        }
+        std::filesystem::remove_all(workDir, ec);
+        if (!variantsRes) {
+            std::wcout << variantsRes.error() << std::endl;
+            return 1;
+        }
+        if (!attachRes) {
+            std::wcout << attachRes.error() << std::endl;
+            return 1;
+        }
+    } else {
+        std::wcout << L"将启动器附加到原文件中..." << std::endl;
+        if (const auto attachRes = Attach::attachExe(srcExe, launchExe, outputExe); !attachRes) {
+            std::wcout << attachRes.error() << std::endl;
+            return 1;
+        }
     }
 
     std::wcout << L"附加完成, 输出到 [" << outputExe << L"]" << std::endl;
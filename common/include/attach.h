@@ -1,22 +1,86 @@
 ﻿#pragma once
 
+#include <cstdint>
 #include <expected>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
-namespace std::filesystem {
-    class path;
-}
+class MappedFile;
 inline constexpr unsigned int EXE_MAGIC = 0x65786546; // "EXEF"
 
+inline constexpr unsigned int EXE_INDEX_MAGIC = 0x65786549; // "EXEI"
+
+// 启动器模板变体，按位组合：bit0 控制台子系统，bit1 需要管理员权限；值即索引下标
+enum class LauncherVariant : unsigned int {
+    Gui = 0,
+    Console = 1,
+    GuiAdmin = 2,
+    ConsoleAdmin = 3,
+};
+
+inline constexpr unsigned int LAUNCHER_VARIANT_COUNT = 4;
+
+inline constexpr LauncherVariant launcherVariant(const bool console, const bool requireAdmin) {
+    return static_cast<LauncherVariant>((console ? 1u : 0u) | (requireAdmin ? 2u : 0u));
+}
+
 #pragma pack(push, 1)
 struct ExeFooter {
     unsigned int magic;
     unsigned long long exeOffset;
     unsigned long long exeSize;
 };
+
+/**
+ * 多模板索引，紧邻 ExeFooter 之前，其前为 count 个 ExeIndexEntry，下标即 LauncherVariant
+ * ExeFooter 仍指向第一个模板（Gui），只认识 ExeFooter 的读取方得到默认模板，
+ * 截断时按 ExeFooter.exeOffset 即可移除全部模板
+ */
+struct ExeIndexEntry {
+    unsigned long long exeOffset;
+    unsigned long long exeSize; // 0 表示没有该变体
+};
+
+struct ExeIndex {
+    unsigned int magic;
+    unsigned int count;
+};
 #pragma pack(pop)
 
+// 附加 EXE 的只读视图，内容直接映射自宿主文件；复制对象共享同一映射，最后一个对象析构时解除映射
+class AttachedExe {
+public:
+    AttachedExe() = default;
+
+    [[nodiscard]] std::span<const std::uint8_t> data() const {
+        return m_data;
+    }
+
+    [[nodiscard]] std::uint64_t size() const {
+        return m_data.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+        return m_data.empty();
+    }
+
+    // 来自多模板索引时为对应的变体，只有单个模板时为空
+    [[nodiscard]] std::optional<LauncherVariant> variant() const {
+        return m_variant;
+    }
+
+private:
+    friend class Attach;
+
+    std::shared_ptr<const MappedFile> m_file;
+    std::span<const std::uint8_t> m_data;
+    std::optional<LauncherVariant> m_variant;
+};
+
 class Attach {
 public:
     using Path = std::filesystem::path;
@@ -26,12 +90,27 @@ public:
 
     static std::expected<Path, std::wstring> attachExe(const Path &attachExePath, const Path &outputPath);
 
+    /**
+     * 附加多个启动器模板并写入 ExeIndex
+     * @param variantPaths 下标为 LauncherVariant，空路径表示没有该变体；第一个必须存在，作为默认模板
+     */
+    static std::expected<Path, std::wstring> attachVariants(const Path &srcEexPath,
+                                                            std::span<const Path> variantPaths,
+                                                            const Path &outputPath);
+
     // 将EXE附加到当前程序
     static std::expected<Path, std::wstring> attachExeToCurrent(const Path &attachExePath);
 
     // 从附加的EXE文件中读取附加内容
     static std::expected<ByteArray, std::wstring> readAttachedExe(const Path &attachedExePath, bool onlyVerify = false);
 
+    // 映射附加的EXE，不复制内容，可缓存后用于多次打包；没有索引或没有该变体时返回默认模板
+    static std::expected<AttachedExe, std::wstring> mapAttachedExe(const Path &attachedExePath,
+                                                                   LauncherVariant variant = LauncherVariant::Gui);
+
+    // 将附加的EXE从映射视图直接写入新文件
+    static std::expected<void, std::wstring> writeAttachedExe(const AttachedExe &exe, const Path &outputPath);
+
 private:
     // 获取当前程序路径
     static std::expected<Path, std::wstring> getCurrentExePath();
@@ -39,13 +118,24 @@ private:
     // 生成新文件名
     static Path generateNewFileName(const Path &originalPath);
 
-    // 读取文件内容
-    static std::expected<ByteArray, std::wstring> readFileContent(const Path &filePath);
+    // 原程序部分的长度：已有附加内容时为其偏移，否则为文件大小
+    static std::expected<std::uint64_t, std::wstring> findAttachmentOffset(const Path &exeFilePath);
+
+    // 输出路径与源文件相同时，截断旧的附加内容后直接追加，不复制原程序部分
+    static std::expected<void, std::wstring> attachInPlace(const Path &exeFilePath, std::span<const Path> attachExePaths);
+
+    /**
+     * 在文件末尾追加附加 EXE 和 ExeFooter，调用前文件长度须等于 exeOffset
+     * 多于一个路径时按变体依次追加，并在 ExeFooter 之前写入 ExeIndex
+     */
+    static std::expected<void, std::wstring> appendAttachment(const Path &exeFilePath,
+                                                              std::span<const Path> attachExePaths,
+                                                              std::uint64_t exeOffset);
 
-    // 移除已存在的附加内容
-    static void removeExistingAttachment(ByteArray &srcData);
+    // 原地附加前把将被截断的内容写入日志，日志内容与改名都写入磁盘后才返回
+    static std::expected<void, std::wstring> writeJournal(const Path &exeFilePath, std::uint64_t fileSize,
+                                                          std::uint64_t exeOffset);
 
-    // 写入附加文件
-    static std::expected<void, std::wstring> writeAttachedFile(const Path &newExeFilePath, const ByteArray &srcData,
-                                                               const ByteArray &attachData);
+    // 按日志恢复被中断的原地附加，没有日志时直接返回
+    static std::expected<void, std::wstring> recoverJournal(const Path &exeFilePath);
 };
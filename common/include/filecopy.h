@@ -0,0 +1,47 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+
+/**
+ * 文件区间复制
+ * 依次尝试：
+ * 1. 块克隆（Windows ReFS 的 FSCTL_DUPLICATE_EXTENTS_TO_FILE，Linux btrfs/xfs 的 FICLONERANGE）
+ * 2. 内核复制（Linux copy_file_range，失败时使用 sendfile）
+ * 3. 大缓冲区读写循环
+ * 块克隆要求源偏移按文件系统簇对齐，未对齐的尾部仍使用后两种方式复制
+ */
+namespace FileCopy {
+    using Path = std::filesystem::path;
+
+    // 读写循环使用的缓冲区大小
+    inline constexpr std::size_t BUFFER_SIZE = 4 * 1024 * 1024;
+
+    // 复制进度回调，在复制线程上调用，每个缓冲区调用一次
+    using Progress = std::function<void(std::uint64_t copied, std::uint64_t total)>;
+
+    enum class Method {
+        Clone, // 块克隆，数据块与源文件共享
+        Kernel, // 内核态复制，不经过用户态缓冲区
+        Buffered, // 用户态缓冲区读写
+    };
+
+    /**
+     * 创建 dst，将 src 中 [srcOffset, srcOffset + size) 的数据复制到 dst 起始处，随后写入 trailer
+     * 目标文件会预先分配 size + trailer.size() 的空间，失败时删除目标文件
+     * @param progress 主体数据的复制进度，块克隆部分一次报告
+     * @param first 从该复制方式开始尝试，跳过更靠前的方式，用于基准测试与排查文件系统问题
+     * @return 主体数据使用的复制方式
+     */
+    std::expected<Method, std::wstring> copyRange(const Path &src, std::uint64_t srcOffset, std::uint64_t size,
+                                                  const Path &dst, std::span<const std::uint8_t> trailer = {},
+                                                  const Progress &progress = {}, Method first = Method::Clone);
+
+    // 复制方式的名称，用于日志
+    const wchar_t *methodName(Method method);
+} // namespace FileCopy
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include <expected>
+#include <filesystem>
+#include <string>
+
+/**
+ * 跨进程文件锁
+ * Windows 使用 LockFileEx，其他平台使用 flock，进程退出时由系统自动释放
+ * 持有锁的进程可以删除锁文件：获得锁后检查路径是否仍指向被锁住的文件，已被删除时重新打开并加锁，
+ * 因此等待中的进程不会锁住已删除的文件而与锁住新文件的进程同时持有锁
+ */
+class FileLock {
+public:
+    using Path = std::filesystem::path;
+
+    // 阻塞直到获得 path 上的独占锁，文件不存在时创建
+    static std::expected<FileLock, std::wstring> acquire(const Path &path);
+
+    // 不等待，锁已被其他进程或同一进程中的其他 FileLock 持有时返回错误
+    static std::expected<FileLock, std::wstring> tryAcquire(const Path &path);
+
+    FileLock() = default;
+
+    ~FileLock();
+
+    // 禁止拷贝
+    FileLock(const FileLock &) = delete;
+
+    FileLock &operator=(const FileLock &) = delete;
+
+    // 允许移动
+    FileLock(FileLock &&other) noexcept;
+
+    FileLock &operator=(FileLock &&other) noexcept;
+
+private:
+    static std::expected<FileLock, std::wstring> lock(const Path &path, bool wait);
+
+    // 锁住的文件仍是 path 指向的文件，未被删除或替换
+    [[nodiscard]] bool current(const Path &path) const;
+
+    void release();
+
+#ifdef _WIN32
+    void *m_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
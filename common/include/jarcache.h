@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+/**
+ * 按内容寻址的 jar 解压缓存
+ * 缓存目录为 defaultRoot()，或用户指定解压目录下的 .jarcache 子目录，清理时只处理符合下列命名的文件
+ * 目录结构：
+ * <root>/<digest>.jar                 解压后的 jar，写入后不再修改
+ * <root>/<digest>.<pid>.tmp           解压中的临时文件
+ * <root>/<digest>.lock                解压锁，获取与清理 jar 时都需持有，随 jar 一起删除
+ * <root>/<digest>.*.jsa               启动器生成的类数据共享归档，随 jar 一起淘汰
+ * <root>/refs/<digest>/<owner>        引用文件，每个使用该 jar 的 exe 一个，修改时间即最近使用时间
+ * <root>/last-evict                   上次清理的时间标记
+ * 内容相同的 jar 只解压一次，由多个 exe 共享；缓存超出容量上限时按最近使用时间淘汰
+ */
+namespace JarCache {
+    using Path = std::filesystem::path;
+    using Digest = std::array<std::uint8_t, 32>;
+
+    // 缓存容量上限
+    inline constexpr std::uint64_t SIZE_LIMIT = 2ull * 1024 * 1024 * 1024;
+
+    // 缓存命中时两次清理之间的最短间隔
+    inline constexpr auto EVICT_INTERVAL = std::chrono::hours(24);
+
+    // 用户指定解压目录时缓存所在的子目录名
+    inline constexpr auto CACHE_DIR_NAME = L".jarcache";
+
+    // 写入缓存的回调，将 jar 写入给定的临时文件
+    using Fill = std::function<std::expected<bool, std::wstring>(const Path &tmpPath)>;
+
+    struct Entry {
+        Path jarPath;
+        bool hit = false; // 缓存命中，未重新解压
+    };
+
+    // 全零摘要表示打包文件未记录内容摘要
+    bool valid(const Digest &digest);
+
+    // 每个用户的默认缓存目录
+    Path defaultRoot();
+
+    // extractPath 为空时返回 defaultRoot()，否则返回 extractPath 下的 CACHE_DIR_NAME 子目录
+    Path root(const Path &extractPath);
+
+    /**
+     * 获取 digest 对应的缓存 jar，不存在、大小不符或尾部校验失败时调用 fill 写入临时文件，再重命名为正式文件
+     * 解压期间持有 <digest>.lock 上的文件锁，并发启动时只有一个进程解压
+     * 同时刷新 owner 对该 jar 的引用
+     * @param size 解压后 jar 的预期大小，见 JarLayout::extractedSize
+     * @param owner 使用该 jar 的可执行文件
+     */
+    std::expected<Entry, std::wstring> acquire(const Path &root, const Digest &digest, std::uint64_t size,
+                                               const Path &owner, const Fill &fill);
+
+    /**
+     * 清理缓存：删除引用的 exe 都已不存在的 jar，总大小超出 limit 时再按最近使用时间淘汰，
+     * 同时删除超过一小时的临时文件；只处理以 64 位十六进制摘要命名的文件
+     * 每个待删除的 jar 先以不等待的方式获取 <digest>.lock，锁被占用时跳过，随后删除 jar、引用、归档与锁文件
+     * 正在被使用（无法删除）的 jar 以及 keep 对应的 jar 不会被删除
+     */
+    void evict(const Path &root, const Digest &keep, std::uint64_t limit = SIZE_LIMIT);
+
+    // 距上次清理超过 EVICT_INTERVAL 时调用 evict，供缓存命中时使用，避免每次启动都遍历缓存目录
+    void evictIfDue(const Path &root, const Digest &keep, std::uint64_t limit = SIZE_LIMIT);
+} // namespace JarCache
@@ -4,7 +4,7 @@
 #include <unordered_map>
 
 namespace JarCommon {
-    enum class LaunchMode { JavaExe = 0, DirectJVM = 1 };
+    enum class LaunchMode { JavaExe = 0, DirectJVM = 1, Daemon = 2 };
 
     inline constexpr unsigned int JAR_MAGIC = 0x4A415246; // "JARF"
 
@@ -35,7 +35,7 @@ namespace JarCommon {
     extern const std::unordered_map<std::string, unsigned int> JAVA_VERSION_MAP;
 
     /**
-     * 完整结构
+     * 旧版（版本 1）完整结构，新打包文件使用 jarlayout.h 中的段目录，此结构仅用于兼容读取
      * exe
      * jar
      * image (png格式)
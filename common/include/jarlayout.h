@@ -0,0 +1,215 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jarcommon.h"
+
+/**
+ * 打包文件的段目录布局（版本 2）
+ * exe
+ * [对齐填充] jar
+ * image (png格式，可选)
+ * LaunchSettings 段 + 字符串表段          <- 元数据块起始
+ * SectionEntry[sectionCount]
+ * SectionFooter                          <- 文件末尾
+ *
+ * 元数据块（设置、字符串、段目录、SectionFooter）总是连续位于文件末尾，
+ * 读取 SectionFooter 后一次读取 metadataSize 字节即可获得全部启动信息。
+ * 旧版 JarCommon::JarFooter 布局会被转换为同样的 PackageInfo 结构。
+ */
+namespace JarLayout {
+    inline constexpr std::uint32_t SECTION_MAGIC = 0x3253464A; // "JFS2"
+    inline constexpr std::uint16_t LEGACY_VERSION = 1;
+    inline constexpr std::uint16_t SECTION_TABLE_VERSION = 2;
+
+    // jar 段的默认对齐，保证 jar 数据按页/簇对齐，便于映射和块克隆
+    inline constexpr std::uint32_t JAR_ALIGNMENT = 4096;
+
+    enum class SectionType : std::uint32_t {
+        Jar = 1,
+        SplashImage = 2,
+        Settings = 3, // LaunchSettings
+        Strings = 4, // 字符串表
+    };
+
+    inline constexpr std::size_t SECTION_TYPE_COUNT = 5;
+
+    // SectionEntry::flags
+    // jar 段的 ZIP 注释已在打包时写入 JarStamp，启动器可直接按区间复制
+    inline constexpr std::uint32_t SECTION_FLAG_JAR_STAMPED = 0x1;
+    // jar 的偏移已按整个文件重新计算，元数据块即 ZIP 注释，启动器直接把 exe 作为类路径
+    inline constexpr std::uint32_t SECTION_FLAG_RUN_FROM_EXE = 0x2;
+
+    enum class StringId : std::uint32_t {
+        MainClass = 0,
+        JvmArgs,
+        ProgramArgs,
+        JavaPath,
+        JarExtractPath,
+        SplashProgramName,
+        SplashProgramVersion,
+    };
+
+    inline constexpr std::size_t STRING_COUNT = 7;
+
+#pragma pack(push, 1)
+    struct SectionEntry {
+        std::uint32_t type;
+        std::uint32_t flags;
+        std::uint64_t offset; // 相对文件起始
+        std::uint64_t size;
+        std::uint32_t alignment;
+        std::uint32_t reserved;
+        std::uint64_t hash; // FNV-1a 64
+    };
+
+    struct SectionFooter {
+        std::uint64_t metadataSize; // 元数据块大小，含本结构
+        std::uint32_t sectionCount;
+        std::uint16_t entrySize;
+        std::uint16_t version;
+        std::uint32_t magic; // 位于文件最后 4 字节
+    };
+
+    // 启动设置段，size 字段用于新旧版本兼容：读取时只拷贝双方都认识的部分
+    struct LaunchSettings {
+        std::uint32_t size = sizeof(LaunchSettings);
+        std::uint32_t javaVersion = 0;
+        std::int32_t launchTime = 0; // 单位：ms
+        JarCommon::LaunchMode launchMode = JarCommon::LaunchMode::JavaExe;
+        std::uint64_t timestamp = 0;
+        std::uint8_t splashShowProgress = 0;
+        std::uint8_t splashShowProgressText = 0;
+        std::uint16_t reserved = 0;
+        // 文本位置百分比 (0-100)
+        float titlePosX = 50.0f;
+        float titlePosY = 33.0f;
+        float versionPosX = 50.0f;
+        float versionPosY = 45.0f;
+        // 进度文本位置百分比 (0-100)
+        float statusPosX = 5.0f;
+        float statusPosY = 85.0f;
+        // 字体大小百分比
+        float titleFontSizePercent = 15.0f;
+        float versionFontSizePercent = 9.0f;
+        float statusFontSizePercent = 5.5f;
+        // jar 内容（EOCD 之前的部分）的 SHA-256，作为解压缓存的键，全零表示不使用缓存
+        std::array<std::uint8_t, 32> jarDigest{};
+        // 单实例：已有实例运行时把命令行参数转发给它，不再启动新的 JVM
+        std::uint8_t singleInstance = 0;
+    };
+
+    // 解压后 jar 的 ZIP 注释内容，用于校验解压文件是否过期
+    struct JarStamp {
+        std::uint64_t timestamp;
+    };
+
+    // 字符串表：StringTableHeader + StringRef[count] + UTF-8 数据，偏移相对于段起始
+    struct StringTableHeader {
+        std::uint32_t count;
+    };
+
+    struct StringRef {
+        std::uint32_t offset;
+        std::uint32_t size;
+    };
+#pragma pack(pop)
+
+    // 定位元数据块所需的尾部探测大小
+    inline constexpr std::size_t PROBE_SIZE = std::max(sizeof(SectionFooter), sizeof(JarCommon::JarFooter));
+
+    struct Range {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+    struct PackageInfo {
+        std::uint16_t version = 0;
+        std::uint64_t metadataOffset = 0; // 元数据块在文件中的起始位置
+        std::array<SectionEntry, SECTION_TYPE_COUNT> sections{}; // 按 SectionType 索引
+        LaunchSettings settings{};
+        std::array<Range, STRING_COUNT> strings{}; // 绝对偏移，均位于元数据块内
+
+        [[nodiscard]] const SectionEntry *find(SectionType type) const {
+            const auto index = static_cast<std::size_t>(type);
+            if (index >= sections.size() || sections[index].type != static_cast<std::uint32_t>(type)) {
+                return nullptr;
+            }
+            return &sections[index];
+        }
+
+        [[nodiscard]] Range range(const SectionType type) const {
+            const auto *entry = find(type);
+            return entry ? Range{entry->offset, entry->size} : Range{};
+        }
+    };
+
+    inline constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+    // FNV-1a 64 位哈希，可传入上一次的结果分段计算
+    std::uint64_t hash(std::span<const std::uint8_t> data, std::uint64_t state = FNV_OFFSET_BASIS);
+
+    /**
+     * 根据文件尾部数据计算元数据块大小
+     * @param tail 文件最后至少 PROBE_SIZE 字节（文件较小时为整个文件）
+     * @param fileSize 文件总大小
+     */
+    std::expected<std::uint64_t, std::wstring> metadataSize(std::span<const std::uint8_t> tail, std::uint64_t fileSize);
+
+    /**
+     * 解析元数据块
+     * @param tail 文件最后至少 metadataSize 字节
+     * @param fileSize 文件总大小
+     */
+    std::expected<PackageInfo, std::wstring> parse(std::span<const std::uint8_t> tail, std::uint64_t fileSize);
+
+    // 从解析时使用的尾部数据中取出字符串（UTF-8）
+    std::string_view stringView(const PackageInfo &info, std::span<const std::uint8_t> tail, std::uint64_t fileSize,
+                                StringId id);
+
+    /**
+     * 解压后 jar 的预期大小
+     * 打包时已写入时间戳的 jar 原样复制，为段大小；旧版打包文件去掉原有注释后追加 JarStamp，
+     * 为 EOCD 结束位置加上 JarStamp 的大小，只在 jar 尾部定位 EOCD
+     * @param jar 打包文件中的 jar 段
+     */
+    std::expected<std::uint64_t, std::wstring> extractedSize(std::span<const std::uint8_t> jar, bool stamped);
+
+    /**
+     * 只读取文件尾部，校验解压后的 jar 是否完整并取出 ZIP 注释中的 JarStamp
+     * 要求文件大小等于 expectedSize、EOCD 注释正好是 JarStamp，且中央目录完整位于 EOCD 之前，耗时与 jar 大小无关
+     * @param expectedSize extractedSize 给出的预期大小
+     */
+    std::expected<JarStamp, std::wstring> readStamp(const std::filesystem::path &jarPath, std::uint64_t expectedSize);
+
+    // 编码字符串表段
+    std::vector<std::uint8_t> encodeStrings(std::span<const std::string_view> strings);
+
+    // 段目录写入器，按写入顺序收集段信息并生成 SectionEntry[] + SectionFooter
+    class SectionTableWriter {
+    public:
+        void add(SectionType type, std::uint64_t offset, std::uint64_t size, std::uint32_t alignment,
+                 std::uint64_t hash, std::uint32_t flags = 0);
+
+        // 更新已添加的 type 段的哈希，供段内容依赖段目录大小时先登记段、定下内容后再补上哈希
+        void setHash(SectionType type, std::uint64_t hash);
+
+        // finish 生成的段目录与 SectionFooter 的字节数
+        [[nodiscard]] std::size_t tableSize() const;
+
+        // tableOffset 为段目录写入位置，metadataOffset 为元数据块起始位置
+        [[nodiscard]] std::vector<std::uint8_t> finish(std::uint64_t metadataOffset, std::uint64_t tableOffset) const;
+
+    private:
+        std::vector<SectionEntry> m_entries;
+    };
+} // namespace JarLayout
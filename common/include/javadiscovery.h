@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Java 运行时查找
+ * 扫描结果按 (类型, javaPath, javaVersion) 记录在每个用户的缓存文件中，
+ * 下次启动时只需对缓存的文件做一次 stat，大小和修改时间不变即直接使用，否则重新扫描
+ * Windows 扫描 JAVA_HOME、PATH 与常见安装目录，其他平台扫描 JAVA_HOME、PATH 与 /usr/lib/jvm
+ * 候选运行时的版本与架构读取自 JDK 根目录下的 release 文件，不满足打包时要求的版本或架构不符的候选会被排除
+ */
+namespace JavaDiscovery {
+    using Path = std::filesystem::path;
+
+    enum class Binary {
+        Java, // java.exe / java
+        Jvm, // jvm.dll / libjvm.so
+    };
+
+    // 候选 Java 运行时
+    struct Runtime {
+        Path home; // JDK 根目录
+        Path binary; // java.exe 或 jvm.dll 的完整路径
+        std::wstring version; // release 文件中的 JAVA_VERSION，未知时为空
+        std::uint32_t feature = 0; // 主版本号，如 8、17、21，未知时为 0
+        std::wstring implementor; // release 文件中的 IMPLEMENTOR
+        std::wstring arch; // release 文件中的 OS_ARCH，规范化为 amd64/x86/aarch64
+    };
+
+    // 缓存文件的默认位置
+    Path defaultCacheFile();
+
+    // 平台的常见安装目录，Windows 为 Program Files 下的各发行版目录，其他平台为 /usr/lib/jvm
+    std::span<const Path> defaultSearchRoots();
+
+    // JNI 版本号（如 JNI_VERSION_1_8、JNI_VERSION_21）对应的 Java 主版本号
+    std::uint32_t featureVersion(std::uint32_t jniVersion);
+
+    // 读取 JDK 根目录下的 release 文件，文件不存在时只填写 home
+    Runtime readRelease(const Path &home);
+
+    /**
+     * 扫描全部候选运行时，各安装目录并行扫描
+     * 结果按优先级排序：架构匹配、版本已知且满足要求、JAVA_HOME > PATH > 安装目录、版本较新
+     * @param javaVersion 打包时指定的 JNI 版本号，为 0 时不限制版本
+     * @param searchRoots 安装目录，其下每个子目录视为一个 JDK 根目录
+     */
+    std::vector<Runtime> index(Binary binary, std::uint32_t javaVersion,
+                               std::span<const Path> searchRoots = defaultSearchRoots());
+
+    // 不使用缓存，完整扫描一次并返回排序最靠前的候选
+    std::expected<Path, std::wstring> scan(Binary binary, std::uint32_t javaVersion = 0,
+                                           std::span<const Path> searchRoots = defaultSearchRoots());
+
+    /**
+     * 查找 Java 运行时，优先使用缓存，缓存失效时回退到完整扫描并更新缓存
+     * @param javaPath 打包时指定的 Java 路径，作为缓存键的一部分
+     * @param javaVersion 打包时指定的 Java 版本，作为缓存键的一部分
+     */
+    std::expected<Path, std::wstring> find(Binary binary, std::wstring_view javaPath, std::uint32_t javaVersion,
+                                           const Path &cacheFile = defaultCacheFile(),
+                                           std::span<const Path> searchRoots = defaultSearchRoots());
+} // namespace JavaDiscovery
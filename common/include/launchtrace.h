@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/**
+ * 启动过程追踪
+ * 设置环境变量 JARPACKAGER_TRACE 后启用：值为空或 1 时输出到临时目录下的 jarpackager-<pid>.trace.json，
+ * 否则作为输出文件路径。输出为 Chrome trace 格式，可在 chrome://tracing 或 Perfetto 中打开
+ * 事件写入固定容量的内存缓冲区，只用一次原子自增分配槽位，不加锁；进程退出时写出文件
+ * 未启用时 Span 只有一次原子读取
+ */
+namespace LaunchTrace {
+    using Clock = std::chrono::steady_clock;
+
+    inline constexpr auto ENV_VAR = "JARPACKAGER_TRACE";
+
+    // 缓冲区容量，超出的事件被丢弃
+    inline constexpr std::size_t CAPACITY = 4096;
+
+    // 按环境变量启用追踪，并在进程退出时写出文件
+    void init();
+
+    // 启用追踪，output 为空时只记录不写出
+    void enable(const std::filesystem::path &output = {});
+
+    bool enabled();
+
+    // 记录一个区间，name 必须是静态字符串
+    void record(const char *name, Clock::time_point start, Clock::time_point end);
+
+    // record 的两个步骤：分配槽位，缓冲区已满时返回 CAPACITY
+    std::uint32_t reserve();
+
+    // 写入 reserve 分配的槽位，name 最后写入，写入前 json 跳过该槽位
+    void commit(std::uint32_t slot, const char *name, Clock::time_point start, Clock::time_point end);
+
+    // 停用追踪并清空缓冲区，调用时不能有其他线程在记录
+    void reset();
+
+    // 已记录事件的 Chrome trace JSON
+    std::string json();
+
+    // 写出到 enable 时指定的文件
+    bool flush();
+
+    // 作用域内的区间
+    class Span {
+    public:
+        explicit Span(const char *name) : m_name(enabled() ? name : nullptr) {
+            if (m_name) {
+                m_start = Clock::now();
+            }
+        }
+
+        ~Span() {
+            if (m_name) {
+                record(m_name, m_start, Clock::now());
+            }
+        }
+
+        Span(const Span &) = delete;
+
+        Span &operator=(const Span &) = delete;
+
+    private:
+        const char *m_name;
+        Clock::time_point m_start{};
+    };
+} // namespace LaunchTrace
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+
+/**
+ * 只读文件映射
+ * Windows 使用 CreateFileMapping/MapViewOfFile，其他平台使用 mmap
+ * 映射建立后文件句柄即关闭，视图在对象析构前一直有效
+ */
+class MappedFile {
+public:
+    using Path = std::filesystem::path;
+
+    static std::expected<MappedFile, std::wstring> open(const Path &path);
+
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    // 禁止拷贝
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // 允许移动
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    [[nodiscard]] std::span<const std::uint8_t> data() const {
+        return {m_data, m_size};
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return m_size;
+    }
+
+    // 取出 [offset, offset + size) 范围的视图，越界时返回空视图
+    [[nodiscard]] std::span<const std::uint8_t> view(std::uint64_t offset, std::uint64_t size) const;
+
+private:
+    void close();
+
+    const std::uint8_t *m_data = nullptr;
+    std::size_t m_size = 0;
+};
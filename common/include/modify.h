@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <expected>
+#include <optional>
 #include <string>
 #include <vector>
 #include <windows.h>
@@ -35,5 +36,9 @@ public:
 
     std::expected<bool, std::wstring> setIcon(const wchar_t *icoFile) const;
 
+    // 一次读写完成图标、执行级别和子系统的修改，参数为空的项保持不变，附加数据原样保留
+    std::expected<bool, std::wstring> apply(const wchar_t *icoFile, std::optional<ExecutionLevel> level,
+                                            std::optional<WORD> subsystem) const;
+
     void showPEInfo();
 };
@@ -0,0 +1,141 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * PE 资源编辑
+ * 在内存中解析 PE 头和三级资源树（类型/名称/语言），修改后一次性重建 .rsrc 节，不依赖 Windows API
+ * 重建时同步修正节表、SizeOfImage、SizeOfInitializedData、资源目录和校验和；
+ * .rsrc 之后只允许有基址重定位节，该节整体后移并修正重定位目录，其他位置的节保持不变
+ * 附加数据（最后一个节之后的内容）按原样复制到新文件末尾，证书目录的文件偏移随之修正
+ * 只支持小端序的 PE32/PE32+ 文件
+ */
+namespace PeResource {
+    using Bytes = std::vector<std::uint8_t>;
+
+    // 常用资源类型，不使用 RT_ 前缀以免与 windows.h 中的宏冲突
+    inline constexpr std::uint16_t TYPE_ICON = 3;
+    inline constexpr std::uint16_t TYPE_GROUP_ICON = 14;
+    inline constexpr std::uint16_t TYPE_MANIFEST = 24;
+
+    // 子系统
+    inline constexpr std::uint16_t SUBSYSTEM_WINDOWS_GUI = 2;
+    inline constexpr std::uint16_t SUBSYSTEM_WINDOWS_CUI = 3;
+
+    // 资源标识，name 为空时使用整数 id
+    struct Id {
+        std::uint16_t id = 0;
+        std::u16string name;
+
+        Id() = default;
+
+        Id(const std::uint16_t id_) : id(id_) {
+        }
+
+        explicit Id(std::u16string name_) : name(std::move(name_)) {
+        }
+
+        [[nodiscard]] bool isName() const {
+            return !name.empty();
+        }
+
+        bool operator==(const Id &other) const = default;
+
+        // 名称排在整数 id 之前，与资源目录中的顺序一致
+        bool operator<(const Id &other) const;
+    };
+
+    struct Resource {
+        Id type;
+        Id name;
+        std::uint16_t language = 0;
+        std::uint32_t codePage = 0;
+        Bytes data;
+    };
+
+    class Image {
+    public:
+        /**
+         * 解析 PE 文件
+         * @param file 完整文件内容，包括附加数据
+         */
+        static std::expected<Image, std::wstring> parse(Bytes file);
+
+        [[nodiscard]] std::uint16_t subsystem() const;
+
+        void setSubsystem(std::uint16_t subsystem);
+
+        [[nodiscard]] const std::vector<Resource> &resources() const {
+            return m_resources;
+        }
+
+        // 查找资源，language 为空时返回任一语言
+        [[nodiscard]] const Resource *find(const Id &type, const Id &name,
+                                           std::optional<std::uint16_t> language = std::nullopt) const;
+
+        // 替换 type/name 下的所有语言，不存在时以 language 新增
+        void set(const Id &type, const Id &name, Bytes data, std::uint16_t language = 0);
+
+        // 删除 type/name 下的所有语言
+        void remove(const Id &type, const Id &name);
+
+        // 清单资源（RT_MANIFEST，ID 1），没有时返回空
+        [[nodiscard]] std::optional<std::string_view> manifest() const;
+
+        void setManifest(std::string_view manifest);
+
+        /**
+         * 用 ICO 文件内容替换程序图标
+         * 替换第一个图标组及其引用的图标，没有图标组时新增 ID 为 1 的图标组
+         */
+        std::expected<void, std::wstring> setIcon(std::span<const std::uint8_t> ico);
+
+        // 附加数据在原文件中的偏移，没有附加数据时等于文件大小
+        [[nodiscard]] std::uint64_t overlayOffset() const {
+            return m_overlayOffset;
+        }
+
+        // 重建资源节并返回新的完整文件
+        [[nodiscard]] std::expected<Bytes, std::wstring> build() const;
+
+    private:
+        struct Section {
+            std::size_t headerOffset; // 节头在文件中的偏移
+            std::uint32_t virtualSize;
+            std::uint32_t virtualAddress;
+            std::uint32_t rawSize;
+            std::uint32_t rawOffset;
+            std::uint32_t characteristics;
+        };
+
+        [[nodiscard]] std::optional<std::size_t> sectionOf(std::uint32_t rva) const;
+
+        [[nodiscard]] std::optional<std::uint32_t> rvaToOffset(std::uint32_t rva) const;
+
+        std::expected<void, std::wstring> parseResources();
+
+        [[nodiscard]] Bytes serializeResources(std::uint32_t baseRva) const;
+
+        Bytes m_file;
+        std::size_t m_optionalHeaderOffset = 0;
+        std::size_t m_dataDirectoryOffset = 0;
+        std::uint32_t m_dataDirectoryCount = 0;
+        std::uint32_t m_sectionAlignment = 0;
+        std::uint32_t m_fileAlignment = 0;
+        std::uint16_t m_subsystem = 0;
+        std::vector<Section> m_sections;
+        std::optional<std::size_t> m_resourceSection;
+        std::uint64_t m_overlayOffset = 0;
+        std::vector<Resource> m_resources;
+    };
+
+    // PE 校验和，与 MapFileAndCheckSum 的算法一致，checksumOffset 处的 4 字节不参与计算
+    std::uint32_t checksum(std::span<const std::uint8_t> file, std::size_t checksumOffset);
+} // namespace PeResource
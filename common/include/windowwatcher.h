@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+
+/**
+ * 等待子进程显示第一个顶层窗口
+ * 等待逻辑只依赖 Provider 接口，平台相关的进程与窗口查询由 Provider 实现，可替换为假实现单独验证
+ * Windows 实现：先 WaitForInputIdle，再用 EnumWindows 检查进程的可见顶层窗口，
+ * 两次检查之间通过 WinEvent 钩子（EVENT_OBJECT_SHOW）在窗口出现时立即唤醒
+ */
+namespace WindowWatcher {
+    class Provider {
+    public:
+        virtual ~Provider() = default;
+
+        // 单调时钟，单位：毫秒
+        virtual std::uint64_t now() = 0;
+
+        // 等待进程完成初始化并开始处理输入，最多 timeoutMs
+        virtual void waitForInputIdle(std::uint32_t timeoutMs) = 0;
+
+        // 进程是否已有可见的顶层窗口
+        virtual bool hasVisibleWindow() = 0;
+
+        // 进程是否已退出
+        virtual bool exited() = 0;
+
+        // 等待窗口显示、进程退出或 timeoutMs 超时
+        virtual void waitForChange(std::uint32_t timeoutMs) = 0;
+    };
+
+    enum class Result {
+        WindowShown,
+        ProcessExited,
+        TimedOut,
+        Stopped, // 通过 stop_token 取消
+    };
+
+    // 没有窗口事件时两次检查的最长间隔
+    inline constexpr std::uint32_t POLL_INTERVAL_MS = 100;
+
+    // 默认的最长等待时间
+    inline constexpr std::uint32_t DEFAULT_TIMEOUT_MS = 60 * 1000;
+
+    Result wait(Provider &provider, std::uint32_t timeoutMs = DEFAULT_TIMEOUT_MS, std::stop_token stop = {});
+
+#ifdef _WIN32
+    // 观察 process（HANDLE）的窗口，句柄由调用方持有，窗口事件在调用 wait 的线程上接收
+    std::unique_ptr<Provider> processProvider(void *process);
+#endif
+} // namespace WindowWatcher
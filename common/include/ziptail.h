@@ -0,0 +1,122 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+
+/**
+ * ZIP 尾部解析
+ * 在 ZIP 尾部数据中定位 End of Central Directory 记录，并解析 Zip64 定位器
+ * 签名搜索使用 SSE2/AVX2 向量化实现，不支持时回退到标量实现
+ */
+namespace ZipTail {
+    inline constexpr std::uint32_t EOCD_SIGNATURE = 0x06054b50; // "PK\5\6"
+    inline constexpr std::uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50; // "PK\6\7"
+    inline constexpr std::uint32_t ZIP64_EOCD_SIGNATURE = 0x06064b50; // "PK\6\6"
+    inline constexpr std::uint32_t CENTRAL_DIR_SIGNATURE = 0x02014b50; // "PK\1\2"
+
+    inline constexpr std::size_t MAX_COMMENT_SIZE = 65535;
+
+#pragma pack(push, 1)
+    // 中央目录文件头（不含可变长度的文件名、扩展字段和注释）
+    struct CentralDirHeader {
+        std::uint32_t signature; // 0x02014b50
+        std::uint16_t versionMadeBy;
+        std::uint16_t versionNeeded;
+        std::uint16_t flags;
+        std::uint16_t compression;
+        std::uint16_t modTime;
+        std::uint16_t modDate;
+        std::uint32_t crc32;
+        std::uint32_t compressedSize;
+        std::uint32_t uncompressedSize;
+        std::uint16_t fileNameLength;
+        std::uint16_t extraFieldLength;
+        std::uint16_t fileCommentLength;
+        std::uint16_t diskNumberStart;
+        std::uint16_t internalAttributes;
+        std::uint32_t externalAttributes;
+        std::uint32_t localHeaderOffset;
+    };
+
+    // ZIP End of Central Directory 记录结构
+    struct EndOfCentralDirectory {
+        std::uint32_t signature; // 0x06054b50
+        std::uint16_t diskNumber;
+        std::uint16_t centralDirDiskNumber;
+        std::uint16_t recordsOnDisk;
+        std::uint16_t totalRecords;
+        std::uint32_t centralDirSize;
+        std::uint32_t centralDirOffset;
+        std::uint16_t commentLength;
+    };
+
+    // Zip64 End of Central Directory 定位器，紧邻 EOCD 之前
+    struct Zip64Locator {
+        std::uint32_t signature; // 0x07064b50
+        std::uint32_t zip64EocdDiskNumber;
+        std::uint64_t zip64EocdOffset;
+        std::uint32_t totalDisks;
+    };
+
+    // Zip64 End of Central Directory 记录（不含可变长度的扩展数据）
+    struct Zip64EndOfCentralDirectory {
+        std::uint32_t signature; // 0x06064b50
+        std::uint64_t recordSize;
+        std::uint16_t versionMadeBy;
+        std::uint16_t versionNeeded;
+        std::uint32_t diskNumber;
+        std::uint32_t centralDirDiskNumber;
+        std::uint64_t recordsOnDisk;
+        std::uint64_t totalRecords;
+        std::uint64_t centralDirSize;
+        std::uint64_t centralDirOffset;
+    };
+#pragma pack(pop)
+
+    inline constexpr std::size_t EOCD_SIZE = sizeof(EndOfCentralDirectory);
+    // EOCD 可能出现的最大尾部范围（最大注释长度 + EOCD 大小）
+    inline constexpr std::size_t MAX_SEARCH_SIZE = MAX_COMMENT_SIZE + EOCD_SIZE;
+
+    // 解析后的 ZIP 尾部信息，偏移均相对于 ZIP 起始位置
+    struct EndRecord {
+        std::uint64_t eocdOffset;
+        std::uint64_t totalRecords;
+        std::uint64_t centralDirSize;
+        std::uint64_t centralDirOffset;
+        std::uint16_t commentLength;
+        bool zip64;
+        std::uint64_t zip64EocdOffset; // 仅 zip64 为 true 时有效
+        EndOfCentralDirectory eocd; // 原始 EOCD 记录，便于修改后写回
+        std::span<const std::uint8_t> comment; // 指向输入数据中的注释
+    };
+
+    // 在 data 中查找最后一个位于 end 之前的 4 字节签名，未找到返回 npos
+    std::size_t findLastSignature(std::span<const std::uint8_t> data, std::uint32_t signature,
+                                  std::size_t end = static_cast<std::size_t>(-1));
+
+    /**
+     * 从 ZIP 尾部数据中解析 EOCD
+     * @param tail ZIP 末尾的数据，通常为最后 MAX_SEARCH_SIZE 字节，也可以是完整文件或映射视图
+     * @param tailOffset tail 第一个字节在 ZIP 中的偏移
+     */
+    std::expected<EndRecord, std::wstring> locate(std::span<const std::uint8_t> tail, std::uint64_t tailOffset = 0);
+
+    /**
+     * 将中央目录中的本地文件头偏移和 EOCD 中的中央目录偏移整体增加 prefixSize，
+     * 使 ZIP 拼接在 prefixSize 字节的其他数据之后仍是偏移正确的标准 ZIP，不支持 Zip64
+     * @param zip 完整的 ZIP 数据，原地修改
+     */
+    std::expected<bool, std::wstring> rebase(std::span<std::uint8_t> zip, std::uint64_t prefixSize);
+
+    /**
+     * 修改 EOCD 中的注释长度，注释内容由调用方随后写在 EOCD 之后
+     * @param zip 至少包含完整 EOCD 记录的 ZIP 数据，原地修改
+     * @param eocdOffset EOCD 在 zip 中的偏移
+     * @param commentSize 新的注释长度，超过 MAX_COMMENT_SIZE 时返回错误
+     */
+    std::expected<bool, std::wstring> setCommentLength(std::span<std::uint8_t> zip, std::uint64_t eocdOffset,
+                                                       std::size_t commentSize);
+} // namespace ZipTail
@@ -10,73 +10,146 @@ Description:
 
 **************************************************************************/
 #include "attach.h"
+#include "filecopy.h"
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
 #include <shlwapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 import std;
 
+namespace {
+    constexpr unsigned int JOURNAL_MAGIC = 0x6578654A; // "EXEJ"
+
+#pragma pack(push, 1)
+    // 原地附加日志的头部，其后是被截断的旧附加内容
+    struct ExeJournal {
+        unsigned int magic;
+        unsigned long long fileSize; // 附加前的文件大小
+        unsigned long long exeOffset; // 截断位置
+    };
+#pragma pack(pop)
+
+    constexpr std::uint64_t CHUNK_SIZE = 1024 * 1024;
+
+    Attach::Path journalPath(const Attach::Path &exeFilePath) {
+        auto path = exeFilePath;
+        path += L".journal";
+        return path;
+    }
+
+    std::wstring errorMessage(const std::error_code &ec) {
+        const auto msg = ec.message();
+        return std::wstring(msg.begin(), msg.end());
+    }
+
+    // 把文件内容写入磁盘，断电后仍然存在
+    bool syncFile(const Attach::Path &path) {
+#ifdef _WIN32
+        const HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        const bool flushed = FlushFileBuffers(file);
+        CloseHandle(file);
+        return flushed;
+#else
+        const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        const bool flushed = fsync(fd) == 0;
+        ::close(fd);
+        return flushed;
+#endif
+    }
+
+    // 重命名并把目录项的修改写入磁盘：Windows 使用 MOVEFILE_WRITE_THROUGH，POSIX 对所在目录调用 fsync
+    bool durableRename(const Attach::Path &from, const Attach::Path &to) {
+#ifdef _WIN32
+        return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+        if (std::rename(from.c_str(), to.c_str()) != 0) {
+            return false;
+        }
+        const auto dir = to.has_parent_path() ? to.parent_path() : Attach::Path(".");
+        const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        const bool flushed = fsync(fd) == 0;
+        ::close(fd);
+        return flushed;
+#endif
+    }
+
+    // 从 in 的当前位置分块复制 size 字节到 out
+    bool copyStream(std::istream &in, std::ostream &out, std::uint64_t size) {
+        std::vector<char> buffer(static_cast<std::size_t>(std::min(size, CHUNK_SIZE)));
+        while (size > 0) {
+            const auto chunk = static_cast<std::streamsize>(std::min<std::uint64_t>(size, buffer.size()));
+            if (!in.read(buffer.data(), chunk) || !out.write(buffer.data(), chunk)) {
+                return false;
+            }
+            size -= static_cast<std::uint64_t>(chunk);
+        }
+        return true;
+    }
+} // namespace
+
 std::expected<Attach::Path, std::wstring> Attach::attachExe(const Path &srcEexPath, const Path &attachExePath,
                                                             const Path &outputPath) {
-    if (attachExePath.empty() || srcEexPath.empty()) {
+    return attachVariants(srcEexPath, std::span{&attachExePath, 1}, outputPath);
+}
+
+std::expected<Attach::Path, std::wstring> Attach::attachVariants(const Path &srcEexPath,
+                                                                 const std::span<const Path> variantPaths,
+                                                                 const Path &outputPath) {
+    if (variantPaths.empty() || variantPaths.front().empty() || srcEexPath.empty()) {
         return std::unexpected(L"附加EXE路径为空或源EXE路径为空");
     }
-    auto exeFilePath = srcEexPath;
+    if (variantPaths.size() > LAUNCHER_VARIANT_COUNT) {
+        return std::unexpected(L"启动器模板数量超过变体数量");
+    }
 
     // 确定输出路径
-    Path newExeFilePath;
-    bool needCleanupBackup = false;
+    const Path newExeFilePath = outputPath.empty() ? generateNewFileName(srcEexPath) : outputPath;
 
-    if (outputPath.empty()) {
-        // 使用默认命名方案
-        newExeFilePath = generateNewFileName(exeFilePath);
-    } else {
-        newExeFilePath = outputPath;
-        // 如果输出路径与源exe路径一致，需要先备份源文件
-        std::error_code ec;
-        if (std::filesystem::equivalent(outputPath, exeFilePath, ec) && !ec) {
-            auto tempPath = exeFilePath;
-            tempPath += L".backup";
-
-            std::filesystem::copy_file(exeFilePath, tempPath,
-                                       std::filesystem::copy_options::overwrite_existing, ec);
-            if (ec) {
-                auto msg = ec.message();
-                return std::unexpected(std::format(L"无法创建源文件备份: {}",
-                                                   std::wstring(msg.begin(), msg.end())));
-            }
-
-            // 更新源文件路径为备份路径
-            exeFilePath = tempPath;
-            needCleanupBackup = true;
+    // 输出路径与源exe路径一致时原地修改
+    std::error_code ec;
+    if (std::filesystem::equivalent(newExeFilePath, srcEexPath, ec) && !ec) {
+        if (auto result = attachInPlace(srcEexPath, variantPaths); !result) {
+            return std::unexpected(result.error());
         }
+        return newExeFilePath;
     }
 
-    // 读取当前程序内容
-    auto srcDataResult = readFileContent(exeFilePath);
-    if (!srcDataResult) {
-        return std::unexpected(std::format(L"无法读取当前程序文件: {}", srcDataResult.error()));
+    // 源文件可能残留上次中断的原地附加
+    if (auto result = recoverJournal(srcEexPath); !result) {
+        return std::unexpected(result.error());
     }
-    auto srcData = std::move(srcDataResult.value());
 
-    // 检查原程序是否已经附加
-    removeExistingAttachment(srcData);
-
-    // 读取新的附加 EXE
-    auto attachDataResult = readFileContent(attachExePath);
-    if (!attachDataResult) {
-        return std::unexpected(std::format(L"无法读取附加 EXE 文件: {}", attachDataResult.error()));
+    const auto exeOffset = findAttachmentOffset(srcEexPath);
+    if (!exeOffset) {
+        return std::unexpected(std::format(L"无法读取当前程序文件: {}", exeOffset.error()));
     }
-    const auto &attachData = attachDataResult.value();
 
-    // 写入新文件
-    auto writeResult = writeAttachedFile(newExeFilePath, srcData, attachData);
-    if (!writeResult) {
-        return std::unexpected(writeResult.error());
+    // 只复制原程序部分，文件系统支持时使用块克隆
+    if (auto result = FileCopy::copyRange(srcEexPath, 0, exeOffset.value(), newExeFilePath); !result) {
+        return std::unexpected(result.error());
     }
 
-    // 如果使用了备份文件，清理备份
-    if (needCleanupBackup) {
-        std::error_code ec;
-        std::filesystem::remove(exeFilePath, ec);
+    if (auto result = appendAttachment(newExeFilePath, variantPaths, exeOffset.value()); !result) {
+        std::filesystem::remove(newExeFilePath, ec);
+        return std::unexpected(result.error());
     }
 
     return newExeFilePath;
@@ -140,6 +213,80 @@ std::expected<Attach::ByteArray, std::wstring> Attach::readAttachedExe(const Pat
     return exeData;
 }
 
+std::expected<AttachedExe, std::wstring> Attach::mapAttachedExe(const Path &attachedExePath,
+                                                                const LauncherVariant variant) {
+    auto mapRes = MappedFile::open(attachedExePath);
+    if (!mapRes) {
+        return std::unexpected(mapRes.error());
+    }
+    auto file = std::make_shared<const MappedFile>(std::move(mapRes.value()));
+    if (file->size() < sizeof(ExeFooter)) {
+        return std::unexpected(L"文件太小，没有 ExeFooter");
+    }
+
+    ExeFooter footer;
+    std::memcpy(&footer, file->data().last(sizeof(ExeFooter)).data(), sizeof(footer));
+    if (footer.magic != EXE_MAGIC) {
+        return std::unexpected(L"ExeFooter magic 不匹配");
+    }
+
+    // 附加 EXE 必须位于 ExeFooter 之前
+    const auto exeData = file->view(footer.exeOffset, footer.exeSize);
+    if (exeData.empty() || footer.exeOffset + footer.exeSize > file->size() - sizeof(ExeFooter)) {
+        return std::unexpected(L"ExeFooter 记录的附加 EXE 范围无效");
+    }
+
+    AttachedExe exe;
+    exe.m_data = exeData;
+
+    // 有索引时按变体直接取下标，索引位于附加区域内才有效
+    const std::uint64_t indexEnd = file->size() - sizeof(ExeFooter);
+    if (indexEnd - footer.exeOffset >= sizeof(ExeIndex)) {
+        ExeIndex index;
+        std::memcpy(&index, file->view(indexEnd - sizeof(ExeIndex), sizeof(ExeIndex)).data(), sizeof(index));
+        const std::uint64_t entriesSize = static_cast<std::uint64_t>(index.count) * sizeof(ExeIndexEntry);
+        const auto entryId = static_cast<unsigned int>(variant);
+        if (index.magic == EXE_INDEX_MAGIC && index.count <= LAUNCHER_VARIANT_COUNT && entryId < index.count &&
+            indexEnd - footer.exeOffset - sizeof(ExeIndex) >= entriesSize) {
+            const std::uint64_t entriesOffset = indexEnd - sizeof(ExeIndex) - entriesSize;
+            ExeIndexEntry entry;
+            std::memcpy(&entry, file->view(entriesOffset + entryId * sizeof(ExeIndexEntry), sizeof(entry)).data(),
+                        sizeof(entry));
+            if (const auto variantData = file->view(entry.exeOffset, entry.exeSize);
+                !variantData.empty() && entry.exeOffset >= footer.exeOffset &&
+                entry.exeOffset + entry.exeSize <= entriesOffset) {
+                exe.m_data = variantData;
+                exe.m_variant = variant;
+            }
+        }
+    }
+
+    exe.m_file = std::move(file);
+    return exe;
+}
+
+std::expected<void, std::wstring> Attach::writeAttachedExe(const AttachedExe &exe, const Path &outputPath) {
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return std::unexpected(std::format(L"无法创建输出文件: {}", outputPath.wstring()));
+    }
+
+    // 分块写入，映射页按需读入，不经过中间缓冲区
+    auto rest = exe.data();
+    while (!rest.empty()) {
+        const auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(rest.size(), CHUNK_SIZE));
+        if (!file.write(reinterpret_cast<const char *>(rest.data()), static_cast<std::streamsize>(chunk))) {
+            break;
+        }
+        rest = rest.subspan(chunk);
+    }
+    file.close();
+    if (!file) {
+        return std::unexpected(std::format(L"写入附加 EXE 失败: {}", outputPath.wstring()));
+    }
+    return {};
+}
+
 std::expected<Attach::Path, std::wstring> Attach::attachExe(const Path &attachExePath,
                                                             const Path &outputPath) {
     // 获取当前程序路径
@@ -151,11 +298,20 @@ std::expected<Attach::Path, std::wstring> Attach::attachExe(const Path &attachEx
 }
 
 std::expected<Attach::Path, std::wstring> Attach::getCurrentExePath() {
+#ifdef _WIN32
     wchar_t path[MAX_PATH];
     if (const DWORD result = GetModuleFileNameW(nullptr, path, MAX_PATH); result == 0 || result == MAX_PATH) {
         return std::unexpected(L"无法获取当前程序路径");
     }
     return Path{path};
+#else
+    std::error_code ec;
+    auto path = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (ec) {
+        return std::unexpected(L"无法获取当前程序路径");
+    }
+    return path;
+#endif
 }
 
 Attach::Path Attach::generateNewFileName(const Path &originalPath) {
@@ -166,68 +322,190 @@ Attach::Path Attach::generateNewFileName(const Path &originalPath) {
     return parent / (stem + L"_attached" + extension);
 }
 
-std::expected<Attach::ByteArray, std::wstring> Attach::readFileContent(const Path &filePath) {
+std::expected<std::uint64_t, std::wstring> Attach::findAttachmentOffset(const Path &exeFilePath) {
     std::error_code ec;
-    auto fileSize = std::filesystem::file_size(filePath, ec);
+    const auto fileSize = std::filesystem::file_size(exeFilePath, ec);
     if (ec) {
-        return std::unexpected(std::format(L"无法获取文件大小: {}", filePath.wstring()));
+        return std::unexpected(std::format(L"无法获取文件大小: {}", exeFilePath.wstring()));
+    }
+    if (fileSize < sizeof(ExeFooter)) {
+        return fileSize;
     }
 
-    std::ifstream file(filePath, std::ios::binary);
+    std::ifstream file(exeFilePath, std::ios::binary);
     if (!file) {
-        return std::unexpected(std::format(L"无法打开文件: {}", filePath.wstring()));
+        return std::unexpected(std::format(L"无法打开文件: {}", exeFilePath.wstring()));
     }
 
-    ByteArray buffer(fileSize);
-    file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(fileSize));
-
-    if (!file || static_cast<std::uintmax_t>(file.gcount()) != fileSize) {
-        return std::unexpected(std::format(L"读取文件失败: {}", filePath.wstring()));
+    // 只读取尾部的 ExeFooter
+    ExeFooter footer;
+    file.seekg(-static_cast<std::streamoff>(sizeof(ExeFooter)), std::ios::end);
+    file.read(reinterpret_cast<char *>(&footer), sizeof(footer));
+    if (!file) {
+        return std::unexpected(L"读取 ExeFooter 失败");
     }
 
-    return buffer;
+    if (footer.magic == EXE_MAGIC && footer.exeOffset <= fileSize - sizeof(ExeFooter)) {
+        return footer.exeOffset;
+    }
+    return fileSize;
 }
 
-void Attach::removeExistingAttachment(ByteArray &srcData) {
-    if (srcData.size() >= sizeof(ExeFooter)) {
-        const auto *footerPtr =
-                reinterpret_cast<const ExeFooter *>(srcData.data() + srcData.size() - sizeof(ExeFooter));
+std::expected<void, std::wstring> Attach::attachInPlace(const Path &exeFilePath,
+                                                        const std::span<const Path> attachExePaths) {
+    if (auto result = recoverJournal(exeFilePath); !result) {
+        return result;
+    }
 
-        if (footerPtr->magic == EXE_MAGIC) {
-            srcData.resize(footerPtr->exeOffset);
+    // 修改源文件前先确认附加 EXE 可读
+    std::error_code ec;
+    for (const auto &attachExePath: attachExePaths) {
+        if (!attachExePath.empty() && !std::filesystem::is_regular_file(attachExePath, ec)) {
+            return std::unexpected(std::format(L"无法读取附加 EXE 文件: {}", attachExePath.wstring()));
         }
     }
-}
 
-std::expected<void, std::wstring> Attach::writeAttachedFile(const Path &newExeFilePath, const ByteArray &srcData,
-                                                            const ByteArray &attachData) {
-    std::ofstream file(newExeFilePath, std::ios::binary);
-    if (!file) {
-        return std::unexpected(std::format(L"无法创建输出文件: {}", newExeFilePath.wstring()));
+    const auto fileSize = std::filesystem::file_size(exeFilePath, ec);
+    if (ec) {
+        return std::unexpected(std::format(L"无法获取文件大小: {}", exeFilePath.wstring()));
+    }
+    const auto exeOffset = findAttachmentOffset(exeFilePath);
+    if (!exeOffset) {
+        return std::unexpected(std::format(L"无法读取当前程序文件: {}", exeOffset.error()));
     }
 
-    // 写入原程序数据
-    file.write(reinterpret_cast<const char *>(srcData.data()), static_cast<std::streamsize>(srcData.size()));
-    if (!file) {
-        return std::unexpected(L"写入当前程序失败");
+    if (auto result = writeJournal(exeFilePath, fileSize, exeOffset.value()); !result) {
+        return result;
     }
 
-    // 记录 EXE 偏移
-    auto exeOffset = static_cast<std::uint64_t>(file.tellp());
+    // 截断旧的附加内容后追加，失败时按日志还原
+    std::expected<void, std::wstring> result;
+    std::filesystem::resize_file(exeFilePath, exeOffset.value(), ec);
+    if (ec) {
+        result = std::unexpected(std::format(L"无法截断源文件: {}", errorMessage(ec)));
+    } else {
+        result = appendAttachment(exeFilePath, attachExePaths, exeOffset.value());
+    }
+    // 新内容落盘后才删除日志，否则断电后可能既没有日志也没有完整的附加内容
+    if (result && !syncFile(exeFilePath)) {
+        result = std::unexpected(std::format(L"无法写入源文件: {}", exeFilePath.wstring()));
+    }
+    if (!result) {
+        recoverJournal(exeFilePath);
+        return result;
+    }
 
-    // 写入附加数据
-    file.write(reinterpret_cast<const char *>(attachData.data()), static_cast<std::streamsize>(attachData.size()));
+    std::filesystem::remove(journalPath(exeFilePath), ec);
+    return {};
+}
+
+std::expected<void, std::wstring> Attach::appendAttachment(const Path &exeFilePath,
+                                                           const std::span<const Path> attachExePaths,
+                                                           const std::uint64_t exeOffset) {
+    std::ofstream file(exeFilePath, std::ios::binary | std::ios::app);
     if (!file) {
-        return std::unexpected(L"写入附加 EXE 失败");
+        return std::unexpected(std::format(L"无法打开输出文件: {}", exeFilePath.wstring()));
+    }
+
+    // 写入附加数据，按变体顺序排列
+    std::vector<ExeIndexEntry> entries(attachExePaths.size());
+    std::uint64_t offset = exeOffset;
+    for (std::size_t i = 0; i < attachExePaths.size(); ++i) {
+        const auto &attachExePath = attachExePaths[i];
+        if (attachExePath.empty()) {
+            continue;
+        }
+        std::error_code ec;
+        const auto attachSize = std::filesystem::file_size(attachExePath, ec);
+        std::ifstream in(attachExePath, std::ios::binary);
+        if (ec || !in) {
+            return std::unexpected(std::format(L"无法读取附加 EXE 文件: {}", attachExePath.wstring()));
+        }
+        if (!copyStream(in, file, attachSize)) {
+            return std::unexpected(L"写入附加 EXE 失败");
+        }
+        entries[i] = {.exeOffset = offset, .exeSize = attachSize};
+        offset += attachSize;
     }
 
-    // 写入 Footer
-    ExeFooter footer{.magic = EXE_MAGIC, .exeOffset = exeOffset, .exeSize = attachData.size()};
+    // 写入索引，只有一个模板时保持原格式
+    if (entries.size() > 1) {
+        const ExeIndex index{.magic = EXE_INDEX_MAGIC, .count = static_cast<unsigned int>(entries.size())};
+        file.write(reinterpret_cast<const char *>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(ExeIndexEntry)));
+        file.write(reinterpret_cast<const char *>(&index), sizeof(index));
+    }
 
+    // 写入 Footer，指向默认模板
+    const ExeFooter footer{.magic = EXE_MAGIC, .exeOffset = exeOffset, .exeSize = entries.front().exeSize};
     file.write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+    file.close();
     if (!file) {
         return std::unexpected(L"写入 ExeFooter 失败");
     }
 
     return {};
 }
+
+std::expected<void, std::wstring> Attach::writeJournal(const Path &exeFilePath, const std::uint64_t fileSize,
+                                                       const std::uint64_t exeOffset) {
+    const auto path = journalPath(exeFilePath);
+    auto tempPath = path;
+    tempPath += L".tmp";
+
+    // 日志只保存将被截断的部分，原程序部分不会被修改
+    bool written = false;
+    {
+        std::ifstream in(exeFilePath, std::ios::binary);
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        const ExeJournal journal{.magic = JOURNAL_MAGIC, .fileSize = fileSize, .exeOffset = exeOffset};
+        if (in && out) {
+            out.write(reinterpret_cast<const char *>(&journal), sizeof(journal));
+            in.seekg(static_cast<std::streamoff>(exeOffset));
+            written = in && out && copyStream(in, out, fileSize - exeOffset);
+            out.close();
+            written = written && out;
+        }
+    }
+
+    // 写完并落盘后再改名，改名同样落盘后才截断源文件：断电后存在的日志总是完整的，
+    // 截断生效时日志也一定已经在磁盘上
+    std::error_code ec;
+    if (!written || !syncFile(tempPath) || !durableRename(tempPath, path)) {
+        std::filesystem::remove(tempPath, ec);
+        return std::unexpected(std::format(L"无法创建日志文件: {}", path.wstring()));
+    }
+    return {};
+}
+
+std::expected<void, std::wstring> Attach::recoverJournal(const Path &exeFilePath) {
+    const auto path = journalPath(exeFilePath);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return {};
+    }
+
+    const auto journalSize = std::filesystem::file_size(path, ec);
+    std::ifstream in(path, std::ios::binary);
+    ExeJournal journal{};
+    in.read(reinterpret_cast<char *>(&journal), sizeof(journal));
+
+    // 日志不完整说明中断发生在截断源文件之前，直接丢弃
+    if (!ec && in && journal.magic == JOURNAL_MAGIC && journal.exeOffset <= journal.fileSize &&
+        journalSize == sizeof(journal) + journal.fileSize - journal.exeOffset) {
+        std::filesystem::resize_file(exeFilePath, journal.exeOffset, ec);
+        if (ec) {
+            return std::unexpected(std::format(L"无法按日志恢复源文件: {}", errorMessage(ec)));
+        }
+        std::ofstream out(exeFilePath, std::ios::binary | std::ios::app);
+        const bool restored = out && copyStream(in, out, journal.fileSize - journal.exeOffset);
+        out.close();
+        if (!restored || !out || !syncFile(exeFilePath)) {
+            return std::unexpected(std::format(L"无法按日志恢复源文件: {}", exeFilePath.wstring()));
+        }
+    }
+
+    in.close();
+    std::filesystem::remove(path, ec);
+    return {};
+}
@@ -0,0 +1,390 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 文件区间复制，优先使用块克隆和内核复制
+
+**************************************************************************/
+#include "filecopy.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/sendfile.h>
+#endif
+#endif
+
+import std;
+
+namespace {
+    using FileCopy::Method;
+
+#ifdef _WIN32
+    class Handle {
+    public:
+        explicit Handle(const HANDLE handle) : m_handle(handle) {
+        }
+
+        ~Handle() {
+            if (valid()) {
+                CloseHandle(m_handle);
+            }
+        }
+
+        Handle(const Handle &) = delete;
+
+        Handle &operator=(const Handle &) = delete;
+
+        [[nodiscard]] bool valid() const {
+            return m_handle != INVALID_HANDLE_VALUE;
+        }
+
+        [[nodiscard]] HANDLE get() const {
+            return m_handle;
+        }
+
+    private:
+        HANDLE m_handle;
+    };
+
+    bool setEndOfFile(const HANDLE file, const std::uint64_t size) {
+        FILE_END_OF_FILE_INFO info{};
+        info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+        return SetFileInformationByHandle(file, FileEndOfFileInfo, &info, sizeof(info));
+    }
+
+    // ReFS 块克隆，返回已克隆的字节数
+    std::uint64_t cloneRange(const HANDLE src, const HANDLE dst, const std::uint64_t srcOffset, const std::uint64_t size,
+                             const std::uint64_t totalSize) {
+        DWORD flags = 0;
+        if (!GetVolumeInformationByHandleW(dst, nullptr, 0, nullptr, nullptr, &flags, nullptr, 0) ||
+            !(flags & FILE_SUPPORTS_BLOCK_REFCOUNTING)) {
+            return 0;
+        }
+
+        FSCTL_GET_INTEGRITY_INFORMATION_BUFFER integrity{};
+        DWORD bytes = 0;
+        if (!DeviceIoControl(src, FSCTL_GET_INTEGRITY_INFORMATION, nullptr, 0, &integrity, sizeof(integrity), &bytes,
+                             nullptr) || integrity.ClusterSizeInBytes == 0) {
+            return 0;
+        }
+        const std::uint64_t clusterSize = integrity.ClusterSizeInBytes;
+        const std::uint64_t alignedSize = size / clusterSize * clusterSize;
+        if (srcOffset % clusterSize != 0 || alignedSize == 0) {
+            return 0;
+        }
+
+        // 目标文件必须先具有足够的大小
+        if (!setEndOfFile(dst, totalSize)) {
+            return 0;
+        }
+        DUPLICATE_EXTENTS_DATA extents{};
+        extents.FileHandle = src;
+        extents.SourceFileOffset.QuadPart = static_cast<LONGLONG>(srcOffset);
+        extents.TargetFileOffset.QuadPart = 0;
+        extents.ByteCount.QuadPart = static_cast<LONGLONG>(alignedSize);
+        if (!DeviceIoControl(dst, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents), nullptr, 0, &bytes,
+                             nullptr)) {
+            return 0;
+        }
+        return alignedSize;
+    }
+
+    bool readAt(const HANDLE file, const std::uint64_t offset, void *buffer, const DWORD size) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD bytesRead = 0;
+        return ReadFile(file, buffer, size, &bytesRead, &overlapped) && bytesRead == size;
+    }
+
+    bool writeAt(const HANDLE file, const std::uint64_t offset, const void *buffer, const DWORD size) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        return WriteFile(file, buffer, size, &written, &overlapped) && written == size;
+    }
+
+    std::expected<Method, std::wstring> copyRangeImpl(const FileCopy::Path &src, const std::uint64_t srcOffset,
+                                                      const std::uint64_t size, const FileCopy::Path &dst,
+                                                      const std::span<const std::uint8_t> trailer,
+                                                      const FileCopy::Progress &progress, const Method first) {
+        const Handle srcFile{CreateFileW(src.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                         OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+        if (!srcFile.valid()) {
+            return std::unexpected{L"无法读取文件: " + src.wstring()};
+        }
+        const Handle dstFile{CreateFileW(dst.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+        if (!dstFile.valid()) {
+            return std::unexpected{L"无法创建输出文件: " + dst.wstring()};
+        }
+
+        const std::uint64_t totalSize = size + trailer.size();
+        Method method = Method::Buffered;
+        std::uint64_t copied = first == Method::Clone
+                                   ? cloneRange(srcFile.get(), dstFile.get(), srcOffset, size, totalSize)
+                                   : 0;
+        if (copied > 0) {
+            method = Method::Clone;
+            if (progress) {
+                progress(copied, size);
+            }
+        } else {
+            // 预分配目标文件空间，减少写入过程中的碎片和元数据更新
+            FILE_ALLOCATION_INFO allocationInfo{};
+            allocationInfo.AllocationSize.QuadPart = static_cast<LONGLONG>(totalSize);
+            SetFileInformationByHandle(dstFile.get(), FileAllocationInfo, &allocationInfo, sizeof(allocationInfo));
+        }
+
+        // Windows 没有通用的文件到文件内核复制接口，剩余部分使用大缓冲区读写
+        if (copied < size) {
+            const auto buffer = std::make_unique_for_overwrite<std::uint8_t[]>(
+                static_cast<std::size_t>(std::min<std::uint64_t>(size - copied, FileCopy::BUFFER_SIZE)));
+            while (copied < size) {
+                const auto chunk = static_cast<DWORD>(std::min<std::uint64_t>(size - copied, FileCopy::BUFFER_SIZE));
+                if (!readAt(srcFile.get(), srcOffset + copied, buffer.get(), chunk)) {
+                    return std::unexpected{L"读取数据时发生错误: " + src.wstring()};
+                }
+                if (!writeAt(dstFile.get(), copied, buffer.get(), chunk)) {
+                    return std::unexpected{L"写入数据时发生错误: " + dst.wstring()};
+                }
+                copied += chunk;
+                if (progress) {
+                    progress(copied, size);
+                }
+            }
+        }
+
+        if (!trailer.empty() &&
+            !writeAt(dstFile.get(), size, trailer.data(), static_cast<DWORD>(trailer.size()))) {
+            return std::unexpected{L"写入数据时发生错误: " + dst.wstring()};
+        }
+        if (!setEndOfFile(dstFile.get(), totalSize)) {
+            return std::unexpected{L"设置文件大小失败: " + dst.wstring()};
+        }
+        return method;
+    }
+#else
+    class Handle {
+    public:
+        explicit Handle(const int fd) : m_fd(fd) {
+        }
+
+        ~Handle() {
+            if (valid()) {
+                ::close(m_fd);
+            }
+        }
+
+        Handle(const Handle &) = delete;
+
+        Handle &operator=(const Handle &) = delete;
+
+        [[nodiscard]] bool valid() const {
+            return m_fd >= 0;
+        }
+
+        [[nodiscard]] int get() const {
+            return m_fd;
+        }
+
+    private:
+        int m_fd;
+    };
+
+    // btrfs/xfs 块克隆，返回已克隆的字节数
+    std::uint64_t cloneRange(const int src, const int dst, const std::uint64_t srcOffset, const std::uint64_t size,
+                             const std::uint64_t totalSize) {
+#ifdef FICLONERANGE
+        struct stat st{};
+        if (fstat(dst, &st) != 0 || st.st_blksize <= 0) {
+            return 0;
+        }
+        const auto blockSize = static_cast<std::uint64_t>(st.st_blksize);
+        const std::uint64_t alignedSize = size / blockSize * blockSize;
+        if (srcOffset % blockSize != 0 || alignedSize == 0) {
+            return 0;
+        }
+        if (ftruncate(dst, static_cast<off_t>(totalSize)) != 0) {
+            return 0;
+        }
+        file_clone_range range{};
+        range.src_fd = src;
+        range.src_offset = srcOffset;
+        range.src_length = alignedSize;
+        range.dest_offset = 0;
+        if (ioctl(dst, FICLONERANGE, &range) != 0) {
+            return 0;
+        }
+        return alignedSize;
+#else
+        return 0;
+#endif
+    }
+
+    // copy_file_range，不支持时使用 sendfile，返回已复制到的位置
+    std::uint64_t kernelCopy(const int src, const int dst, const std::uint64_t srcOffset, const std::uint64_t size,
+                             std::uint64_t copied) {
+#ifdef __linux__
+        while (copied < size) {
+            auto offIn = static_cast<off_t>(srcOffset + copied);
+            auto offOut = static_cast<off_t>(copied);
+            const ssize_t n = copy_file_range(src, &offIn, dst, &offOut, size - copied, 0);
+            if (n <= 0) {
+                break;
+            }
+            copied += static_cast<std::uint64_t>(n);
+        }
+        if (copied < size && lseek(dst, static_cast<off_t>(copied), SEEK_SET) >= 0) {
+            while (copied < size) {
+                auto offIn = static_cast<off_t>(srcOffset + copied);
+                const ssize_t n = sendfile(dst, src, &offIn, std::min<std::uint64_t>(size - copied, 0x7ffff000));
+                if (n <= 0) {
+                    break;
+                }
+                copied += static_cast<std::uint64_t>(n);
+            }
+        }
+#endif
+        return copied;
+    }
+
+    bool readAt(const int fd, std::uint64_t offset, std::uint8_t *buffer, std::size_t size) {
+        while (size > 0) {
+            const ssize_t n = pread(fd, buffer, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            buffer += n;
+            offset += static_cast<std::uint64_t>(n);
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    bool writeAt(const int fd, std::uint64_t offset, const std::uint8_t *buffer, std::size_t size) {
+        while (size > 0) {
+            const ssize_t n = pwrite(fd, buffer, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            buffer += n;
+            offset += static_cast<std::uint64_t>(n);
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    std::expected<Method, std::wstring> copyRangeImpl(const FileCopy::Path &src, const std::uint64_t srcOffset,
+                                                      const std::uint64_t size, const FileCopy::Path &dst,
+                                                      const std::span<const std::uint8_t> trailer,
+                                                      const FileCopy::Progress &progress, const Method first) {
+        const Handle srcFile{::open(src.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (!srcFile.valid()) {
+            return std::unexpected{L"无法读取文件: " + src.wstring()};
+        }
+        const Handle dstFile{::open(dst.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+        if (!dstFile.valid()) {
+            return std::unexpected{L"无法创建输出文件: " + dst.wstring()};
+        }
+
+        const std::uint64_t totalSize = size + trailer.size();
+        Method method = Method::Buffered;
+        std::uint64_t copied = first == Method::Clone
+                                   ? cloneRange(srcFile.get(), dstFile.get(), srcOffset, size, totalSize)
+                                   : 0;
+        if (copied > 0) {
+            method = Method::Clone;
+            if (progress) {
+                progress(copied, size);
+            }
+        } else {
+            // 预分配目标文件空间，文件系统不支持时忽略
+            posix_fallocate(dstFile.get(), 0, static_cast<off_t>(totalSize));
+        }
+
+        if (copied < size && first != Method::Buffered) {
+            const std::uint64_t before = copied;
+            copied = kernelCopy(srcFile.get(), dstFile.get(), srcOffset, size, copied);
+            if (method == Method::Buffered && copied > before) {
+                method = Method::Kernel;
+            }
+            if (progress && copied > before) {
+                progress(copied, size);
+            }
+        }
+
+        if (copied < size) {
+            const auto buffer = std::make_unique_for_overwrite<std::uint8_t[]>(
+                static_cast<std::size_t>(std::min<std::uint64_t>(size - copied, FileCopy::BUFFER_SIZE)));
+            while (copied < size) {
+                const auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(size - copied, FileCopy::BUFFER_SIZE));
+                if (!readAt(srcFile.get(), srcOffset + copied, buffer.get(), chunk)) {
+                    return std::unexpected{L"读取数据时发生错误: " + src.wstring()};
+                }
+                if (!writeAt(dstFile.get(), copied, buffer.get(), chunk)) {
+                    return std::unexpected{L"写入数据时发生错误: " + dst.wstring()};
+                }
+                copied += chunk;
+                if (progress) {
+                    progress(copied, size);
+                }
+            }
+        }
+
+        if (!trailer.empty() && !writeAt(dstFile.get(), size, trailer.data(), trailer.size())) {
+            return std::unexpected{L"写入数据时发生错误: " + dst.wstring()};
+        }
+        if (ftruncate(dstFile.get(), static_cast<off_t>(totalSize)) != 0) {
+            return std::unexpected{L"设置文件大小失败: " + dst.wstring()};
+        }
+        return method;
+    }
+#endif
+} // namespace
+
+namespace FileCopy {
+    std::expected<Method, std::wstring> copyRange(const Path &src, const std::uint64_t srcOffset,
+                                                  const std::uint64_t size, const Path &dst,
+                                                  const std::span<const std::uint8_t> trailer,
+                                                  const Progress &progress, const Method first) {
+        auto result = copyRangeImpl(src, srcOffset, size, dst, trailer, progress, first);
+        if (!result) {
+            std::error_code ec;
+            std::filesystem::remove(dst, ec);
+        }
+        return result;
+    }
+
+    const wchar_t *methodName(const Method method) {
+        switch (method) {
+            case Method::Clone:
+                return L"clone";
+            case Method::Kernel:
+                return L"kernel";
+            default:
+                return L"buffered";
+        }
+    }
+} // namespace FileCopy
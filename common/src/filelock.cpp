@@ -0,0 +1,133 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 跨进程文件锁
+
+**************************************************************************/
+#include "filelock.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+import std;
+
+std::expected<FileLock, std::wstring> FileLock::acquire(const Path &path) {
+    return lock(path, true);
+}
+
+std::expected<FileLock, std::wstring> FileLock::tryAcquire(const Path &path) {
+    return lock(path, false);
+}
+
+std::expected<FileLock, std::wstring> FileLock::lock(const Path &path, const bool wait) {
+#ifdef _WIN32
+    // 锁文件被删除但仍有句柄未关闭时处于删除挂起状态，打开会返回拒绝访问，短暂等待后重试
+    constexpr int DELETE_PENDING_RETRIES = 50;
+    int retries = 0;
+#endif
+    while (true) {
+        FileLock lock;
+#ifdef _WIN32
+        const HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                                         FILE_ATTRIBUTE_HIDDEN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE) {
+            if (wait && GetLastError() == ERROR_ACCESS_DENIED && retries++ < DELETE_PENDING_RETRIES) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            return std::unexpected{L"无法打开锁文件: " + path.wstring()};
+        }
+        lock.m_handle = hFile;
+
+        OVERLAPPED overlapped{};
+        const DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+        if (!LockFileEx(hFile, flags, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+            return std::unexpected{(wait ? L"无法锁定文件: " : L"锁文件已被占用: ") + path.wstring()};
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return std::unexpected{L"无法打开锁文件: " + path.wstring()};
+        }
+        lock.m_fd = fd;
+
+        int result;
+        do {
+            result = flock(fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB);
+        } while (result != 0 && errno == EINTR);
+        if (result != 0) {
+            return std::unexpected{(errno == EWOULDBLOCK ? L"锁文件已被占用: " : L"无法锁定文件: ") + path.wstring()};
+        }
+#endif
+        // 等待期间持有者删除了锁文件，锁住的是已删除的文件，重新打开
+        if (lock.current(path)) {
+            return lock;
+        }
+    }
+}
+
+bool FileLock::current(const Path &path) const {
+#ifdef _WIN32
+    FILE_STANDARD_INFO info{};
+    return GetFileInformationByHandleEx(m_handle, FileStandardInfo, &info, sizeof(info)) && !info.DeletePending &&
+           info.NumberOfLinks > 0;
+#else
+    struct stat held{};
+    struct stat named{};
+    return fstat(m_fd, &held) == 0 && stat(path.c_str(), &named) == 0 && held.st_dev == named.st_dev &&
+           held.st_ino == named.st_ino;
+#endif
+}
+
+FileLock::~FileLock() {
+    release();
+}
+
+FileLock::FileLock(FileLock &&other) noexcept {
+#ifdef _WIN32
+    std::swap(m_handle, other.m_handle);
+#else
+    std::swap(m_fd, other.m_fd);
+#endif
+}
+
+FileLock &FileLock::operator=(FileLock &&other) noexcept {
+    if (this != &other) {
+        release();
+#ifdef _WIN32
+        std::swap(m_handle, other.m_handle);
+#else
+        std::swap(m_fd, other.m_fd);
+#endif
+    }
+    return *this;
+}
+
+void FileLock::release() {
+    // 关闭句柄即释放锁
+#ifdef _WIN32
+    if (m_handle) {
+        CloseHandle(m_handle);
+        m_handle = nullptr;
+    }
+#else
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+#endif
+}
@@ -0,0 +1,326 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 按内容寻址的 jar 解压缓存，支持多个 exe 共享与按最近使用时间淘汰
+
+**************************************************************************/
+#include "jarcache.h"
+#include "filelock.h"
+#include "jarlayout.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+import std;
+
+namespace {
+    using JarCache::Digest;
+    using JarCache::Path;
+
+    // 未完成的临时文件保留时间，超过后视为中断的解压
+    constexpr auto STALE_TMP_AGE = std::chrono::hours(1);
+
+    constexpr std::size_t DIGEST_NAME_LENGTH = std::tuple_size_v<Digest> * 2;
+
+    constexpr auto EVICT_MARKER = L"last-evict";
+
+    bool isDigestName(const std::wstring_view name) {
+        return name.size() == DIGEST_NAME_LENGTH && std::ranges::all_of(name, [](const wchar_t c) {
+            return (c >= L'0' && c <= L'9') || (c >= L'a' && c <= L'f');
+        });
+    }
+
+    // 以 "<digest>." 开头的文件名，如归档 <digest>.*.jsa 与临时文件 <digest>.<pid>.tmp
+    bool hasDigestPrefix(const std::wstring_view name) {
+        return name.size() > DIGEST_NAME_LENGTH && name[DIGEST_NAME_LENGTH] == L'.' &&
+               isDigestName(name.substr(0, DIGEST_NAME_LENGTH));
+    }
+
+    bool isTmpName(const std::wstring_view stem) {
+        if (!hasDigestPrefix(stem)) {
+            return false;
+        }
+        const auto pid = stem.substr(DIGEST_NAME_LENGTH + 1);
+        return !pid.empty() && std::ranges::all_of(pid, [](const wchar_t c) { return c >= L'0' && c <= L'9'; });
+    }
+
+    // jar 只通过重命名放入缓存，大小一致且尾部的 EOCD 与 JarStamp 完整才视为可用，大小由 readStamp 比较
+    bool complete(const Path &jarPath, const std::uint64_t size) {
+        std::error_code ec;
+        return std::filesystem::exists(jarPath, ec) && JarLayout::readStamp(jarPath, size).has_value();
+    }
+
+    std::wstring toHex(const Digest &digest) {
+        static constexpr wchar_t DIGITS[] = L"0123456789abcdef";
+        std::wstring result;
+        result.reserve(digest.size() * 2);
+        for (const auto byte: digest) {
+            result.push_back(DIGITS[byte >> 4]);
+            result.push_back(DIGITS[byte & 0xF]);
+        }
+        return result;
+    }
+
+    std::uint32_t processId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<std::uint32_t>(getpid());
+#endif
+    }
+
+    Path refsDir(const Path &root, const std::wstring &name) {
+        return root / L"refs" / name;
+    }
+
+    // 引用文件名为 exe 路径的哈希，内容为 exe 的 UTF-8 路径
+    // 已存在时只刷新修改时间，新建时写入临时文件再重命名，并发清理不会读到空的引用而误删
+    void touchRef(const Path &root, const std::wstring &name, const Path &owner) {
+        const auto dir = refsDir(root, name);
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        if (ec) {
+            return;
+        }
+        const auto ownerPath = owner.lexically_normal().u8string();
+        const auto ownerKey = JarLayout::hash({reinterpret_cast<const std::uint8_t *>(ownerPath.data()),
+                                               ownerPath.size()});
+        const auto refPath = dir / std::format(L"{:016x}", ownerKey);
+        if (std::filesystem::last_write_time(refPath, std::filesystem::file_time_type::clock::now(), ec); !ec) {
+            return;
+        }
+
+        const auto tmpPath = dir / std::format(L"{:016x}.{}.tmp", ownerKey, processId());
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(ownerPath.data()),
+                      static_cast<std::streamsize>(ownerPath.size()));
+        }
+        std::filesystem::rename(tmpPath, refPath, ec);
+        if (ec) {
+            std::filesystem::remove(tmpPath, ec);
+        }
+    }
+
+    void touchMarker(const Path &root) {
+        const auto marker = root / EVICT_MARKER;
+        std::error_code ec;
+        if (!std::filesystem::exists(marker, ec)) {
+            std::ofstream out(marker, std::ios::binary);
+        }
+        std::filesystem::last_write_time(marker, std::filesystem::file_time_type::clock::now(), ec);
+    }
+
+    std::optional<Path> readRef(const Path &refPath) {
+        std::ifstream in(refPath, std::ios::binary);
+        if (!in) {
+            return std::nullopt;
+        }
+        const std::string content{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        if (content.empty()) {
+            return std::nullopt;
+        }
+        return Path(std::u8string(content.begin(), content.end()));
+    }
+} // namespace
+
+namespace JarCache {
+    bool valid(const Digest &digest) {
+        return std::ranges::any_of(digest, [](const std::uint8_t byte) { return byte != 0; });
+    }
+
+    Path defaultRoot() {
+#ifdef _WIN32
+        wchar_t buffer[MAX_PATH];
+        if (const DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", buffer, MAX_PATH);
+            length > 0 && length < MAX_PATH) {
+            return Path(buffer) / L"JarPackager" / L"cache";
+        }
+#else
+        if (const char *xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+            return Path(xdg) / "jarpackager";
+        }
+        if (const char *home = std::getenv("HOME"); home && *home) {
+            return Path(home) / ".cache" / "jarpackager";
+        }
+#endif
+        std::error_code ec;
+        return std::filesystem::temp_directory_path(ec) / L"JarPackager" / L"cache";
+    }
+
+    Path root(const Path &extractPath) {
+        // 用户指定的目录中可能还有其他文件，缓存放在独立的子目录中，清理时不会误删
+        return extractPath.empty() ? defaultRoot() : extractPath / CACHE_DIR_NAME;
+    }
+
+    std::expected<Entry, std::wstring> acquire(const Path &root, const Digest &digest, const std::uint64_t size,
+                                               const Path &owner, const Fill &fill) {
+        std::error_code ec;
+        std::filesystem::create_directories(root, ec);
+        if (ec) {
+            return std::unexpected{L"无法创建缓存目录: " + root.wstring()};
+        }
+
+        const auto name = toHex(digest);
+        Entry entry{root / (name + L".jar")};
+
+        // 先登记引用再放入 jar，清理时不会把刚解压的 jar 当作无主文件
+        touchRef(root, name, owner);
+
+        // 同一 jar 只由一个进程解压，其他进程等待后直接使用结果；
+        // 命中判断也在锁内进行，清理只删除能获得锁的 jar，判断为命中后不会被其他进程删除
+        const auto lock = FileLock::acquire(root / (name + L".lock"));
+        if (!lock) {
+            return std::unexpected{lock.error()};
+        }
+        if (complete(entry.jarPath, size)) {
+            entry.hit = true;
+            return entry;
+        }
+
+        const Path tmpPath = root / std::format(L"{}.{}.tmp", name, processId());
+        if (auto fillResult = fill(tmpPath); !fillResult) {
+            std::filesystem::remove(tmpPath, ec);
+            return std::unexpected{fillResult.error()};
+        }
+
+        std::filesystem::rename(tmpPath, entry.jarPath, ec);
+        if (ec) {
+            // 其他进程已放入相同内容的 jar，且该 jar 正在被使用而无法替换
+            std::filesystem::remove(tmpPath, ec);
+            if (complete(entry.jarPath, size)) {
+                entry.hit = true;
+                return entry;
+            }
+            return std::unexpected{L"无法写入解压缓存: " + entry.jarPath.wstring()};
+        }
+        return entry;
+    }
+
+    void evict(const Path &root, const Digest &keep, const std::uint64_t limit) {
+        struct Candidate {
+            std::wstring name;
+            std::uint64_t size = 0;
+            std::filesystem::file_time_type lastUse{};
+            bool orphan = true;
+            bool lockOnly = false; // 只有锁文件，没有对应的 jar
+        };
+
+        const auto keepName = toHex(keep);
+        const auto now = std::filesystem::file_time_type::clock::now();
+        std::vector<Candidate> candidates;
+        std::vector<Path> archives; // jar 旁边的类数据共享归档，随 jar 一起删除
+        std::uint64_t total = 0;
+
+        std::error_code ec;
+        touchMarker(root);
+        for (const auto &item: std::filesystem::directory_iterator(root, ec)) {
+            std::error_code itemEc;
+            if (!item.is_regular_file(itemEc)) {
+                continue;
+            }
+            // 只处理缓存自己命名的文件
+            const auto &path = item.path();
+            const auto stem = path.stem().wstring();
+            if (path.extension() == L".tmp") {
+                if (isTmpName(stem) && now - item.last_write_time(itemEc) > STALE_TMP_AGE && !itemEc) {
+                    std::filesystem::remove(path, itemEc);
+                }
+                continue;
+            }
+            if (path.extension() == L".jsa" || path.extension() == L".aot") {
+                if (hasDigestPrefix(path.filename().wstring())) {
+                    archives.push_back(path);
+                }
+                continue;
+            }
+            if (path.extension() == L".lock") {
+                // 没有对应 jar 的锁文件（如解压失败后残留的），能获得锁时删除
+                if (isDigestName(stem) && !std::filesystem::exists(root / (stem + L".jar"), itemEc)) {
+                    candidates.push_back({.name = stem, .lockOnly = true});
+                }
+                continue;
+            }
+            if (path.extension() != L".jar" || !isDigestName(stem)) {
+                continue;
+            }
+
+            Candidate candidate{stem, item.file_size(itemEc), item.last_write_time(itemEc)};
+            if (itemEc) {
+                continue;
+            }
+            // 引用的 exe 已不存在时删除引用，最近使用时间取剩余引用中最新的一个
+            for (const auto &ref: std::filesystem::directory_iterator(refsDir(root, candidate.name), itemEc)) {
+                std::error_code refEc;
+                if (ref.path().extension() == L".tmp") {
+                    // 正在登记的引用，超时未完成的视为中断
+                    if (now - ref.last_write_time(refEc) > STALE_TMP_AGE && !refEc) {
+                        std::filesystem::remove(ref.path(), refEc);
+                    } else {
+                        candidate.orphan = false;
+                    }
+                    continue;
+                }
+                const auto owner = readRef(ref.path());
+                if (!owner || !std::filesystem::exists(*owner, refEc)) {
+                    std::filesystem::remove(ref.path(), refEc);
+                    continue;
+                }
+                candidate.orphan = false;
+                candidate.lastUse = std::max(candidate.lastUse, ref.last_write_time(refEc));
+            }
+            total += candidate.size;
+            candidates.push_back(std::move(candidate));
+        }
+
+        std::ranges::sort(candidates, {}, &Candidate::lastUse);
+        for (const auto &candidate: candidates) {
+            if (candidate.name == keepName || (!candidate.orphan && total <= limit)) {
+                continue;
+            }
+            // 其他进程正在解压或判断命中时跳过；锁文件在持有锁时删除，等待中的进程会重新打开
+            const auto lockPath = root / (candidate.name + L".lock");
+            const auto lock = FileLock::tryAcquire(lockPath);
+            if (!lock) {
+                continue;
+            }
+            // 引用可能属于正要解压该 jar 的进程，只删除锁文件
+            if (candidate.lockOnly) {
+                std::filesystem::remove(lockPath, ec);
+                continue;
+            }
+            // 正在运行的 JVM 打开着 jar 时删除会失败，保留该项
+            const auto jarPath = root / (candidate.name + L".jar");
+            std::filesystem::remove(jarPath, ec);
+            if (std::filesystem::exists(jarPath, ec)) {
+                continue;
+            }
+            total -= candidate.size;
+            std::filesystem::remove_all(refsDir(root, candidate.name), ec);
+            for (const auto &archive: archives) {
+                if (archive.filename().wstring().starts_with(candidate.name + L".")) {
+                    std::filesystem::remove(archive, ec);
+                }
+            }
+            std::filesystem::remove(lockPath, ec);
+        }
+    }
+
+    void evictIfDue(const Path &root, const Digest &keep, const std::uint64_t limit) {
+        std::error_code ec;
+        const auto last = std::filesystem::last_write_time(root / EVICT_MARKER, ec);
+        if (!ec && std::filesystem::file_time_type::clock::now() - last < EVICT_INTERVAL) {
+            return;
+        }
+        evict(root, keep, limit);
+    }
+} // namespace JarCache
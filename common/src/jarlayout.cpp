@@ -0,0 +1,342 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 打包文件段目录的读写
+
+**************************************************************************/
+#include "jarlayout.h"
+#include "ziptail.h"
+
+import std;
+
+namespace {
+    template<typename T>
+    T readStruct(const std::span<const std::uint8_t> data, const std::size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void appendStruct(std::vector<std::uint8_t> &out, const T &value) {
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // 将绝对范围转换为尾部数据中的子视图，范围不在尾部数据内时返回空
+    std::optional<std::span<const std::uint8_t>> subspan(const std::span<const std::uint8_t> tail,
+                                                         const std::uint64_t fileSize,
+                                                         const JarLayout::Range &range) {
+        const std::uint64_t tailStart = fileSize - tail.size();
+        if (range.offset < tailStart || range.size > fileSize || range.offset > fileSize - range.size) {
+            return std::nullopt;
+        }
+        return tail.subspan(static_cast<std::size_t>(range.offset - tailStart), static_cast<std::size_t>(range.size));
+    }
+
+    std::expected<JarLayout::PackageInfo, std::wstring> parseLegacy(const std::span<const std::uint8_t> tail,
+                                                                     const std::uint64_t fileSize,
+                                                                     const std::uint64_t metadataOffset) {
+        using namespace JarLayout;
+        const auto footer = readStruct<JarCommon::JarFooter>(tail, tail.size() - sizeof(JarCommon::JarFooter));
+
+        PackageInfo info{};
+        info.version = LEGACY_VERSION;
+        info.metadataOffset = metadataOffset;
+
+        if (footer.jarSize > fileSize || footer.jarOffset > fileSize - footer.jarSize ||
+            footer.splashImageSize > fileSize - footer.jarOffset - footer.jarSize) {
+            return std::unexpected{L"JAR 信息超出文件范围"};
+        }
+        info.sections[static_cast<std::size_t>(SectionType::Jar)] = {
+            static_cast<std::uint32_t>(SectionType::Jar), 0, footer.jarOffset, footer.jarSize, 1, 0, 0};
+        if (footer.splashImageSize > 0) {
+            info.sections[static_cast<std::size_t>(SectionType::SplashImage)] = {
+                static_cast<std::uint32_t>(SectionType::SplashImage), 0, footer.jarOffset + footer.jarSize,
+                footer.splashImageSize, 1, 0, 0};
+        }
+
+        auto &settings = info.settings;
+        settings.javaVersion = footer.javaVersion;
+        settings.launchTime = footer.launchTime;
+        settings.launchMode = footer.launchMode;
+        settings.timestamp = footer.timestamp;
+        settings.splashShowProgress = footer.splashShowProgress;
+        settings.splashShowProgressText = footer.splashShowProgressText;
+        settings.titlePosX = footer.titlePosX;
+        settings.titlePosY = footer.titlePosY;
+        settings.versionPosX = footer.versionPosX;
+        settings.versionPosY = footer.versionPosY;
+        settings.statusPosX = footer.statusPosX;
+        settings.statusPosY = footer.statusPosY;
+        settings.titleFontSizePercent = footer.titleFontSizePercent;
+        settings.versionFontSizePercent = footer.versionFontSizePercent;
+        settings.statusFontSizePercent = footer.statusFontSizePercent;
+
+        // 旧版字符串按固定顺序紧邻 JarFooter 之前
+        const std::array<std::uint32_t, STRING_COUNT> lengths{
+            footer.mainClassLength, footer.jvmArgsLength, footer.programArgsLength,
+            footer.javaPathLength, footer.jarExtractPathLength, footer.splashProgramNameLength,
+            footer.splashProgramVersionLength,
+        };
+        std::uint64_t offset = metadataOffset;
+        for (std::size_t i = 0; i < STRING_COUNT; ++i) {
+            info.strings[i] = {offset, lengths[i]};
+            offset += lengths[i];
+        }
+        info.sections[static_cast<std::size_t>(SectionType::Strings)] = {
+            static_cast<std::uint32_t>(SectionType::Strings), 0, metadataOffset, offset - metadataOffset, 1, 0, 0};
+        return info;
+    }
+} // namespace
+
+namespace JarLayout {
+    std::uint64_t hash(const std::span<const std::uint8_t> data, std::uint64_t state) {
+        for (const auto byte: data) {
+            state ^= byte;
+            state *= 0x100000001b3ULL;
+        }
+        return state;
+    }
+
+    std::expected<std::uint64_t, std::wstring> metadataSize(const std::span<const std::uint8_t> tail,
+                                                            const std::uint64_t fileSize) {
+        if (tail.size() > fileSize) {
+            return std::unexpected{L"尾部数据大小无效"};
+        }
+
+        if (tail.size() >= sizeof(SectionFooter)) {
+            if (const auto footer = readStruct<SectionFooter>(tail, tail.size() - sizeof(SectionFooter));
+                footer.magic == SECTION_MAGIC) {
+                const std::uint64_t tableSize =
+                        static_cast<std::uint64_t>(footer.sectionCount) * footer.entrySize + sizeof(SectionFooter);
+                if (footer.version < SECTION_TABLE_VERSION || footer.entrySize == 0 ||
+                    footer.metadataSize < tableSize || footer.metadataSize > fileSize) {
+                    return std::unexpected{L"段目录信息无效"};
+                }
+                return footer.metadataSize;
+            }
+        }
+
+        if (tail.size() >= sizeof(JarCommon::JarFooter)) {
+            if (const auto footer = readStruct<JarCommon::JarFooter>(tail, tail.size() - sizeof(JarCommon::JarFooter));
+                footer.magic == JarCommon::JAR_MAGIC) {
+                const std::uint64_t size = sizeof(JarCommon::JarFooter) + static_cast<std::uint64_t>(
+                                               footer.mainClassLength) + footer.jvmArgsLength + footer.
+                                           programArgsLength + footer.javaPathLength + footer.jarExtractPathLength +
+                                           footer.splashProgramNameLength + footer.splashProgramVersionLength;
+                if (size > fileSize) {
+                    return std::unexpected{L"JAR 信息超出文件范围"};
+                }
+                return size;
+            }
+        }
+
+        return std::unexpected{L"无效的JAR文件格式"};
+    }
+
+    std::expected<PackageInfo, std::wstring> parse(const std::span<const std::uint8_t> tail,
+                                                   const std::uint64_t fileSize) {
+        const auto sizeResult = metadataSize(tail, fileSize);
+        if (!sizeResult) {
+            return std::unexpected{sizeResult.error()};
+        }
+        const std::uint64_t size = sizeResult.value();
+        if (tail.size() < size) {
+            return std::unexpected{L"元数据读取不完整"};
+        }
+        const std::uint64_t metadataOffset = fileSize - size;
+
+        const auto footer = readStruct<SectionFooter>(tail, tail.size() - sizeof(SectionFooter));
+        if (footer.magic != SECTION_MAGIC) {
+            return parseLegacy(tail, fileSize, metadataOffset);
+        }
+
+        PackageInfo info{};
+        info.version = footer.version;
+        info.metadataOffset = metadataOffset;
+
+        // 段目录：未知类型跳过，较新的段目录项只读取已知部分
+        const std::size_t tableStart =
+                tail.size() - sizeof(SectionFooter) - static_cast<std::size_t>(footer.sectionCount) * footer.entrySize;
+        const std::size_t copySize = std::min<std::size_t>(footer.entrySize, sizeof(SectionEntry));
+        for (std::uint32_t i = 0; i < footer.sectionCount; ++i) {
+            SectionEntry entry{};
+            std::memcpy(&entry, tail.data() + tableStart + static_cast<std::size_t>(i) * footer.entrySize, copySize);
+            if (entry.size > fileSize || entry.offset > fileSize - entry.size) {
+                return std::unexpected{L"段信息超出文件范围"};
+            }
+            if (entry.type != 0 && entry.type < SECTION_TYPE_COUNT) {
+                info.sections[entry.type] = entry;
+            }
+        }
+
+        if (!info.find(SectionType::Jar)) {
+            return std::unexpected{L"缺少 JAR 段"};
+        }
+
+        // 启动设置
+        const auto *settingsEntry = info.find(SectionType::Settings);
+        if (!settingsEntry) {
+            return std::unexpected{L"缺少启动设置段"};
+        }
+        const auto settingsData = subspan(tail, fileSize, {settingsEntry->offset, settingsEntry->size});
+        if (!settingsData || settingsData->size() < sizeof(std::uint32_t) ||
+            hash(*settingsData) != settingsEntry->hash) {
+            return std::unexpected{L"启动设置段无效"};
+        }
+        const auto declaredSize = readStruct<std::uint32_t>(*settingsData, 0);
+        std::memcpy(&info.settings, settingsData->data(),
+                    std::min({static_cast<std::size_t>(declaredSize), settingsData->size(), sizeof(LaunchSettings)}));
+        info.settings.size = sizeof(LaunchSettings);
+
+        // 字符串表
+        if (const auto *stringsEntry = info.find(SectionType::Strings)) {
+            const auto stringsData = subspan(tail, fileSize, {stringsEntry->offset, stringsEntry->size});
+            if (!stringsData || stringsData->size() < sizeof(StringTableHeader) ||
+                hash(*stringsData) != stringsEntry->hash) {
+                return std::unexpected{L"字符串表段无效"};
+            }
+            const auto header = readStruct<StringTableHeader>(*stringsData, 0);
+            if (stringsData->size() < sizeof(StringTableHeader) + static_cast<std::uint64_t>(header.count) *
+                sizeof(StringRef)) {
+                return std::unexpected{L"字符串表段无效"};
+            }
+            for (std::uint32_t i = 0; i < header.count && i < STRING_COUNT; ++i) {
+                const auto ref = readStruct<StringRef>(*stringsData, sizeof(StringTableHeader) + i * sizeof(StringRef));
+                if (static_cast<std::uint64_t>(ref.offset) + ref.size > stringsData->size()) {
+                    return std::unexpected{L"字符串表段无效"};
+                }
+                info.strings[i] = {stringsEntry->offset + ref.offset, ref.size};
+            }
+        }
+
+        return info;
+    }
+
+    std::string_view stringView(const PackageInfo &info, const std::span<const std::uint8_t> tail,
+                                const std::uint64_t fileSize, const StringId id) {
+        const auto data = subspan(tail, fileSize, info.strings[static_cast<std::size_t>(id)]);
+        if (!data || data->empty()) {
+            return {};
+        }
+        return {reinterpret_cast<const char *>(data->data()), data->size()};
+    }
+
+    std::expected<std::uint64_t, std::wstring> extractedSize(const std::span<const std::uint8_t> jar,
+                                                             const bool stamped) {
+        if (stamped) {
+            return jar.size();
+        }
+        const std::size_t tailSize = std::min(jar.size(), ZipTail::MAX_SEARCH_SIZE);
+        const auto record = ZipTail::locate(jar.last(tailSize), jar.size() - tailSize);
+        if (!record) {
+            return std::unexpected{L"JAR 文件格式无效: " + record.error()};
+        }
+        return record->eocdOffset + ZipTail::EOCD_SIZE + sizeof(JarStamp);
+    }
+
+    std::expected<JarStamp, std::wstring> readStamp(const std::filesystem::path &jarPath,
+                                                    const std::uint64_t expectedSize) {
+        std::error_code ec;
+        const std::uint64_t fileSize = std::filesystem::file_size(jarPath, ec);
+        if (ec) {
+            return std::unexpected{L"读取jar文件失败, " + jarPath.wstring()};
+        }
+        // 截断或追加了数据的文件尾部可能仍能解析，先比较大小
+        if (fileSize != expectedSize) {
+            return std::unexpected{L"时间戳校验失败: 文件大小不匹配"};
+        }
+        if (fileSize < ZipTail::EOCD_SIZE + sizeof(JarStamp)) {
+            return std::unexpected{L"时间戳校验失败: 文件大小无效"};
+        }
+
+        std::ifstream in(jarPath, std::ios::binary);
+        if (!in) {
+            return std::unexpected{L"读取jar文件失败, " + jarPath.wstring()};
+        }
+
+        // 只读取 EOCD 可能存在的尾部区域
+        const std::uint64_t tailSize = std::min<std::uint64_t>(fileSize, ZipTail::MAX_SEARCH_SIZE);
+        std::vector<std::uint8_t> tail(static_cast<std::size_t>(tailSize));
+        in.seekg(static_cast<std::streamoff>(fileSize - tailSize));
+        in.read(reinterpret_cast<char *>(tail.data()), static_cast<std::streamsize>(tailSize));
+        if (in.gcount() != static_cast<std::streamsize>(tailSize)) {
+            return std::unexpected{L"读取jar文件失败, " + jarPath.wstring()};
+        }
+
+        const auto record = ZipTail::locate(tail, fileSize - tailSize);
+        if (!record) {
+            return std::unexpected{L"无效的 JAR 文件格式: " + record.error()};
+        }
+        if (record->commentLength != sizeof(JarStamp)) {
+            return std::unexpected{L"时间戳校验失败: 注释大小不匹配"};
+        }
+        // 中央目录必须完整位于 EOCD 之前，否则说明文件被截断或损坏
+        if (record->centralDirOffset + record->centralDirSize > record->eocdOffset) {
+            return std::unexpected{L"时间戳校验失败: 文件大小不匹配"};
+        }
+
+        JarStamp stamp;
+        std::memcpy(&stamp, record->comment.data(), sizeof(stamp));
+        return stamp;
+    }
+
+    std::vector<std::uint8_t> encodeStrings(const std::span<const std::string_view> strings) {
+        std::vector<std::uint8_t> out;
+        appendStruct(out, StringTableHeader{static_cast<std::uint32_t>(strings.size())});
+
+        auto offset = static_cast<std::uint32_t>(sizeof(StringTableHeader) + strings.size() * sizeof(StringRef));
+        for (const auto &str: strings) {
+            appendStruct(out, StringRef{offset, static_cast<std::uint32_t>(str.size())});
+            offset += static_cast<std::uint32_t>(str.size());
+        }
+        for (const auto &str: strings) {
+            out.insert(out.end(), str.begin(), str.end());
+        }
+        return out;
+    }
+
+    void SectionTableWriter::add(const SectionType type, const std::uint64_t offset, const std::uint64_t size,
+                                 const std::uint32_t alignment, const std::uint64_t hash, const std::uint32_t flags) {
+        m_entries.push_back({static_cast<std::uint32_t>(type), flags, offset, size, alignment, 0, hash});
+    }
+
+    void SectionTableWriter::setHash(const SectionType type, const std::uint64_t hash) {
+        // SectionEntry 按 1 字节对齐，不能用成员指针投影绑定引用
+        const auto it = std::ranges::find_if(m_entries, [type](const SectionEntry &entry) {
+            return entry.type == static_cast<std::uint32_t>(type);
+        });
+        if (it != m_entries.end()) {
+            it->hash = hash;
+        }
+    }
+
+    std::size_t SectionTableWriter::tableSize() const {
+        return m_entries.size() * sizeof(SectionEntry) + sizeof(SectionFooter);
+    }
+
+    std::vector<std::uint8_t> SectionTableWriter::finish(const std::uint64_t metadataOffset,
+                                                         const std::uint64_t tableOffset) const {
+        std::vector<std::uint8_t> out;
+        out.reserve(tableSize());
+        for (const auto &entry: m_entries) {
+            appendStruct(out, entry);
+        }
+
+        const std::uint64_t tableEnd = tableOffset + out.size() + sizeof(SectionFooter);
+        appendStruct(out, SectionFooter{
+                         .metadataSize = tableEnd - metadataOffset,
+                         .sectionCount = static_cast<std::uint32_t>(m_entries.size()),
+                         .entrySize = static_cast<std::uint16_t>(sizeof(SectionEntry)),
+                         .version = SECTION_TABLE_VERSION,
+                         .magic = SECTION_MAGIC,
+                     });
+        return out;
+    }
+} // namespace JarLayout
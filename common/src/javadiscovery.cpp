@@ -0,0 +1,435 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: Java 运行时查找与查找结果缓存
+
+**************************************************************************/
+#include "javadiscovery.h"
+#include "jarcache.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+import std;
+
+namespace {
+    using JavaDiscovery::Binary;
+    using JavaDiscovery::Path;
+
+#ifdef _WIN32
+    constexpr auto JAVA_NAME = L"java.exe";
+    constexpr wchar_t PATH_SEPARATOR = L';';
+
+    // 相对 JDK 根目录的 jvm 动态库位置，优先 server 版本
+    const std::array<Path, 2> JVM_PATHS = {Path(L"bin") / L"server" / L"jvm.dll", Path(L"bin") / L"client" / L"jvm.dll"};
+
+    const std::array<Path, 5> SEARCH_ROOTS = {
+        L"C:\\Program Files\\Java", L"C:\\Program Files (x86)\\Java", L"C:\\Program Files\\Eclipse Adoptium",
+        L"C:\\Program Files\\Amazon Corretto", L"C:\\Program Files\\Microsoft\\jdk"
+    };
+#else
+    constexpr auto JAVA_NAME = L"java";
+    constexpr wchar_t PATH_SEPARATOR = L':';
+
+    const std::array<Path, 2> JVM_PATHS = {Path("lib") / "server" / "libjvm.so", Path("lib") / "client" / "libjvm.so"};
+
+    const std::array<Path, 1> SEARCH_ROOTS = {"/usr/lib/jvm"};
+#endif
+
+    std::wstring environment(const wchar_t *name) {
+#ifdef _WIN32
+        const DWORD size = GetEnvironmentVariableW(name, nullptr, 0);
+        if (size == 0) {
+            return {};
+        }
+        std::wstring value(size, L'\0');
+        const DWORD length = GetEnvironmentVariableW(name, value.data(), size);
+        value.resize(length < size ? length : 0);
+        return value;
+#else
+        const std::string narrow(name, name + std::wcslen(name));
+        const char *value = std::getenv(narrow.c_str());
+        return value ? Path(value).wstring() : std::wstring{};
+#endif
+    }
+
+    bool isFile(const Path &path) {
+        std::error_code ec;
+        return std::filesystem::is_regular_file(path, ec);
+    }
+
+    // 在 JDK 根目录下查找指定类型的文件
+    std::optional<Path> inHome(const Path &home, const Binary binary) {
+        if (binary == Binary::Java) {
+            if (auto java = home / L"bin" / JAVA_NAME; isFile(java)) {
+                return java;
+            }
+            return std::nullopt;
+        }
+        for (const auto &relative: JVM_PATHS) {
+            if (auto jvm = home / relative; isFile(jvm)) {
+                return jvm;
+            }
+        }
+        return std::nullopt;
+    }
+
+#if defined(_M_X64) || defined(__x86_64__)
+    constexpr auto HOST_ARCH = L"amd64";
+#elif defined(_M_ARM64) || defined(__aarch64__)
+    constexpr auto HOST_ARCH = L"aarch64";
+#elif defined(_M_IX86) || defined(__i386__)
+    constexpr auto HOST_ARCH = L"x86";
+#else
+    constexpr auto HOST_ARCH = L"";
+#endif
+
+    std::wstring normalizeArch(const std::wstring_view arch) {
+        if (arch == L"x86_64" || arch == L"x64") {
+            return L"amd64";
+        }
+        if (arch == L"i386" || arch == L"i586" || arch == L"i686") {
+            return L"x86";
+        }
+        if (arch == L"arm64") {
+            return L"aarch64";
+        }
+        return std::wstring(arch);
+    }
+
+    // 版本号拆分为数字序列，1.8.0_392 视为 8.0.392
+    std::vector<std::uint32_t> versionParts(std::wstring_view version) {
+        std::vector<std::uint32_t> parts;
+        std::uint32_t value = 0;
+        bool inNumber = false;
+        for (const wchar_t ch: version) {
+            if (ch >= L'0' && ch <= L'9') {
+                value = value * 10 + static_cast<std::uint32_t>(ch - L'0');
+                inNumber = true;
+            } else if (inNumber) {
+                parts.push_back(value);
+                value = 0;
+                inNumber = false;
+            }
+        }
+        if (inNumber) {
+            parts.push_back(value);
+        }
+        if (parts.size() > 1 && parts.front() == 1) {
+            parts.erase(parts.begin());
+        }
+        return parts;
+    }
+
+    // 候选运行时及其来源，来源越小优先级越高
+    struct Candidate {
+        JavaDiscovery::Runtime runtime;
+        int source = 0;
+        std::vector<std::uint32_t> parts;
+    };
+
+    enum Source { JavaHome = 0, SearchPath = 1, InstallRoot = 2 };
+
+    Candidate makeCandidate(const Path &home, Path binary, const int source) {
+        auto runtime = JavaDiscovery::readRelease(home);
+        runtime.binary = std::move(binary);
+        auto parts = versionParts(runtime.version);
+        return {std::move(runtime), source, std::move(parts)};
+    }
+
+    // PATH 中的 bin 目录，java 直接使用，jvm 动态库从其上级目录查找
+    std::vector<Candidate> scanPath(const Binary binary) {
+        std::vector<Candidate> candidates;
+        const std::wstring pathEnv = environment(L"PATH");
+        std::wstring_view rest = pathEnv;
+        while (!rest.empty()) {
+            const auto pos = rest.find(PATH_SEPARATOR);
+            if (const auto dir = rest.substr(0, pos); !dir.empty()) {
+                const Path home = Path(dir).parent_path();
+                if (binary == Binary::Java) {
+                    if (auto java = Path(dir) / JAVA_NAME; isFile(java)) {
+                        candidates.push_back(makeCandidate(home, std::move(java), SearchPath));
+                    }
+                } else if (auto jvm = inHome(home, binary)) {
+                    candidates.push_back(makeCandidate(home, std::move(*jvm), SearchPath));
+                }
+            }
+            if (pos == std::wstring_view::npos) {
+                break;
+            }
+            rest.remove_prefix(pos + 1);
+        }
+        return candidates;
+    }
+
+    std::vector<Candidate> scanRoot(const Path &root, const Binary binary) {
+        std::vector<Candidate> candidates;
+        std::error_code ec;
+        for (const auto &entry: std::filesystem::directory_iterator(root, ec)) {
+            std::error_code entryEc;
+            if (!entry.is_directory(entryEc)) {
+                continue;
+            }
+            if (auto found = inHome(entry.path(), binary)) {
+                candidates.push_back(makeCandidate(entry.path(), std::move(*found), InstallRoot));
+            }
+        }
+        return candidates;
+    }
+
+    // 缓存文件中的一项：键、路径以及写入缓存时目标文件的大小和修改时间
+    struct CacheEntry {
+        std::wstring key;
+        Path path;
+        std::uintmax_t size = 0;
+        std::int64_t mtime = 0;
+    };
+
+    std::optional<std::pair<std::uintmax_t, std::int64_t>> statFile(const Path &path) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        const auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        return std::pair{size, static_cast<std::int64_t>(mtime.time_since_epoch().count())};
+    }
+
+    std::wstring makeKey(const Binary binary, const std::wstring_view javaPath, const std::uint32_t javaVersion) {
+        return std::format(L"{}|{}|{}", binary == Binary::Java ? L"java" : L"jvm", javaVersion, javaPath);
+    }
+
+    // 每行一项：key \t path \t size \t mtime，使用 UTF-8 编码
+    std::vector<CacheEntry> readCache(const Path &cacheFile) {
+        std::vector<CacheEntry> entries;
+        std::ifstream in(cacheFile, std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            std::array<std::string_view, 4> fields;
+            std::string_view rest = line;
+            std::size_t count = 0;
+            for (; count < fields.size(); ++count) {
+                const auto pos = rest.find('\t');
+                fields[count] = rest.substr(0, pos);
+                if (pos == std::string_view::npos) {
+                    ++count;
+                    break;
+                }
+                rest.remove_prefix(pos + 1);
+            }
+            if (count != fields.size()) {
+                continue;
+            }
+            CacheEntry entry;
+            try {
+                entry.key = Path(std::u8string(fields[0].begin(), fields[0].end())).wstring();
+                entry.path = Path(std::u8string(fields[1].begin(), fields[1].end()));
+            } catch (const std::system_error &) {
+                // 缓存文件损坏，不是有效的 UTF-8，跳过该行
+                continue;
+            }
+            if (std::from_chars(fields[2].data(), fields[2].data() + fields[2].size(), entry.size).ec != std::errc{} ||
+                std::from_chars(fields[3].data(), fields[3].data() + fields[3].size(), entry.mtime).ec != std::errc{}) {
+                continue;
+            }
+            entries.push_back(std::move(entry));
+        }
+        return entries;
+    }
+
+    // 先写入临时文件再重命名，并发启动的进程不会读到写了一半的缓存
+    void writeCache(const Path &cacheFile, const std::vector<CacheEntry> &entries) {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheFile.parent_path(), ec);
+
+        std::string content;
+        for (const auto &entry: entries) {
+            const auto key = Path(entry.key).u8string();
+            const auto path = entry.path.u8string();
+            content.append(key.begin(), key.end());
+            content += '\t';
+            content.append(path.begin(), path.end());
+            content += std::format("\t{}\t{}\n", entry.size, entry.mtime);
+        }
+
+        auto tmpPath = cacheFile;
+#ifdef _WIN32
+        tmpPath += std::format(L".{}.tmp", GetCurrentProcessId());
+#else
+        tmpPath += std::format(L".{}.tmp", getpid());
+#endif
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(content.data(), static_cast<std::streamsize>(content.size()));
+            if (!out) {
+                out.close();
+                std::filesystem::remove(tmpPath, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmpPath, cacheFile, ec);
+        if (ec) {
+            std::filesystem::remove(tmpPath, ec);
+        }
+    }
+} // namespace
+
+namespace JavaDiscovery {
+    Path defaultCacheFile() {
+        return JarCache::defaultRoot() / L"jvm-discovery.cache";
+    }
+
+    std::span<const Path> defaultSearchRoots() {
+        return SEARCH_ROOTS;
+    }
+
+    std::uint32_t featureVersion(const std::uint32_t jniVersion) {
+        // JNI_VERSION_1_x 为 0x0001000x，9 及以后为 0x00xx0000
+        const std::uint32_t major = jniVersion >> 16;
+        return major == 1 ? jniVersion & 0xFFFF : major;
+    }
+
+    Runtime readRelease(const Path &home) {
+        Runtime runtime;
+        runtime.home = home;
+        std::ifstream in(home / L"release", std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            // KEY="value"
+            const auto eq = line.find('=');
+            if (eq == std::string::npos) {
+                continue;
+            }
+            const std::string_view key = std::string_view(line).substr(0, eq);
+            std::string_view value = std::string_view(line).substr(eq + 1);
+            while (!value.empty() && (value.back() == '\r' || value.back() == ' ')) {
+                value.remove_suffix(1);
+            }
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+                value = value.substr(1, value.size() - 2);
+            }
+            const auto wide = Path(std::u8string(value.begin(), value.end())).wstring();
+            if (key == "JAVA_VERSION") {
+                runtime.version = wide;
+            } else if (key == "IMPLEMENTOR") {
+                runtime.implementor = wide;
+            } else if (key == "OS_ARCH") {
+                runtime.arch = normalizeArch(wide);
+            }
+        }
+        if (const auto parts = versionParts(runtime.version); !parts.empty()) {
+            runtime.feature = parts.front();
+        }
+        return runtime;
+    }
+
+    std::vector<Runtime> index(const Binary binary, const std::uint32_t javaVersion,
+                               const std::span<const Path> searchRoots) {
+        // 安装目录可能位于网络驱动器或被杀毒软件扫描，各目录并行扫描
+        std::vector<std::future<std::vector<Candidate>>> rootTasks;
+        for (const auto &root: searchRoots) {
+            rootTasks.push_back(std::async(std::launch::async, scanRoot, std::cref(root), binary));
+        }
+
+        std::vector<Candidate> candidates;
+        if (const auto javaHome = environment(L"JAVA_HOME"); !javaHome.empty()) {
+            if (auto found = inHome(javaHome, binary)) {
+                candidates.push_back(makeCandidate(javaHome, std::move(*found), JavaHome));
+            }
+        }
+        std::ranges::move(scanPath(binary), std::back_inserter(candidates));
+        for (auto &task: rootTasks) {
+            std::ranges::move(task.get(), std::back_inserter(candidates));
+        }
+
+        // 排除版本过低的候选；jvm 动态库在进程内加载，架构必须一致
+        const std::uint32_t required = featureVersion(javaVersion);
+        const std::wstring_view hostArch = HOST_ARCH;
+        std::erase_if(candidates, [&](const Candidate &candidate) {
+            const auto &runtime = candidate.runtime;
+            const bool tooOld = javaVersion != 0 && runtime.feature != 0 && runtime.feature < required;
+            const bool wrongArch = binary == Binary::Jvm && !runtime.arch.empty() && !hostArch.empty() &&
+                                   runtime.arch != hostArch;
+            return tooOld || wrongArch;
+        });
+
+        // 同一个文件可能同时来自 JAVA_HOME 和 PATH，只保留优先级最高的一项
+        std::ranges::stable_sort(candidates, {}, &Candidate::source);
+        std::vector<Candidate> unique;
+        for (auto &candidate: candidates) {
+            std::error_code ec;
+            if (std::ranges::none_of(unique, [&](const Candidate &other) {
+                return std::filesystem::equivalent(other.runtime.binary, candidate.runtime.binary, ec);
+            })) {
+                unique.push_back(std::move(candidate));
+            }
+        }
+
+        const auto rank = [&](const Candidate &candidate) {
+            const auto &runtime = candidate.runtime;
+            return std::tuple{runtime.arch.empty() || runtime.arch == hostArch, runtime.feature != 0,
+                              -candidate.source, candidate.parts};
+        };
+        std::ranges::stable_sort(unique, std::greater{}, rank);
+
+        std::vector<Runtime> result;
+        result.reserve(unique.size());
+        for (auto &candidate: unique) {
+            result.push_back(std::move(candidate.runtime));
+        }
+        return result;
+    }
+
+    std::expected<Path, std::wstring> scan(const Binary binary, const std::uint32_t javaVersion,
+                                           const std::span<const Path> searchRoots) {
+        if (auto runtimes = index(binary, javaVersion, searchRoots); !runtimes.empty()) {
+            return std::move(runtimes.front().binary);
+        }
+        if (javaVersion != 0) {
+            return std::unexpected{std::format(L"未找到 Java {} 及以上版本的{}", featureVersion(javaVersion),
+                                               binary == Binary::Java ? L"运行时环境" : L"JVM动态库")};
+        }
+        return std::unexpected{binary == Binary::Java ? L"未找到Java运行时环境" : L"未找到JVM动态库"};
+    }
+
+    std::expected<Path, std::wstring> find(const Binary binary, const std::wstring_view javaPath,
+                                           const std::uint32_t javaVersion, const Path &cacheFile,
+                                           const std::span<const Path> searchRoots) {
+        const auto key = makeKey(binary, javaPath, javaVersion);
+        auto entries = readCache(cacheFile);
+
+        bool dirty = false;
+        if (const auto it = std::ranges::find(entries, key, &CacheEntry::key); it != entries.end()) {
+            // 只对缓存的文件做一次 stat：文件被删除、升级或替换时重新扫描
+            if (const auto stat = statFile(it->path); stat && stat->first == it->size && stat->second == it->mtime) {
+                return it->path;
+            }
+            entries.erase(it);
+            dirty = true;
+        }
+
+        auto result = scan(binary, javaVersion, searchRoots);
+        if (result) {
+            if (const auto stat = statFile(result.value())) {
+                entries.push_back({key, result.value(), stat->first, stat->second});
+                dirty = true;
+            }
+        }
+        if (dirty) {
+            writeCache(cacheFile, entries);
+        }
+        return result;
+    }
+} // namespace JavaDiscovery
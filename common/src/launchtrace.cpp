@@ -0,0 +1,154 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 启动过程追踪，无锁内存缓冲区，退出时输出 Chrome trace JSON
+
+**************************************************************************/
+#include "launchtrace.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+import std;
+
+namespace {
+    using LaunchTrace::Clock;
+
+    struct Event {
+        std::atomic<const char *> name{nullptr}; // 最后写入，非空表示事件已完整
+        std::int64_t start = 0; // 微秒，相对 g_origin
+        std::int64_t duration = 0;
+        std::uint32_t thread = 0;
+    };
+
+    std::atomic<bool> g_enabled{false};
+    std::atomic<std::uint32_t> g_count{0};
+    std::array<Event, LaunchTrace::CAPACITY> g_events;
+    std::filesystem::path g_output;
+    Clock::time_point g_origin = Clock::now();
+
+    std::uint32_t processId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<std::uint32_t>(getpid());
+#endif
+    }
+
+    // 小而稳定的线程编号，首次记录时分配
+    std::uint32_t threadIndex() {
+        static std::atomic<std::uint32_t> next{1};
+        thread_local const std::uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+    void appendEscaped(std::string &out, const std::string_view text) {
+        for (const char c: text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                continue;
+            }
+            out += c;
+        }
+    }
+} // namespace
+
+namespace LaunchTrace {
+    void init() {
+        const char *value = std::getenv(ENV_VAR);
+        if (!value) {
+            return;
+        }
+        const std::string_view setting = value;
+        if (setting.empty() || setting == "1") {
+            std::error_code ec;
+            enable(std::filesystem::temp_directory_path(ec) / std::format("jarpackager-{}.trace.json", processId()));
+        } else {
+            enable(std::filesystem::path(std::u8string(setting.begin(), setting.end())));
+        }
+        std::atexit([] { flush(); });
+    }
+
+    void enable(const std::filesystem::path &output) {
+        g_output = output;
+        g_enabled.store(true, std::memory_order_release);
+    }
+
+    bool enabled() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    void record(const char *name, const Clock::time_point start, const Clock::time_point end) {
+        commit(reserve(), name, start, end);
+    }
+
+    std::uint32_t reserve() {
+        const std::uint32_t slot = g_count.fetch_add(1, std::memory_order_relaxed);
+        return std::min<std::uint32_t>(slot, CAPACITY);
+    }
+
+    void commit(const std::uint32_t slot, const char *name, const Clock::time_point start,
+                const Clock::time_point end) {
+        if (slot >= CAPACITY) {
+            return;
+        }
+        auto &event = g_events[slot];
+        event.start = std::chrono::duration_cast<std::chrono::microseconds>(start - g_origin).count();
+        event.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        event.thread = threadIndex();
+        event.name.store(name, std::memory_order_release);
+    }
+
+    void reset() {
+        g_enabled.store(false, std::memory_order_relaxed);
+        const std::uint32_t count = std::min<std::uint32_t>(g_count.load(std::memory_order_relaxed), CAPACITY);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            g_events[i].name.store(nullptr, std::memory_order_relaxed);
+        }
+        g_count.store(0, std::memory_order_release);
+        g_output.clear();
+    }
+
+    std::string json() {
+        const std::uint32_t count = std::min<std::uint32_t>(g_count.load(std::memory_order_acquire), CAPACITY);
+        const std::uint32_t pid = processId();
+        std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out += std::format(R"({{"name":"process_name","ph":"M","pid":{},"args":{{"name":"launcher"}}}})", pid);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const auto &event = g_events[i];
+            const char *name = event.name.load(std::memory_order_acquire);
+            // 仍在写入的事件
+            if (!name) {
+                continue;
+            }
+            out += ",\n{\"name\":\"";
+            appendEscaped(out, name);
+            out += std::format(R"(","cat":"launcher","ph":"X","ts":{},"dur":{},"pid":{},"tid":{}}})", event.start,
+                               event.duration, pid, event.thread);
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool flush() {
+        if (!enabled() || g_output.empty()) {
+            return false;
+        }
+        const auto content = json();
+        std::ofstream out(g_output, std::ios::binary | std::ios::trunc);
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        return static_cast<bool>(out);
+    }
+} // namespace LaunchTrace
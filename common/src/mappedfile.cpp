@@ -0,0 +1,121 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 只读文件映射
+
+**************************************************************************/
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+import std;
+
+std::expected<MappedFile, std::wstring> MappedFile::open(const Path &path) {
+    MappedFile file;
+#ifdef _WIN32
+    const HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return std::unexpected{L"无法打开文件: " + path.wstring()};
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size)) {
+        CloseHandle(hFile);
+        return std::unexpected{L"无法获取文件大小: " + path.wstring()};
+    }
+    // 空文件无法创建映射，直接返回空视图
+    if (size.QuadPart == 0) {
+        CloseHandle(hFile);
+        return file;
+    }
+
+    const HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hFile);
+    if (!hMapping) {
+        return std::unexpected{L"无法创建文件映射: " + path.wstring()};
+    }
+
+    const LPVOID base = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(hMapping);
+    if (!base) {
+        return std::unexpected{L"无法映射文件视图: " + path.wstring()};
+    }
+    file.m_data = static_cast<const std::uint8_t *>(base);
+    file.m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected{L"无法打开文件: " + path.wstring()};
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return std::unexpected{L"无法获取文件大小: " + path.wstring()};
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        return file;
+    }
+
+    void *base = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return std::unexpected{L"无法映射文件视图: " + path.wstring()};
+    }
+    file.m_data = static_cast<const std::uint8_t *>(base);
+    file.m_size = static_cast<std::size_t>(st.st_size);
+#endif
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+    return *this;
+}
+
+std::span<const std::uint8_t> MappedFile::view(const std::uint64_t offset, const std::uint64_t size) const {
+    if (size > m_size || offset > m_size - size) {
+        return {};
+    }
+    return {m_data + offset, static_cast<std::size_t>(size)};
+}
+
+void MappedFile::close() {
+    if (m_data) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<std::uint8_t *>(m_data), m_size);
+#endif
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -11,6 +11,7 @@ Description:
 **************************************************************************/
 #define UNICODE
 #include "modify.h"
+#include "peresource.h"
 #include <fcntl.h>
 #include <filesystem>
 #include <fstream>
@@ -19,6 +20,7 @@ Description:
 #include <vector>
 #include <format>
 #include <expected>
+#include <optional>
 #include <windows.h>
 
 // 文件映射RAII包装类
@@ -167,54 +169,6 @@ static DWORD getPEActualSize(const std::wstring& path) {
     return peSize;
 }
 
-// 保存文件尾部的附加数据
-static std::vector<BYTE> saveAppendedData(const std::wstring& path) {
-    std::vector<BYTE> appendedData;
-
-    // 获取PE实际大小
-    DWORD peSize = getPEActualSize(path);
-    if (peSize == 0) {
-        return appendedData;
-    }
-
-    // 获取文件总大小
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        return appendedData;
-    }
-
-    size_t totalSize = file.tellg();
-
-    // 如果有附加数据
-    if (totalSize > peSize) {
-        size_t appendedSize = totalSize - peSize;
-        appendedData.resize(appendedSize);
-
-        file.seekg(peSize, std::ios::beg);
-        file.read(reinterpret_cast<char*>(appendedData.data()), appendedSize);
-    }
-
-    file.close();
-    return appendedData;
-}
-
-// 恢复文件尾部的附加数据
-static bool restoreAppendedData(const std::wstring& path, const std::vector<BYTE>& appendedData) {
-    if (appendedData.empty()) {
-        return true;  // 没有需要恢复的数据
-    }
-
-    std::ofstream file(path, std::ios::binary | std::ios::app);
-    if (!file.is_open()) {
-        return false;
-    }
-
-    file.write(reinterpret_cast<const char*>(appendedData.data()), appendedData.size());
-    file.close();
-
-    return true;
-}
-
 static std::string generateManifest(const ExecutionLevel level) {
     const char* levelStr = (level == ExecutionLevel::RequireAdmin)
         ? "requireAdministrator"
@@ -393,72 +347,7 @@ std::expected<bool, std::wstring> PEModifier::setSubsystem(WORD subsystem) {
 }
 
 std::expected<bool, std::wstring> PEModifier::setExecutionLevel(const ExecutionLevel level) const {
-    // 检查文件是否存在
-    DWORD attrs = GetFileAttributesW(filePath.c_str());
-    if (attrs == INVALID_FILE_ATTRIBUTES) {
-        return std::unexpected(L"文件不存在或无法访问");
-    }
-
-    // 重要：先保存附加数据
-    std::vector<BYTE> appendedData = saveAppendedData(filePath);
-    if (!appendedData.empty()) {
-        std::wcout << L"已保存 " << appendedData.size() << L" 字节的附加数据" << std::endl;
-    }
-
-    // 生成清单内容
-    std::string manifestContent = generateManifest(level);
-
-    // 开始更新资源
-    HANDLE hUpdate = BeginUpdateResourceW(filePath.c_str(), FALSE);
-    if (!hUpdate) {
-        DWORD error = GetLastError();
-        std::wstring errorMsg = L"无法开始资源更新，错误代码: " + std::to_wstring(error);
-        return std::unexpected(errorMsg);
-    }
-
-    // 更新清单资源
-    BOOL result = UpdateResourceW(
-        hUpdate,
-        MAKEINTRESOURCEW(24),  // RT_MANIFEST
-        MAKEINTRESOURCEW(1),    // 资源ID
-        MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL),
-        (LPVOID)manifestContent.c_str(),
-        static_cast<DWORD>(manifestContent.size())
-    );
-
-    if (!result) {
-        EndUpdateResourceW(hUpdate, TRUE);  // 取消更新
-        return std::unexpected(L"更新清单资源失败");
-    }
-
-    // 提交资源更新
-    if (!EndUpdateResourceW(hUpdate, FALSE)) {
-        DWORD error = GetLastError();
-        std::wstring errorMsg = L"提交资源更新失败，错误代码: " + std::to_wstring(error);
-        return std::unexpected(errorMsg);
-    }
-
-    // 重要：恢复附加数据
-    if (!appendedData.empty()) {
-        if (restoreAppendedData(filePath, appendedData)) {
-            std::wcout << L"已恢复 " << appendedData.size() << L" 字节的附加数据" << std::endl;
-        } else {
-            std::wcout << L"警告：无法恢复附加数据！" << std::endl;
-            // 可以考虑将附加数据保存到单独的文件
-            std::wstring dataPath = filePath + L".appended_data";
-            std::ofstream dataFile(dataPath, std::ios::binary);
-            if (dataFile.is_open()) {
-                dataFile.write(reinterpret_cast<const char*>(appendedData.data()), appendedData.size());
-                dataFile.close();
-                std::wcout << L"附加数据已保存到: " << dataPath << std::endl;
-            }
-        }
-    }
-
-    // 更新PE文件校验和
-    updateChecksum(filePath);
-
-    return true;
+    return apply(nullptr, level, std::nullopt);
 }
 
 std::expected<ExecutionLevel, std::wstring> PEModifier::getExecutionLevel() const {
@@ -513,141 +402,79 @@ std::expected<ExecutionLevel, std::wstring> PEModifier::getExecutionLevel() cons
     return level;
 }
 
-#pragma pack(push, 2)
-struct ICONDIR {
-    WORD idReserved;
-    WORD idType;
-    WORD idCount;
-};
-struct ICONDIRENTRY {
-    BYTE bWidth;
-    BYTE bHeight;
-    BYTE bColorCount;
-    BYTE bReserved;
-    WORD wPlanes;
-    WORD wBitCount;
-    DWORD dwBytesInRes;
-    DWORD dwImageOffset;
-};
-struct GRPICONDIRENTRY {
-    BYTE bWidth;
-    BYTE bHeight;
-    BYTE bColorCount;
-    BYTE bReserved;
-    WORD wPlanes;
-    WORD wBitCount;
-    DWORD dwBytesInRes;
-    WORD nID;
-};
-#pragma pack(pop)
-
 std::expected<bool, std::wstring> PEModifier::setIcon(const wchar_t* icoFile) const {
-    // 保存附加数据
-    std::vector<BYTE> appendedData = saveAppendedData(filePath);
+    return apply(icoFile, std::nullopt, std::nullopt);
+}
 
-    // 尝试读取原 manifest
-    std::vector<BYTE> originalManifest;
-    {
-        HMODULE hModule = LoadLibraryExW(filePath.c_str(), nullptr, LOAD_LIBRARY_AS_DATAFILE);
-        if (hModule) {
-            HRSRC hRes = FindResourceW(hModule, MAKEINTRESOURCE(1), MAKEINTRESOURCE(24));
-            if (hRes) {
-                HGLOBAL hGlobal = LoadResource(hModule, hRes);
-                if (hGlobal) {
-                    LPVOID pData = LockResource(hGlobal);
-                    DWORD size = SizeofResource(hModule, hRes);
-                    if (pData && size > 0) {
-                        originalManifest.assign((BYTE*)pData, (BYTE*)pData + size);
-                    }
-                }
-            }
-            FreeLibrary(hModule);
+std::expected<bool, std::wstring> PEModifier::apply(const wchar_t* icoFile, const std::optional<ExecutionLevel> level,
+                                                    const std::optional<WORD> subsystem) const {
+    // 读取整个文件，附加数据由 PeResource 原样保留
+    const auto readAll = [](const std::filesystem::path& path) -> std::optional<PeResource::Bytes> {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return std::nullopt;
         }
-    }
-
-    // 读取 ICO 文件
-    std::ifstream ico(icoFile, std::ios::binary);
-    if (!ico) return std::unexpected{std::format(L"无法打开 ICO 文件: {}", icoFile)};
-
-    ICONDIR iconDir{};
-    ico.read(reinterpret_cast<char*>(&iconDir), sizeof(iconDir));
-    if (iconDir.idType != 1 || iconDir.idCount == 0) return std::unexpected{L"ICO 文件格式错误"};
-
-    std::vector<ICONDIRENTRY> entries(iconDir.idCount);
-    ico.read(reinterpret_cast<char*>(entries.data()), iconDir.idCount * sizeof(ICONDIRENTRY));
-
-    // 开始更新资源
-    HANDLE hRes = BeginUpdateResourceW(filePath.c_str(), FALSE);
-    if (!hRes) return std::unexpected{std::format(L"无法打开 EXE: {}", filePath)};
+        PeResource::Bytes data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+            return std::nullopt;
+        }
+        return data;
+    };
 
-    // 写入每个 RT_ICON
-    for (int i = 0; i < iconDir.idCount; i++) {
-        std::vector<char> image(entries[i].dwBytesInRes);
-        ico.seekg(entries[i].dwImageOffset, std::ios::beg);
-        ico.read(image.data(), entries[i].dwBytesInRes);
+    auto fileContent = readAll(filePath);
+    if (!fileContent) {
+        return std::unexpected{L"无法读取文件: " + filePath};
+    }
+    auto image = PeResource::Image::parse(std::move(*fileContent));
+    if (!image) {
+        return std::unexpected{image.error()};
+    }
 
-        if (!UpdateResourceW(hRes, RT_ICON, MAKEINTRESOURCE(i + 1),
-                             MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL),
-                             image.data(), entries[i].dwBytesInRes)) {
-            EndUpdateResourceW(hRes, TRUE);
-            return std::unexpected{L"写入 RT_ICON 失败"};
+    if (icoFile) {
+        const auto ico = readAll(icoFile);
+        if (!ico) {
+            return std::unexpected{std::format(L"无法打开 ICO 文件: {}", icoFile)};
+        }
+        if (auto res = image->setIcon(*ico); !res) {
+            return std::unexpected{res.error()};
         }
     }
 
-    // 构造 RT_GROUP_ICON
-    struct {
-        ICONDIR dir{};
-        std::vector<GRPICONDIRENTRY> entries;
-    } grp;
-    grp.dir.idReserved = 0;
-    grp.dir.idType = 1;
-    grp.dir.idCount = iconDir.idCount;
-    grp.entries.resize(iconDir.idCount);
-
-    for (int i = 0; i < iconDir.idCount; i++) {
-        grp.entries[i].bWidth = entries[i].bWidth;
-        grp.entries[i].bHeight = entries[i].bHeight;
-        grp.entries[i].bColorCount = entries[i].bColorCount;
-        grp.entries[i].bReserved = entries[i].bReserved;
-        grp.entries[i].wPlanes = entries[i].wPlanes;
-        grp.entries[i].wBitCount = entries[i].wBitCount;
-        grp.entries[i].dwBytesInRes = entries[i].dwBytesInRes;
-        grp.entries[i].nID = i + 1;
-    }
-
-    size_t grpSize = sizeof(ICONDIR) + grp.entries.size() * sizeof(GRPICONDIRENTRY);
-    std::vector<BYTE> grpData(grpSize);
-    memcpy(grpData.data(), &grp.dir, sizeof(ICONDIR));
-    memcpy(grpData.data() + sizeof(ICONDIR), grp.entries.data(), grp.entries.size() * sizeof(GRPICONDIRENTRY));
-
-    if (!UpdateResourceW(hRes, RT_GROUP_ICON, MAKEINTRESOURCE(1),
-                         MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL),
-                         grpData.data(), grpSize)) {
-        EndUpdateResourceW(hRes, TRUE);
-        return std::unexpected{L"写入 RT_GROUP_ICON 失败"};
-    }
-
-    // 恢复原 manifest
-    if (!originalManifest.empty()) {
-        if (!UpdateResourceW(hRes, RT_MANIFEST, MAKEINTRESOURCE(1),
-                             MAKELANGID(LANG_NEUTRAL, SUBLANG_NEUTRAL),
-                             originalManifest.data(), static_cast<DWORD>(originalManifest.size()))) {
-            EndUpdateResourceW(hRes, TRUE);
-            return std::unexpected{L"恢复原 manifest 失败"};
+    // 执行级别与当前清单一致时保留原清单
+    if (level) {
+        const auto manifest = image->manifest();
+        const bool requireAdmin = manifest && manifest->find("requireAdministrator") != std::string_view::npos;
+        if (!manifest || requireAdmin != (*level == ExecutionLevel::RequireAdmin)) {
+            image->setManifest(generateManifest(*level));
         }
     }
 
-    if (!EndUpdateResourceW(hRes, FALSE)) {
-        return std::unexpected{L"提交资源更新失败"};
+    if (subsystem) {
+        image->setSubsystem(*subsystem);
     }
 
-    // 恢复尾部附加数据
-    if (!restoreAppendedData(filePath, appendedData)) {
-        std::wcout << L"警告：无法恢复附加数据！" << std::endl;
+    // 重建资源节，节表、可选头和校验和一并更新
+    const auto output = image->build();
+    if (!output) {
+        return std::unexpected{output.error()};
     }
 
-    // 更新校验和
-    updateChecksum(filePath);
+    // 先写入临时文件再替换，失败时原文件不受影响
+    const std::filesystem::path tempPath = filePath + L".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(output->data()), static_cast<std::streamsize>(output->size()));
+        file.close();
+        if (!file) {
+            DeleteFileW(tempPath.c_str());
+            return std::unexpected{L"写入文件失败: " + tempPath.wstring()};
+        }
+    }
+    if (!MoveFileExW(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(tempPath.c_str());
+        return std::unexpected{L"替换文件失败: " + filePath};
+    }
 
     return true;
 }
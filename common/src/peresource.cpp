@@ -0,0 +1,678 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: PE 资源编辑，在内存中解析并重建资源节
+
+**************************************************************************/
+#include "peresource.h"
+
+import std;
+
+namespace {
+    constexpr std::uint16_t DOS_SIGNATURE = 0x5A4D; // "MZ"
+    constexpr std::uint32_t NT_SIGNATURE = 0x00004550; // "PE\0\0"
+    constexpr std::uint16_t PE32_MAGIC = 0x10B;
+    constexpr std::uint16_t PE32_PLUS_MAGIC = 0x20B;
+    constexpr std::size_t DOS_LFANEW = 0x3C;
+    constexpr std::size_t FILE_HEADER_SIZE = 20;
+    constexpr std::size_t SECTION_HEADER_SIZE = 40;
+    constexpr std::uint32_t SCN_CNT_INITIALIZED_DATA = 0x00000040;
+
+    // 可选头字段偏移，PE32 与 PE32+ 相同
+    constexpr std::size_t OPT_SIZE_OF_INITIALIZED_DATA = 8;
+    constexpr std::size_t OPT_SECTION_ALIGNMENT = 32;
+    constexpr std::size_t OPT_FILE_ALIGNMENT = 36;
+    constexpr std::size_t OPT_SIZE_OF_IMAGE = 56;
+    constexpr std::size_t OPT_SIZE_OF_HEADERS = 60;
+    constexpr std::size_t OPT_CHECKSUM = 64;
+    constexpr std::size_t OPT_SUBSYSTEM = 68;
+
+    // NumberOfRvaAndSizes 和数据目录的偏移，PE32 与 PE32+ 不同
+    constexpr std::size_t PE32_DIRECTORY_COUNT = 92;
+    constexpr std::size_t PE32_PLUS_DIRECTORY_COUNT = 108;
+
+    // 数据目录下标
+    constexpr std::uint32_t DIR_SECURITY = 4;
+    constexpr std::uint32_t DIR_RESOURCE = 2;
+    constexpr std::uint32_t DIR_BASERELOC = 5;
+    constexpr std::uint32_t DIR_DEBUG = 6;
+
+    constexpr std::size_t RES_DIRECTORY_SIZE = 16;
+    constexpr std::size_t RES_ENTRY_SIZE = 8;
+    constexpr std::size_t RES_DATA_ENTRY_SIZE = 16;
+    constexpr std::uint32_t RES_HIGH_BIT = 0x80000000;
+    constexpr std::size_t RES_DATA_ALIGNMENT = 8;
+
+    constexpr std::size_t DEBUG_DIRECTORY_SIZE = 28;
+
+    // ICO 文件的 ICONDIR/ICONDIRENTRY 与资源中的 GRPICONDIRENTRY
+    constexpr std::size_t ICON_DIR_SIZE = 6;
+    constexpr std::size_t ICON_ENTRY_SIZE = 16;
+    constexpr std::size_t GROUP_ICON_ENTRY_SIZE = 14;
+    constexpr std::size_t ICON_ENTRY_COMMON_SIZE = 12; // 两种目录项相同的前缀，到 dwBytesInRes 为止
+
+    template<typename T>
+    T read(const std::span<const std::uint8_t> data, const std::size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    void write(const std::span<std::uint8_t> data, const std::size_t offset, const T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    bool inRange(const std::uint64_t size, const std::uint64_t offset, const std::uint64_t length) {
+        return length <= size && offset <= size - length;
+    }
+
+    std::uint64_t alignUp(const std::uint64_t value, const std::uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    struct Directory {
+        std::uint32_t rva = 0;
+        std::uint32_t size = 0;
+    };
+
+    using Entries = std::vector<std::pair<PeResource::Id, std::uint32_t>>;
+
+    // 读取一级资源目录的全部目录项：标识和指向下一级的偏移
+    std::expected<Entries, std::wstring> readDirectory(const std::span<const std::uint8_t> rsrc,
+                                                       const std::uint32_t offset) {
+        if (!inRange(rsrc.size(), offset, RES_DIRECTORY_SIZE)) {
+            return std::unexpected{L"资源目录超出范围"};
+        }
+        const std::size_t count = read<std::uint16_t>(rsrc, offset + 12) + read<std::uint16_t>(rsrc, offset + 14);
+        if (!inRange(rsrc.size(), offset + RES_DIRECTORY_SIZE, count * RES_ENTRY_SIZE)) {
+            return std::unexpected{L"资源目录超出范围"};
+        }
+
+        Entries entries;
+        entries.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::size_t entryOffset = offset + RES_DIRECTORY_SIZE + i * RES_ENTRY_SIZE;
+            const auto nameField = read<std::uint32_t>(rsrc, entryOffset);
+            const auto target = read<std::uint32_t>(rsrc, entryOffset + 4);
+            if (!(nameField & RES_HIGH_BIT)) {
+                entries.emplace_back(PeResource::Id(static_cast<std::uint16_t>(nameField)), target);
+                continue;
+            }
+
+            // 名称：uint16 长度 + UTF-16 字符
+            const std::uint32_t nameOffset = nameField & ~RES_HIGH_BIT;
+            if (!inRange(rsrc.size(), nameOffset, sizeof(std::uint16_t))) {
+                return std::unexpected{L"资源名称超出范围"};
+            }
+            const auto length = read<std::uint16_t>(rsrc, nameOffset);
+            if (!inRange(rsrc.size(), nameOffset + sizeof(std::uint16_t), length * sizeof(char16_t))) {
+                return std::unexpected{L"资源名称超出范围"};
+            }
+            std::u16string name(length, u'\0');
+            std::memcpy(name.data(), rsrc.data() + nameOffset + sizeof(std::uint16_t), length * sizeof(char16_t));
+            entries.emplace_back(PeResource::Id(std::move(name)), target);
+        }
+        return entries;
+    }
+} // namespace
+
+namespace PeResource {
+    bool Id::operator<(const Id &other) const {
+        if (isName() != other.isName()) {
+            return isName();
+        }
+        return isName() ? name < other.name : id < other.id;
+    }
+
+    std::expected<Image, std::wstring> Image::parse(Bytes file) {
+        Image image;
+        image.m_file = std::move(file);
+        const std::span<const std::uint8_t> data = image.m_file;
+
+        if (!inRange(data.size(), 0, DOS_LFANEW + sizeof(std::uint32_t)) ||
+            read<std::uint16_t>(data, 0) != DOS_SIGNATURE) {
+            return std::unexpected{L"不是有效的PE文件：DOS签名错误"};
+        }
+        const auto peOffset = read<std::uint32_t>(data, DOS_LFANEW);
+        if (!inRange(data.size(), peOffset, sizeof(std::uint32_t) + FILE_HEADER_SIZE) ||
+            read<std::uint32_t>(data, peOffset) != NT_SIGNATURE) {
+            return std::unexpected{L"不是有效的PE文件：NT签名错误"};
+        }
+
+        const std::size_t fileHeader = peOffset + sizeof(std::uint32_t);
+        const auto sectionCount = read<std::uint16_t>(data, fileHeader + 2);
+        const auto optionalHeaderSize = read<std::uint16_t>(data, fileHeader + 16);
+        const std::size_t opt = fileHeader + FILE_HEADER_SIZE;
+        image.m_optionalHeaderOffset = opt;
+        if (!inRange(data.size(), opt, optionalHeaderSize) || optionalHeaderSize < OPT_SUBSYSTEM + 2) {
+            return std::unexpected{L"PE可选头无效"};
+        }
+
+        std::size_t directoryCountOffset;
+        switch (read<std::uint16_t>(data, opt)) {
+            case PE32_MAGIC:
+                directoryCountOffset = PE32_DIRECTORY_COUNT;
+                break;
+            case PE32_PLUS_MAGIC:
+                directoryCountOffset = PE32_PLUS_DIRECTORY_COUNT;
+                break;
+            default:
+                return std::unexpected{L"不支持的PE格式"};
+        }
+        const std::size_t directoryOffset = directoryCountOffset + sizeof(std::uint32_t);
+        if (optionalHeaderSize < directoryOffset) {
+            return std::unexpected{L"PE可选头无效"};
+        }
+        image.m_dataDirectoryOffset = opt + directoryOffset;
+        image.m_dataDirectoryCount = std::min<std::uint32_t>(read<std::uint32_t>(data, opt + directoryCountOffset),
+                                                             (optionalHeaderSize - directoryOffset) / 8);
+        image.m_sectionAlignment = read<std::uint32_t>(data, opt + OPT_SECTION_ALIGNMENT);
+        image.m_fileAlignment = read<std::uint32_t>(data, opt + OPT_FILE_ALIGNMENT);
+        image.m_subsystem = read<std::uint16_t>(data, opt + OPT_SUBSYSTEM);
+        if (image.m_sectionAlignment == 0 || image.m_fileAlignment == 0) {
+            return std::unexpected{L"PE对齐值无效"};
+        }
+
+        const std::size_t sectionTable = opt + optionalHeaderSize;
+        if (!inRange(data.size(), sectionTable, sectionCount * SECTION_HEADER_SIZE)) {
+            return std::unexpected{L"节表超出文件范围"};
+        }
+
+        // 附加数据从最后一个节的数据之后开始
+        std::uint64_t imageEnd = read<std::uint32_t>(data, opt + OPT_SIZE_OF_HEADERS);
+        for (std::size_t i = 0; i < sectionCount; ++i) {
+            const std::size_t header = sectionTable + i * SECTION_HEADER_SIZE;
+            const Section section{
+                .headerOffset = header,
+                .virtualSize = read<std::uint32_t>(data, header + 8),
+                .virtualAddress = read<std::uint32_t>(data, header + 12),
+                .rawSize = read<std::uint32_t>(data, header + 16),
+                .rawOffset = read<std::uint32_t>(data, header + 20),
+                .characteristics = read<std::uint32_t>(data, header + 36),
+            };
+            if (section.rawSize > 0) {
+                if (!inRange(data.size(), section.rawOffset, section.rawSize)) {
+                    return std::unexpected{L"节数据超出文件范围"};
+                }
+                imageEnd = std::max<std::uint64_t>(imageEnd, section.rawOffset + section.rawSize);
+            }
+            image.m_sections.push_back(section);
+        }
+        image.m_overlayOffset = std::min<std::uint64_t>(imageEnd, data.size());
+
+        if (auto result = image.parseResources(); !result) {
+            return std::unexpected{result.error()};
+        }
+        return image;
+    }
+
+    std::uint16_t Image::subsystem() const {
+        return m_subsystem;
+    }
+
+    void Image::setSubsystem(const std::uint16_t subsystem) {
+        m_subsystem = subsystem;
+    }
+
+    const Resource *Image::find(const Id &type, const Id &name, const std::optional<std::uint16_t> language) const {
+        const auto it = std::ranges::find_if(m_resources, [&](const Resource &resource) {
+            return resource.type == type && resource.name == name && (!language || resource.language == *language);
+        });
+        return it == m_resources.end() ? nullptr : &*it;
+    }
+
+    void Image::set(const Id &type, const Id &name, Bytes data, const std::uint16_t language) {
+        bool replaced = false;
+        for (auto &resource: m_resources) {
+            if (resource.type == type && resource.name == name) {
+                resource.data = data;
+                replaced = true;
+            }
+        }
+        if (!replaced) {
+            m_resources.push_back({.type = type, .name = name, .language = language, .data = std::move(data)});
+        }
+    }
+
+    void Image::remove(const Id &type, const Id &name) {
+        std::erase_if(m_resources, [&](const Resource &resource) {
+            return resource.type == type && resource.name == name;
+        });
+    }
+
+    std::optional<std::string_view> Image::manifest() const {
+        const Resource *resource = find(TYPE_MANIFEST, 1);
+        if (!resource) {
+            return std::nullopt;
+        }
+        return std::string_view{reinterpret_cast<const char *>(resource->data.data()), resource->data.size()};
+    }
+
+    void Image::setManifest(const std::string_view manifest) {
+        set(TYPE_MANIFEST, 1, Bytes(manifest.begin(), manifest.end()));
+    }
+
+    std::expected<void, std::wstring> Image::setIcon(const std::span<const std::uint8_t> ico) {
+        if (ico.size() < ICON_DIR_SIZE || read<std::uint16_t>(ico, 2) != 1) {
+            return std::unexpected{L"ICO 文件格式错误"};
+        }
+        const auto count = read<std::uint16_t>(ico, 4);
+        if (count == 0 || !inRange(ico.size(), ICON_DIR_SIZE, count * ICON_ENTRY_SIZE)) {
+            return std::unexpected{L"ICO 文件格式错误"};
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::size_t entry = ICON_DIR_SIZE + i * ICON_ENTRY_SIZE;
+            if (!inRange(ico.size(), read<std::uint32_t>(ico, entry + 12), read<std::uint32_t>(ico, entry + 8))) {
+                return std::unexpected{L"ICO 文件格式错误"};
+            }
+        }
+
+        // 资源按目录顺序解析，第一个图标组即程序图标；删除它及其引用的图标
+        Id groupName = 1;
+        std::uint16_t language = 0;
+        if (const auto group = std::ranges::find(m_resources, Id(TYPE_GROUP_ICON), &Resource::type);
+            group != m_resources.end()) {
+            groupName = group->name;
+            language = group->language;
+            const std::span<const std::uint8_t> groupData = group->data;
+            if (groupData.size() >= ICON_DIR_SIZE) {
+                const std::size_t oldCount = std::min<std::size_t>(
+                    read<std::uint16_t>(groupData, 4), (groupData.size() - ICON_DIR_SIZE) / GROUP_ICON_ENTRY_SIZE);
+                std::vector<std::uint16_t> iconIds;
+                for (std::size_t i = 0; i < oldCount; ++i) {
+                    iconIds.push_back(read<std::uint16_t>(groupData, ICON_DIR_SIZE + i * GROUP_ICON_ENTRY_SIZE + 12));
+                }
+                for (const auto iconId: iconIds) {
+                    remove(TYPE_ICON, iconId);
+                }
+            }
+            remove(TYPE_GROUP_ICON, groupName);
+        }
+
+        // 新图标使用未被占用的最小 ID
+        std::set<std::uint16_t> usedIds;
+        for (const auto &resource: m_resources) {
+            if (resource.type == Id(TYPE_ICON) && !resource.name.isName()) {
+                usedIds.insert(resource.name.id);
+            }
+        }
+
+        Bytes groupData(ICON_DIR_SIZE + count * GROUP_ICON_ENTRY_SIZE);
+        write<std::uint16_t>(groupData, 0, 0);
+        write<std::uint16_t>(groupData, 2, 1);
+        write<std::uint16_t>(groupData, 4, count);
+        std::uint16_t nextId = 1;
+        for (std::size_t i = 0; i < count; ++i) {
+            while (usedIds.contains(nextId)) {
+                ++nextId;
+            }
+            usedIds.insert(nextId);
+
+            const std::size_t entry = ICON_DIR_SIZE + i * ICON_ENTRY_SIZE;
+            const auto size = read<std::uint32_t>(ico, entry + 8);
+            const auto offset = read<std::uint32_t>(ico, entry + 12);
+            m_resources.push_back({
+                .type = TYPE_ICON, .name = nextId, .language = language,
+                .data = Bytes(ico.begin() + offset, ico.begin() + offset + size)
+            });
+
+            const std::size_t groupEntry = ICON_DIR_SIZE + i * GROUP_ICON_ENTRY_SIZE;
+            std::memcpy(groupData.data() + groupEntry, ico.data() + entry, ICON_ENTRY_COMMON_SIZE);
+            write<std::uint16_t>(groupData, groupEntry + ICON_ENTRY_COMMON_SIZE, nextId);
+        }
+        m_resources.push_back({
+            .type = TYPE_GROUP_ICON, .name = groupName, .language = language, .data = std::move(groupData)
+        });
+        return {};
+    }
+
+    std::expected<Bytes, std::wstring> Image::build() const {
+        const std::span<const std::uint8_t> source = m_file;
+        const auto directory = [&](const std::uint32_t index) {
+            Directory result;
+            if (index < m_dataDirectoryCount) {
+                result.rva = read<std::uint32_t>(source, m_dataDirectoryOffset + index * 8);
+                result.size = read<std::uint32_t>(source, m_dataDirectoryOffset + index * 8 + 4);
+            }
+            return result;
+        };
+        const std::size_t opt = m_optionalHeaderOffset;
+
+        // 没有资源节时只能修改头部
+        if (!m_resourceSection) {
+            if (!m_resources.empty()) {
+                return std::unexpected{L"文件没有资源节，无法写入资源"};
+            }
+            Bytes output = m_file;
+            write<std::uint16_t>(output, opt + OPT_SUBSYSTEM, m_subsystem);
+            write<std::uint32_t>(output, opt + OPT_CHECKSUM, checksum(output, opt + OPT_CHECKSUM));
+            return output;
+        }
+
+        const Section &rsrc = m_sections[*m_resourceSection];
+        const std::uint64_t rawEnd = static_cast<std::uint64_t>(rsrc.rawOffset) + rsrc.rawSize;
+        const auto virtualEnd = [&](const Section &section) {
+            return alignUp(static_cast<std::uint64_t>(section.virtualAddress) +
+                           (section.virtualSize ? section.virtualSize : section.rawSize), m_sectionAlignment);
+        };
+
+        // 资源节之后的节整体后移，只有基址重定位节可以移动：其内容不含指向自身的地址
+        const Directory baseReloc = directory(DIR_BASERELOC);
+        for (std::size_t i = 0; i < m_sections.size(); ++i) {
+            const Section &section = m_sections[i];
+            if (i == *m_resourceSection) {
+                continue;
+            }
+            if (section.virtualAddress > rsrc.virtualAddress) {
+                for (std::uint32_t index = 0; index < m_dataDirectoryCount; ++index) {
+                    const Directory dir = directory(index);
+                    if (index != DIR_SECURITY && dir.size > 0 && sectionOf(dir.rva) == i && index != DIR_BASERELOC) {
+                        return std::unexpected{L"资源节之后存在无法移动的节"};
+                    }
+                }
+                if (baseReloc.size == 0 || sectionOf(baseReloc.rva) != i) {
+                    return std::unexpected{L"资源节之后存在无法移动的节"};
+                }
+                if (section.rawSize > 0 && section.rawOffset < rawEnd) {
+                    return std::unexpected{L"节数据顺序与地址顺序不一致"};
+                }
+            } else if (section.rawSize > 0 && section.rawOffset + section.rawSize > rsrc.rawOffset) {
+                return std::unexpected{L"节数据顺序与地址顺序不一致"};
+            }
+        }
+
+        const Bytes resourceData = serializeResources(rsrc.virtualAddress);
+        if (resourceData.size() > std::numeric_limits<std::uint32_t>::max() / 2) {
+            return std::unexpected{L"资源数据过大"};
+        }
+        const auto newRawSize = static_cast<std::uint32_t>(alignUp(resourceData.size(), m_fileAlignment));
+        const std::int64_t rawDelta = static_cast<std::int64_t>(newRawSize) - rsrc.rawSize;
+        const std::int64_t virtualDelta =
+                static_cast<std::int64_t>(alignUp(rsrc.virtualAddress + resourceData.size(), m_sectionAlignment)) -
+                static_cast<std::int64_t>(virtualEnd(rsrc));
+        const auto shiftOffset = [&](const std::uint32_t offset) {
+            return offset >= rawEnd ? static_cast<std::uint32_t>(offset + rawDelta) : offset;
+        };
+        const auto shiftRva = [&](const std::uint32_t rva) {
+            const auto index = sectionOf(rva);
+            return index && m_sections[*index].virtualAddress > rsrc.virtualAddress
+                       ? static_cast<std::uint32_t>(rva + virtualDelta)
+                       : rva;
+        };
+
+        // 新文件：资源节之前的内容 + 新资源节 + 其后的节和附加数据
+        Bytes output;
+        output.reserve(static_cast<std::size_t>(static_cast<std::int64_t>(m_file.size()) + std::max<std::int64_t>(
+                                                    rawDelta, 0)));
+        output.insert(output.end(), m_file.begin(), m_file.begin() + rsrc.rawOffset);
+        output.insert(output.end(), resourceData.begin(), resourceData.end());
+        output.resize(static_cast<std::size_t>(rsrc.rawOffset) + newRawSize, 0);
+        output.insert(output.end(), m_file.begin() + static_cast<std::ptrdiff_t>(rawEnd), m_file.end());
+
+        // 节表
+        std::uint64_t sizeOfImage = 0;
+        for (std::size_t i = 0; i < m_sections.size(); ++i) {
+            Section section = m_sections[i];
+            if (i == *m_resourceSection) {
+                section.virtualSize = static_cast<std::uint32_t>(resourceData.size());
+                section.rawSize = newRawSize;
+            } else if (section.virtualAddress > rsrc.virtualAddress) {
+                section.virtualAddress = static_cast<std::uint32_t>(section.virtualAddress + virtualDelta);
+                if (section.rawSize > 0) {
+                    section.rawOffset = shiftOffset(section.rawOffset);
+                }
+            }
+            write<std::uint32_t>(output, section.headerOffset + 8, section.virtualSize);
+            write<std::uint32_t>(output, section.headerOffset + 12, section.virtualAddress);
+            write<std::uint32_t>(output, section.headerOffset + 16, section.rawSize);
+            write<std::uint32_t>(output, section.headerOffset + 20, section.rawOffset);
+            sizeOfImage = std::max(sizeOfImage, virtualEnd(section));
+        }
+
+        // 数据目录：资源目录、移动后的重定位目录、证书的文件偏移
+        const auto writeDirectory = [&](const std::uint32_t index, const Directory dir) {
+            if (index < m_dataDirectoryCount) {
+                write<std::uint32_t>(output, m_dataDirectoryOffset + index * 8, dir.rva);
+                write<std::uint32_t>(output, m_dataDirectoryOffset + index * 8 + 4, dir.size);
+            }
+        };
+        writeDirectory(DIR_RESOURCE, {rsrc.virtualAddress, static_cast<std::uint32_t>(resourceData.size())});
+        if (baseReloc.size > 0) {
+            writeDirectory(DIR_BASERELOC, {shiftRva(baseReloc.rva), baseReloc.size});
+        }
+        if (const Directory security = directory(DIR_SECURITY); security.size > 0) {
+            writeDirectory(DIR_SECURITY, {shiftOffset(security.rva), security.size});
+        }
+
+        // 调试目录中的数据位置
+        if (const Directory debug = directory(DIR_DEBUG); debug.size > 0) {
+            if (const auto debugOffset = rvaToOffset(debug.rva);
+                debugOffset && inRange(m_file.size(), *debugOffset, debug.size)) {
+                const std::uint32_t offset = shiftOffset(*debugOffset);
+                for (std::size_t entry = 0; entry + DEBUG_DIRECTORY_SIZE <= debug.size; entry += DEBUG_DIRECTORY_SIZE) {
+                    const std::size_t at = offset + entry;
+                    if (const auto address = read<std::uint32_t>(output, at + 20); address != 0) {
+                        write<std::uint32_t>(output, at + 20, shiftRva(address));
+                    }
+                    if (const auto pointer = read<std::uint32_t>(output, at + 24); pointer != 0) {
+                        write<std::uint32_t>(output, at + 24, shiftOffset(pointer));
+                    }
+                }
+            }
+        }
+
+        // 可选头
+        write<std::uint32_t>(output, opt + OPT_SIZE_OF_IMAGE, static_cast<std::uint32_t>(sizeOfImage));
+        if (rsrc.characteristics & SCN_CNT_INITIALIZED_DATA) {
+            const std::int64_t initializedData = read<std::uint32_t>(output, opt + OPT_SIZE_OF_INITIALIZED_DATA);
+            write<std::uint32_t>(output, opt + OPT_SIZE_OF_INITIALIZED_DATA,
+                                 static_cast<std::uint32_t>(std::max<std::int64_t>(initializedData + rawDelta, 0)));
+        }
+        write<std::uint16_t>(output, opt + OPT_SUBSYSTEM, m_subsystem);
+        write<std::uint32_t>(output, opt + OPT_CHECKSUM, checksum(output, opt + OPT_CHECKSUM));
+        return output;
+    }
+
+    std::optional<std::size_t> Image::sectionOf(const std::uint32_t rva) const {
+        for (std::size_t i = 0; i < m_sections.size(); ++i) {
+            const Section &section = m_sections[i];
+            const std::uint32_t size = std::max(section.virtualSize, section.rawSize);
+            if (rva >= section.virtualAddress && rva - section.virtualAddress < size) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::uint32_t> Image::rvaToOffset(const std::uint32_t rva) const {
+        const auto index = sectionOf(rva);
+        if (!index || rva - m_sections[*index].virtualAddress >= m_sections[*index].rawSize) {
+            return std::nullopt;
+        }
+        return m_sections[*index].rawOffset + (rva - m_sections[*index].virtualAddress);
+    }
+
+    std::expected<void, std::wstring> Image::parseResources() {
+        if (DIR_RESOURCE >= m_dataDirectoryCount) {
+            return {};
+        }
+        const std::span<const std::uint8_t> data = m_file;
+        const auto rva = read<std::uint32_t>(data, m_dataDirectoryOffset + DIR_RESOURCE * 8);
+        const auto size = read<std::uint32_t>(data, m_dataDirectoryOffset + DIR_RESOURCE * 8 + 4);
+        if (rva == 0 || size == 0) {
+            return {};
+        }
+
+        // 重建时替换整个节，资源目录必须独占所在的节
+        m_resourceSection = sectionOf(rva);
+        if (!m_resourceSection || m_sections[*m_resourceSection].virtualAddress != rva) {
+            return std::unexpected{L"资源目录不在资源节的起始位置"};
+        }
+        for (std::uint32_t index = 0; index < m_dataDirectoryCount; ++index) {
+            const auto otherRva = read<std::uint32_t>(data, m_dataDirectoryOffset + index * 8);
+            const auto otherSize = read<std::uint32_t>(data, m_dataDirectoryOffset + index * 8 + 4);
+            if (index != DIR_RESOURCE && index != DIR_SECURITY && otherSize > 0 &&
+                sectionOf(otherRva) == m_resourceSection) {
+                return std::unexpected{L"资源节中包含其他数据目录"};
+            }
+        }
+        const Section &section = m_sections[*m_resourceSection];
+        const auto rsrc = data.subspan(section.rawOffset, section.rawSize);
+
+        // 固定三级：类型、名称、语言
+        const auto types = readDirectory(rsrc, 0);
+        if (!types) {
+            return std::unexpected{types.error()};
+        }
+        for (const auto &[type, typeTarget]: *types) {
+            if (!(typeTarget & RES_HIGH_BIT)) {
+                return std::unexpected{L"资源目录层级无效"};
+            }
+            const auto names = readDirectory(rsrc, typeTarget & ~RES_HIGH_BIT);
+            if (!names) {
+                return std::unexpected{names.error()};
+            }
+            for (const auto &[name, nameTarget]: *names) {
+                if (!(nameTarget & RES_HIGH_BIT)) {
+                    return std::unexpected{L"资源目录层级无效"};
+                }
+                const auto languages = readDirectory(rsrc, nameTarget & ~RES_HIGH_BIT);
+                if (!languages) {
+                    return std::unexpected{languages.error()};
+                }
+                for (const auto &[language, dataTarget]: *languages) {
+                    if ((dataTarget & RES_HIGH_BIT) || language.isName() ||
+                        !inRange(rsrc.size(), dataTarget, RES_DATA_ENTRY_SIZE)) {
+                        return std::unexpected{L"资源目录层级无效"};
+                    }
+                    const auto dataRva = read<std::uint32_t>(rsrc, dataTarget);
+                    const auto dataSize = read<std::uint32_t>(rsrc, dataTarget + 4);
+                    const auto offset = dataSize > 0 ? rvaToOffset(dataRva) : std::optional<std::uint32_t>{0};
+                    if (!offset || !inRange(m_file.size(), *offset, dataSize)) {
+                        return std::unexpected{L"资源数据超出文件范围"};
+                    }
+                    m_resources.push_back({
+                        .type = type, .name = name, .language = language.id,
+                        .codePage = read<std::uint32_t>(rsrc, dataTarget + 8),
+                        .data = Bytes(m_file.begin() + *offset, m_file.begin() + *offset + dataSize),
+                    });
+                }
+            }
+        }
+        return {};
+    }
+
+    Bytes Image::serializeResources(const std::uint32_t baseRva) const {
+        using Languages = std::map<std::uint16_t, const Resource *>;
+        using Names = std::map<Id, Languages>;
+        std::map<Id, Names> tree;
+        for (const auto &resource: m_resources) {
+            tree[resource.type][resource.name][resource.language] = &resource;
+        }
+        const auto namedCount = [](const auto &entries) {
+            return static_cast<std::uint16_t>(std::ranges::count_if(entries, [](const auto &entry) {
+                return entry.first.isName();
+            }));
+        };
+
+        // 布局：各级目录按层排列，之后是数据项、名称字符串和按 8 字节对齐的资源数据
+        std::size_t size = RES_DIRECTORY_SIZE + tree.size() * RES_ENTRY_SIZE;
+        std::size_t typeCursor = size;
+        for (const auto &names: tree | std::views::values) {
+            size += RES_DIRECTORY_SIZE + names.size() * RES_ENTRY_SIZE;
+        }
+        std::size_t nameCursor = size;
+        std::size_t leafCount = 0;
+        for (const auto &names: tree | std::views::values) {
+            for (const auto &languages: names | std::views::values) {
+                size += RES_DIRECTORY_SIZE + languages.size() * RES_ENTRY_SIZE;
+                leafCount += languages.size();
+            }
+        }
+        std::size_t entryCursor = size;
+        size += leafCount * RES_DATA_ENTRY_SIZE;
+        std::size_t stringCursor = size;
+        for (const auto &[type, names]: tree) {
+            size += type.isName() ? sizeof(std::uint16_t) + type.name.size() * sizeof(char16_t) : 0;
+            for (const auto &name: names | std::views::keys) {
+                size += name.isName() ? sizeof(std::uint16_t) + name.name.size() * sizeof(char16_t) : 0;
+            }
+        }
+        size = alignUp(size, RES_DATA_ALIGNMENT);
+        std::size_t dataCursor = size;
+        for (const auto &resource: m_resources) {
+            size = alignUp(size + resource.data.size(), RES_DATA_ALIGNMENT);
+        }
+
+        Bytes output(size);
+        const auto writeHeader = [&](const std::size_t offset, const std::uint16_t named, const std::size_t total) {
+            write<std::uint16_t>(output, offset + 12, named);
+            write<std::uint16_t>(output, offset + 14, static_cast<std::uint16_t>(total - named));
+        };
+        const auto writeEntry = [&](const std::size_t offset, const Id &id, const std::uint32_t target) {
+            std::uint32_t nameField = id.id;
+            if (id.isName()) {
+                nameField = static_cast<std::uint32_t>(stringCursor) | RES_HIGH_BIT;
+                write<std::uint16_t>(output, stringCursor, static_cast<std::uint16_t>(id.name.size()));
+                std::memcpy(output.data() + stringCursor + sizeof(std::uint16_t), id.name.data(),
+                            id.name.size() * sizeof(char16_t));
+                stringCursor += sizeof(std::uint16_t) + id.name.size() * sizeof(char16_t);
+            }
+            write<std::uint32_t>(output, offset, nameField);
+            write<std::uint32_t>(output, offset + 4, target);
+        };
+
+        writeHeader(0, namedCount(tree), tree.size());
+        std::size_t typeEntry = RES_DIRECTORY_SIZE;
+        for (const auto &[type, names]: tree) {
+            writeEntry(typeEntry, type, static_cast<std::uint32_t>(typeCursor) | RES_HIGH_BIT);
+            typeEntry += RES_ENTRY_SIZE;
+            writeHeader(typeCursor, namedCount(names), names.size());
+            std::size_t nameEntry = typeCursor + RES_DIRECTORY_SIZE;
+            typeCursor = nameEntry + names.size() * RES_ENTRY_SIZE;
+
+            for (const auto &[name, languages]: names) {
+                writeEntry(nameEntry, name, static_cast<std::uint32_t>(nameCursor) | RES_HIGH_BIT);
+                nameEntry += RES_ENTRY_SIZE;
+                writeHeader(nameCursor, 0, languages.size());
+                std::size_t languageEntry = nameCursor + RES_DIRECTORY_SIZE;
+                nameCursor = languageEntry + languages.size() * RES_ENTRY_SIZE;
+
+                for (const auto &[language, resource]: languages) {
+                    writeEntry(languageEntry, language, static_cast<std::uint32_t>(entryCursor));
+                    languageEntry += RES_ENTRY_SIZE;
+                    write<std::uint32_t>(output, entryCursor, baseRva + static_cast<std::uint32_t>(dataCursor));
+                    write<std::uint32_t>(output, entryCursor + 4, static_cast<std::uint32_t>(resource->data.size()));
+                    write<std::uint32_t>(output, entryCursor + 8, resource->codePage);
+                    entryCursor += RES_DATA_ENTRY_SIZE;
+                    std::ranges::copy(resource->data, output.begin() + static_cast<std::ptrdiff_t>(dataCursor));
+                    dataCursor = alignUp(dataCursor + resource->data.size(), RES_DATA_ALIGNMENT);
+                }
+            }
+        }
+        return output;
+    }
+
+    std::uint32_t checksum(const std::span<const std::uint8_t> file, const std::size_t checksumOffset) {
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i < file.size(); i += 2) {
+            if (i == checksumOffset || i == checksumOffset + 2) {
+                continue;
+            }
+            std::uint32_t word = file[i];
+            if (i + 1 < file.size()) {
+                word |= static_cast<std::uint32_t>(file[i + 1]) << 8;
+            }
+            sum += word;
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        sum = (sum & 0xFFFF) + (sum >> 16);
+        return static_cast<std::uint32_t>(sum + file.size());
+    }
+} // namespace PeResource
@@ -0,0 +1,151 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 等待子进程显示第一个顶层窗口，平台相关部分通过 Provider 接口实现
+
+**************************************************************************/
+#include "windowwatcher.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+import std;
+
+namespace {
+#ifdef _WIN32
+    // WinEvent 回调没有用户数据参数，通过线程局部变量通知当前线程上的等待
+    thread_local bool t_windowShown = false;
+
+    void CALLBACK onWindowShown(HWINEVENTHOOK, DWORD, const HWND hwnd, const LONG idObject, const LONG idChild, DWORD,
+                                DWORD) {
+        if (idObject == OBJID_WINDOW && idChild == CHILDID_SELF && hwnd && GetAncestor(hwnd, GA_ROOT) == hwnd) {
+            t_windowShown = true;
+        }
+    }
+
+    class ProcessProvider final : public WindowWatcher::Provider {
+    public:
+        explicit ProcessProvider(const HANDLE process) : m_process(process), m_processId(GetProcessId(process)) {
+            // 只接收目标进程的窗口事件，回调在本线程处理消息时调用
+            m_hook = SetWinEventHook(EVENT_OBJECT_SHOW, EVENT_OBJECT_SHOW, nullptr, onWindowShown, m_processId, 0,
+                                     WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+            t_windowShown = false;
+        }
+
+        ~ProcessProvider() override {
+            if (m_hook) {
+                UnhookWinEvent(m_hook);
+            }
+        }
+
+        ProcessProvider(const ProcessProvider &) = delete;
+
+        ProcessProvider &operator=(const ProcessProvider &) = delete;
+
+        std::uint64_t now() override {
+            return GetTickCount64();
+        }
+
+        void waitForInputIdle(const std::uint32_t timeoutMs) override {
+            // 控制台程序（java.exe）没有输入空闲状态，立即返回失败
+            WaitForInputIdle(m_process, timeoutMs);
+        }
+
+        bool hasVisibleWindow() override {
+            t_windowShown = false;
+            struct Search {
+                DWORD processId;
+                bool found;
+            } search{m_processId, false};
+            EnumWindows([](const HWND hwnd, const LPARAM param) -> BOOL {
+                auto &s = *reinterpret_cast<Search *>(param);
+                DWORD owner = 0;
+                GetWindowThreadProcessId(hwnd, &owner);
+                if (owner != s.processId || !IsWindowVisible(hwnd) || GetWindow(hwnd, GW_OWNER) != nullptr) {
+                    return TRUE;
+                }
+                // 忽略工具窗口和尺寸为 0 的隐藏辅助窗口
+                RECT rect{};
+                if ((GetWindowLongPtrW(hwnd, GWL_EXSTYLE) & WS_EX_TOOLWINDOW) || !GetWindowRect(hwnd, &rect) ||
+                    rect.right <= rect.left || rect.bottom <= rect.top) {
+                    return TRUE;
+                }
+                s.found = true;
+                return FALSE;
+            }, reinterpret_cast<LPARAM>(&search));
+            return search.found;
+        }
+
+        bool exited() override {
+            return WaitForSingleObject(m_process, 0) == WAIT_OBJECT_0;
+        }
+
+        void waitForChange(const std::uint32_t timeoutMs) override {
+            const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+            while (!t_windowShown) {
+                const ULONGLONG current = GetTickCount64();
+                if (current >= deadline) {
+                    return;
+                }
+                const DWORD result = MsgWaitForMultipleObjects(1, &m_process, FALSE,
+                                                               static_cast<DWORD>(deadline - current), QS_ALLINPUT);
+                if (result != WAIT_OBJECT_0 + 1) {
+                    return;
+                }
+                // 分发消息以调用 WinEvent 回调
+                MSG msg;
+                while (PeekMessageW(&msg, nullptr, 0, 0, PM_REMOVE)) {
+                    TranslateMessage(&msg);
+                    DispatchMessageW(&msg);
+                }
+            }
+        }
+
+    private:
+        HANDLE m_process;
+        DWORD m_processId;
+        HWINEVENTHOOK m_hook = nullptr;
+    };
+#endif
+} // namespace
+
+namespace WindowWatcher {
+    Result wait(Provider &provider, const std::uint32_t timeoutMs, const std::stop_token stop) {
+        const std::uint64_t start = provider.now();
+        const auto remaining = [&]() -> std::uint32_t {
+            const std::uint64_t elapsed = provider.now() - start;
+            return elapsed >= timeoutMs ? 0 : static_cast<std::uint32_t>(timeoutMs - elapsed);
+        };
+
+        provider.waitForInputIdle(std::min(remaining(), POLL_INTERVAL_MS * 10));
+        while (true) {
+            if (provider.hasVisibleWindow()) {
+                return Result::WindowShown;
+            }
+            if (provider.exited()) {
+                return Result::ProcessExited;
+            }
+            if (stop.stop_requested()) {
+                return Result::Stopped;
+            }
+            const std::uint32_t left = remaining();
+            if (left == 0) {
+                return Result::TimedOut;
+            }
+            provider.waitForChange(std::min(left, POLL_INTERVAL_MS));
+        }
+    }
+
+#ifdef _WIN32
+    std::unique_ptr<Provider> processProvider(void *process) {
+        return std::make_unique<ProcessProvider>(static_cast<HANDLE>(process));
+    }
+#endif
+} // namespace WindowWatcher
@@ -0,0 +1,243 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: ZIP 尾部（EOCD/Zip64）定位与解析
+
+**************************************************************************/
+#include "ziptail.h"
+
+// 定义 ZIPTAIL_NO_SIMD 时只编译标量实现，供测试对照
+#if !defined(ZIPTAIL_NO_SIMD) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+#include <immintrin.h>
+#define ZIPTAIL_HAS_SSE2 1
+#if defined(__AVX2__)
+#define ZIPTAIL_HAS_AVX2 1
+#endif
+#endif
+
+import std;
+
+namespace {
+    template<typename T>
+    T readStruct(const std::span<const std::uint8_t> data, const std::size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    std::size_t findLastScalar(const std::uint8_t *data, std::size_t end, const std::uint32_t signature) {
+        while (end > 0) {
+            --end;
+            std::uint32_t value;
+            std::memcpy(&value, data + end, sizeof(value));
+            if (value == signature) {
+                return end;
+            }
+        }
+        return static_cast<std::size_t>(-1);
+    }
+
+#if defined(ZIPTAIL_HAS_AVX2)
+    // 每次比较 32 个候选位置，end 为候选位置上界（不含）
+    std::size_t findLastAvx2(const std::uint8_t *data, std::size_t &end, const std::uint32_t signature) {
+        const __m256i s0 = _mm256_set1_epi8(static_cast<char>(signature & 0xFF));
+        const __m256i s1 = _mm256_set1_epi8(static_cast<char>((signature >> 8) & 0xFF));
+        const __m256i s2 = _mm256_set1_epi8(static_cast<char>((signature >> 16) & 0xFF));
+        const __m256i s3 = _mm256_set1_epi8(static_cast<char>((signature >> 24) & 0xFF));
+        while (end >= 32) {
+            const std::size_t base = end - 32;
+            const auto *p = data + base;
+            const __m256i m0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), s0);
+            const __m256i m1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), s1);
+            const __m256i m2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 2)), s2);
+            const __m256i m3 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 3)), s3);
+            const __m256i all = _mm256_and_si256(_mm256_and_si256(m0, m1), _mm256_and_si256(m2, m3));
+            if (const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(all)); mask != 0) {
+                return base + static_cast<std::size_t>(std::bit_width(mask) - 1);
+            }
+            end = base;
+        }
+        return static_cast<std::size_t>(-1);
+    }
+#endif
+
+#if defined(ZIPTAIL_HAS_SSE2)
+    // 每次比较 16 个候选位置，end 为候选位置上界（不含）
+    std::size_t findLastSse2(const std::uint8_t *data, std::size_t &end, const std::uint32_t signature) {
+        const __m128i s0 = _mm_set1_epi8(static_cast<char>(signature & 0xFF));
+        const __m128i s1 = _mm_set1_epi8(static_cast<char>((signature >> 8) & 0xFF));
+        const __m128i s2 = _mm_set1_epi8(static_cast<char>((signature >> 16) & 0xFF));
+        const __m128i s3 = _mm_set1_epi8(static_cast<char>((signature >> 24) & 0xFF));
+        while (end >= 16) {
+            const std::size_t base = end - 16;
+            const auto *p = data + base;
+            const __m128i m0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), s0);
+            const __m128i m1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), s1);
+            const __m128i m2 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2)), s2);
+            const __m128i m3 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3)), s3);
+            const __m128i all = _mm_and_si128(_mm_and_si128(m0, m1), _mm_and_si128(m2, m3));
+            if (const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(all)); mask != 0) {
+                return base + static_cast<std::size_t>(std::bit_width(mask) - 1);
+            }
+            end = base;
+        }
+        return static_cast<std::size_t>(-1);
+    }
+#endif
+} // namespace
+
+namespace ZipTail {
+    std::size_t findLastSignature(const std::span<const std::uint8_t> data, const std::uint32_t signature,
+                                  const std::size_t end) {
+        constexpr auto npos = static_cast<std::size_t>(-1);
+        if (data.size() < sizeof(std::uint32_t)) {
+            return npos;
+        }
+        // 候选位置 i 需要满足 i + 4 <= size，向量版本每个候选位置读取 i..i+3
+        std::size_t limit = std::min(end, data.size() - sizeof(std::uint32_t) + 1);
+
+#if defined(ZIPTAIL_HAS_AVX2)
+        if (const auto pos = findLastAvx2(data.data(), limit, signature); pos != npos) {
+            return pos;
+        }
+#endif
+#if defined(ZIPTAIL_HAS_SSE2)
+        if (const auto pos = findLastSse2(data.data(), limit, signature); pos != npos) {
+            return pos;
+        }
+#endif
+        return findLastScalar(data.data(), limit, signature);
+    }
+
+    std::expected<EndRecord, std::wstring> locate(const std::span<const std::uint8_t> tail,
+                                                  const std::uint64_t tailOffset) {
+        constexpr auto npos = static_cast<std::size_t>(-1);
+        if (tail.size() < EOCD_SIZE) {
+            return std::unexpected{L"文件太小，不是有效的 ZIP 文件"};
+        }
+
+        // EOCD 只可能出现在最后 MAX_SEARCH_SIZE 字节内，且其后的注释必须正好到达末尾
+        const std::size_t searchStart = tail.size() > MAX_SEARCH_SIZE ? tail.size() - MAX_SEARCH_SIZE : 0;
+        std::size_t end = tail.size() - EOCD_SIZE + 1;
+        std::size_t eocdPos = npos;
+        while (end > searchStart) {
+            const auto pos = findLastSignature(tail, EOCD_SIGNATURE, end);
+            if (pos == npos || pos < searchStart) {
+                break;
+            }
+            if (const auto eocd = readStruct<EndOfCentralDirectory>(tail, pos);
+                pos + EOCD_SIZE + eocd.commentLength == tail.size()) {
+                eocdPos = pos;
+                break;
+            }
+            end = pos;
+        }
+        if (eocdPos == npos) {
+            return std::unexpected{L"未找到有效的 ZIP 结束标记"};
+        }
+
+        const auto eocd = readStruct<EndOfCentralDirectory>(tail, eocdPos);
+        EndRecord record{
+            .eocdOffset = tailOffset + eocdPos,
+            .totalRecords = eocd.totalRecords,
+            .centralDirSize = eocd.centralDirSize,
+            .centralDirOffset = eocd.centralDirOffset,
+            .commentLength = eocd.commentLength,
+            .zip64 = false,
+            .zip64EocdOffset = 0,
+            .eocd = eocd,
+            .comment = tail.subspan(eocdPos + EOCD_SIZE, eocd.commentLength),
+        };
+
+        // 检查紧邻 EOCD 之前的 Zip64 定位器
+        if (eocdPos < sizeof(Zip64Locator)) {
+            return record;
+        }
+        const auto locator = readStruct<Zip64Locator>(tail, eocdPos - sizeof(Zip64Locator));
+        if (locator.signature != ZIP64_LOCATOR_SIGNATURE) {
+            return record;
+        }
+
+        record.zip64 = true;
+        record.zip64EocdOffset = locator.zip64EocdOffset;
+        if (locator.zip64EocdOffset < tailOffset ||
+            locator.zip64EocdOffset - tailOffset + sizeof(Zip64EndOfCentralDirectory) >
+            eocdPos - sizeof(Zip64Locator)) {
+            return std::unexpected{L"Zip64 结束记录不在给定的数据范围内"};
+        }
+
+        const auto zip64Eocd =
+                readStruct<Zip64EndOfCentralDirectory>(tail, static_cast<std::size_t>(locator.zip64EocdOffset - tailOffset));
+        if (zip64Eocd.signature != ZIP64_EOCD_SIGNATURE) {
+            return std::unexpected{L"Zip64 结束记录签名无效"};
+        }
+        record.totalRecords = zip64Eocd.totalRecords;
+        record.centralDirSize = zip64Eocd.centralDirSize;
+        record.centralDirOffset = zip64Eocd.centralDirOffset;
+        return record;
+    }
+
+    std::expected<bool, std::wstring> rebase(const std::span<std::uint8_t> zip, const std::uint64_t prefixSize) {
+        const auto recordResult = locate(zip);
+        if (!recordResult) {
+            return std::unexpected{recordResult.error()};
+        }
+        const auto &record = recordResult.value();
+        if (record.zip64) {
+            return std::unexpected{L"不支持 Zip64 格式的 JAR"};
+        }
+
+        // 32 位偏移字段的最大值 0xFFFFFFFF 表示使用 Zip64，调整后的偏移必须小于它
+        constexpr std::uint64_t maxOffset = 0xFFFFFFFEULL;
+        if (record.centralDirOffset + record.centralDirSize > record.eocdOffset ||
+            record.centralDirOffset + prefixSize > maxOffset) {
+            return std::unexpected{L"中央目录偏移无效或调整后超出 32 位范围"};
+        }
+
+        std::size_t pos = static_cast<std::size_t>(record.centralDirOffset);
+        for (std::uint64_t i = 0; i < record.totalRecords; ++i) {
+            if (pos + sizeof(CentralDirHeader) > record.eocdOffset) {
+                return std::unexpected{L"中央目录记录超出范围"};
+            }
+            auto header = readStruct<CentralDirHeader>(zip, pos);
+            if (header.signature != CENTRAL_DIR_SIGNATURE) {
+                return std::unexpected{L"中央目录记录签名无效"};
+            }
+            if (header.localHeaderOffset == 0xFFFFFFFFU ||
+                header.localHeaderOffset + prefixSize > maxOffset) {
+                return std::unexpected{L"本地文件头偏移无效或调整后超出 32 位范围"};
+            }
+            header.localHeaderOffset += static_cast<std::uint32_t>(prefixSize);
+            std::memcpy(zip.data() + pos, &header, sizeof(header));
+            pos += sizeof(CentralDirHeader) + header.fileNameLength + header.extraFieldLength +
+                    header.fileCommentLength;
+        }
+
+        auto eocd = record.eocd;
+        eocd.centralDirOffset += static_cast<std::uint32_t>(prefixSize);
+        std::memcpy(zip.data() + record.eocdOffset, &eocd, sizeof(eocd));
+        return true;
+    }
+
+    std::expected<bool, std::wstring> setCommentLength(const std::span<std::uint8_t> zip, const std::uint64_t eocdOffset,
+                                                       const std::size_t commentSize) {
+        if (commentSize > MAX_COMMENT_SIZE) {
+            return std::unexpected{std::format(L"ZIP 注释过长: {} 字节，最大 {} 字节", commentSize, MAX_COMMENT_SIZE)};
+        }
+        if (eocdOffset > zip.size() || zip.size() - eocdOffset < EOCD_SIZE) {
+            return std::unexpected{L"EOCD 超出数据范围"};
+        }
+        auto eocd = readStruct<EndOfCentralDirectory>(zip, static_cast<std::size_t>(eocdOffset));
+        if (eocd.signature != EOCD_SIGNATURE) {
+            return std::unexpected{L"EOCD 签名无效"};
+        }
+        eocd.commentLength = static_cast<std::uint16_t>(commentSize);
+        std::memcpy(zip.data() + eocdOffset, &eocd, sizeof(eocd));
+        return true;
+    }
+} // namespace ZipTail
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * 守护模式客户端与守护进程之间的消息格式，与传输方式无关
+ * 请求：uint32 长度 + RequestHeader + 工作目录 + 参数，字符串为 uint32 字符数 + UTF-16 数据
+ * 响应：固定大小的 Response
+ */
+namespace DaemonProtocol {
+    inline constexpr std::uint32_t REQUEST_MAGIC = 0x4D44504A; // "JPDM"
+    inline constexpr std::uint32_t RESPONSE_MAGIC = 0x5244504A; // "JPDR"
+    inline constexpr std::uint32_t PROTOCOL_VERSION = 1;
+    inline constexpr std::uint32_t MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+
+#pragma pack(push, 1)
+    struct RequestHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t argCount;
+        std::uint32_t reserved;
+        // 客户端进程中的标准输入输出句柄值，由守护进程复制
+        std::uint64_t stdIn;
+        std::uint64_t stdOut;
+        std::uint64_t stdErr;
+    };
+
+    struct Response {
+        std::uint32_t magic;
+        std::int32_t exitCode;
+    };
+#pragma pack(pop)
+
+    struct Request {
+        std::wstring cwd;
+        std::vector<std::wstring> args;
+        std::uint64_t stdIn = 0;
+        std::uint64_t stdOut = 0;
+        std::uint64_t stdErr = 0;
+    };
+
+    // 编码为完整的请求消息，包含开头的长度
+    std::vector<std::uint8_t> encodeRequest(const Request &request);
+
+    // 长度前缀之后的消息体大小是否合法，不合法时不再读取消息体
+    bool validRequestSize(std::uint32_t size);
+
+    // 解码长度前缀之后的消息体
+    std::expected<Request, std::wstring> decodeRequest(std::span<const std::uint8_t> payload);
+} // namespace DaemonProtocol
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <vector>
+#include <windows.h>
+#include <jni.h>
+
+/**
+ * 常驻 JVM 守护模式（LaunchMode::Daemon）
+ * 第一次启动时以 DAEMON_ARGUMENT 参数启动一个后台启动器进程，由它创建 JVM 并在命名管道上等待请求；
+ * 之后的启动只把命令行参数、工作目录和标准输入输出句柄转发给守护进程，在已预热的 JVM 中调用 main 并取回退出码
+ * 管道名包含会话 ID 与 jar 和 JVM 参数的哈希，jar 变化后自动启动新的守护进程，旧进程在空闲超时后退出
+ * 请求逐个执行，守护进程正忙时客户端等待 BUSY_TIMEOUT_MS 后改为在本进程内创建 JVM 启动；
+ * Java 程序调用 System.exit 会结束守护进程，退出码仍会返回给当前客户端
+ */
+namespace JvmDaemon {
+    // 以守护进程身份运行的命令行参数
+    inline constexpr auto DAEMON_ARGUMENT = L"--jarpackager-daemon";
+
+    // 没有请求时守护进程的存活时间
+    inline constexpr DWORD IDLE_TIMEOUT_MS = 30 * 60 * 1000;
+
+    // 等待守护进程创建 JVM 的最长时间
+    inline constexpr DWORD START_TIMEOUT_MS = 60 * 1000;
+
+    // 守护进程正在执行其他客户端的程序时，客户端最多等待的时间，超时后在本进程内启动
+    inline constexpr DWORD BUSY_TIMEOUT_MS = 2 * 1000;
+
+    // 守护进程发现管道已被占用时的退出码，客户端据此继续等待先启动的守护进程
+    inline constexpr DWORD EXIT_ALREADY_RUNNING = 2;
+
+    // 当前会话中 key 对应的管道名
+    std::wstring pipeName(std::uint64_t key);
+
+    struct ForwardError {
+        std::wstring message;
+        bool busy = false; // 守护进程存在但在 BUSY_TIMEOUT_MS 内一直在处理其他请求
+    };
+
+    /**
+     * 把本次启动转发给守护进程并等待 Java 程序结束
+     * @param daemonProcess 刚启动的守护进程，不为空时在其创建管道前持续等待，进程退出则立即失败
+     * @return Java 程序的退出码；没有可用的守护进程或守护进程正忙时返回错误
+     */
+    std::expected<int, ForwardError> forward(const std::wstring &pipeName, const std::vector<std::wstring> &args,
+                                             HANDLE daemonProcess = nullptr);
+
+    // 以 DAEMON_ARGUMENT 启动后台守护进程，返回进程句柄，由调用方关闭
+    std::expected<HANDLE, std::wstring> spawn(const std::wstring &executablePath);
+
+    // 创建管道的第一个实例，名称已被其他守护进程占用时返回错误
+    std::expected<HANDLE, std::wstring> listen(const std::wstring &pipeName);
+
+    /**
+     * 在创建 JVM 的线程上循环处理请求，空闲超时后返回
+     * @param programArgs 打包时指定的程序参数，放在转发的参数之前
+     */
+    int serve(HANDLE pipe, JNIEnv *env, jclass mainClass, jmethodID mainMethod,
+              const std::vector<std::wstring> &programArgs, DWORD idleTimeoutMs = IDLE_TIMEOUT_MS);
+
+    // 作为 "exit" 选项传给 JNI_CreateJavaVM：System.exit 时把退出码返回给当前客户端
+    void JNICALL onExit(jint code);
+} // namespace JvmDaemon
@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "jarlayout.h"
+
+/**
+ * 启动清单
+ * 直接在可执行文件的映射视图上解析末尾的元数据块，字符串以 string_view 形式指向映射视图，
+ * 只有在需要时才转换为宽字符串。映射视图必须在清单使用期间保持有效
+ */
+class LaunchManifest {
+public:
+    /**
+     * 从打包后的可执行文件加载启动清单
+     * @param file 整个可执行文件的映射视图
+     */
+    static std::expected<LaunchManifest, std::wstring> load(std::span<const std::uint8_t> file);
+
+    [[nodiscard]] const JarLayout::LaunchSettings &settings() const {
+        return m_info.settings;
+    }
+
+    [[nodiscard]] JarLayout::Range jar() const {
+        return m_info.range(JarLayout::SectionType::Jar);
+    }
+
+    // jar 段的内容哈希，旧版打包文件为 0
+    [[nodiscard]] std::uint64_t jarHash() const {
+        const auto *entry = m_info.find(JarLayout::SectionType::Jar);
+        return entry ? entry->hash : 0;
+    }
+
+    // jar 段是否已在打包时写入时间戳注释
+    [[nodiscard]] bool jarStamped() const {
+        const auto *entry = m_info.find(JarLayout::SectionType::Jar);
+        return entry && (entry->flags & JarLayout::SECTION_FLAG_JAR_STAMPED);
+    }
+
+    // jar 偏移已按整个文件重新计算，exe 本身可作为 jar 使用
+    [[nodiscard]] bool runFromExe() const {
+        const auto *entry = m_info.find(JarLayout::SectionType::Jar);
+        return entry && (entry->flags & JarLayout::SECTION_FLAG_RUN_FROM_EXE);
+    }
+
+    [[nodiscard]] JarLayout::Range splashImage() const {
+        return m_info.range(JarLayout::SectionType::SplashImage);
+    }
+
+    [[nodiscard]] std::uint16_t version() const {
+        return m_info.version;
+    }
+
+    // 原始 UTF-8 字符串，指向映射视图
+    [[nodiscard]] std::string_view utf8(JarLayout::StringId id) const;
+
+    // 转换为宽字符串
+    [[nodiscard]] std::wstring wide(JarLayout::StringId id) const;
+
+    // 按换行符拆分并转换为宽字符串，忽略空项
+    [[nodiscard]] std::vector<std::wstring> lines(JarLayout::StringId id) const;
+
+    // 解析完成时距离进程启动的时间，单位：微秒
+    [[nodiscard]] std::int64_t decodedAt() const {
+        return m_decodedAt;
+    }
+
+private:
+    LaunchManifest() = default;
+
+    std::span<const std::uint8_t> m_tail; // 元数据块
+    std::uint64_t m_fileSize = 0;
+    JarLayout::PackageInfo m_info{};
+    std::int64_t m_decodedAt = 0;
+};
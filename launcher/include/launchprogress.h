@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <windows.h>
+#include <jni.h>
+
+/**
+ * 启动进度
+ * 各启动阶段按权重折算为总进度，通过 JarCommon::WM_SPLASH_UPDATE 发送给启动遮罩窗口；
+ * jar 解压与 JVM 查找并行执行，按权重累加可以避免进度来回跳动
+ * Java 程序可以提供如下类，启动器在调用 main 前为其注册本地方法：
+ *   package jarpackager;
+ *   public final class JarLauncher {
+ *       public static native void progress(int percent); // 程序自身的初始化进度 0-100
+ *       public static native void closeSplash();
+ *   }
+ * 没有该类时，启动遮罩停在调用 main 之后的进度，由自动关闭定时器关闭
+ * 各阶段的完成时间由 LaunchStats 记录，下次启动时用于在两次报告之间按预计耗时推进进度
+ */
+namespace LaunchProgress {
+    enum class Stage : std::uint32_t {
+        Manifest, // 启动信息已解析
+        Jar, // jar 校验与解压
+        JvmLoad, // jvm.dll 已加载
+        JvmCreate, // JNI_CreateJavaVM 已返回
+        Main, // 已调用 main
+        App, // Java 程序通过 JarLauncher.progress 报告的进度
+    };
+
+    inline constexpr std::size_t STAGE_COUNT = 6;
+
+    // Java 端辅助类
+    inline constexpr auto LAUNCHER_CLASS = "jarpackager/JarLauncher";
+
+    /**
+     * 报告阶段进度，可在任意线程调用
+     * @param fraction 阶段完成比例，千分比
+     */
+    void report(Stage stage, std::uint32_t fraction = 1000);
+
+    // 所有阶段完成，启动遮罩随之关闭；用于 java.exe 模式下子进程显示窗口时
+    void complete();
+
+    // jar 解压进度，签名与 FileCopy::Progress 一致
+    void reportCopy(std::uint64_t copied, std::uint64_t total);
+
+    // 绑定启动遮罩窗口并补发当前进度；传入 nullptr 解除绑定
+    void attach(HWND window);
+
+    // 为 LAUNCHER_CLASS 注册本地方法，Java 程序中没有该类时返回 false
+    bool registerNatives(JNIEnv *env);
+
+    // 距进程启动的毫秒数，0 表示未发生
+    struct Timings {
+        std::array<std::uint32_t, STAGE_COUNT> stageDone{}; // 各阶段完成的时间
+        std::uint32_t splashClosed = 0; // Java 程序关闭启动遮罩或报告 100% 的时间
+    };
+
+    // 本次启动已记录的时间
+    Timings timings();
+
+    // 设置各阶段的预计完成时间，由 tick 使用
+    void setExpected(const Timings &expected);
+
+    // 按预计完成时间推进尚未完成的阶段，最多推进到该阶段的 90%，真实进度更高时不回退
+    void tick();
+} // namespace LaunchProgress
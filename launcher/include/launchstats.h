@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <filesystem>
+#include <string>
+#include <windows.h>
+#include "launchprogress.h"
+
+/**
+ * 启动耗时统计
+ * 每个 exe 在用户缓存目录下保存一个统计文件，记录各启动阶段完成时间与启动遮罩关闭时间的指数加权移动平均（EWMA）
+ * 启动时读取作为预计耗时：在阶段报告之间推进进度条，并据此设置启动遮罩的自动关闭延迟，
+ * 不再依赖打包时填写的 launchTime，在快慢不同的机器上都能得到接近真实的进度
+ */
+namespace LaunchStats {
+    using Path = std::filesystem::path;
+
+    // 新样本的权重
+    inline constexpr double ALPHA = 0.3;
+
+    // exe 对应的统计文件
+    Path defaultFile(const std::wstring &executablePath);
+
+    // 读取历史平均耗时，文件不存在或损坏时全部为 0
+    LaunchProgress::Timings load(const Path &file);
+
+    // 把本次启动的耗时并入平均值并写回，本次未发生的阶段保留原值
+    void record(const Path &file, const LaunchProgress::Timings &sample);
+
+    // 启动遮罩的自动关闭延迟：有关闭记录时为平均关闭时间的 1.5 倍，否则按 launchTime 估计
+    DWORD closeDelay(const LaunchProgress::Timings &expected, int launchTime);
+} // namespace LaunchStats
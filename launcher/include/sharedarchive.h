@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * 托管的类数据共享（AppCDS）归档
+ * 首次启动时由 JVM 生成归档，之后的启动直接映射归档中的类，减少类加载耗时
+ * 归档文件名为 <stem>.<jar 标识>-<JVM 标识>.jsa（JDK 25 及以上为 .aot），jar 或 JDK 变化后自动使用新的归档
+ * JDK 25+：-XX:AOTCacheOutput 生成，-XX:AOTCache 使用
+ * JDK 19+：-XX:+AutoCreateSharedArchive，由 JVM 自行生成、校验和重建
+ * JDK 13+：-XX:ArchiveClassesAtExit 生成，-XX:SharedArchiveFile 使用
+ */
+namespace SharedArchive {
+    using Path = std::filesystem::path;
+
+    /**
+     * 直接运行模式下的归档文件名前缀 app-<exe 路径哈希>
+     * 归档放在所有 exe 共用的缓存目录，按 exe 名称区分时同名的不同程序会互相删除对方的归档
+     */
+    std::wstring appStem(const Path &exePath);
+
+    /**
+     * 计算启动参数，JDK 不支持或 jvmArgs 中已包含 CDS/AOT 相关参数时返回空
+     * @param javaHome JDK 根目录
+     * @param archiveDir 归档所在目录
+     * @param stem 归档文件名前缀
+     * @param jarKey jar 内容标识
+     * @param commandLine 是否用于 java.exe 命令行，是则为路径加引号
+     */
+    std::vector<std::wstring> options(const Path &javaHome, const Path &archiveDir, const std::wstring &stem,
+                                      std::uint64_t jarKey, const std::vector<std::wstring> &jvmArgs,
+                                      bool commandLine);
+} // namespace SharedArchive
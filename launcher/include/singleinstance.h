@@ -0,0 +1,44 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * 单实例模式
+ * 每个 exe 在当前会话中持有一个命名互斥量，第一个实例在命名管道上接收后续启动的命令行参数；
+ * 后续启动把参数发给它后立即退出，不再解压 jar 或创建 JVM
+ * Java 程序在主类中定义 public static void onNewInstance(String[] args) 接收参数，
+ * 该方法在启动器的管道线程上调用，可能早于 main 初始化完成
+ */
+namespace SingleInstance {
+    // 收到转发参数时的回调，在管道线程上调用
+    using Handler = std::function<void(const std::vector<std::wstring> &args)>;
+
+    // 等待第一个实例创建管道的最长时间
+    inline constexpr std::uint32_t FORWARD_TIMEOUT_MS = 10 * 1000;
+
+    /**
+     * 获取 exe 的实例锁，成功时开始在后台线程接收转发的参数，锁在进程退出时释放
+     * @return 已有其他实例持有锁时返回 false
+     */
+    bool acquire(const std::wstring &executablePath);
+
+    /**
+     * 把参数转发给持有实例锁的进程，并允许它把窗口切换到前台
+     * 对方已退出或超时未创建管道时返回错误，调用方可按普通方式启动
+     */
+    std::expected<bool, std::wstring> forward(const std::wstring &executablePath,
+                                              const std::vector<std::wstring> &args);
+
+    // 设置回调并交付设置前收到的参数，未持有实例锁时忽略
+    void setHandler(Handler handler);
+
+    /**
+     * 清除回调并等待正在执行的回调返回，之后收到的参数被丢弃
+     * 回调持有 JVM，必须在 DestroyJavaVM 之前调用，否则管道线程可能附加到已销毁的 JVM
+     */
+    void clearHandler();
+} // namespace SingleInstance
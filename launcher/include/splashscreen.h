@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 #include <windows.h>
@@ -65,7 +67,7 @@ private:
     float GetDPIScale();
 
     // 从PNG数据创建位图
-    void CreateBitmapFromPNG(const std::vector<char> &pngData);
+    void CreateBitmapFromPNG(std::span<const std::uint8_t> pngData);
 
     // 创建默认背景
     void CreateDefaultBackground();
@@ -84,7 +86,8 @@ private:
 
 
 public:
-    SplashScreen(const std::vector<char> &pngData, const std::wstring &programName, const std::wstring &programVersion,
+    SplashScreen(std::span<const std::uint8_t> pngData, const std::wstring &programName,
+                 const std::wstring &programVersion,
                  bool showProgress = true, bool showProgressText = true,
                  float titlePosX = 50.0f, float titlePosY = 33.0f, float versionPosX = 50.0f, float versionPosY = 45.0f,
                  float statusPosX = 5.0f, float statusPosY = 85.0f, float titleFontSizePercent = 15.0f,
@@ -0,0 +1,121 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 守护模式请求的编码与解码
+
+**************************************************************************/
+#include "daemonprotocol.h"
+
+import std;
+
+namespace {
+    // 线上格式固定为 UTF-16；wchar_t 为 32 位的平台上，补充平面字符拆为代理对
+    void appendString(std::vector<std::uint8_t> &buffer, const std::wstring_view text) {
+        std::u16string units;
+        units.reserve(text.size());
+        for (const wchar_t ch: text) {
+            const auto code = static_cast<std::uint32_t>(ch);
+            if constexpr (sizeof(wchar_t) > 2) {
+                if (code > 0xFFFF) {
+                    units.push_back(static_cast<char16_t>(0xD800 + ((code - 0x10000) >> 10)));
+                    units.push_back(static_cast<char16_t>(0xDC00 + ((code - 0x10000) & 0x3FF)));
+                    continue;
+                }
+            }
+            units.push_back(static_cast<char16_t>(code));
+        }
+        const auto length = static_cast<std::uint32_t>(units.size());
+        const auto *lengthBytes = reinterpret_cast<const std::uint8_t *>(&length);
+        buffer.insert(buffer.end(), lengthBytes, lengthBytes + sizeof(length));
+        const auto *textBytes = reinterpret_cast<const std::uint8_t *>(units.data());
+        buffer.insert(buffer.end(), textBytes, textBytes + units.size() * sizeof(char16_t));
+    }
+
+    std::optional<std::wstring> readString(std::span<const std::uint8_t> &payload) {
+        std::uint32_t length;
+        if (payload.size() < sizeof(length)) {
+            return std::nullopt;
+        }
+        std::memcpy(&length, payload.data(), sizeof(length));
+        payload = payload.subspan(sizeof(length));
+        if (payload.size() / sizeof(char16_t) < length) {
+            return std::nullopt;
+        }
+        std::u16string units(length, u'\0');
+        std::memcpy(units.data(), payload.data(), length * sizeof(char16_t));
+        payload = payload.subspan(length * sizeof(char16_t));
+
+        std::wstring text;
+        text.reserve(units.size());
+        for (std::size_t i = 0; i < units.size(); ++i) {
+            std::uint32_t code = units[i];
+            if constexpr (sizeof(wchar_t) > 2) {
+                if (code >= 0xD800 && code < 0xDC00 && i + 1 < units.size() && units[i + 1] >= 0xDC00 &&
+                    units[i + 1] < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (units[++i] - 0xDC00);
+                }
+            }
+            text.push_back(static_cast<wchar_t>(code));
+        }
+        return text;
+    }
+} // namespace
+
+namespace DaemonProtocol {
+    std::vector<std::uint8_t> encodeRequest(const Request &request) {
+        std::vector<std::uint8_t> buffer(sizeof(std::uint32_t) + sizeof(RequestHeader));
+        const RequestHeader header{
+            REQUEST_MAGIC, PROTOCOL_VERSION, static_cast<std::uint32_t>(request.args.size()), 0,
+            request.stdIn, request.stdOut, request.stdErr,
+        };
+        std::memcpy(buffer.data() + sizeof(std::uint32_t), &header, sizeof(header));
+        appendString(buffer, request.cwd);
+        for (const auto &arg: request.args) {
+            appendString(buffer, arg);
+        }
+        const auto size = static_cast<std::uint32_t>(buffer.size() - sizeof(std::uint32_t));
+        std::memcpy(buffer.data(), &size, sizeof(size));
+        return buffer;
+    }
+
+    bool validRequestSize(const std::uint32_t size) {
+        return size >= sizeof(RequestHeader) && size <= MAX_REQUEST_SIZE;
+    }
+
+    std::expected<Request, std::wstring> decodeRequest(std::span<const std::uint8_t> payload) {
+        if (!validRequestSize(static_cast<std::uint32_t>(std::min<std::size_t>(payload.size(), ~0U)))) {
+            return std::unexpected{L"请求大小无效"};
+        }
+        RequestHeader header;
+        std::memcpy(&header, payload.data(), sizeof(header));
+        if (header.magic != REQUEST_MAGIC || header.version != PROTOCOL_VERSION) {
+            return std::unexpected{L"请求格式或版本不符"};
+        }
+        payload = payload.subspan(sizeof(header));
+
+        Request request{{}, {}, header.stdIn, header.stdOut, header.stdErr};
+        auto cwd = readString(payload);
+        if (!cwd) {
+            return std::unexpected{L"请求数据不完整"};
+        }
+        request.cwd = std::move(*cwd);
+        // 每个参数至少占 4 字节，参数数量不可能超过剩余数据
+        if (header.argCount > payload.size() / sizeof(std::uint32_t)) {
+            return std::unexpected{L"请求数据不完整"};
+        }
+        request.args.reserve(header.argCount);
+        for (std::uint32_t i = 0; i < header.argCount; ++i) {
+            auto arg = readString(payload);
+            if (!arg) {
+                return std::unexpected{L"请求数据不完整"};
+            }
+            request.args.push_back(std::move(*arg));
+        }
+        return request;
+    }
+} // namespace DaemonProtocol
@@ -0,0 +1,411 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 常驻 JVM 守护模式，通过命名管道把启动请求转发给已预热的 JVM
+
+**************************************************************************/
+#include "jvmdaemon.h"
+#include "daemonprotocol.h"
+
+import std;
+
+namespace {
+    using DaemonProtocol::Request;
+    using DaemonProtocol::Response;
+    using DaemonProtocol::RESPONSE_MAGIC;
+
+    constexpr DWORD PIPE_BUFFER_SIZE = 64 * 1024;
+    constexpr DWORD CONNECT_RETRY_MS = 50;
+
+    // 正在处理请求的客户端管道，供 exit 钩子返回退出码
+    std::atomic<HANDLE> g_client{nullptr};
+
+    class Event {
+    public:
+        Event() : m_handle(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {
+        }
+
+        ~Event() {
+            if (m_handle) {
+                CloseHandle(m_handle);
+            }
+        }
+
+        Event(const Event &) = delete;
+
+        Event &operator=(const Event &) = delete;
+
+        [[nodiscard]] HANDLE get() const {
+            return m_handle;
+        }
+
+    private:
+        HANDLE m_handle;
+    };
+
+    // 在重叠方式打开的管道上完整读写 size 字节
+    bool transfer(const HANDLE pipe, void *data, std::size_t size, const bool write) {
+        const Event event;
+        auto *bytes = static_cast<std::uint8_t *>(data);
+        while (size > 0) {
+            OVERLAPPED overlapped{};
+            overlapped.hEvent = event.get();
+            const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size, PIPE_BUFFER_SIZE));
+            const BOOL ok = write
+                                ? WriteFile(pipe, bytes, chunk, nullptr, &overlapped)
+                                : ReadFile(pipe, bytes, chunk, nullptr, &overlapped);
+            if (!ok && GetLastError() != ERROR_IO_PENDING) {
+                return false;
+            }
+            DWORD done = 0;
+            if (!GetOverlappedResult(pipe, &overlapped, &done, TRUE) || done == 0) {
+                return false;
+            }
+            bytes += done;
+            size -= done;
+        }
+        return true;
+    }
+
+    void sendExitCode(const HANDLE pipe, const int exitCode) {
+        Response response{RESPONSE_MAGIC, exitCode};
+        transfer(pipe, &response, sizeof(response), true);
+        FlushFileBuffers(pipe);
+    }
+
+    jstring newString(JNIEnv *env, const std::wstring_view text) {
+        return env->NewString(reinterpret_cast<const jchar *>(text.data()), static_cast<jsize>(text.size()));
+    }
+
+    /**
+     * 把 System.in/out/err 临时替换为客户端的标准输入输出，析构时恢复并关闭复制的句柄
+     * 请求逐个执行，替换全局流不会影响其他请求
+     */
+    class StdioRedirect {
+    public:
+        StdioRedirect(JNIEnv *env, const HANDLE in, const HANDLE out, const HANDLE err) : m_env(env) {
+            m_system = env->FindClass("java/lang/System");
+            m_fileDescriptor = env->FindClass("java/io/FileDescriptor");
+            if (!m_system || !m_fileDescriptor) {
+                env->ExceptionClear();
+                closeHandles({in, out, err});
+                return;
+            }
+            redirect("in", "Ljava/io/InputStream;", "setIn", in, false);
+            redirect("out", "Ljava/io/PrintStream;", "setOut", out, true);
+            redirect("err", "Ljava/io/PrintStream;", "setErr", err, true);
+        }
+
+        ~StdioRedirect() {
+            for (const auto &[setter, signature, original, stream]: m_replaced) {
+                const jmethodID flush = m_env->GetMethodID(m_env->GetObjectClass(stream), "flush", "()V");
+                if (flush) {
+                    m_env->CallVoidMethod(stream, flush);
+                }
+                m_env->ExceptionClear();
+                m_env->CallStaticVoidMethod(m_system, m_env->GetStaticMethodID(m_system, setter, signature), original);
+                const jmethodID close = m_env->GetMethodID(m_env->GetObjectClass(stream), "close", "()V");
+                m_env->CallVoidMethod(stream, close);
+                m_env->ExceptionClear();
+            }
+        }
+
+        StdioRedirect(const StdioRedirect &) = delete;
+
+        StdioRedirect &operator=(const StdioRedirect &) = delete;
+
+    private:
+        struct Replaced {
+            const char *setter;
+            const char *signature;
+            jobject original;
+            jobject stream;
+        };
+
+        static void closeHandles(const std::initializer_list<HANDLE> handles) {
+            for (const HANDLE handle: handles) {
+                if (handle) {
+                    CloseHandle(handle);
+                }
+            }
+        }
+
+        // FileDescriptor 在 Windows 上通过 handle 字段持有文件句柄
+        jobject newFileDescriptor(const HANDLE handle) const {
+            const jmethodID init = m_env->GetMethodID(m_fileDescriptor, "<init>", "()V");
+            const jfieldID handleField = m_env->GetFieldID(m_fileDescriptor, "handle", "J");
+            if (!init || !handleField) {
+                m_env->ExceptionClear();
+                return nullptr;
+            }
+            const jobject fd = m_env->NewObject(m_fileDescriptor, init);
+            if (fd) {
+                m_env->SetLongField(fd, handleField, reinterpret_cast<jlong>(handle));
+            }
+            return fd;
+        }
+
+        jobject newStream(const HANDLE handle, const bool output) const {
+            const jobject fd = newFileDescriptor(handle);
+            if (!fd) {
+                return nullptr;
+            }
+            const jclass fileStream = m_env->FindClass(output ? "java/io/FileOutputStream" : "java/io/FileInputStream");
+            if (!fileStream) {
+                m_env->ExceptionClear();
+                return nullptr;
+            }
+            const jobject stream = m_env->NewObject(fileStream,
+                                                    m_env->GetMethodID(fileStream, "<init>",
+                                                                       "(Ljava/io/FileDescriptor;)V"), fd);
+            if (!stream || !output) {
+                return stream;
+            }
+            const jclass printStream = m_env->FindClass("java/io/PrintStream");
+            return m_env->NewObject(printStream,
+                                    m_env->GetMethodID(printStream, "<init>", "(Ljava/io/OutputStream;Z)V"),
+                                    stream, JNI_TRUE);
+        }
+
+        void redirect(const char *field, const char *type, const char *setter, const HANDLE handle,
+                      const bool output) {
+            if (!handle) {
+                return;
+            }
+            const jobject stream = newStream(handle, output);
+            if (!stream || m_env->ExceptionCheck()) {
+                m_env->ExceptionClear();
+                CloseHandle(handle);
+                return;
+            }
+            const auto signature = output ? "(Ljava/io/PrintStream;)V" : "(Ljava/io/InputStream;)V";
+            const jobject original = m_env->GetStaticObjectField(m_system,
+                                                                 m_env->GetStaticFieldID(m_system, field, type));
+            m_env->CallStaticVoidMethod(m_system, m_env->GetStaticMethodID(m_system, setter, signature), stream);
+            m_replaced.push_back({setter, signature, original, stream});
+        }
+
+        JNIEnv *m_env;
+        jclass m_system = nullptr;
+        jclass m_fileDescriptor = nullptr;
+        std::vector<Replaced> m_replaced;
+    };
+
+    // 把客户端进程中的句柄复制到守护进程
+    HANDLE duplicateFrom(const HANDLE clientProcess, const std::uint64_t value) {
+        if (value == 0 || reinterpret_cast<HANDLE>(value) == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        HANDLE duplicate = nullptr;
+        if (!DuplicateHandle(clientProcess, reinterpret_cast<HANDLE>(value), GetCurrentProcess(), &duplicate, 0,
+                             FALSE, DUPLICATE_SAME_ACCESS)) {
+            return nullptr;
+        }
+        return duplicate;
+    }
+
+    // 处理一个已连接客户端的请求，返回 false 表示请求无效
+    bool handleRequest(const HANDLE pipe, JNIEnv *env, const jclass mainClass, const jmethodID mainMethod,
+                       const std::vector<std::wstring> &programArgs) {
+        std::uint32_t size = 0;
+        if (!transfer(pipe, &size, sizeof(size), false) || !DaemonProtocol::validRequestSize(size)) {
+            return false;
+        }
+        std::vector<std::uint8_t> buffer(size);
+        if (!transfer(pipe, buffer.data(), buffer.size(), false)) {
+            return false;
+        }
+        const auto request = DaemonProtocol::decodeRequest(buffer);
+        if (!request) {
+            return false;
+        }
+        std::vector<std::wstring> args = programArgs;
+        args.insert(args.end(), request->args.begin(), request->args.end());
+
+        // 句柄所属进程以管道对端为准，不信任请求中的进程号
+        ULONG clientPid = 0;
+        if (!GetNamedPipeClientProcessId(pipe, &clientPid)) {
+            return false;
+        }
+        const HANDLE clientProcess = OpenProcess(PROCESS_DUP_HANDLE, FALSE, clientPid);
+        if (!clientProcess) {
+            return false;
+        }
+        const HANDLE in = duplicateFrom(clientProcess, request->stdIn);
+        const HANDLE out = duplicateFrom(clientProcess, request->stdOut);
+        const HANDLE err = duplicateFrom(clientProcess, request->stdErr);
+        CloseHandle(clientProcess);
+
+        env->PushLocalFrame(64);
+        int exitCode = 0;
+        {
+            SetCurrentDirectoryW(request->cwd.c_str());
+            const jclass system = env->FindClass("java/lang/System");
+            env->CallStaticObjectMethod(
+                system,
+                env->GetStaticMethodID(system, "setProperty", "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
+                newString(env, L"user.dir"), newString(env, request->cwd));
+            env->ExceptionClear();
+
+            const StdioRedirect redirect(env, in, out, err);
+            const jobjectArray javaArgs = env->NewObjectArray(static_cast<jsize>(args.size()),
+                                                              env->FindClass("java/lang/String"), nullptr);
+            for (std::size_t i = 0; i < args.size(); ++i) {
+                const jstring arg = newString(env, args[i]);
+                env->SetObjectArrayElement(javaArgs, static_cast<jsize>(i), arg);
+                env->DeleteLocalRef(arg);
+            }
+
+            g_client = pipe;
+            env->CallStaticVoidMethod(mainClass, mainMethod, javaArgs);
+            if (env->ExceptionCheck()) {
+                // 打印到已重定向的 System.err
+                env->ExceptionDescribe();
+                exitCode = 1;
+            }
+            g_client = nullptr;
+        }
+        env->PopLocalFrame(nullptr);
+
+        sendExitCode(pipe, exitCode);
+        return true;
+    }
+} // namespace
+
+namespace JvmDaemon {
+    std::wstring pipeName(const std::uint64_t key) {
+        DWORD sessionId = 0;
+        ProcessIdToSessionId(GetCurrentProcessId(), &sessionId);
+        return std::format(L"\\\\.\\pipe\\JarPackager-{}-{:016x}", sessionId, key);
+    }
+
+    std::expected<int, ForwardError> forward(const std::wstring &pipeName, const std::vector<std::wstring> &args,
+                                             HANDLE daemonProcess) {
+        const ULONGLONG start = GetTickCount64();
+        std::optional<ULONGLONG> busySince;
+        HANDLE pipe;
+        while (true) {
+            pipe = CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                               FILE_FLAG_OVERLAPPED, nullptr);
+            if (pipe != INVALID_HANDLE_VALUE) {
+                break;
+            }
+            // 守护进程正在执行其他客户端的程序，可能要等到它结束，超时后由调用方改为在本进程启动
+            if (GetLastError() == ERROR_PIPE_BUSY) {
+                if (!busySince) {
+                    busySince = GetTickCount64();
+                }
+                const ULONGLONG waited = GetTickCount64() - *busySince;
+                if (waited >= BUSY_TIMEOUT_MS) {
+                    return std::unexpected{ForwardError{L"守护进程正忙", true}};
+                }
+                WaitNamedPipeW(pipeName.c_str(), static_cast<DWORD>(BUSY_TIMEOUT_MS - waited));
+                continue;
+            }
+            if (!daemonProcess) {
+                return std::unexpected{ForwardError{L"守护进程未运行", false}};
+            }
+            if (WaitForSingleObject(daemonProcess, CONNECT_RETRY_MS) == WAIT_OBJECT_0) {
+                // 其他启动抢先创建了守护进程，继续等待它的管道
+                DWORD exitCode = 0;
+                GetExitCodeProcess(daemonProcess, &exitCode);
+                if (exitCode != EXIT_ALREADY_RUNNING) {
+                    return std::unexpected{ForwardError{L"守护进程启动失败", false}};
+                }
+                Sleep(CONNECT_RETRY_MS);
+            }
+            if (GetTickCount64() - start > START_TIMEOUT_MS) {
+                return std::unexpected{ForwardError{L"等待守护进程启动超时", false}};
+            }
+        }
+
+        Request request;
+        request.args = args;
+        request.stdIn = reinterpret_cast<std::uint64_t>(GetStdHandle(STD_INPUT_HANDLE));
+        request.stdOut = reinterpret_cast<std::uint64_t>(GetStdHandle(STD_OUTPUT_HANDLE));
+        request.stdErr = reinterpret_cast<std::uint64_t>(GetStdHandle(STD_ERROR_HANDLE));
+        request.cwd.resize(GetCurrentDirectoryW(0, nullptr));
+        request.cwd.resize(GetCurrentDirectoryW(static_cast<DWORD>(request.cwd.size()), request.cwd.data()));
+        auto message = DaemonProtocol::encodeRequest(request);
+
+        Response response{};
+        const bool ok = transfer(pipe, message.data(), message.size(), true) &&
+                        transfer(pipe, &response, sizeof(response), false);
+        CloseHandle(pipe);
+        if (!ok || response.magic != RESPONSE_MAGIC) {
+            return std::unexpected{ForwardError{L"守护进程意外退出", false}};
+        }
+        return response.exitCode;
+    }
+
+    std::expected<HANDLE, std::wstring> spawn(const std::wstring &executablePath) {
+        std::wstring command = std::format(L"\"{}\" {}", executablePath, DAEMON_ARGUMENT);
+        STARTUPINFOW si = {};
+        PROCESS_INFORMATION pi = {};
+        si.cb = sizeof(si);
+        if (!CreateProcessW(executablePath.c_str(), command.data(), nullptr, nullptr, FALSE,
+                            DETACHED_PROCESS | CREATE_NEW_PROCESS_GROUP, nullptr, nullptr, &si, &pi)) {
+            return std::unexpected{L"无法启动守护进程"};
+        }
+        CloseHandle(pi.hThread);
+        return pi.hProcess;
+    }
+
+    std::expected<HANDLE, std::wstring> listen(const std::wstring &pipeName) {
+        // 只允许一个实例：名称被占用说明已有守护进程，请求逐个处理，其他客户端在 WaitNamedPipe 中最多等待 BUSY_TIMEOUT_MS
+        const HANDLE pipe = CreateNamedPipeW(pipeName.c_str(),
+                                             PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                             PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+                                             PIPE_REJECT_REMOTE_CLIENTS,
+                                             1, PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            return std::unexpected{L"守护进程已在运行"};
+        }
+        return pipe;
+    }
+
+    int serve(const HANDLE pipe, JNIEnv *env, const jclass mainClass, const jmethodID mainMethod,
+              const std::vector<std::wstring> &programArgs, const DWORD idleTimeoutMs) {
+        const Event event;
+        while (true) {
+            OVERLAPPED overlapped{};
+            overlapped.hEvent = event.get();
+            bool connected = ConnectNamedPipe(pipe, &overlapped);
+            if (!connected) {
+                DWORD ignored = 0;
+                switch (GetLastError()) {
+                    case ERROR_PIPE_CONNECTED:
+                        connected = true;
+                        break;
+                    case ERROR_IO_PENDING:
+                        if (WaitForSingleObject(event.get(), idleTimeoutMs) != WAIT_OBJECT_0) {
+                            // 空闲超时
+                            CancelIo(pipe);
+                            GetOverlappedResult(pipe, &overlapped, &ignored, TRUE);
+                            CloseHandle(pipe);
+                            return 0;
+                        }
+                        connected = GetOverlappedResult(pipe, &overlapped, &ignored, FALSE);
+                        break;
+                    default:
+                        break;
+                }
+            }
+            if (connected) {
+                handleRequest(pipe, env, mainClass, mainMethod, programArgs);
+            }
+            DisconnectNamedPipe(pipe);
+        }
+    }
+
+    void JNICALL onExit(const jint code) {
+        if (const HANDLE pipe = g_client.exchange(nullptr)) {
+            sendExitCode(pipe, code);
+        }
+    }
+} // namespace JvmDaemon
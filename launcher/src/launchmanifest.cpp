@@ -0,0 +1,121 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 启动清单，在映射视图上解析打包文件的元数据块
+
+**************************************************************************/
+#include "launchmanifest.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+import std;
+
+namespace {
+    std::wstring widen(const std::string_view utf8) {
+        if (utf8.empty()) {
+            return {};
+        }
+#ifdef _WIN32
+        const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+        std::wstring result(length, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), result.data(), length);
+        return result;
+#else
+        // wchar_t 为 UTF-32，逐个解码；无效序列与 MultiByteToWideChar 一样替换为 U+FFFD
+        std::wstring result;
+        result.reserve(utf8.size());
+        for (std::size_t i = 0; i < utf8.size();) {
+            const auto lead = static_cast<unsigned char>(utf8[i]);
+            const std::size_t length = lead < 0x80 ? 1 : lead >= 0xC2 && lead < 0xE0 ? 2 : lead >= 0xE0 && lead < 0xF0
+                                                   ? 3 : lead >= 0xF0 && lead < 0xF5 ? 4 : 0;
+            char32_t code = length == 1 ? lead : lead & (0x7F >> length);
+            bool valid = length != 0 && i + length <= utf8.size();
+            for (std::size_t k = 1; valid && k < length; ++k) {
+                const auto next = static_cast<unsigned char>(utf8[i + k]);
+                valid = (next & 0xC0) == 0x80;
+                code = code << 6 | (next & 0x3F);
+            }
+            constexpr char32_t MIN_CODE[] = {0, 0, 0x80, 0x800, 0x10000};
+            if (valid && (code < MIN_CODE[length] || code > 0x10FFFF || (code >= 0xD800 && code < 0xE000))) {
+                valid = false;
+            }
+            result.push_back(valid ? static_cast<wchar_t>(code) : L'\uFFFD');
+            i += valid ? length : 1;
+        }
+        return result;
+#endif
+    }
+
+    // 距离进程创建的时间，单位：微秒；非 Windows 平台返回 0
+    std::int64_t sinceProcessStart() {
+#ifdef _WIN32
+        FILETIME creation, exitTime, kernel, user, now;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+            return 0;
+        }
+        GetSystemTimePreciseAsFileTime(&now);
+        const auto toTicks = [](const FILETIME &time) {
+            return static_cast<std::int64_t>(time.dwHighDateTime) << 32 | time.dwLowDateTime;
+        };
+        return (toTicks(now) - toTicks(creation)) / 10;
+#else
+        return 0;
+#endif
+    }
+} // namespace
+
+std::expected<LaunchManifest, std::wstring> LaunchManifest::load(const std::span<const std::uint8_t> file) {
+    if (file.size() < JarLayout::PROBE_SIZE) {
+        return std::unexpected{L"文件太小，不包含有效的JAR信息"};
+    }
+
+    LaunchManifest manifest;
+    manifest.m_fileSize = file.size();
+
+    const auto metadataSize = JarLayout::metadataSize(file.last(JarLayout::PROBE_SIZE), manifest.m_fileSize);
+    if (!metadataSize) {
+        return std::unexpected{metadataSize.error()};
+    }
+    manifest.m_tail = file.last(static_cast<std::size_t>(std::max<std::uint64_t>(metadataSize.value(),
+                                                                                   JarLayout::PROBE_SIZE)));
+
+    auto info = JarLayout::parse(manifest.m_tail, manifest.m_fileSize);
+    if (!info) {
+        return std::unexpected{info.error()};
+    }
+    manifest.m_info = info.value();
+    manifest.m_decodedAt = sinceProcessStart();
+    return manifest;
+}
+
+std::string_view LaunchManifest::utf8(const JarLayout::StringId id) const {
+    return JarLayout::stringView(m_info, m_tail, m_fileSize, id);
+}
+
+std::wstring LaunchManifest::wide(const JarLayout::StringId id) const {
+    return widen(utf8(id));
+}
+
+std::vector<std::wstring> LaunchManifest::lines(const JarLayout::StringId id) const {
+    std::vector<std::wstring> result;
+    std::string_view rest = utf8(id);
+    while (!rest.empty()) {
+        const auto pos = rest.find('\n');
+        if (const auto line = rest.substr(0, pos); !line.empty()) {
+            result.push_back(widen(line));
+        }
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(pos + 1);
+    }
+    return result;
+}
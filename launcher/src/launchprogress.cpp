@@ -0,0 +1,165 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 启动进度，按阶段权重计算真实进度并发送给启动遮罩，提供 Java 端的本地方法
+
+**************************************************************************/
+#include "launchprogress.h"
+#include "jarcommon.h"
+
+import std;
+
+namespace {
+    using LaunchProgress::Stage;
+    using LaunchProgress::STAGE_COUNT;
+
+    // 各阶段在总进度中的权重，合计 100；Java 程序不报告进度时停在 90%
+    constexpr std::array<std::uint32_t, STAGE_COUNT> WEIGHTS{5, 40, 10, 30, 5, 10};
+    static_assert(std::ranges::fold_left(WEIGHTS, 0u, std::plus{}) == 100);
+
+    // 状态文本，随 WM_SPLASH_UPDATE 的 lParam 传给窗口，必须是静态字符串
+    constexpr std::array<const wchar_t *, STAGE_COUNT> LABELS{
+        L"正在读取启动信息", L"正在解压", L"正在加载 JVM", L"正在创建 JVM", L"正在启动程序", L"正在初始化",
+    };
+
+    // tick 推进的上限，千分比
+    constexpr std::uint32_t ESTIMATE_LIMIT = 900;
+
+    std::array<std::atomic<std::uint32_t>, STAGE_COUNT> g_fractions{};
+    std::array<std::atomic<std::uint32_t>, STAGE_COUNT> g_stageDone{};
+    std::atomic<std::uint32_t> g_splashClosed{0};
+    std::atomic<HWND> g_window{nullptr};
+    std::atomic<Stage> g_lastStage{Stage::Manifest};
+    LaunchProgress::Timings g_expected{}; // 只在主线程读写
+
+    // 距进程启动的毫秒数
+    std::uint32_t sinceProcessStart() {
+        FILETIME creation, exitTime, kernel, user, now;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user)) {
+            return 0;
+        }
+        GetSystemTimePreciseAsFileTime(&now);
+        const auto toTicks = [](const FILETIME &time) {
+            return static_cast<std::int64_t>(time.dwHighDateTime) << 32 | time.dwLowDateTime;
+        };
+        return static_cast<std::uint32_t>(std::max<std::int64_t>((toTicks(now) - toTicks(creation)) / 10000, 1));
+    }
+
+    std::uint32_t total() {
+        std::uint32_t permille = 0;
+        for (std::size_t i = 0; i < STAGE_COUNT; ++i) {
+            permille += WEIGHTS[i] * g_fractions[i].load(std::memory_order_relaxed);
+        }
+        return permille / 1000;
+    }
+
+    void post(const Stage stage) {
+        if (const HWND window = g_window.load()) {
+            PostMessageW(window, JarCommon::WM_SPLASH_UPDATE, total(),
+                         reinterpret_cast<LPARAM>(LABELS[static_cast<std::size_t>(stage)]));
+        }
+    }
+
+    void JNICALL nativeProgress(JNIEnv *, jclass, const jint percent) {
+        LaunchProgress::report(Stage::App, static_cast<std::uint32_t>(std::clamp(percent, 0, 100)) * 10);
+    }
+
+    void JNICALL nativeCloseSplash(JNIEnv *, jclass) {
+        std::uint32_t expected = 0;
+        g_splashClosed.compare_exchange_strong(expected, sinceProcessStart());
+        // 窗口属于主线程，由窗口过程自行销毁
+        if (const HWND window = g_window.exchange(nullptr)) {
+            PostMessageW(window, WM_CLOSE, 0, 0);
+        }
+    }
+} // namespace
+
+namespace LaunchProgress {
+    void report(const Stage stage, const std::uint32_t fraction) {
+        auto &current = g_fractions[static_cast<std::size_t>(stage)];
+        const std::uint32_t value = std::min<std::uint32_t>(fraction, 1000);
+        // 阶段进度只增不减
+        std::uint32_t previous = current.load(std::memory_order_relaxed);
+        while (previous < value && !current.compare_exchange_weak(previous, value)) {
+        }
+        if (previous >= value) {
+            return;
+        }
+        if (value == 1000) {
+            const std::uint32_t now = sinceProcessStart();
+            g_stageDone[static_cast<std::size_t>(stage)] = now;
+            if (stage == Stage::App) {
+                std::uint32_t expected = 0;
+                g_splashClosed.compare_exchange_strong(expected, now);
+            }
+        }
+        g_lastStage = stage;
+        post(stage);
+    }
+
+    void complete() {
+        for (std::size_t i = 0; i < STAGE_COUNT; ++i) {
+            report(static_cast<Stage>(i));
+        }
+    }
+
+    void reportCopy(const std::uint64_t copied, const std::uint64_t total) {
+        if (total > 0) {
+            report(Stage::Jar, static_cast<std::uint32_t>(copied * 1000 / total));
+        }
+    }
+
+    void attach(const HWND window) {
+        g_window = window;
+        post(g_lastStage.load());
+    }
+
+    bool registerNatives(JNIEnv *env) {
+        const jclass launcherClass = env->FindClass(LAUNCHER_CLASS);
+        if (!launcherClass) {
+            env->ExceptionClear();
+            return false;
+        }
+        const JNINativeMethod methods[] = {
+            {const_cast<char *>("progress"), const_cast<char *>("(I)V"), reinterpret_cast<void *>(&nativeProgress)},
+            {
+                const_cast<char *>("closeSplash"), const_cast<char *>("()V"),
+                reinterpret_cast<void *>(&nativeCloseSplash)
+            },
+        };
+        const bool registered = env->RegisterNatives(launcherClass, methods, std::size(methods)) == JNI_OK;
+        if (!registered) {
+            env->ExceptionClear();
+        }
+        env->DeleteLocalRef(launcherClass);
+        return registered;
+    }
+
+    Timings timings() {
+        Timings result;
+        for (std::size_t i = 0; i < STAGE_COUNT; ++i) {
+            result.stageDone[i] = g_stageDone[i];
+        }
+        result.splashClosed = g_splashClosed;
+        return result;
+    }
+
+    void setExpected(const Timings &expected) {
+        g_expected = expected;
+    }
+
+    void tick() {
+        const std::uint64_t now = sinceProcessStart();
+        for (std::size_t i = 0; i < STAGE_COUNT; ++i) {
+            if (const std::uint32_t expected = g_expected.stageDone[i]; expected > 0) {
+                report(static_cast<Stage>(i),
+                       static_cast<std::uint32_t>(std::min<std::uint64_t>(now * 1000 / expected, ESTIMATE_LIMIT)));
+            }
+        }
+    }
+} // namespace LaunchProgress
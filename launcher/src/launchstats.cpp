@@ -0,0 +1,133 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 启动耗时统计，按指数加权移动平均记录各阶段耗时
+
+**************************************************************************/
+#include "launchstats.h"
+#include "jarcache.h"
+#include "jarlayout.h"
+
+import std;
+
+namespace {
+    using LaunchProgress::STAGE_COUNT;
+    using LaunchProgress::Timings;
+
+    // 没有历史记录且未填写 launchTime 时的预计启动时间
+    constexpr DWORD DEFAULT_LAUNCH_TIME_MS = 10000;
+    // 自动关闭延迟的下限
+    constexpr DWORD MIN_CLOSE_DELAY_MS = 1000;
+
+    // 统计项：前 STAGE_COUNT 项为各阶段，最后一项为启动遮罩关闭时间
+    constexpr std::size_t FIELD_COUNT = STAGE_COUNT + 1;
+
+    std::array<std::uint32_t, FIELD_COUNT> toFields(const Timings &timings) {
+        std::array<std::uint32_t, FIELD_COUNT> fields{};
+        std::ranges::copy(timings.stageDone, fields.begin());
+        fields[STAGE_COUNT] = timings.splashClosed;
+        return fields;
+    }
+
+    Timings fromFields(const std::array<std::uint32_t, FIELD_COUNT> &fields) {
+        Timings timings;
+        std::ranges::copy_n(fields.begin(), STAGE_COUNT, timings.stageDone.begin());
+        timings.splashClosed = fields[STAGE_COUNT];
+        return timings;
+    }
+} // namespace
+
+namespace LaunchStats {
+    Path defaultFile(const std::wstring &executablePath) {
+        std::wstring path = std::filesystem::path(executablePath).lexically_normal().wstring();
+        CharLowerBuffW(path.data(), static_cast<DWORD>(path.size()));
+        const auto key = JarLayout::hash({
+            reinterpret_cast<const std::uint8_t *>(path.data()), path.size() * sizeof(wchar_t)
+        });
+        return JarCache::defaultRoot() / std::format(L"launch-{:016x}.stats", key);
+    }
+
+    // 每行一项：序号 \t 平均毫秒数
+    Timings load(const Path &file) {
+        std::array<std::uint32_t, FIELD_COUNT> fields{};
+        std::ifstream in(file, std::ios::binary);
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto tab = line.find('\t');
+            if (tab == std::string::npos) {
+                continue;
+            }
+            std::size_t index = 0;
+            std::uint32_t value = 0;
+            if (std::from_chars(line.data(), line.data() + tab, index).ec != std::errc{} ||
+                std::from_chars(line.data() + tab + 1, line.data() + line.size(), value).ec != std::errc{} ||
+                index >= FIELD_COUNT) {
+                continue;
+            }
+            fields[index] = value;
+        }
+        return fromFields(fields);
+    }
+
+    void record(const Path &file, const Timings &sample) {
+        auto fields = toFields(load(file));
+        const auto samples = toFields(sample);
+        bool changed = false;
+        for (std::size_t i = 0; i < FIELD_COUNT; ++i) {
+            if (samples[i] == 0) {
+                continue;
+            }
+            fields[i] = fields[i] == 0
+                            ? samples[i]
+                            : static_cast<std::uint32_t>(std::lround(fields[i] + ALPHA * (
+                                                                         static_cast<double>(samples[i]) - fields[i])));
+            changed = true;
+        }
+        if (!changed) {
+            return;
+        }
+
+        std::string content;
+        for (std::size_t i = 0; i < FIELD_COUNT; ++i) {
+            if (fields[i] != 0) {
+                content += std::format("{}\t{}\n", i, fields[i]);
+            }
+        }
+
+        // 先写入临时文件再重命名，同时退出的多个实例不会写出损坏的文件
+        std::error_code ec;
+        std::filesystem::create_directories(file.parent_path(), ec);
+        auto tmpPath = file;
+        tmpPath += std::format(L".{}.tmp", GetCurrentProcessId());
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write(content.data(), static_cast<std::streamsize>(content.size()));
+            if (!out) {
+                out.close();
+                std::filesystem::remove(tmpPath, ec);
+                return;
+            }
+        }
+        std::filesystem::rename(tmpPath, file, ec);
+        if (ec) {
+            std::filesystem::remove(tmpPath, ec);
+        }
+    }
+
+    DWORD closeDelay(const Timings &expected, const int launchTime) {
+        if (expected.splashClosed > 0) {
+            return std::max(MIN_CLOSE_DELAY_MS, static_cast<DWORD>(expected.splashClosed) * 3 / 2);
+        }
+        // Java 程序不报告时只知道调用 main 的时间，为窗口出现留出同样长的时间
+        if (const DWORD lastStage = std::ranges::max(expected.stageDone); lastStage > 0) {
+            return std::max(MIN_CLOSE_DELAY_MS, lastStage * 2);
+        }
+        const DWORD estimate = launchTime > 0 ? static_cast<DWORD>(launchTime) : DEFAULT_LAUNCH_TIME_MS;
+        return estimate * 3 / 2;
+    }
+} // namespace LaunchStats
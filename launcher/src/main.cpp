@@ -8,29 +8,25 @@
 #include <jni.h>
 #include <windows.h>
 #include "jarcommon.h"
+#include "filecopy.h"
+#include "filelock.h"
+#include "jarcache.h"
+#include "javadiscovery.h"
+#include "jvmdaemon.h"
+#include "launchmanifest.h"
+#include "launchprogress.h"
+#include "launchstats.h"
+#include "launchtrace.h"
+#include "mappedfile.h"
+#include "sharedarchive.h"
+#include "singleinstance.h"
 #include "splashscreen.h"
+#include "windowwatcher.h"
+#include "ziptail.h"
 #include <versionhelpers.h>
 
 import std;
 
-#pragma pack(push, 1)
-struct Footer {
-    uint64_t timestamp;
-};
-
-// ZIP End of Central Directory 记录结构
-struct EndOfCentralDirectory {
-    uint32_t signature; // 0x06054b50
-    uint16_t diskNumber;
-    uint16_t centralDirDiskNumber;
-    uint16_t recordsOnDisk;
-    uint16_t totalRecords;
-    uint32_t centralDirSize;
-    uint32_t centralDirOffset;
-    uint16_t commentLength;
-};
-#pragma pack(pop)
-
 class SplashGuard {
 private:
     bool m_shouldExit = false;
@@ -45,6 +41,7 @@ public:
     void closeSplash() {
         std::lock_guard lock(m_mutex);
         m_shouldExit = true;
+        LaunchProgress::attach(nullptr);
         if (m_splashScreen != nullptr) {
             m_splashScreen->Hide();
             m_splashScreen = nullptr;
@@ -57,6 +54,7 @@ public:
         m_splashScreen = std::move(splashScreen);
         if (m_splashScreen) {
             m_splashScreen->Show();
+            LaunchProgress::attach(m_splashScreen->GetHandle());
         }
         return true;
     }
@@ -64,58 +62,26 @@ public:
 
 static SplashGuard splashGuard{};
 
-// 查找 ZIP 文件的 End of Central Directory 记录
-static std::expected<size_t, std::wstring> findEOCD(const std::vector<uint8_t> &data) {
-    const uint32_t EOCD_SIGNATURE = 0x06054b50;
-    const size_t MIN_EOCD_SIZE = 22; // EOCD 最小大小
-
-    if (data.size() < MIN_EOCD_SIZE) {
-        return std::unexpected{L"文件太小，不是有效的 ZIP 文件"};
-    }
-
-    // 从文件末尾开始搜索 EOCD 签名
-    // 最多搜索 65535 + 22 字节（最大注释长度 + EOCD 大小）
-    size_t searchStart = (data.size() > 65557) ? (data.size() - 65557) : 0;
-
-    for (size_t i = data.size() - MIN_EOCD_SIZE; i >= searchStart; --i) {
-        uint32_t sig = *reinterpret_cast<const uint32_t *>(&data[i]);
-        if (sig == EOCD_SIGNATURE) {
-            // 验证这确实是 EOCD（通过检查注释长度是否正确）
-            size_t commentLengthOffset = i + 20;
-            uint16_t commentLength = *reinterpret_cast<const uint16_t *>(&data[commentLengthOffset]);
-
-            // EOCD + 注释应该正好到文件末尾
-            if (i + MIN_EOCD_SIZE + commentLength == data.size()) {
-                return i;
-            }
-        }
-        if (i == searchStart)
-            break;
-    }
-
-    return std::unexpected{L"未找到有效的 ZIP 结束标记"};
-}
-
 // UTF-8和宽字符转换辅助函数
-std::string wstringToUtf8(const std::wstring &wstr) {
-    return std::wstring_convert<std::codecvt_utf8<wchar_t> >().to_bytes(wstr);
-}
-
-std::wstring utf8ToWstring(const std::string &utf8) {
-    return std::wstring_convert<std::codecvt_utf8<wchar_t> >().from_bytes(utf8);
+std::string wstringToUtf8(const std::wstring_view wstr) {
+    if (wstr.empty()) {
+        return {};
+    }
+    const int length = WideCharToMultiByte(CP_UTF8, 0, wstr.data(), static_cast<int>(wstr.size()), nullptr, 0,
+                                           nullptr, nullptr);
+    std::string result(length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, wstr.data(), static_cast<int>(wstr.size()), result.data(), length, nullptr,
+                        nullptr);
+    return result;
 }
 
-// 辅助函数：分割宽字符串
-std::vector<std::wstring> splitWString(const std::wstring &str, wchar_t delimiter) {
-    std::vector<std::wstring> result;
-    std::wstringstream ss(str);
-    std::wstring item;
-
-    while (std::getline(ss, item, delimiter)) {
-        if (!item.empty()) {
-            result.push_back(item);
-        }
+std::wstring utf8ToWstring(const std::string_view utf8) {
+    if (utf8.empty()) {
+        return {};
     }
+    const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), nullptr, 0);
+    std::wstring result(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, utf8.data(), static_cast<int>(utf8.size()), result.data(), length);
     return result;
 }
 
@@ -128,162 +94,6 @@ std::expected<std::wstring, std::wstring> getCurrentExecutablePath() {
     return std::wstring(path);
 }
 
-// 查找Java路径
-std::expected<std::wstring, std::wstring> findJavaPath() {
-    // 首先检查环境变量JAVA_HOME
-    wchar_t javaHome[MAX_PATH];
-    if (GetEnvironmentVariableW(L"JAVA_HOME", javaHome, MAX_PATH) > 0) {
-        if (const auto javaPath = std::filesystem::path(javaHome) / L"bin" / JarCommon::JAVA_EXE_NAME;
-            std::filesystem::exists(javaPath)) {
-            return javaPath;
-        }
-    }
-
-    // 搜索PATH环境变量
-    if (SearchPathW(nullptr, JarCommon::JAVA_EXE_NAME, nullptr, MAX_PATH, javaHome, nullptr)) {
-        return std::wstring(javaHome);
-    }
-
-    // 检查常见安装路径
-    std::vector<std::wstring> searchPaths = {
-        L"C:\\Program Files\\Java", L"C:\\Program Files (x86)\\Java", L"C:\\Program Files\\Eclipse Adoptium",
-        L"C:\\Program Files\\Amazon Corretto", L"C:\\Program Files\\Microsoft\\jdk"
-    };
-
-    for (const auto &basePath: searchPaths) {
-        if (std::filesystem::exists(basePath)) {
-            for (const auto &entry: std::filesystem::directory_iterator(basePath)) {
-                if (entry.is_directory()) {
-                    if (auto javaExe = entry.path() / "bin" / JarCommon::JAVA_EXE_NAME;
-                        std::filesystem::exists(javaExe)) {
-                        return javaExe.wstring();
-                    }
-                }
-            }
-        }
-    }
-
-    return std::unexpected{L"未找到Java运行时环境"};
-}
-
-// 查找JVM.dll路径
-std::expected<std::wstring, std::wstring> findJvmPath() {
-    // 检查常见JVM路径
-    std::vector<std::wstring> searchPaths = {
-        L"C:\\Program Files\\Java", L"C:\\Program Files (x86)\\Java",
-        L"C:\\Program Files\\Eclipse Adoptium",
-        L"C:\\Program Files\\Amazon Corretto"
-    };
-
-    for (const auto &basePath: searchPaths) {
-        if (std::filesystem::exists(basePath)) {
-            for (const auto &entry: std::filesystem::directory_iterator(basePath)) {
-                if (entry.is_directory()) {
-                    // 优先查找server版本
-                    auto serverJvm = entry.path() / "bin" / "server" / JarCommon::JVM_DLL_NAME;
-                    if (std::filesystem::exists(serverJvm)) {
-                        return serverJvm.wstring();
-                    }
-                    // 备选client版本
-                    auto clientJvm = entry.path() / "bin" / "client" / JarCommon::JVM_DLL_NAME;
-                    if (std::filesystem::exists(clientJvm)) {
-                        return clientJvm.wstring();
-                    }
-                }
-            }
-        }
-    }
-
-    return std::unexpected{L"未找到JVM动态库"};
-}
-
-std::expected<bool, std::wstring>
-extractJarInfo(const std::wstring &filePath, uint64_t &jarOffset, uint64_t &jarSize, uint64_t &splashImageSize,
-               bool &splashShowProgress, bool &splashShowProgressText, int &launchTime, uint64_t &timestamp,
-               uint32_t &javaVersion, std::wstring &mainClass, std::vector<std::wstring> &jvmArgs,
-               std::vector<std::wstring> &programArgs, std::wstring &javaPath, std::wstring &jarExtractPath,
-               std::wstring &splashProgramName, std::wstring &splashProgramVersion, JarCommon::LaunchMode &launchMode,
-               float &titlePosX, float &titlePosY, float &versionPosX, float &versionPosY, float &statusPosX,
-               float &statusPosY, float &titleFontSizePercent, float &versionFontSizePercent,
-               float &statusFontSizePercent) {
-    std::ifstream file(filePath, std::ios::binary);
-    if (!file.is_open()) {
-        return std::unexpected{L"无法打开文件: " + filePath};
-    }
-
-    file.seekg(0, std::ios::end);
-    const int64_t fileSize = file.tellg();
-
-    if (fileSize < static_cast<int64_t>(sizeof(JarCommon::JarFooter))) {
-        return std::unexpected{L"文件太小，不包含有效的JAR信息"};
-    }
-
-    file.seekg(fileSize - sizeof(JarCommon::JarFooter));
-    JarCommon::JarFooter footer;
-    file.read(reinterpret_cast<char *>(&footer), sizeof(footer));
-
-    if (!file.good() || footer.magic != JarCommon::JAR_MAGIC) {
-        return std::unexpected{L"无效的JAR文件格式"};
-    }
-
-    const int64_t stringsOffset = fileSize - sizeof(JarCommon::JarFooter) - footer.mainClassLength -
-                                  footer.jvmArgsLength - footer.programArgsLength - footer.javaPathLength -
-                                  footer.jarExtractPathLength - footer.splashProgramNameLength -
-                                  footer.splashProgramVersionLength;
-    file.seekg(stringsOffset);
-
-    auto readUtf8String = [&](const uint32_t length) -> std::wstring {
-        if (length == 0)
-            return L"";
-        std::vector<char> buffer(length);
-        file.read(buffer.data(), length);
-        std::string utf8Str(buffer.begin(), buffer.end());
-        return utf8ToWstring(utf8Str);
-    };
-
-    mainClass = readUtf8String(footer.mainClassLength);
-
-    if (footer.jvmArgsLength > 0) {
-        const std::wstring jvmArgsStr = readUtf8String(footer.jvmArgsLength);
-        jvmArgs = splitWString(jvmArgsStr, L'\n');
-    } else {
-        jvmArgs.clear();
-    }
-
-    if (footer.programArgsLength > 0) {
-        const std::wstring programArgsStr = readUtf8String(footer.programArgsLength);
-        programArgs = splitWString(programArgsStr, L'\n');
-    } else {
-        programArgs.clear();
-    }
-
-    javaPath = readUtf8String(footer.javaPathLength);
-    jarExtractPath = readUtf8String(footer.jarExtractPathLength);
-    splashProgramName = readUtf8String(footer.splashProgramNameLength);
-    splashProgramVersion = readUtf8String(footer.splashProgramVersionLength);
-
-    jarOffset = footer.jarOffset;
-    jarSize = footer.jarSize;
-    splashImageSize = footer.splashImageSize;
-    splashShowProgress = footer.splashShowProgress;
-    splashShowProgressText = footer.splashShowProgressText;
-    launchTime = footer.launchTime;
-    javaVersion = footer.javaVersion;
-    launchMode = footer.launchMode;
-    titlePosX = footer.titlePosX;
-    titlePosY = footer.titlePosY;
-    versionPosX = footer.versionPosX;
-    versionPosY = footer.versionPosY;
-    statusPosX = footer.statusPosX;
-    statusPosY = footer.statusPosY;
-    titleFontSizePercent = footer.titleFontSizePercent;
-    versionFontSizePercent = footer.versionFontSizePercent;
-    statusFontSizePercent = footer.statusFontSizePercent;
-    timestamp = footer.timestamp;
-
-    return true;
-}
-
 std::wstring expandEnvironmentVariablesWindows(const std::wstring &path) {
     std::wstring result = path;
     const std::wregex envPattern(LR"(\$ENV\{([^}]+)\})");
@@ -309,58 +119,59 @@ std::wstring expandEnvironmentVariablesWindows(const std::wstring &path) {
     return result;
 }
 
-std::expected<bool, std::wstring> extractJarFile(const std::wstring &executablePath, const std::wstring &jarPath,
-                                                 const uint64_t jarOffset, const uint64_t jarSize,
-                                                 const Footer &footer) {
-    std::ifstream inFile(executablePath, std::ios::binary);
-    if (!inFile.is_open()) {
-        return std::unexpected{L"无法读取可执行文件: " + executablePath};
+std::expected<bool, std::wstring> extractJarFile(const std::wstring &executablePath, const uint64_t jarOffset,
+                                                 const std::span<const uint8_t> jarData, const bool stamped,
+                                                 const std::wstring &jarPath, const JarLayout::JarStamp &stamp) {
+    LaunchTrace::Span span("extractJarFile");
+    if (jarData.empty()) {
+        return std::unexpected{L"JAR 数据超出可执行文件范围"};
     }
 
-    // 先读取 JAR 数据到内存
-    inFile.seekg(jarOffset);
-    std::vector<uint8_t> jarData(jarSize);
-    inFile.read(reinterpret_cast<char *>(jarData.data()), jarSize);
-    inFile.close();
+    SetFileAttributesW(jarPath.c_str(), FILE_ATTRIBUTE_NORMAL);
 
-    if (inFile.gcount() != static_cast<std::streamsize>(jarSize)) {
-        return std::unexpected{L"读取JAR数据时发生错误"};
+    // 打包时已写入时间戳注释，直接按区间复制，无需解析 ZIP
+    if (stamped) {
+        if (const auto copyResult = FileCopy::copyRange(executablePath, jarOffset, jarData.size(), jarPath, {},
+                                                                 LaunchProgress::reportCopy);
+            !copyResult) {
+            return std::unexpected{L"解压JAR失败: " + copyResult.error()};
+        }
+        SetFileAttributesW(jarPath.c_str(), FILE_ATTRIBUTE_HIDDEN);
+        return true;
     }
 
+    // 只在 JAR 尾部定位 EOCD
+    const uint64_t jarSize = jarData.size();
+    const uint64_t tailSize = std::min<uint64_t>(jarSize, ZipTail::MAX_SEARCH_SIZE);
+    const uint64_t tailOffset = jarSize - tailSize;
+    const auto tailData = jarData.last(static_cast<size_t>(tailSize));
+
     // 查找 EOCD 位置
-    auto eocdResult = findEOCD(jarData);
+    const auto eocdResult = ZipTail::locate(tailData, tailOffset);
     if (!eocdResult.has_value()) {
         return std::unexpected{L"JAR 文件格式无效: " + eocdResult.error()};
     }
 
-    size_t eocdPos = eocdResult.value();
-    EndOfCentralDirectory *eocd = reinterpret_cast<EndOfCentralDirectory *>(&jarData[eocdPos]);
-
-    // 更新 EOCD 中的注释长度字段
-    uint16_t oldCommentLength = eocd->commentLength;
-    eocd->commentLength = sizeof(Footer);
-
-    // 准备输出
-    SetFileAttributesW(jarPath.c_str(), FILE_ATTRIBUTE_NORMAL);
-    std::ofstream outFile(jarPath, std::ios::binary);
-    if (!outFile.is_open()) {
-        return std::unexpected{L"无法创建输出文件: " + jarPath};
+    // 旧版打包文件：更新 EOCD 中的注释长度字段，原有注释不再写入，时间戳作为新的注释
+    struct {
+        ZipTail::EndOfCentralDirectory eocd;
+        JarLayout::JarStamp stamp;
+    } trailer{eocdResult->eocd, stamp};
+    trailer.eocd.commentLength = sizeof(JarLayout::JarStamp);
+    static_assert(sizeof(trailer) == ZipTail::EOCD_SIZE + sizeof(JarLayout::JarStamp));
+
+    // EOCD 之前的数据是原样的区间复制，交给 FileCopy 使用块克隆或内核复制
+    const auto copyResult = FileCopy::copyRange(executablePath, jarOffset, eocdResult->eocdOffset, jarPath,
+                                                {reinterpret_cast<const uint8_t *>(&trailer), sizeof(trailer)},
+                                                LaunchProgress::reportCopy);
+    if (!copyResult) {
+        return std::unexpected{L"解压JAR失败: " + copyResult.error()};
     }
-
-    // 写入 JAR 数据（不包括原有注释）
-    size_t jarDataEnd = jarSize - oldCommentLength;
-    outFile.write(reinterpret_cast<const char *>(jarData.data()), jarDataEnd);
-
-    // 写入时间戳作为新的注释
-    outFile.write(reinterpret_cast<const char *>(&footer), sizeof(Footer));
-
-    outFile.close();
     SetFileAttributesW(jarPath.c_str(), FILE_ATTRIBUTE_HIDDEN);
 
     return true;
 }
 
-
 std::wstring calculateMD5(const std::vector<std::uint8_t> &data) {
     HCRYPTPROV hProv = 0;
     HCRYPTHASH hHash = 0;
@@ -422,48 +233,54 @@ std::expected<bool, std::wstring> verifyJarFile(const std::wstring &jarPath, con
     return actualMD5Result.value() == expectedMD5;
 }
 
-std::expected<bool, std::wstring> verifyJarFile(const std::wstring &jarPath, const uint64_t timestamp) {
-    std::ifstream inFile(jarPath, std::ios::binary);
-    if (!inFile) {
-        return std::unexpected{L"读取jar文件失败, " + jarPath};
+std::expected<bool, std::wstring> verifyJarFile(const std::wstring &jarPath, const uint64_t timestamp,
+                                                const uint64_t expectedSize) {
+    LaunchTrace::Span span("verifyJarFile");
+    // 只读取 EOCD 可能存在的尾部区域，校验耗时与 JAR 大小无关
+    const auto stamp = JarLayout::readStamp(jarPath, expectedSize);
+    if (!stamp) {
+        return std::unexpected{stamp.error()};
     }
-
-    // 读取整个文件
-    inFile.seekg(0, std::ios::end);
-    const size_t fileSize = inFile.tellg();
-    inFile.seekg(0, std::ios::beg);
-
-    std::vector<uint8_t> fileData(fileSize);
-    inFile.read(reinterpret_cast<char *>(fileData.data()), fileSize);
-    inFile.close();
-
-    // 查找 EOCD
-    auto eocdResult = findEOCD(fileData);
-    if (!eocdResult.has_value()) {
-        return std::unexpected{L"无效的 JAR 文件格式: " + eocdResult.error()};
+    if (stamp->timestamp == timestamp) {
+        return true;
     }
 
-    size_t eocdPos = eocdResult.value();
-    EndOfCentralDirectory *eocd = reinterpret_cast<EndOfCentralDirectory *>(&fileData[eocdPos]);
+    return std::unexpected{L"时间戳校验失败: 时间戳不匹配"};
+}
 
-    // 检查是否有注释
-    if (eocd->commentLength != sizeof(Footer)) {
-        return std::unexpected{L"时间戳校验失败: 注释大小不匹配"};
+// 按 exe 名称解压 jar：持有锁文件期间写入临时文件，再原子重命名为正式文件，
+// 并发启动的其他进程等待锁后重新校验，不会读到写了一半的 jar
+std::expected<bool, std::wstring> extractJarFileLocked(
+    const std::wstring &jarPath, const uint64_t timestamp, const uint64_t expectedSize,
+    const std::function<std::expected<bool, std::wstring>(const std::wstring &)> &extract) {
+    if (std::filesystem::exists(jarPath) && verifyJarFile(jarPath, timestamp, expectedSize)) {
+        return true;
     }
 
-    // 读取注释区域的时间戳
-    size_t commentStart = eocdPos + sizeof(EndOfCentralDirectory);
-    Footer *footer = reinterpret_cast<Footer *>(&fileData[commentStart]);
-
-    if (footer->timestamp == timestamp) {
+    const auto lock = FileLock::acquire(jarPath + L".lock");
+    if (!lock) {
+        return std::unexpected{lock.error()};
+    }
+    // 等待期间其他进程可能已经完成解压
+    if (std::filesystem::exists(jarPath) && verifyJarFile(jarPath, timestamp, expectedSize)) {
         return true;
     }
 
-    return std::unexpected{L"时间戳校验失败: 时间戳不匹配"};
+    const std::wstring tmpPath = std::format(L"{}.{}.tmp", jarPath, GetCurrentProcessId());
+    if (auto extractResult = extract(tmpPath); !extractResult) {
+        DeleteFileW(tmpPath.c_str());
+        return extractResult;
+    }
+    SetFileAttributesW(jarPath.c_str(), FILE_ATTRIBUTE_NORMAL);
+    if (!MoveFileExW(tmpPath.c_str(), jarPath.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileW(tmpPath.c_str());
+        return std::unexpected{L"无法替换JAR文件，可能正在被使用: " + jarPath};
+    }
+    return true;
 }
 
-// 使用java.exe启动JAR
-std::expected<bool, std::wstring> launchWithJavaExe(const std::wstring &javaPath, const std::wstring &jarPath,
+// 使用java.exe启动JAR，返回子进程句柄，由调用方关闭
+std::expected<HANDLE, std::wstring> launchWithJavaExe(const std::wstring &javaPath, const std::wstring &jarPath,
                                                     const std::vector<std::wstring> &jvmArgs,
                                                     const std::vector<std::wstring> &programArgs) {
     std::wstring command = L"\"" + javaPath + L"\"";
@@ -490,22 +307,31 @@ std::expected<bool, std::wstring> launchWithJavaExe(const std::wstring &javaPath
         return std::unexpected{L"启动Java进程失败"};
     }
 
-    CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
-    return true;
+    return pi.hProcess;
 }
 
-// 使用JVM.dll启动JAR
-std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath, const std::wstring &jarPath,
-                                                   const unsigned int javaVersion, const std::wstring &mainClass,
-                                                   const std::vector<std::wstring> &jvmArgs,
-                                                   const std::vector<std::wstring> &programArgs) {
+// 已创建的 JVM
+struct JavaVMInstance {
+    HMODULE module = nullptr;
+    JavaVM *jvm = nullptr;
+    JNIEnv *env = nullptr;
+};
+
+// 加载 jvm.dll 并在当前线程创建 JVM，extraOptions 用于传入 exit/abort 等钩子
+std::expected<JavaVMInstance, std::wstring> createJavaVM(const std::wstring &jvmPath, const std::wstring &jarPath,
+                                                         const unsigned int javaVersion,
+                                                         const std::vector<std::wstring> &jvmArgs,
+                                                         const std::vector<JavaVMOption> &extraOptions = {}) {
     std::filesystem::path jvmDllPath = jvmPath;
     std::filesystem::path jvmDir = jvmDllPath.parent_path();
     std::filesystem::path jreBin = jvmDir.parent_path();
 
     SetDllDirectoryW(jreBin.wstring().c_str());
-    const HMODULE jvmHandle = LoadLibraryW(jvmPath.c_str());
+    const HMODULE jvmHandle = [&] {
+        LaunchTrace::Span span("LoadLibraryW(jvm.dll)");
+        return LoadLibraryW(jvmPath.c_str());
+    }();
     if (!jvmHandle) {
         return std::unexpected{L"无法加载JVM动态库"};
     }
@@ -517,6 +343,7 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
         FreeLibrary(jvmHandle);
         return std::unexpected{L"无法获取JNI_CreateJavaVM函数"};
     }
+    LaunchProgress::report(LaunchProgress::Stage::JvmLoad);
 
     // 构建JVM选项
     std::vector<std::string> options;
@@ -531,6 +358,7 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
         vmOptions[i].optionString = const_cast<char *>(options[i].c_str());
         vmOptions[i].extraInfo = nullptr;
     }
+    vmOptions.insert(vmOptions.end(), extraOptions.begin(), extraOptions.end());
 
     JavaVMInitArgs vmArgs;
     vmArgs.version = javaVersion;
@@ -540,12 +368,78 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
 
     JavaVM *jvm = nullptr;
     JNIEnv *env = nullptr;
-    jint result = CreateJavaVM_func(&jvm, (void **) &env, &vmArgs);
+    jint result;
+    {
+        LaunchTrace::Span span("JNI_CreateJavaVM");
+        result = CreateJavaVM_func(&jvm, (void **) &env, &vmArgs);
+    }
 
     if (result != JNI_OK) {
         FreeLibrary(jvmHandle);
         return std::unexpected{L"创建JVM失败"};
     }
+    LaunchProgress::report(LaunchProgress::Stage::JvmCreate);
+    return JavaVMInstance{jvmHandle, jvm, env};
+}
+
+// 等待当前线程之外的非守护线程全部结束，与 DestroyJavaVM 开始销毁前的等待相同；等待期间新建的线程同样会被等待
+void joinNonDaemonThreads(JNIEnv *env) {
+    const jclass threadClass = env->FindClass("java/lang/Thread");
+    const jclass mapClass = env->FindClass("java/util/Map");
+    const jclass setClass = env->FindClass("java/util/Set");
+    if (!threadClass || !mapClass || !setClass) {
+        env->ExceptionClear();
+        return;
+    }
+    const jmethodID currentThread = env->GetStaticMethodID(threadClass, "currentThread", "()Ljava/lang/Thread;");
+    const jmethodID allThreads = env->GetStaticMethodID(threadClass, "getAllStackTraces", "()Ljava/util/Map;");
+    const jmethodID isDaemon = env->GetMethodID(threadClass, "isDaemon", "()Z");
+    const jmethodID join = env->GetMethodID(threadClass, "join", "()V");
+    const jmethodID keySet = env->GetMethodID(mapClass, "keySet", "()Ljava/util/Set;");
+    const jmethodID toArray = env->GetMethodID(setClass, "toArray", "()[Ljava/lang/Object;");
+    if (!currentThread || !allThreads || !isDaemon || !join || !keySet || !toArray) {
+        env->ExceptionClear();
+        return;
+    }
+
+    const jobject self = env->CallStaticObjectMethod(threadClass, currentThread);
+    bool joined = true;
+    while (joined) {
+        joined = false;
+        env->PushLocalFrame(16);
+        const jobject map = env->CallStaticObjectMethod(threadClass, allThreads);
+        const jobject set = map ? env->CallObjectMethod(map, keySet) : nullptr;
+        const auto threads = set ? static_cast<jobjectArray>(env->CallObjectMethod(set, toArray)) : nullptr;
+        if (!threads || env->ExceptionCheck()) {
+            env->ExceptionClear();
+            env->PopLocalFrame(nullptr);
+            break;
+        }
+        const jsize count = env->GetArrayLength(threads);
+        for (jsize i = 0; i < count; ++i) {
+            const jobject thread = env->GetObjectArrayElement(threads, i);
+            if (!env->IsSameObject(thread, self) && !env->CallBooleanMethod(thread, isDaemon)) {
+                env->CallVoidMethod(thread, join);
+                env->ExceptionClear();
+                joined = true;
+            }
+            env->DeleteLocalRef(thread);
+        }
+        env->PopLocalFrame(nullptr);
+    }
+    env->DeleteLocalRef(self);
+}
+
+// 使用JVM.dll启动JAR
+std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath, const std::wstring &jarPath,
+                                                   const unsigned int javaVersion, const std::wstring &mainClass,
+                                                   const std::vector<std::wstring> &jvmArgs,
+                                                   const std::vector<std::wstring> &programArgs) {
+    const auto instance = createJavaVM(jvmPath, jarPath, javaVersion, jvmArgs);
+    if (!instance) {
+        return std::unexpected{instance.error()};
+    }
+    const auto [jvmHandle, jvm, env] = instance.value();
 
     // 查找并调用main方法
     if (mainClass.empty()) {
@@ -557,7 +451,11 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
     std::string classPath = wstringToUtf8(mainClass);
     std::replace(classPath.begin(), classPath.end(), '.', '/');
 
-    jclass mainClassObj = env->FindClass(classPath.c_str());
+    jclass mainClassObj;
+    {
+        LaunchTrace::Span span("FindClass(main)");
+        mainClassObj = env->FindClass(classPath.c_str());
+    }
     if (!mainClassObj) {
         jvm->DestroyJavaVM();
         FreeLibrary(jvmHandle);
@@ -571,6 +469,36 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
         return std::unexpected{L"找不到main方法"};
     }
 
+    // 单实例模式下后续启动转发的参数交给主类的 onNewInstance，主类没有该方法时忽略
+    // 图形界面程序的 main 通常立即返回，窗口线程结束前仍需接收参数，因此销毁 JVM 前先等待非守护线程再清除回调
+    bool forwarding = false;
+    if (const jmethodID onNewInstance = env->GetStaticMethodID(mainClassObj, "onNewInstance",
+                                                               "([Ljava/lang/String;)V")) {
+        const auto mainClassRef = static_cast<jclass>(env->NewGlobalRef(mainClassObj));
+        SingleInstance::setHandler([jvm, mainClassRef, onNewInstance](const std::vector<std::wstring> &args) {
+            JNIEnv *threadEnv = nullptr;
+            if (jvm->AttachCurrentThreadAsDaemon(reinterpret_cast<void **>(&threadEnv), nullptr) != JNI_OK) {
+                return;
+            }
+            jobjectArray newArgs = threadEnv->NewObjectArray(static_cast<jsize>(args.size()),
+                                                             threadEnv->FindClass("java/lang/String"), nullptr);
+            for (size_t i = 0; i < args.size(); ++i) {
+                jstring argStr = threadEnv->NewString(reinterpret_cast<const jchar *>(args[i].data()),
+                                                      static_cast<jsize>(args[i].size()));
+                threadEnv->SetObjectArrayElement(newArgs, static_cast<jsize>(i), argStr);
+                threadEnv->DeleteLocalRef(argStr);
+            }
+            threadEnv->CallStaticVoidMethod(mainClassRef, onNewInstance, newArgs);
+            if (threadEnv->ExceptionCheck()) {
+                threadEnv->ExceptionDescribe();
+            }
+            jvm->DetachCurrentThread();
+        });
+        forwarding = true;
+    } else {
+        env->ExceptionClear();
+    }
+
     // 创建参数数组
     jobjectArray javaArgs =
             env->NewObjectArray(static_cast<jsize>(programArgs.size()), env->FindClass("java/lang/String"), nullptr);
@@ -580,7 +508,9 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
         env->DeleteLocalRef(argStr);
     }
 
-    // 调用main方法
+    // 调用main方法，Java 程序提供 JarLauncher 类时由它报告后续进度并关闭启动遮罩
+    LaunchProgress::registerNatives(env);
+    LaunchProgress::report(LaunchProgress::Stage::Main);
     env->CallStaticVoidMethod(mainClassObj, mainMethod, javaArgs);
 
     if (env->ExceptionCheck()) {
@@ -706,12 +636,20 @@ std::expected<bool, std::wstring> launchWithJvmDll(const std::wstring &jvmPath,
         env->DeleteLocalRef(ex);
     }
 
+    if (forwarding) {
+        joinNonDaemonThreads(env);
+    }
+    SingleInstance::clearHandler();
     jvm->DestroyJavaVM();
     FreeLibrary(jvmHandle);
 
     return std::unexpected{error};
 }
 
+    if (forwarding) {
+        joinNonDaemonThreads(env);
+    }
+    SingleInstance::clearHandler();
     jvm->DestroyJavaVM();
     FreeLibrary(jvmHandle);
     return true;
@@ -743,23 +681,40 @@ std::wstring parseJavaVersion(const uint32_t javaVersion) {
     return javaVer;
 }
 
-void showJarInfo(const std::wstring &mainClass, const uint32_t javaVersion, const uint64_t splashImageSize,
-                 const bool splashShowProgress, const bool splashShowProgressText, const int launchTime,
-                 const uint64_t timestamp, const std::vector<std::wstring> &jvmArgs,
-                 const std::vector<std::wstring> &programArgs, const std::wstring &javaPath,
-                 const std::wstring &jarExtractPath, const std::wstring &splashProgramName,
-                 const std::wstring &splashProgramVersion, const JarCommon::LaunchMode launchMode, uint64_t jarOffset,
-                 uint64_t jarSize) {
+void showJarInfo(const LaunchManifest &manifest) {
+    using JarLayout::StringId;
+    const auto &settings = manifest.settings();
+    const auto javaVersion = settings.javaVersion;
+    const auto timestamp = settings.timestamp;
+    const auto launchMode = settings.launchMode;
+    const auto launchTime = settings.launchTime;
+    const bool splashShowProgress = settings.splashShowProgress != 0;
+    const bool splashShowProgressText = settings.splashShowProgressText != 0;
+    const auto splashImageSize = manifest.splashImage().size;
+    const auto mainClass = manifest.wide(StringId::MainClass);
+    const auto javaPath = manifest.wide(StringId::JavaPath);
+    const auto jarExtractPath = manifest.wide(StringId::JarExtractPath);
+    const auto splashProgramName = manifest.wide(StringId::SplashProgramName);
+    const auto splashProgramVersion = manifest.wide(StringId::SplashProgramVersion);
+    const auto jvmArgs = manifest.lines(StringId::JvmArgs);
+    const auto programArgs = manifest.lines(StringId::ProgramArgs);
+
     std::wstringstream info;
     info << L"=== JAR 信息 ===\n";
-    info << L"JAR 偏移: " << jarOffset << L"\n";
-    info << L"JAR 大小: " << jarSize << L" 字节\n";
+    info << L"JAR 偏移: " << manifest.jar().offset << L"\n";
+    info << L"JAR 大小: " << manifest.jar().size << L" 字节\n";
+    info << L"元数据版本: " << manifest.version() << L"\n";
+    info << L"元数据解析完成(距进程启动): " << manifest.decodedAt() << L" 微秒\n";
 
     const auto javaVer = parseJavaVersion(javaVersion);
     info << L"Java 版本: " << (javaVer.empty() ? L"未指定" : javaVer) << L"\n";
     info << L"时间戳: " << timestamp << L"\n";
-    info << L"启动模式: " << (launchMode == JarCommon::LaunchMode::DirectJVM ? L"direct_jvm" : JarCommon::JAVA_EXE_NAME)
-            << L"\n";
+    info << L"启动模式: " << (launchMode == JarCommon::LaunchMode::DirectJVM
+                                    ? L"direct_jvm"
+                                    : launchMode == JarCommon::LaunchMode::Daemon
+                                    ? L"daemon"
+                                    : JarCommon::JAVA_EXE_NAME) << L"\n";
+    info << L"单实例: " << (settings.singleInstance != 0 ? L"是" : L"否") << L"\n";
     info << L"主类: " << (mainClass.empty() ? L"未指定" : mainClass) << L"\n";
     info << L"Java 路径: " << (javaPath.empty() ? L"未指定" : javaPath) << L"\n";
     info << L"Splash 图片大小: " << splashImageSize << L" 字节\n";
@@ -803,47 +758,219 @@ void showError(const std::wstring &message, const bool sync = false) {
     }
 }
 
-std::vector<char> loadImageFromExe(const std::wstring &exePath, const uint64_t imgOffset, const uint64_t imageSize) {
-    std::vector<char> imageData;
-    if (imageSize == 0)
-        return imageData;
+// 进度由各启动阶段通过 LaunchProgress 报告，两次报告之间和自动关闭延迟按历史耗时估计
+void updateSplashProgress(const std::shared_ptr<SplashScreen> &splash, const int launchTime,
+                          const std::wstring &executablePath) {
+    if (splash == nullptr)return;
+    const auto statsFile = LaunchStats::defaultFile(executablePath);
+    const auto expected = LaunchStats::load(statsFile);
+    LaunchProgress::setExpected(expected);
+    splash->SetAutoCloseDelay(LaunchStats::closeDelay(expected, launchTime));
 
-    imageData.resize(imageSize);
+    constexpr UINT tickInterval = 50;
+    const UINT_PTR tickTimer = SetTimer(nullptr, 0, tickInterval, nullptr);
+    MSG msg;
+    while (GetMessage(&msg, nullptr, 0, 0)) {
+        if (msg.message == WM_TIMER && msg.hwnd == nullptr && msg.wParam == tickTimer) {
+            LaunchProgress::tick();
+            continue;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    KillTimer(nullptr, tickTimer);
+    LaunchStats::record(statsFile, LaunchProgress::timings());
+}
 
-    std::ifstream file(exePath, std::ios::binary);
-    if (!file.is_open()) {
-        std::wcerr << L"无法打开文件: " << exePath << std::endl;
-        return {};
+// 检查并提取JAR文件，返回启动时使用的 jar 路径，直接运行模式下 exe 本身就是 jar
+std::expected<std::wstring, std::wstring> prepareJarFile(const std::wstring &executablePath,
+                                                         const LaunchManifest &manifest,
+                                                         const std::span<const uint8_t> jarData) {
+    LaunchTrace::Span span("jar");
+    if (manifest.runFromExe()) {
+        return executablePath;
     }
 
-    file.seekg(imgOffset, std::ios::beg);
-    file.read(imageData.data(), imageSize);
+    const auto &settings = manifest.settings();
+    const auto extractPath = expandEnvironmentVariablesWindows(manifest.wide(JarLayout::StringId::JarExtractPath));
+    const auto extract = [&](const std::wstring &targetPath) {
+        return extractJarFile(executablePath, manifest.jar().offset, jarData, manifest.jarStamped(), targetPath,
+                              {settings.timestamp});
+    };
+    // 已解压的 jar 必须正好是这个大小，截断或残留的文件都重新解压
+    const auto expectedSize = JarLayout::extractedSize(jarData, manifest.jarStamped());
+    if (!expectedSize) {
+        return std::unexpected{expectedSize.error()};
+    }
 
-    if (!file) {
-        std::wcerr << L"读取图片数据失败！" << std::endl;
-        imageData.clear();
+    if (JarCache::valid(settings.jarDigest)) {
+        // 按内容摘要放入共享缓存，内容相同的 jar 在多个 exe 和多次打包之间复用
+        const auto cacheRoot = JarCache::root(extractPath);
+        const auto entry = JarCache::acquire(cacheRoot, settings.jarDigest, expectedSize.value(), executablePath,
+                                             [&](const JarCache::Path &tmpPath) {
+                                                 return extract(tmpPath.wstring());
+                                             });
+        if (!entry) {
+            return std::unexpected{entry.error()};
+        }
+        // 解压了新 jar 时立即清理，命中时按间隔清理，长期只命中缓存的 exe 也能淘汰过期内容
+        if (entry->hit) {
+            JarCache::evictIfDue(cacheRoot, settings.jarDigest);
+        } else {
+            JarCache::evict(cacheRoot, settings.jarDigest);
+        }
+        return entry->jarPath.wstring();
     }
 
-    return imageData;
+    // 旧版打包文件没有内容摘要，按 exe 名称解压并用时间戳校验
+    const auto fileStem = std::filesystem::path(executablePath).stem().wstring();
+    const std::wstring jarPath = std::filesystem::path(extractPath) / (fileStem + L".jar");
+    if (auto extractResult = extractJarFileLocked(jarPath, settings.timestamp, expectedSize.value(), extract);
+        !extractResult) {
+        return std::unexpected{extractResult.error()};
+    }
+    return jarPath;
 }
 
-void updateSplashProgress(const std::shared_ptr<SplashScreen> &splash, int launchTime) {
-    if (splash == nullptr)return;
-    constexpr DWORD interval = 20;
-    if (launchTime <= 0) {
-        launchTime = 10000;
+// 启动所用的 Java 运行时，jvmDllPath 为空时使用 java.exe
+struct JavaRuntime {
+    std::filesystem::path jvmDllPath;
+    std::filesystem::path javaExePath;
+};
+
+// 查找 Java 运行时。DirectJVM 与守护模式下找到 jvm.dll 后立即在当前线程加载，
+// 与 jar 解压并行完成 DLL 映射和重定位，启动时 LoadLibraryW 只增加引用计数
+JavaRuntime discoverJavaRuntime(const JarCommon::LaunchMode launchMode, const std::wstring &javaPath,
+                                const std::uint32_t javaVersion) {
+    LaunchTrace::Span span("discovery");
+    JavaRuntime runtime;
+
+    if (launchMode != JarCommon::LaunchMode::JavaExe) {
+        // 优先在 javaPath 下找 server/client jvm.dll
+        auto serverJvm = std::filesystem::path(javaPath) / "server" / JarCommon::JVM_DLL_NAME;
+        auto clientJvm = std::filesystem::path(javaPath) / "client" / JarCommon::JVM_DLL_NAME;
+
+        if (std::filesystem::exists(serverJvm)) {
+            runtime.jvmDllPath = serverJvm;
+        } else if (std::filesystem::exists(clientJvm)) {
+            runtime.jvmDllPath = clientJvm;
+        }
+
+        // 如果还没找到，使用查找缓存或完整扫描
+        if (runtime.jvmDllPath.empty()) {
+            if (auto res = JavaDiscovery::find(JavaDiscovery::Binary::Jvm, javaPath, javaVersion)) {
+                runtime.jvmDllPath = res.value();
+            }
+        }
+
+        if (!runtime.jvmDllPath.empty()) {
+            LaunchTrace::Span preloadSpan("LoadLibraryW(jvm.dll) preload");
+            SetDllDirectoryW(runtime.jvmDllPath.parent_path().parent_path().c_str());
+            if (LoadLibraryW(runtime.jvmDllPath.c_str())) {
+                LaunchProgress::report(LaunchProgress::Stage::JvmLoad);
+            }
+            return runtime;
+        }
     }
-    const double step = 100.0 / launchTime * interval;
-    splash->StartAutoProgress(step, interval);
-    splash->SetAutoCloseDelay(launchTime * 1.5);
 
-    MSG msg;
-    while (GetMessage(&msg, nullptr, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+    // java.exe 模式，或未找到 jvm.dll 时的回退
+    runtime.javaExePath = std::filesystem::path(javaPath) / JarCommon::JAVA_EXE_NAME;
+    if (!std::filesystem::exists(runtime.javaExePath)) {
+        if (auto res = JavaDiscovery::find(JavaDiscovery::Binary::Java, javaPath, javaVersion)) {
+            runtime.javaExePath = res.value();
+        }
     }
+    return runtime;
 }
 
+/**
+ * 守护模式启动
+ * @param daemon 本进程是否为守护进程：是则创建 JVM 并处理请求，否则把本次启动转发给守护进程，没有时先启动一个
+ * @param forwardArgs 本次启动的命令行参数
+ * @return 进程退出码；守护进程正忙时返回空，由调用方在本进程内启动
+ */
+std::optional<int> runDaemonMode(const bool daemon, const std::wstring &executablePath, const LaunchManifest &manifest,
+                  const std::span<const uint8_t> jarData, const std::vector<std::wstring> &forwardArgs) {
+    using JarLayout::StringId;
+    const auto &settings = manifest.settings();
+
+    // 管道名包含 jar 与 JVM 参数的哈希，重新打包后的启动不会连到旧 jar 的守护进程
+    const auto jvmArgsText = manifest.utf8(StringId::JvmArgs);
+    const auto key = JarLayout::hash({reinterpret_cast<const std::uint8_t *>(jvmArgsText.data()), jvmArgsText.size()},
+                                     manifest.jarHash() != 0 ? manifest.jarHash() : settings.timestamp);
+    const auto pipeName = JvmDaemon::pipeName(key);
+
+    if (!daemon) {
+        auto result = JvmDaemon::forward(pipeName, forwardArgs);
+        if (!result && !result.error().busy) {
+            const auto process = JvmDaemon::spawn(executablePath);
+            if (!process) {
+                showError(process.error(), true);
+                return 1;
+            }
+            result = JvmDaemon::forward(pipeName, forwardArgs, process.value());
+            CloseHandle(process.value());
+        }
+        if (!result && result.error().busy) {
+            return std::nullopt;
+        }
+        if (!result) {
+            showError(result.error().message, true);
+            return 1;
+        }
+        return result.value();
+    }
+
+    // 先占用管道名，同时启动的多个守护进程只保留一个
+    const auto pipe = JvmDaemon::listen(pipeName);
+    if (!pipe) {
+        return static_cast<int>(JvmDaemon::EXIT_ALREADY_RUNNING);
+    }
+
+    const auto jarPath = prepareJarFile(executablePath, manifest, jarData);
+    if (!jarPath) {
+        showError(jarPath.error(), true);
+        return 1;
+    }
+    const auto runtime = discoverJavaRuntime(settings.launchMode, manifest.wide(StringId::JavaPath),
+                                             settings.javaVersion);
+    if (runtime.jvmDllPath.empty()) {
+        showError(L"守护模式需要 jvm.dll，未找到可用的 Java 运行时", true);
+        return 1;
+    }
+
+    // System.exit 会结束守护进程，通过 exit 钩子把退出码交给当前客户端
+    const std::vector<JavaVMOption> hooks{
+        {const_cast<char *>("exit"), reinterpret_cast<void *>(&JvmDaemon::onExit)}
+    };
+    const auto instance = createJavaVM(runtime.jvmDllPath, jarPath.value(), settings.javaVersion,
+                                       manifest.lines(StringId::JvmArgs), hooks);
+    if (!instance) {
+        showError(L"守护进程创建 JVM 失败: " + instance.error(), true);
+        return 1;
+    }
+    const auto [jvmHandle, jvm, env] = instance.value();
+
+    std::string classPath = wstringToUtf8(manifest.wide(StringId::MainClass));
+    std::replace(classPath.begin(), classPath.end(), '.', '/');
+    const jclass mainClass = classPath.empty() ? nullptr : env->FindClass(classPath.c_str());
+    const jmethodID mainMethod = mainClass
+                                     ? env->GetStaticMethodID(mainClass, "main", "([Ljava/lang/String;)V")
+                                     : nullptr;
+    if (!mainMethod) {
+        env->ExceptionClear();
+        jvm->DestroyJavaVM();
+        FreeLibrary(jvmHandle);
+        showError(L"找不到主类或main方法: " + manifest.wide(StringId::MainClass), true);
+        return 1;
+    }
+
+    const int exitCode = JvmDaemon::serve(pipe.value(), env, mainClass, mainMethod,
+                                          manifest.lines(StringId::ProgramArgs));
+    jvm->DestroyJavaVM();
+    FreeLibrary(jvmHandle);
+    return exitCode;
+}
 
 void SetDpiAwarenessIfNeeded() {
     typedef BOOL (WINAPI *SetProcessDpiAwarenessContext_t)(DPI_AWARENESS_CONTEXT);
@@ -859,6 +986,7 @@ void SetDpiAwarenessIfNeeded() {
 }
 
 int wmain(int argc, wchar_t *argv[]) {
+    LaunchTrace::init();
     SetDpiAwarenessIfNeeded();
     SetConsoleOutputCP(CP_UTF8);
     _setmode(_fileno(stdout), _O_U8TEXT);
@@ -885,150 +1013,162 @@ int wmain(int argc, wchar_t *argv[]) {
             return 1;
         }
 
-        // 提取JAR信息
-        uint64_t jarOffset, jarSize, imageSize;
-        uint32_t javaVersion;
-        std::wstring mainClass, javaPath, jarExtractPath, splashProgramName, splashProgramVersion;
-        std::vector<std::wstring> jvmArgs, programArgs;
-        JarCommon::LaunchMode launchMode;
-        bool splashShowProgress, splashShowProgressText;
-        int launchTime;
-        uint64_t timestamp;
-        float titlePosX, titlePosY, versionPosX, versionPosY;
-        float statusPosX, statusPosY;
-        float titleFontSizePercent, versionFontSizePercent, statusFontSizePercent;
-
-        auto result = extractJarInfo(executablePath, jarOffset, jarSize, imageSize, splashShowProgress,
-                                     splashShowProgressText, launchTime, timestamp, javaVersion, mainClass, jvmArgs,
-                                     programArgs, javaPath, jarExtractPath, splashProgramName, splashProgramVersion,
-                                     launchMode, titlePosX, titlePosY, versionPosX, versionPosY, statusPosX, statusPosY,
-                                     titleFontSizePercent, versionFontSizePercent, statusFontSizePercent);
+        // 映射可执行文件，后续各阶段直接使用映射视图
+        auto mappingResult = MappedFile::open(executablePath);
+        if (!mappingResult) {
+            showError(mappingResult.error());
+            return 1;
+        }
+        const MappedFile &mapping = mappingResult.value();
 
-        if (!result) {
-            showError(result.error());
+        // 提取JAR信息
+        auto manifestResult = [&] {
+            LaunchTrace::Span span("extractJarInfo");
+            return LaunchManifest::load(mapping.data());
+        }();
+        if (!manifestResult) {
+            showError(manifestResult.error());
             return 1;
         }
+        const LaunchManifest &manifest = manifestResult.value();
+        LaunchProgress::report(LaunchProgress::Stage::Manifest);
 
         // 如果是info命令，显示信息后退出
         if (showInfo) {
-            showJarInfo(mainClass, javaVersion, imageSize, splashShowProgress, splashShowProgressText, launchTime,
-                        timestamp, jvmArgs, programArgs, javaPath, jarExtractPath, splashProgramName,
-                        splashProgramVersion, launchMode, jarOffset, jarSize);
+            showJarInfo(manifest);
             return 0;
         }
 
+        using JarLayout::StringId;
+        const auto &settings = manifest.settings();
+        const auto jarData = mapping.view(manifest.jar().offset, manifest.jar().size);
+        const auto imageData = mapping.view(manifest.splashImage().offset, manifest.splashImage().size);
+        const JarCommon::LaunchMode launchMode = settings.launchMode;
+        const std::wstring javaPath = manifest.wide(StringId::JavaPath);
+        const std::vector<std::wstring> jvmArgs = manifest.lines(StringId::JvmArgs);
+        std::vector<std::wstring> programArgs = manifest.lines(StringId::ProgramArgs);
+
+        // 单实例：已有实例运行时只转发参数，不解压 jar 也不创建 JVM；对方已退出时按普通方式启动
+        if (settings.singleInstance != 0 && launchMode == JarCommon::LaunchMode::DirectJVM &&
+            !SingleInstance::acquire(executablePath)) {
+            LaunchTrace::Span span("forward");
+            if (SingleInstance::forward(executablePath, {argv + 1, argv + argc})) {
+                return 0;
+            }
+        }
+
+        // 守护模式不显示启动遮罩，由守护进程中已预热的 JVM 执行；守护进程正忙时按直接加载 JVM 的方式启动
+        if (launchMode == JarCommon::LaunchMode::Daemon) {
+            const bool daemon = argc > 1 && std::wstring_view(argv[1]) == JvmDaemon::DAEMON_ARGUMENT;
+            if (const auto exitCode = runDaemonMode(daemon, executablePath, manifest, jarData,
+                                                    {argv + 1, argv + argc})) {
+                return *exitCode;
+            }
+        }
+
         // 将命令行参数添加到程序参数列表（从第二个参数开始，因为第一个是程序名）
         // 这样当通过文件关联启动时，被打开的文件路径会传递给 Java 程序
         for (int i = 1; i < argc; ++i) {
             programArgs.emplace_back(argv[i]);
         }
 
-        std::thread t([&] {
+        // 启动任务图：jar 准备、运行时查找（含 jvm.dll 预加载）与主线程的启动遮罩解码并行执行，
+        // 启动 JVM 前等待三者全部完成
+        auto jarTask = std::async(std::launch::async, prepareJarFile, std::cref(executablePath), std::cref(manifest),
+                                  jarData);
+        auto runtimeTask = std::async(std::launch::async, discoverJavaRuntime, launchMode, std::cref(javaPath),
+                                      settings.javaVersion);
+        std::promise<void> splashReady;
+        std::stop_source watchStop; // 启动遮罩关闭后不再等待子进程的窗口
+
+        std::thread t([&, splashShown = splashReady.get_future()] {
             struct Defer {
                 ~Defer() {
                     splashGuard.closeSplash();
                 }
             } defer{};
-            // 检查并提取JAR文件
-            auto fileStem = std::filesystem::path(executablePath.c_str()).stem().wstring();
-            bool needExtract = true;
-            const std::wstring expandJarExtractPath =
-                    std::filesystem::path(expandEnvironmentVariablesWindows(jarExtractPath)) / (fileStem + L".jar");
-
-            if (std::filesystem::exists(expandJarExtractPath)) {
-                if (auto verifyResult = verifyJarFile(expandJarExtractPath, timestamp); verifyResult) {
-                    needExtract = false;
-                }
+
+            const auto jarPath = jarTask.get();
+            if (!jarPath) {
+                showError(jarPath.error());
+                return 1;
             }
+            LaunchProgress::report(LaunchProgress::Stage::Jar);
+            const auto runtime = runtimeTask.get();
+            splashShown.wait();
+            LaunchTrace::Span span("launch");
+
+            // 类数据共享归档放在 jar 旁边；直接运行模式下 exe 所在目录可能不可写，放在缓存目录
+            const std::filesystem::path jarFile = jarPath.value();
+            const auto archiveDir = manifest.runFromExe() ? JarCache::defaultRoot() : jarFile.parent_path();
+            const auto archiveStem = manifest.runFromExe() ? SharedArchive::appStem(jarFile) : jarFile.stem().wstring();
+            const std::uint64_t jarKey = manifest.jarHash() != 0 ? manifest.jarHash() : settings.timestamp;
+            const auto withArchive = [&](const std::filesystem::path &javaHome, const bool commandLine) {
+                auto args = SharedArchive::options(javaHome, archiveDir, archiveStem, jarKey, jvmArgs, commandLine);
+                args.insert(args.end(), jvmArgs.begin(), jvmArgs.end());
+                return args;
+            };
 
-            if (needExtract) {
-                const Footer footer{timestamp};
-                if (auto extractResult =
-                            extractJarFile(executablePath, expandJarExtractPath, jarOffset, jarSize, footer);
-                    !extractResult) {
-                    showError(extractResult.error());
+            // 根据启动模式启动JAR
+            if (!runtime.jvmDllPath.empty()) {
+                // <home>/bin/server/jvm.dll
+                const auto javaHome = runtime.jvmDllPath.parent_path().parent_path().parent_path();
+                if (auto launchResult = launchWithJvmDll(runtime.jvmDllPath, jarPath.value(), settings.javaVersion,
+                                                         manifest.wide(StringId::MainClass),
+                                                         withArchive(javaHome, false), programArgs);
+                    !launchResult) {
+                    showError(L"JVM 模式启动失败: " + launchResult.error());
                     return 1;
                 }
+                return 0;
             }
 
-            // 根据启动模式启动JAR
             if (launchMode == JarCommon::LaunchMode::DirectJVM) {
-                // direct_jvm
-                std::filesystem::path jvmDllPath;
-
-                // 优先在 javaPath 下找 server/client jvm.dll
-                auto serverJvm = std::filesystem::path(javaPath) / "server" / JarCommon::JVM_DLL_NAME;
-                auto clientJvm = std::filesystem::path(javaPath) / "client" / JarCommon::JVM_DLL_NAME;
-
-                if (std::filesystem::exists(serverJvm)) {
-                    jvmDllPath = serverJvm;
-                } else if (std::filesystem::exists(clientJvm)) {
-                    jvmDllPath = clientJvm;
-                }
-
-                // 如果还没找到，调用 findJvmPath
-                if (jvmDllPath.empty()) {
-                    if (auto res = findJvmPath()) {
-                        jvmDllPath = res.value();
-                    }
-                }
-
-                if (jvmDllPath.empty()) {
-                    showError(L"未找到 jvm.dll，正在尝试使用 java.exe 模式...", false);
-
-                    std::filesystem::path javaExePath = std::filesystem::path(javaPath) / JarCommon::JAVA_EXE_NAME;
-
-                    if (!std::filesystem::exists(javaExePath)) {
-                        if (auto res = findJavaPath()) {
-                            javaExePath = res.value();
-                        }
-                    }
-
-                    if (auto launchResult = launchWithJavaExe(javaExePath, expandJarExtractPath, jvmArgs, programArgs);
-                        !launchResult) {
-                        showError(launchResult.error());
-                        return 1;
-                    }
-                } else {
-                    if (auto launchResult = launchWithJvmDll(jvmDllPath, expandJarExtractPath, javaVersion, mainClass,
-                                                             jvmArgs, programArgs);
-                        !launchResult) {
-                        showError(L"JVM 模式启动失败: " + launchResult.error());
-                        return 1;
-                    }
-                }
-            } else {
-                // java.exe 模式
-                std::filesystem::path javaExePath = std::filesystem::path(javaPath) / JarCommon::JAVA_EXE_NAME;
-
-                if (!std::filesystem::exists(javaExePath)) {
-                    if (auto res = findJavaPath()) {
-                        javaExePath = res.value();
-                    }
-                }
-
-                if (auto launchResult = launchWithJavaExe(javaExePath, expandJarExtractPath, jvmArgs, programArgs);
-                    !launchResult) {
-                    showError(launchResult.error());
-                    return 1;
+                showError(L"未找到 jvm.dll，正在尝试使用 java.exe 模式...", false);
+            }
+            // <home>/bin/java.exe
+            const auto javaHome = runtime.javaExePath.parent_path().parent_path();
+            const auto process = launchWithJavaExe(runtime.javaExePath, jarPath.value(), withArchive(javaHome, true),
+                                                   programArgs);
+            if (!process) {
+                showError(process.error());
+                return 1;
+            }
+            // 显示启动遮罩时等到子进程的第一个窗口出现再关闭
+            if (!imageData.empty()) {
+                const auto watcher = WindowWatcher::processProvider(process.value());
+                if (WindowWatcher::wait(*watcher, WindowWatcher::DEFAULT_TIMEOUT_MS, watchStop.get_token()) ==
+                    WindowWatcher::Result::WindowShown) {
+                    LaunchProgress::complete();
                 }
             }
+            CloseHandle(process.value());
             return 0;
         });
 
-        if (imageSize > 0 && IsWindows10OrGreater()) {
-            if (const auto imageData = loadImageFromExe(executablePath, jarOffset + jarSize, imageSize);
-                !imageData.empty()) {
-                const auto splash = std::make_shared<SplashScreen>(imageData, splashProgramName, splashProgramVersion,
-                                                                   splashShowProgress, splashShowProgressText,
-                                                                   titlePosX, titlePosY, versionPosX, versionPosY,
-                                                                   statusPosX, statusPosY, titleFontSizePercent,
-                                                                   versionFontSizePercent, statusFontSizePercent);
-                if (splashGuard.initSplash(splash)) {
-                    updateSplashProgress(splash, launchTime);
-                }
+        if (!imageData.empty() && IsWindows10OrGreater()) {
+            std::shared_ptr<SplashScreen> splash;
+            {
+                LaunchTrace::Span span("splash decode");
+                splash = std::make_shared<SplashScreen>(
+                    imageData, manifest.wide(StringId::SplashProgramName), manifest.wide(StringId::SplashProgramVersion),
+                    settings.splashShowProgress != 0, settings.splashShowProgressText != 0, settings.titlePosX,
+                    settings.titlePosY, settings.versionPosX, settings.versionPosY, settings.statusPosX,
+                    settings.statusPosY, settings.titleFontSizePercent, settings.versionFontSizePercent,
+                    settings.statusFontSizePercent);
+            }
+            const bool shown = [&] {
+                LaunchTrace::Span span("splash first frame");
+                return splashGuard.initSplash(splash);
+            }();
+            splashReady.set_value();
+            if (shown) {
+                updateSplashProgress(splash, settings.launchTime, executablePath);
             }
+        } else {
+            splashReady.set_value();
         }
+        watchStop.request_stop();
         t.join();
         return 0;
     } catch (const std::exception &e) {
@@ -0,0 +1,105 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 托管的类数据共享归档，按 jar 与 JDK 生成并复用
+
+**************************************************************************/
+#include "sharedarchive.h"
+#include "jarlayout.h"
+#include "javadiscovery.h"
+
+import std;
+
+namespace {
+    using SharedArchive::Path;
+
+    // 用户已自行配置时不再添加
+    constexpr std::array<std::wstring_view, 6> USER_OPTIONS = {
+        L"-Xshare", L"-XX:SharedArchiveFile", L"-XX:ArchiveClassesAtExit", L"-XX:+AutoCreateSharedArchive",
+        L"-XX:AOTCache", L"-XX:AOTMode"
+    };
+
+    // JVM 标识：JDK 目录、版本、厂商以及 release 文件的修改时间，JDK 原地升级后随之变化
+    std::uint64_t jvmKey(const JavaDiscovery::Runtime &runtime) {
+        std::error_code ec;
+        const auto mtime = std::filesystem::last_write_time(runtime.home / L"release", ec);
+        const auto identity = std::format(L"{}|{}|{}|{}", runtime.home.wstring(), runtime.version,
+                                          runtime.implementor, ec ? 0 : mtime.time_since_epoch().count());
+        return JarLayout::hash({reinterpret_cast<const std::uint8_t *>(identity.data()),
+                                identity.size() * sizeof(wchar_t)});
+    }
+
+    // 删除同一前缀下其他 jar 或 JDK 生成的旧归档，正在使用的归档删除失败时保留
+    void removeStale(const Path &archiveDir, const std::wstring &stem, const Path &current) {
+        std::error_code ec;
+        for (const auto &entry: std::filesystem::directory_iterator(archiveDir, ec)) {
+            const auto &path = entry.path();
+            const auto extension = path.extension();
+            if (path == current || (extension != L".jsa" && extension != L".aot") ||
+                !path.filename().wstring().starts_with(stem + L".")) {
+                continue;
+            }
+            std::error_code removeEc;
+            std::filesystem::remove(path, removeEc);
+        }
+    }
+} // namespace
+
+namespace SharedArchive {
+    std::wstring appStem(const Path &exePath) {
+        std::error_code ec;
+        auto normalized = std::filesystem::weakly_canonical(exePath, ec);
+        if (ec) {
+            normalized = std::filesystem::absolute(exePath, ec).lexically_normal();
+        }
+        auto identity = normalized.wstring();
+#ifdef _WIN32
+        // NTFS 路径不区分大小写
+        std::ranges::transform(identity, identity.begin(), [](const wchar_t c) { return std::towlower(c); });
+#endif
+        return std::format(L"app-{:016x}", JarLayout::hash({reinterpret_cast<const std::uint8_t *>(identity.data()),
+                                                            identity.size() * sizeof(wchar_t)}));
+    }
+
+    std::vector<std::wstring> options(const Path &javaHome, const Path &archiveDir, const std::wstring &stem,
+                                      const std::uint64_t jarKey, const std::vector<std::wstring> &jvmArgs,
+                                      const bool commandLine) {
+        if (std::ranges::any_of(jvmArgs, [](const std::wstring &arg) {
+            return std::ranges::any_of(USER_OPTIONS, [&](const std::wstring_view option) {
+                return arg.starts_with(option);
+            });
+        })) {
+            return {};
+        }
+
+        const auto runtime = JavaDiscovery::readRelease(javaHome);
+        if (runtime.feature < 13) {
+            return {};
+        }
+
+        const bool aot = runtime.feature >= 25;
+        const Path archive = archiveDir / std::format(L"{}.{:016x}-{:016x}{}", stem, jarKey, jvmKey(runtime),
+                                                      aot ? L".aot" : L".jsa");
+        const auto quoted = commandLine ? L"\"" + archive.wstring() + L"\"" : archive.wstring();
+
+        std::error_code ec;
+        const bool exists = std::filesystem::is_regular_file(archive, ec);
+        if (!exists) {
+            std::filesystem::create_directories(archiveDir, ec);
+            removeStale(archiveDir, stem, archive);
+        }
+
+        if (aot) {
+            return {(exists ? L"-XX:AOTCache=" : L"-XX:AOTCacheOutput=") + quoted};
+        }
+        if (runtime.feature >= 19) {
+            return {L"-XX:+AutoCreateSharedArchive", L"-XX:SharedArchiveFile=" + quoted};
+        }
+        return {(exists ? L"-XX:SharedArchiveFile=" : L"-XX:ArchiveClassesAtExit=") + quoted};
+    }
+} // namespace SharedArchive
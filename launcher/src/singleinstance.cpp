@@ -0,0 +1,283 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 单实例模式，通过命名互斥量判断已运行的实例，用命名管道转发命令行参数
+
+**************************************************************************/
+#define NOMINMAX
+#include <windows.h>
+#include "jarlayout.h"
+#include "singleinstance.h"
+
+import std;
+
+namespace {
+    constexpr std::uint32_t MESSAGE_MAGIC = 0x4953504A; // "JPSI"
+    constexpr std::uint32_t MAX_MESSAGE_SIZE = 1024 * 1024;
+    constexpr DWORD PIPE_BUFFER_SIZE = 16 * 1024;
+    constexpr DWORD RETRY_MS = 20;
+
+    struct State {
+        std::mutex mutex;
+        std::condition_variable idle;
+        bool owner = false;
+        bool closed = false; // clearHandler 之后收到的参数直接丢弃
+        int active = 0; // 正在执行的回调数
+        SingleInstance::Handler handler;
+        std::vector<std::vector<std::wstring>> pending; // 设置回调前收到的参数
+    };
+
+    State &state() {
+        static State instance;
+        return instance;
+    }
+
+    // 同一 exe 的所有启动使用相同的名称，路径不区分大小写
+    std::uint64_t instanceKey(const std::wstring &executablePath) {
+        std::wstring path = std::filesystem::path(executablePath).lexically_normal().wstring();
+        CharLowerBuffW(path.data(), static_cast<DWORD>(path.size()));
+        return JarLayout::hash({reinterpret_cast<const std::uint8_t *>(path.data()), path.size() * sizeof(wchar_t)});
+    }
+
+    // Local\ 前缀使互斥量只在当前会话中可见
+    std::wstring mutexName(const std::uint64_t key) {
+        return std::format(L"Local\\JarPackager-instance-{:016x}", key);
+    }
+
+    std::wstring pipeName(const std::uint64_t key) {
+        DWORD sessionId = 0;
+        ProcessIdToSessionId(GetCurrentProcessId(), &sessionId);
+        return std::format(L"\\\\.\\pipe\\JarPackager-instance-{}-{:016x}", sessionId, key);
+    }
+
+    bool readExact(const HANDLE pipe, void *data, DWORD size) {
+        auto *bytes = static_cast<std::uint8_t *>(data);
+        while (size > 0) {
+            DWORD done = 0;
+            if (!ReadFile(pipe, bytes, size, &done, nullptr) || done == 0) {
+                return false;
+            }
+            bytes += done;
+            size -= done;
+        }
+        return true;
+    }
+
+    bool writeExact(const HANDLE pipe, const void *data, DWORD size) {
+        const auto *bytes = static_cast<const std::uint8_t *>(data);
+        while (size > 0) {
+            DWORD done = 0;
+            if (!WriteFile(pipe, bytes, size, &done, nullptr) || done == 0) {
+                return false;
+            }
+            bytes += done;
+            size -= done;
+        }
+        return true;
+    }
+
+    // 消息：uint32 长度 + uint32 magic + uint32 参数个数 + 每个参数的 uint32 字符数和 UTF-16 数据
+    std::vector<std::uint8_t> encode(const std::vector<std::wstring> &args) {
+        std::vector<std::uint8_t> message(sizeof(std::uint32_t) * 3);
+        const auto append = [&](const void *data, const std::size_t size) {
+            const auto *bytes = static_cast<const std::uint8_t *>(data);
+            message.insert(message.end(), bytes, bytes + size);
+        };
+        for (const auto &arg: args) {
+            const auto length = static_cast<std::uint32_t>(arg.size());
+            append(&length, sizeof(length));
+            append(arg.data(), arg.size() * sizeof(wchar_t));
+        }
+        const std::uint32_t header[] = {
+            static_cast<std::uint32_t>(message.size() - sizeof(std::uint32_t)), MESSAGE_MAGIC,
+            static_cast<std::uint32_t>(args.size())
+        };
+        std::memcpy(message.data(), header, sizeof(header));
+        return message;
+    }
+
+    std::optional<std::vector<std::wstring>> receive(const HANDLE pipe) {
+        std::uint32_t size = 0;
+        if (!readExact(pipe, &size, sizeof(size)) || size < sizeof(std::uint32_t) * 2 || size > MAX_MESSAGE_SIZE) {
+            return std::nullopt;
+        }
+        std::vector<std::uint8_t> payload(size);
+        if (!readExact(pipe, payload.data(), size)) {
+            return std::nullopt;
+        }
+
+        std::uint32_t header[2];
+        std::memcpy(header, payload.data(), sizeof(header));
+        if (header[0] != MESSAGE_MAGIC) {
+            return std::nullopt;
+        }
+        std::span<const std::uint8_t> rest = std::span{payload}.subspan(sizeof(header));
+        std::vector<std::wstring> args;
+        for (std::uint32_t i = 0; i < header[1]; ++i) {
+            std::uint32_t length = 0;
+            if (rest.size() < sizeof(length)) {
+                return std::nullopt;
+            }
+            std::memcpy(&length, rest.data(), sizeof(length));
+            rest = rest.subspan(sizeof(length));
+            if (rest.size() / sizeof(wchar_t) < length) {
+                return std::nullopt;
+            }
+            std::wstring arg(length, L'\0');
+            std::memcpy(arg.data(), rest.data(), length * sizeof(wchar_t));
+            rest = rest.subspan(length * sizeof(wchar_t));
+            args.push_back(std::move(arg));
+        }
+
+        // 回执：发送方收到后才退出，保证参数不会丢失
+        constexpr std::uint8_t ack = 1;
+        writeExact(pipe, &ack, sizeof(ack));
+        return args;
+    }
+
+    void deliver(std::vector<std::wstring> args) {
+        auto &s = state();
+        SingleInstance::Handler handler;
+        {
+            std::lock_guard lock(s.mutex);
+            if (s.closed) {
+                return;
+            }
+            if (!s.handler) {
+                s.pending.push_back(std::move(args));
+                return;
+            }
+            handler = s.handler;
+            ++s.active;
+        }
+        handler(args);
+        {
+            std::lock_guard lock(s.mutex);
+            --s.active;
+        }
+        s.idle.notify_all();
+    }
+
+    // 逐个处理转发请求，随进程退出结束
+    void listen(const std::wstring name) {
+        const HANDLE pipe = CreateNamedPipeW(name.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                             PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT |
+                                             PIPE_REJECT_REMOTE_CLIENTS,
+                                             1, PIPE_BUFFER_SIZE, PIPE_BUFFER_SIZE, 0, nullptr);
+        if (pipe == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        while (true) {
+            if (ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED) {
+                auto args = receive(pipe);
+                DisconnectNamedPipe(pipe);
+                if (args) {
+                    deliver(std::move(*args));
+                }
+            } else {
+                DisconnectNamedPipe(pipe);
+            }
+        }
+    }
+} // namespace
+
+namespace SingleInstance {
+    bool acquire(const std::wstring &executablePath) {
+        const auto key = instanceKey(executablePath);
+        // 互斥量只用于标识实例是否存在，句柄保持到进程退出
+        const HANDLE mutex = CreateMutexW(nullptr, FALSE, mutexName(key).c_str());
+        if (!mutex) {
+            return true;
+        }
+        if (GetLastError() == ERROR_ALREADY_EXISTS) {
+            CloseHandle(mutex);
+            return false;
+        }
+
+        {
+            std::lock_guard lock(state().mutex);
+            state().owner = true;
+        }
+        std::thread(listen, pipeName(key)).detach();
+        return true;
+    }
+
+    std::expected<bool, std::wstring> forward(const std::wstring &executablePath,
+                                              const std::vector<std::wstring> &args) {
+        const auto key = instanceKey(executablePath);
+        const auto name = pipeName(key);
+        const ULONGLONG start = GetTickCount64();
+        HANDLE pipe;
+        while (true) {
+            pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+            if (pipe != INVALID_HANDLE_VALUE) {
+                break;
+            }
+            if (GetLastError() == ERROR_PIPE_BUSY) {
+                WaitNamedPipeW(name.c_str(), RETRY_MS);
+            } else {
+                // 管道尚未创建：互斥量仍存在说明第一个实例还在启动，否则它已退出
+                const HANDLE mutex = OpenMutexW(SYNCHRONIZE, FALSE, mutexName(key).c_str());
+                if (!mutex) {
+                    return std::unexpected{L"已运行的实例已退出"};
+                }
+                CloseHandle(mutex);
+                Sleep(RETRY_MS);
+            }
+            if (GetTickCount64() - start > FORWARD_TIMEOUT_MS) {
+                return std::unexpected{L"等待已运行的实例超时"};
+            }
+        }
+
+        // 前台窗口权限属于当前启动，交给已运行的实例以便其激活窗口
+        if (ULONG serverPid = 0; GetNamedPipeServerProcessId(pipe, &serverPid)) {
+            AllowSetForegroundWindow(serverPid);
+        }
+
+        const auto message = encode(args);
+        std::uint8_t ack = 0;
+        const bool ok = writeExact(pipe, message.data(), static_cast<DWORD>(message.size())) &&
+                        readExact(pipe, &ack, sizeof(ack));
+        CloseHandle(pipe);
+        if (!ok) {
+            return std::unexpected{L"转发参数失败"};
+        }
+        return true;
+    }
+
+    void setHandler(Handler handler) {
+        auto &s = state();
+        std::vector<std::vector<std::wstring>> pending;
+        {
+            std::lock_guard lock(s.mutex);
+            if (!s.owner) {
+                return;
+            }
+            s.handler = std::move(handler);
+            s.closed = false;
+            pending = std::move(s.pending);
+        }
+        if (!pending.empty()) {
+            // 不在调用方线程上交付，调用方通常是即将执行 main 的 JVM 线程
+            std::thread([pending = std::move(pending)]() mutable {
+                for (auto &args: pending) {
+                    deliver(std::move(args));
+                }
+            }).detach();
+        }
+    }
+
+    void clearHandler() {
+        auto &s = state();
+        std::unique_lock lock(s.mutex);
+        s.handler = nullptr;
+        s.closed = true;
+        s.pending.clear();
+        s.idle.wait(lock, [&] { return s.active == 0; });
+    }
+} // namespace SingleInstance
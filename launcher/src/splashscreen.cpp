@@ -21,7 +21,7 @@ Description: 纯GDI+实现的启动遮罩，支持DPI缩放和自动进度更新
 static ULONG_PTR g_gdiplusToken = 0;
 static int g_gdiplusRefCount = 0;
 
-SplashScreen::SplashScreen(const std::vector<char> &pngData, const std::wstring &programName,
+SplashScreen::SplashScreen(const std::span<const std::uint8_t> pngData, const std::wstring &programName,
                            const std::wstring &programVersion, bool showProgress, bool showProgressText,
                            float titlePosX, float titlePosY, float versionPosX, float versionPosY, float statusPosX,
                            float statusPosY, float titleFontSizePercent, float versionFontSizePercent,
@@ -105,7 +105,7 @@ float SplashScreen::GetDPIScale() {
     return static_cast<float>(dpiX) / 96.0f;
 }
 
-void SplashScreen::CreateBitmapFromPNG(const std::vector<char> &pngData) {
+void SplashScreen::CreateBitmapFromPNG(const std::span<const std::uint8_t> pngData) {
     if (pngData.empty()) {
         CreateDefaultBackground();
         return;
@@ -535,16 +535,27 @@ LRESULT CALLBACK SplashScreen::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, L
                 pThis->StopAutoProgress();
 
                 // wParam: progress (0-100)
+                // lParam: 可选的阶段名称，静态字符串
                 int progress = static_cast<int>(wParam);
+                const auto *stage = reinterpret_cast<const wchar_t *>(lParam);
 
                 // 如果新进度比当前进度小，则忽略（防止回退）
                 if (static_cast<double>(progress) >= pThis->m_progress) {
                     // 格式化状态文本 "正在加载...  50.00%"
-                    std::wstring statusText = std::format(L"正在加载... {:>6.2f}%", static_cast<double>(progress));
+                    std::wstring statusText = std::format(L"{}... {:>6.2f}%", stage ? stage : L"正在加载",
+                                                          static_cast<double>(progress));
                     pThis->UpdateProgress(progress, &statusText);
+                    if (progress >= 100) {
+                        pThis->Close();
+                    }
                 }
                 return 0;
             }
+            case WM_CLOSE: {
+                // 其他线程通过 PostMessage 请求关闭
+                pThis->Close();
+                return 0;
+            }
             case WM_DESTROY: {
                 PostQuitMessage(0);
                 break;
@@ -564,7 +575,7 @@ LRESULT CALLBACK SplashScreen::WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, L
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine, int nCmdShow) {
 
-    std::vector<char> pngData;
+    std::vector<std::uint8_t> pngData;
     // ... 加载PNG数据 ...
 
     // 创建启动遮罩
@@ -589,7 +600,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine, int nCmdShow) {
 
-    std::vector<char> pngData;
+    std::vector<std::uint8_t> pngData;
     SplashScreen splash(pngData, L"我的应用程序", L"版本 3.0.0");
 
     splash.Show();
@@ -9,6 +9,7 @@
 #include <QtWidgets/QMainWindow>
 #include <expected>
 
+#include "attach.h"
 #include "jarcommon.h"
 
 
@@ -42,6 +43,8 @@ public:
     QString iconPath{};
     bool showConsole = false;
     bool requireAdmin = false;
+    bool runFromExe = false; // 直接从exe运行，不解压jar
+    bool singleInstance = false; // 单实例，参数转发给已运行的实例
     QString externalExePath{};
     bool enableZip = false;
     QStringList zipPaths{};
@@ -89,7 +92,7 @@ public:
     };
 
     struct Config {
-        QByteArray exeData;
+        AttachedExe exeData; // 启动器模板，映射自打包程序自身
         QString jarPath;
         QString splashImagePath;
         bool splashShowProgress;
@@ -118,8 +121,10 @@ public:
         float versionFontSizePercent;
         float statusFontSizePercent;
         bool requireAdmin;
+        bool runFromExe; // 直接从exe运行，不解压jar
+        bool singleInstance; // 单实例，参数转发给已运行的实例
 
-        Config(const QByteArray &exeData_, const QString &jarPath_, const QString &splashImagePath_,
+        Config(const AttachedExe &exeData_, const QString &jarPath_, const QString &splashImagePath_,
                const bool splashShowProgress_, const bool splashShowProgressText_, int launchTime_,
                unsigned int javaVersion_, const QString &outputPath_, const QString &mainClass_,
                const QStringList &jvmArgs_, const QStringList &programArgs_, const QString &javaPath_,
@@ -127,7 +132,8 @@ public:
                const JarCommon::LaunchMode launchMode_, const QString &iconPath_, const bool showConsole_,
                float titlePosX_, float titlePosY_, float versionPosX_, float versionPosY_, float statusPosX_,
                float statusPosY_, float titleFontSizePercent_, float versionFontSizePercent_,
-               float statusFontSizePercent_, const bool requireAdmin_) : exeData(exeData_), jarPath(jarPath_),
+               float statusFontSizePercent_, const bool requireAdmin_,
+               const bool runFromExe_ = false, const bool singleInstance_ = false) : exeData(exeData_), jarPath(jarPath_),
                                                                          splashImagePath(splashImagePath_),
                                                                          splashShowProgress(splashShowProgress_),
                                                                          splashShowProgressText(
@@ -151,7 +157,9 @@ public:
                                                                          versionFontSizePercent(
                                                                              versionFontSizePercent_),
                                                                          statusFontSizePercent(statusFontSizePercent_),
-                                                                         requireAdmin(requireAdmin_) {
+                                                                         requireAdmin(requireAdmin_),
+                                                                         runFromExe(runFromExe_),
+                                                                         singleInstance(singleInstance_) {
         }
     };
 
@@ -163,10 +171,15 @@ public:
 
     static std::expected<bool, QString> packageJar(const Config &config);
 
+    // 获取附加在打包程序中的启动器模板，映射后缓存，多次打包共享同一映射；没有对应变体时返回默认模板
+    static std::expected<AttachedExe, QString> launcherTemplate(const QString &applicationFilePath,
+                                                                LauncherVariant variant);
+
     static std::expected<bool, QString> extractJarInfo(const QString &jarPath, PackageConfig &jarInfo);
 
+    // patchHeaders 为 false 时只更新图标，用于已具有对应子系统和权限的预生成模板
     static std::expected<bool, QString> modifyExe(const QString &exePath, const QString &iconPath, bool showConsole,
-                                                  bool requireAdmin);
+                                                  bool requireAdmin, bool patchHeaders = true);
 };
 
 class JarPackagerWindow final : public QMainWindow {
@@ -14,8 +14,10 @@ Description:
 
 #define NOMINMAX
 #include <QBuffer>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QEvent>
+#include <QHash>
 #include <QImageReader>
 #include <QJsonArray>
 #include <QListWidget>
@@ -33,7 +35,9 @@ Description:
 #include <ShlObj.h>
 #include <Windows.h>
 #include <attach.h>
+#include <jarlayout.h>
 #include <modify.h>
+#include <ziptail.h>
 
 
 #include "jarcommon.h"
@@ -151,6 +155,8 @@ QJsonObject PackageConfig::toJson() const {
     obj["iconPath"] = iconPath;
     obj["showConsole"] = showConsole;
     obj["requireAdmin"] = requireAdmin;
+    obj["runFromExe"] = runFromExe;
+    obj["singleInstance"] = singleInstance;
     obj["externalExePath"] = externalExePath;
     obj["enableZip"] = enableZip;
     obj["zipPaths"] = QJsonArray::fromStringList(zipPaths);
@@ -195,6 +201,8 @@ void PackageConfig::fromJson(const QJsonObject &obj) {
     iconPath = obj.value("iconPath").toString();
     showConsole = obj.value("showConsole").toBool(false);
     requireAdmin = obj.value("requireAdmin").toBool(false);
+    runFromExe = obj.value("runFromExe").toBool(false);
+    singleInstance = obj.value("singleInstance").toBool(false);
     externalExePath = obj.value("externalExePath").toString();
     enableZip = obj.value("enableZip").toBool(false);
     QJsonArray zipArray = obj["zipPaths"].toArray();
@@ -249,7 +257,9 @@ std::expected<Packager::PackageResult, QString> Packager::packageFromConfig(
     const PackageConfig &config, const QString &applicationFilePath) {
     const QString jarPath = config.jarPath.trimmed();
     const QString outputPath = config.outputPath.trimmed();
-    const JarCommon::LaunchMode launchMode = config.launchMode == static_cast<int>(JarCommon::LaunchMode::DirectJVM)
+    const JarCommon::LaunchMode launchMode = config.launchMode == static_cast<int>(JarCommon::LaunchMode::Daemon)
+                                                 ? JarCommon::LaunchMode::Daemon
+                                                 : config.launchMode == static_cast<int>(JarCommon::LaunchMode::DirectJVM)
                                                  ? JarCommon::LaunchMode::DirectJVM
                                                  : JarCommon::LaunchMode::JavaExe;
 
@@ -259,9 +269,14 @@ std::expected<Packager::PackageResult, QString> Packager::packageFromConfig(
         return std::unexpected("请填写必要的路径信息（JAR路径、输出路径）");
     }
 
-    if (launchMode == JarCommon::LaunchMode::DirectJVM && (
+    if (launchMode != JarCommon::LaunchMode::JavaExe && (
             config.mainClass.trimmed().isEmpty() || config.javaVersion == 0)) {
-        return std::unexpected("DirectJVM模式需要填写主类和Java版本");
+        return std::unexpected("DirectJVM和守护模式需要填写主类和Java版本");
+    }
+
+    // 参数通过 JNI 交给同一进程内的 JVM，java.exe 模式下启动器会先于 Java 程序退出
+    if (config.singleInstance && launchMode != JarCommon::LaunchMode::DirectJVM) {
+        return std::unexpected("单实例只支持DirectJVM模式");
     }
 
     const QString splashImagePath = config.enableSplash ? config.splashImagePath.trimmed() : QString();
@@ -273,15 +288,14 @@ std::expected<Packager::PackageResult, QString> Packager::packageFromConfig(
         return std::unexpected(QString("JAR文件不存在: %1").arg(jarPath));
     }
 
-    const auto readAttachRes = Attach::readAttachedExe(applicationFilePath.toStdWString());
-    if (!readAttachRes) {
-        return std::unexpected(QString("获取当前程序的附加exe失败: %1")
-            .arg(QString::fromStdWString(readAttachRes.error())));
+    const auto templateRes = launcherTemplate(applicationFilePath,
+                                              launcherVariant(config.showConsole, config.requireAdmin));
+    if (!templateRes) {
+        return std::unexpected(templateRes.error());
     }
 
-    const auto &exeBytes = readAttachRes.value();
     const Config packagerConfig{
-        QByteArray(reinterpret_cast<const char *>(exeBytes.data()), static_cast<int>(exeBytes.size())),
+        templateRes.value(),
         jarPath,
         splashImagePath,
         config.splashShowProgress,
@@ -309,6 +323,8 @@ std::expected<Packager::PackageResult, QString> Packager::packageFromConfig(
         config.versionFontSizePercent,
         config.statusFontSizePercent,
         config.requireAdmin,
+        config.runFromExe,
+        config.singleInstance,
     };
 
     qInfo() << "开始打包...";
@@ -329,15 +345,57 @@ std::expected<Packager::PackageResult, QString> Packager::packageFromConfig(
     return result;
 }
 
+std::expected<AttachedExe, QString> Packager::launcherTemplate(const QString &applicationFilePath,
+                                                              const LauncherVariant variant) {
+    // 程序运行期间自身文件不会被修改，映射建立后一直有效
+    static QMutex mutex;
+    static QHash<QPair<QString, unsigned int>, AttachedExe> cache;
+    const QPair<QString, unsigned int> key{applicationFilePath, static_cast<unsigned int>(variant)};
+    QMutexLocker locker(&mutex);
+    if (const auto it = cache.constFind(key); it != cache.cend()) {
+        return it.value();
+    }
+
+    auto mapRes = Attach::mapAttachedExe(applicationFilePath.toStdWString(), variant);
+    if (!mapRes) {
+        return std::unexpected(QString("获取当前程序的附加exe失败: %1")
+            .arg(QString::fromStdWString(mapRes.error())));
+    }
+    cache.insert(key, mapRes.value());
+    return mapRes.value();
+}
+
 std::expected<bool, QString> Packager::packageJar(const Config &config) {
     // 读取JAR文件
     QFile jarFile(config.jarPath);
     if (!jarFile.open(QIODevice::ReadOnly)) {
         return std::unexpected(QString("无法打开JAR文件: %1").arg(jarFile.errorString()));
     }
-    const QByteArray jarData = jarFile.readAll();
+    QByteArray jarData = jarFile.readAll();
     jarFile.close();
 
+    const auto bytesOf = [](const QByteArray &data) {
+        return std::span{reinterpret_cast<const std::uint8_t *>(data.constData()), static_cast<std::size_t>(data.size())};
+    };
+
+    const auto now = std::chrono::system_clock::now();
+    const auto duration = now.time_since_epoch();
+    const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+
+    // 定位 EOCD，随后去掉原有注释：普通模式写入时间戳，直接运行模式写入元数据块
+    const auto jarTailSize = std::min<std::size_t>(jarData.size(), ZipTail::MAX_SEARCH_SIZE);
+    const auto eocdRes = ZipTail::locate(bytesOf(jarData).last(jarTailSize), jarData.size() - jarTailSize);
+    if (!eocdRes) {
+        return std::unexpected(QString("JAR文件格式无效: %1").arg(QString::fromStdWString(eocdRes.error())));
+    }
+    const qsizetype eocdOffset = static_cast<qsizetype>(eocdRes->eocdOffset);
+    jarData.truncate(eocdOffset + static_cast<qsizetype>(ZipTail::EOCD_SIZE));
+    const auto setCommentLength = [&](const std::size_t length) {
+        return ZipTail::setCommentLength(std::span{reinterpret_cast<std::uint8_t *>(jarData.data()),
+                                                   static_cast<std::size_t>(jarData.size())},
+                                         static_cast<std::uint64_t>(eocdOffset), length);
+    };
+
     // 准备字符串数据
     const QByteArray mainClassBytes = config.mainClass.toUtf8();
     const QByteArray jvmArgsBytes = config.jvmArgs.join('\n').toUtf8();
@@ -347,26 +405,6 @@ std::expected<bool, QString> Packager::packageJar(const Config &config) {
     const QByteArray splashProgramNameBytes = config.splashProgramName.toUtf8();
     const QByteArray splashProgramVersionBytes = config.splashProgramVersion.toUtf8();
 
-    // 写入输出文件
-    QFile outFile(config.outputPath);
-    if (!outFile.open(QIODevice::WriteOnly)) {
-        return std::unexpected(QString("无法创建输出文件: %1").arg(outFile.errorString()));
-    }
-
-    // 写入EXE数据
-    outFile.write(config.exeData);
-    outFile.close();
-    if (auto modifyRes = modifyExe(config.outputPath, config.iconPath, config.showConsole, config.requireAdmin);
-        !modifyRes) {
-        return std::unexpected(QString("修改exe失败: %1").arg(modifyRes.error()));
-    }
-    outFile.open(QIODevice::WriteOnly | QIODevice::Append);
-    const qint64 exeSize = outFile.size();
-    outFile.seek(exeSize);
-
-    // 写入JAR数据
-    outFile.write(jarData);
-
     QByteArray pngData;
     if (!config.splashImagePath.isEmpty()) {
         // 读取图片
@@ -383,53 +421,134 @@ std::expected<bool, QString> Packager::packageJar(const Config &config) {
         }
         buffer.close();
     }
-    // 写入图片数据
-    outFile.write(pngData);
-    // 写入字符串数据
-    outFile.write(mainClassBytes);
-    outFile.write(jvmArgsBytes);
-    outFile.write(programArgsBytes);
-    outFile.write(javaPathBytes);
-    outFile.write(jarExtractPathBytes);
-    outFile.write(splashProgramNameBytes);
-    outFile.write(splashProgramVersionBytes);
 
-    const auto now = std::chrono::system_clock::now();
-    const auto duration = now.time_since_epoch();
-    const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    // 启动设置段
+    JarLayout::LaunchSettings settings{};
+    settings.javaVersion = config.javaVersion;
+    settings.launchTime = config.launchTime;
+    settings.launchMode = config.launchMode;
+    settings.timestamp = static_cast<std::uint64_t>(timestamp);
+    settings.splashShowProgress = config.splashShowProgress;
+    settings.splashShowProgressText = config.splashShowProgressText;
+    settings.titlePosX = config.titlePosX;
+    settings.titlePosY = config.titlePosY;
+    settings.versionPosX = config.versionPosX;
+    settings.versionPosY = config.versionPosY;
+    settings.statusPosX = config.statusPosX;
+    settings.statusPosY = config.statusPosY;
+    settings.titleFontSizePercent = config.titleFontSizePercent;
+    settings.versionFontSizePercent = config.versionFontSizePercent;
+    settings.statusFontSizePercent = config.statusFontSizePercent;
+    settings.singleInstance = config.singleInstance;
+    if (!config.runFromExe) {
+        // 摘要不含 EOCD，重新打包相同的 jar 时启动器可以复用已解压的文件
+        const QByteArray digest = QCryptographicHash::hash(QByteArrayView(jarData.constData(), eocdOffset),
+                                                           QCryptographicHash::Sha256);
+        std::memcpy(settings.jarDigest.data(), digest.constData(), settings.jarDigest.size());
+    }
+    const QByteArray settingsData(reinterpret_cast<const char *>(&settings), sizeof(settings));
+
+    // 字符串表段，顺序与 JarLayout::StringId 一致
+    const std::array<std::string_view, JarLayout::STRING_COUNT> strings{
+        std::string_view{mainClassBytes.constData(), static_cast<std::size_t>(mainClassBytes.size())},
+        std::string_view{jvmArgsBytes.constData(), static_cast<std::size_t>(jvmArgsBytes.size())},
+        std::string_view{programArgsBytes.constData(), static_cast<std::size_t>(programArgsBytes.size())},
+        std::string_view{javaPathBytes.constData(), static_cast<std::size_t>(javaPathBytes.size())},
+        std::string_view{jarExtractPathBytes.constData(), static_cast<std::size_t>(jarExtractPathBytes.size())},
+        std::string_view{splashProgramNameBytes.constData(), static_cast<std::size_t>(splashProgramNameBytes.size())},
+        std::string_view{splashProgramVersionBytes.constData(), static_cast<std::size_t>(splashProgramVersionBytes.size())},
+    };
+    const auto stringTable = JarLayout::encodeStrings(strings);
 
-    // 创建Footer结构
-    const JarCommon::JarFooter footer{
-        JarCommon::JAR_MAGIC,
-        static_cast<unsigned long long>(exeSize),
-        static_cast<unsigned long long>(jarData.size()),
-        static_cast<unsigned long long>(pngData.size()),
-        config.splashShowProgress,
-        config.splashShowProgressText,
-        config.launchTime,
-        static_cast<unsigned long long>(timestamp),
-        config.javaVersion,
-        static_cast<unsigned int>(mainClassBytes.size()),
-        static_cast<unsigned int>(jvmArgsBytes.size()),
-        static_cast<unsigned int>(programArgsBytes.size()),
-        static_cast<unsigned int>(javaPathBytes.size()),
-        static_cast<unsigned int>(jarExtractPathBytes.size()),
-        static_cast<unsigned int>(splashProgramNameBytes.size()),
-        static_cast<unsigned int>(splashProgramVersionBytes.size()),
-        config.launchMode,
-        config.titlePosX,
-        config.titlePosY,
-        config.versionPosX,
-        config.versionPosY,
-        config.statusPosX,
-        config.statusPosY,
-        config.titleFontSizePercent,
-        config.versionFontSizePercent,
-        config.statusFontSizePercent,
+    // 写入EXE数据，直接从映射视图写入输出文件
+    if (auto writeRes = Attach::writeAttachedExe(config.exeData, config.outputPath.toStdWString()); !writeRes) {
+        return std::unexpected(QString::fromStdWString(writeRes.error()));
+    }
+    QFile outFile(config.outputPath);
+    // 预生成的模板已具有对应的子系统和权限，只需更新图标
+    const bool prebuilt = config.exeData.variant() == launcherVariant(config.showConsole, config.requireAdmin);
+    if (auto modifyRes = modifyExe(config.outputPath, config.iconPath, config.showConsole, config.requireAdmin,
+                                   !prebuilt);
+        !modifyRes) {
+        return std::unexpected(QString("修改exe失败: %1").arg(modifyRes.error()));
+    }
+    outFile.open(QIODevice::WriteOnly | QIODevice::Append);
+    const qint64 exeSize = outFile.size();
+    outFile.seek(exeSize);
+
+    JarLayout::SectionTableWriter sections;
+    const auto writeImage = [&] {
+        if (!pngData.isEmpty()) {
+            sections.add(JarLayout::SectionType::SplashImage, outFile.pos(), pngData.size(), 1,
+                         JarLayout::hash(bytesOf(pngData)));
+            outFile.write(pngData);
+        }
     };
+    const auto alignJar = [&] {
+        const qint64 pos = outFile.pos();
+        const qint64 aligned = (pos + JarLayout::JAR_ALIGNMENT - 1) / JarLayout::JAR_ALIGNMENT * JarLayout::JAR_ALIGNMENT;
+        outFile.write(QByteArray(aligned - pos, '\0'));
+        return aligned;
+    };
+    // 登记元数据块中的启动设置段与字符串表段，offset 为元数据块起始位置
+    const auto addMetadata = [&](const qint64 offset) {
+        sections.add(JarLayout::SectionType::Settings, offset, settingsData.size(), 1,
+                     JarLayout::hash(bytesOf(settingsData)));
+        sections.add(JarLayout::SectionType::Strings, offset + settingsData.size(), stringTable.size(), 1,
+                     JarLayout::hash(stringTable));
+        return offset;
+    };
+    qint64 metadataOffset = 0;
+
+    if (config.runFromExe) {
+        // 直接运行模式：exe + image + jar，元数据块作为 jar 的 ZIP 注释位于文件末尾，
+        // 整个文件即是偏移正确的 ZIP，java 可直接把 exe 作为类路径
+        writeImage();
+        const qint64 jarOffset = alignJar();
+        if (auto commentRes = setCommentLength(0); !commentRes) {
+            return std::unexpected(QString("JAR文件格式无效: %1").arg(QString::fromStdWString(commentRes.error())));
+        }
+        if (auto rebaseRes = ZipTail::rebase(std::span{reinterpret_cast<std::uint8_t *>(jarData.data()),
+                                                       static_cast<std::size_t>(jarData.size())},
+                                             static_cast<std::uint64_t>(jarOffset));
+            !rebaseRes) {
+            return std::unexpected(QString("调整JAR偏移失败: %1").arg(QString::fromStdWString(rebaseRes.error())));
+        }
+
+        // 元数据块紧跟 jar，其大小即 ZIP 注释长度；先登记全部段得到段目录大小，写好注释长度后再补上 jar 的哈希
+        sections.add(JarLayout::SectionType::Jar, jarOffset, jarData.size(), JarLayout::JAR_ALIGNMENT, 0,
+                     JarLayout::SECTION_FLAG_RUN_FROM_EXE);
+        metadataOffset = addMetadata(jarOffset + jarData.size());
+        const std::size_t metadataSize = settingsData.size() + stringTable.size() + sections.tableSize();
+        if (auto commentRes = setCommentLength(metadataSize); !commentRes) {
+            return std::unexpected(QString("启动参数过长，无法放入ZIP注释: %1").arg(
+                QString::fromStdWString(commentRes.error())));
+        }
+        sections.setHash(JarLayout::SectionType::Jar, JarLayout::hash(bytesOf(jarData)));
+        outFile.write(jarData);
+    } else {
+        // 普通模式：exe + jar + image，ZIP 注释写入时间戳，启动器解压时只需按区间复制
+        const JarLayout::JarStamp stamp{static_cast<std::uint64_t>(timestamp)};
+        if (auto commentRes = setCommentLength(sizeof(stamp)); !commentRes) {
+            return std::unexpected(QString("JAR文件格式无效: %1").arg(QString::fromStdWString(commentRes.error())));
+        }
+        jarData.append(reinterpret_cast<const char *>(&stamp), sizeof(stamp));
 
-    // 写入Footer结构体
-    outFile.write(reinterpret_cast<const char *>(&footer), sizeof(JarCommon::JarFooter));
+        const qint64 jarOffset = alignJar();
+        sections.add(JarLayout::SectionType::Jar, jarOffset, jarData.size(), JarLayout::JAR_ALIGNMENT,
+                     JarLayout::hash(bytesOf(jarData)), JarLayout::SECTION_FLAG_JAR_STAMPED);
+        outFile.write(jarData);
+        writeImage();
+        metadataOffset = addMetadata(outFile.pos());
+    }
+
+    // 写入启动设置段与字符串表段
+    outFile.write(settingsData);
+    outFile.write(reinterpret_cast<const char *>(stringTable.data()), static_cast<qint64>(stringTable.size()));
+
+    // 写入段目录和 SectionFooter
+    const auto table = sections.finish(metadataOffset, outFile.pos());
+    outFile.write(reinterpret_cast<const char *>(table.data()), static_cast<qint64>(table.size()));
 
     outFile.close();
     return true;
@@ -442,95 +561,89 @@ std::expected<bool, QString> Packager::extractJarInfo(const QString &jarPath, Pa
     }
 
     const qint64 fileSize = file.size();
-    if (fileSize < sizeof(JarCommon::JarFooter)) {
+    if (fileSize < static_cast<qint64>(JarLayout::PROBE_SIZE)) {
         return std::unexpected{"文件太小，不包含有效的JAR信息"};
     }
 
-    // 读取Footer结构体
-    file.seek(fileSize - sizeof(JarCommon::JarFooter));
-    JarCommon::JarFooter footer{};
-    if (file.read(reinterpret_cast<char *>(&footer), sizeof(JarCommon::JarFooter)) != sizeof(JarCommon::JarFooter)) {
-        return std::unexpected{"读取Footer失败"};
+    // 先读取尾部确定元数据块大小，再一次读取整个元数据块
+    file.seek(fileSize - JarLayout::PROBE_SIZE);
+    const QByteArray probe = file.read(JarLayout::PROBE_SIZE);
+    const auto sizeRes = JarLayout::metadataSize(
+        std::span{reinterpret_cast<const std::uint8_t *>(probe.constData()), static_cast<std::size_t>(probe.size())},
+        fileSize);
+    if (!sizeRes) {
+        return std::unexpected{QString::fromStdWString(sizeRes.error())};
     }
 
-    // 验证魔数
-    if (footer.magic != JarCommon::JAR_MAGIC) {
-        return std::unexpected{QString("无效的魔数: 0x%1").arg(footer.magic, 8, 16, QChar('0'))};
+    const auto metadataSize = static_cast<qint64>(std::max<std::uint64_t>(sizeRes.value(), JarLayout::PROBE_SIZE));
+    file.seek(fileSize - metadataSize);
+    const QByteArray metadata = file.read(metadataSize);
+    file.close();
+    if (metadata.size() != metadataSize) {
+        return std::unexpected{"读取元数据失败"};
     }
 
-    // 计算字符串数据的位置
-    const qint64 stringsOffset = fileSize - sizeof(JarCommon::JarFooter) - footer.mainClassLength -
-                                 footer.jvmArgsLength - footer.programArgsLength - footer.javaPathLength -
-                                 footer.jarExtractPathLength;
-
-    file.seek(stringsOffset);
-
-    // 读取字符串数据
-    const QByteArray mainClassData = file.read(footer.mainClassLength);
-    const QByteArray jvmArgsData = file.read(footer.jvmArgsLength);
-    const QByteArray programArgsData = file.read(footer.programArgsLength);
-    const QByteArray javaPathData = file.read(footer.javaPathLength);
-    const QByteArray jarExtractPathData = file.read(footer.jarExtractPathLength);
-
-    file.close();
+    const std::span tail{reinterpret_cast<const std::uint8_t *>(metadata.constData()), static_cast<std::size_t>(metadata.size())};
+    const auto infoRes = JarLayout::parse(tail, fileSize);
+    if (!infoRes) {
+        return std::unexpected{QString::fromStdWString(infoRes.error())};
+    }
+    const auto &info = infoRes.value();
+    const auto text = [&](const JarLayout::StringId id) {
+        const auto view = JarLayout::stringView(info, tail, fileSize, id);
+        return QString::fromUtf8(view.data(), static_cast<qsizetype>(view.size()));
+    };
 
     // 填充JarInfo
-    jarInfo.javaVersion = footer.javaVersion;
-    jarInfo.mainClass = QString::fromUtf8(mainClassData);
-    jarInfo.jvmArgs = QString::fromUtf8(jvmArgsData).split('\n', Qt::SkipEmptyParts);
-    jarInfo.programArgs = QString::fromUtf8(programArgsData).split('\n', Qt::SkipEmptyParts);
-    jarInfo.javaPath = QString::fromUtf8(javaPathData);
-    jarInfo.jarExtractPath = QString::fromUtf8(jarExtractPathData);
-    jarInfo.launchMode = static_cast<int>(footer.launchMode);
+    jarInfo.javaVersion = info.settings.javaVersion;
+    jarInfo.mainClass = text(JarLayout::StringId::MainClass);
+    jarInfo.jvmArgs = text(JarLayout::StringId::JvmArgs).split('\n', Qt::SkipEmptyParts);
+    jarInfo.programArgs = text(JarLayout::StringId::ProgramArgs).split('\n', Qt::SkipEmptyParts);
+    jarInfo.javaPath = text(JarLayout::StringId::JavaPath);
+    jarInfo.jarExtractPath = text(JarLayout::StringId::JarExtractPath);
+    jarInfo.launchMode = static_cast<int>(info.settings.launchMode);
+    jarInfo.singleInstance = info.settings.singleInstance != 0;
+    if (const auto *jarEntry = info.find(JarLayout::SectionType::Jar)) {
+        jarInfo.runFromExe = (jarEntry->flags & JarLayout::SECTION_FLAG_RUN_FROM_EXE) != 0;
+    }
 
     return true;
 }
 
 std::expected<bool, QString> Packager::modifyExe(const QString &exePath, const QString &iconPath,
-                                                 const bool showConsole, const bool requireAdmin) {
+                                                 const bool showConsole, const bool requireAdmin,
+                                                 const bool patchHeaders) {
+    if (!patchHeaders && iconPath.isEmpty()) {
+        return true;
+    }
+
     QFile exeFile(exePath);
     if (!exeFile.open(QIODevice::ReadWrite)) {
         return std::unexpected(QString("无法打开EXE文件: %1").arg(exeFile.errorString()));
     }
     exeFile.close();
 
-    const auto exePathW = exePath.toStdWString();
-    PEModifier modifier(exePathW);
-    modifier.loadFile();
-
-    if (const auto &res = modifier.getExecutionLevel(); res) {
-        if (requireAdmin && res.value() == ExecutionLevel::AsInvoker) {
-            if (auto setRes = modifier.setExecutionLevel(ExecutionLevel::RequireAdmin); !setRes) {
-                return std::unexpected{QString::fromStdWString(setRes.error())};
-            }
-        } else if (!requireAdmin && res.value() == ExecutionLevel::RequireAdmin) {
-            if (auto setRes = modifier.setExecutionLevel(ExecutionLevel::AsInvoker); !setRes) {
-                return std::unexpected{QString::fromStdWString(setRes.error())};
-            }
-        }
-    } else {
-        return std::unexpected{QString::fromStdWString(res.error())};
-    }
-
+    std::wstring iconPathW;
     if (!iconPath.isEmpty()) {
         QFile iconFile(iconPath);
         if (!iconFile.open(QIODevice::ReadOnly)) {
             return std::unexpected(QString("无法打开图标文件: %1").arg(iconFile.errorString()));
         }
         iconFile.close();
-        if (auto updateIcoRes = modifier.setIcon(iconPath.toStdWString().c_str()); !updateIcoRes) {
-            return std::unexpected(QString("无法更新图标: %1").arg(QString::fromStdWString(updateIcoRes.error())));
-        }
+        iconPathW = iconPath.toStdWString();
     }
 
-    if (showConsole) {
-        if (auto res = modifier.setSubsystem(IMAGE_SUBSYSTEM_WINDOWS_CUI); !res) {
-            return std::unexpected{QString::fromStdWString(res.error())};
-        }
-    } else {
-        if (auto res = modifier.setSubsystem(IMAGE_SUBSYSTEM_WINDOWS_GUI); !res) {
-            return std::unexpected{QString::fromStdWString(res.error())};
-        }
+    // 图标、执行级别和子系统在一次读写中完成
+    std::optional<ExecutionLevel> level;
+    std::optional<WORD> subsystem;
+    if (patchHeaders) {
+        level = requireAdmin ? ExecutionLevel::RequireAdmin : ExecutionLevel::AsInvoker;
+        subsystem = showConsole ? IMAGE_SUBSYSTEM_WINDOWS_CUI : IMAGE_SUBSYSTEM_WINDOWS_GUI;
+    }
+
+    PEModifier modifier(exePath.toStdWString());
+    if (auto res = modifier.apply(iconPathW.empty() ? nullptr : iconPathW.c_str(), level, subsystem); !res) {
+        return std::unexpected{QString::fromStdWString(res.error())};
     }
 
     return true;
@@ -552,8 +665,10 @@ JarPackagerWindow::JarPackagerWindow(QWidget *parent) : QMainWindow(parent), ui(
     // 初始化启动模式
     modeMap[0] = ui->modeJava;
     modeMap[1] = ui->modeJvm;
+    modeMap[2] = ui->modeDaemon;
     ui->modeButtonGroup->setId(modeMap[0], 0);
     ui->modeButtonGroup->setId(modeMap[1], 1);
+    ui->modeButtonGroup->setId(modeMap[2], 2);
     constexpr int mode_index = 0;
     const auto &radio_button = modeMap[mode_index];
     radio_button->setChecked(true);
@@ -612,6 +727,7 @@ JarPackagerWindow::JarPackagerWindow(QWidget *parent) : QMainWindow(parent), ui(
     connect(ui->javaPathEdit, &QLineEdit::textChanged, [this]() { configChanged = true; });
     connect(ui->jarExtractPathEdit, &QLineEdit::textChanged, [this]() { configChanged = true; });
     connect(ui->modeJava, &QRadioButton::toggled, [this]() { configChanged = true; });
+    connect(ui->modeDaemon, &QRadioButton::toggled, [this]() { configChanged = true; });
     connect(ui->javaVersionComboBox, &QComboBox::currentTextChanged, [this]() { configChanged = true; });
     connect(ui->mainClassEdit, &QLineEdit::textChanged, [this]() { configChanged = true; });
     // 启动页设置
@@ -635,6 +751,8 @@ JarPackagerWindow::JarPackagerWindow(QWidget *parent) : QMainWindow(parent), ui(
     });
     connect(ui->showConsoleCheckBox, &QCheckBox::checkStateChanged, [this]() { configChanged = true; });
     connect(ui->requireAdminCheckBox, &QCheckBox::checkStateChanged, [this]() { configChanged = true; });
+    connect(ui->runFromExeCheckBox, &QCheckBox::checkStateChanged, [this]() { configChanged = true; });
+    connect(ui->singleInstanceCheckBox, &QCheckBox::checkStateChanged, [this]() { configChanged = true; });
     // 压缩包设置
     connect(ui->enableZipCheckBox, &QCheckBox::checkStateChanged, [this]() { configChanged = true; });
     connect(ui->zipPathsListWidget->model(), &QAbstractItemModel::rowsInserted, [this]() { configChanged = true; });
@@ -835,7 +953,11 @@ void JarPackagerWindow::on_packageBtn_clicked() {
     }
     config.javaPath = ui->javaPathEdit->text().trimmed();
     config.jarExtractPath = ui->jarExtractPathEdit->text().trimmed();
-    config.launchMode = static_cast<int>(ui->modeJvm->isChecked()
+    config.runFromExe = ui->runFromExeCheckBox->isChecked();
+    config.singleInstance = ui->singleInstanceCheckBox->isChecked();
+    config.launchMode = static_cast<int>(ui->modeDaemon->isChecked()
+                                             ? JarCommon::LaunchMode::Daemon
+                                             : ui->modeJvm->isChecked()
                                              ? JarCommon::LaunchMode::DirectJVM
                                              : JarCommon::LaunchMode::JavaExe);
     if (const auto &javaVersion = ui->javaVersionComboBox->currentText(); !javaVersion.isEmpty()) {
@@ -1011,7 +1133,7 @@ void JarPackagerWindow::on_iconBtn_clicked() {
 void JarPackagerWindow::on_modeButtonGroup_idToggled(const int id, const bool checked) {
     if (!checked)
         return;
-    const bool enable = modeMap[id] == ui->modeJvm;
+    const bool enable = modeMap[id] == ui->modeJvm || modeMap[id] == ui->modeDaemon;
     ui->mainClassLabel->setEnabled(enable);
     ui->mainClassEdit->setEnabled(enable);
     ui->javaVersionLabel->setEnabled(enable);
@@ -1205,8 +1327,12 @@ void JarPackagerWindow::loadPackageConfig(const QString &filePath) {
     ui->progArgsEdit->setText(config.programArgs.join(";"));
     ui->javaPathEdit->setText(config.javaPath);
     ui->jarExtractPathEdit->setText(config.jarExtractPath);
+    ui->runFromExeCheckBox->setChecked(config.runFromExe);
+    ui->singleInstanceCheckBox->setChecked(config.singleInstance);
     if (config.launchMode == static_cast<int>(JarCommon::LaunchMode::DirectJVM)) {
         ui->modeJvm->setChecked(true);
+    } else if (config.launchMode == static_cast<int>(JarCommon::LaunchMode::Daemon)) {
+        ui->modeDaemon->setChecked(true);
     } else {
         ui->modeJava->setChecked(true);
     }
@@ -1266,7 +1392,11 @@ void JarPackagerWindow::savePackageConfig(const QString &filePath) {
     }
     config.javaPath = ui->javaPathEdit->text().trimmed();
     config.jarExtractPath = ui->jarExtractPathEdit->text().trimmed();
-    config.launchMode = static_cast<int>(ui->modeJvm->isChecked()
+    config.runFromExe = ui->runFromExeCheckBox->isChecked();
+    config.singleInstance = ui->singleInstanceCheckBox->isChecked();
+    config.launchMode = static_cast<int>(ui->modeDaemon->isChecked()
+                                             ? JarCommon::LaunchMode::Daemon
+                                             : ui->modeJvm->isChecked()
                                              ? JarCommon::LaunchMode::DirectJVM
                                              : JarCommon::LaunchMode::JavaExe);
     if (const auto &javaVersion = ui->javaVersionComboBox->currentText(); !javaVersion.isEmpty()) {
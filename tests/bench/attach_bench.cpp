@@ -0,0 +1,155 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 附加启动器模板：流式附加与原先整文件缓冲实现的对比
+             Buffered 按原实现读入源文件与模板、去掉旧附加内容后整体写出，原地附加时先复制 .backup；
+             Streaming 为 Attach::attachExe，只复制原程序部分（文件系统支持时为块克隆），原地附加时截断后追加
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include "attach.h"
+#include "testutil.h"
+
+using TestUtil::Bytes;
+using Path = Attach::Path;
+
+namespace {
+    constexpr std::size_t LAUNCHER_SIZE = 2 << 20;
+
+    struct Fixture {
+        TestUtil::TempDir dir;
+        Path launcher = dir / "launcher.exe";
+        Path launcher2 = dir / "launcher2.exe";
+
+        Fixture() {
+            TestUtil::writeFile(launcher, TestUtil::randomBytes(LAUNCHER_SIZE, 1));
+            TestUtil::writeFile(launcher2, TestUtil::randomBytes(LAUNCHER_SIZE + 4096, 2));
+        }
+
+        // 已附加模板的打包程序
+        Path program(const std::size_t mib) const {
+            const auto path = dir / std::format("program-{}.exe", mib);
+            if (!std::filesystem::exists(path)) {
+                const auto raw = dir / "raw.exe";
+                TestUtil::writeFile(raw, TestUtil::randomBytes(mib << 20, 3));
+                Attach::attachExe(raw, launcher, path);
+                std::filesystem::remove(raw);
+            }
+            return path;
+        }
+    };
+
+    const Fixture &fixture() {
+        static const Fixture instance;
+        return instance;
+    }
+
+    Attach::ByteArray readAll(const Path &path) {
+        Attach::ByteArray data(std::filesystem::file_size(path));
+        std::ifstream in(path, std::ios::binary);
+        in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        return data;
+    }
+
+    // 原实现：整文件读入内存，原地附加时先复制备份
+    bool bufferedAttach(const Path &src, const Path &attachExe, const Path &output) {
+        auto source = src;
+        std::error_code ec;
+        const bool inPlace = std::filesystem::equivalent(output, src, ec) && !ec;
+        if (inPlace) {
+            source += ".backup";
+            std::filesystem::copy_file(src, source, std::filesystem::copy_options::overwrite_existing, ec);
+            if (ec) {
+                return false;
+            }
+        }
+        auto srcData = readAll(source);
+        if (srcData.size() >= sizeof(ExeFooter)) {
+            ExeFooter footer;
+            std::memcpy(&footer, srcData.data() + srcData.size() - sizeof(ExeFooter), sizeof(footer));
+            if (footer.magic == EXE_MAGIC) {
+                srcData.resize(footer.exeOffset);
+            }
+        }
+        const auto attachData = readAll(attachExe);
+
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(srcData.data()), static_cast<std::streamsize>(srcData.size()));
+        out.write(reinterpret_cast<const char *>(attachData.data()), static_cast<std::streamsize>(attachData.size()));
+        const ExeFooter footer{.magic = EXE_MAGIC, .exeOffset = srcData.size(), .exeSize = attachData.size()};
+        out.write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+        out.close();
+        if (inPlace) {
+            std::filesystem::remove(source, ec);
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool streamingAttach(const Path &src, const Path &attachExe, const Path &output) {
+        return Attach::attachExe(src, attachExe, output).has_value();
+    }
+
+    // range(0)：原程序大小（MiB）
+    template<bool (*attach)(const Path &, const Path &, const Path &)>
+    void runCopy(benchmark::State &state) {
+        const auto &f = fixture();
+        const auto program = f.program(static_cast<std::size_t>(state.range(0)));
+        const auto output = f.dir / "out.exe";
+        for (auto _: state) {
+            if (!attach(program, f.launcher2, output)) {
+                state.SkipWithError("附加失败");
+                break;
+            }
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                                static_cast<std::int64_t>(std::filesystem::file_size(output)));
+        std::filesystem::remove(output);
+    }
+
+    // 每次交替使用两个模板，保证每次都真正替换旧附加内容
+    template<bool (*attach)(const Path &, const Path &, const Path &)>
+    void runInPlace(benchmark::State &state) {
+        const auto &f = fixture();
+        const auto target = f.dir / "inplace.exe";
+        std::filesystem::copy_file(f.program(static_cast<std::size_t>(state.range(0))), target,
+                                   std::filesystem::copy_options::overwrite_existing);
+        bool second = false;
+        for (auto _: state) {
+            if (!attach(target, second ? f.launcher2 : f.launcher, target)) {
+                state.SkipWithError("附加失败");
+                break;
+            }
+            second = !second;
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                                static_cast<std::int64_t>(std::filesystem::file_size(target)));
+        std::filesystem::remove(target);
+    }
+} // namespace
+
+static void BM_AttachCopy_Buffered(benchmark::State &state) {
+    runCopy<bufferedAttach>(state);
+}
+
+static void BM_AttachCopy_Streaming(benchmark::State &state) {
+    runCopy<streamingAttach>(state);
+}
+
+static void BM_AttachInPlace_Buffered(benchmark::State &state) {
+    runInPlace<bufferedAttach>(state);
+}
+
+static void BM_AttachInPlace_Streaming(benchmark::State &state) {
+    runInPlace<streamingAttach>(state);
+}
+
+BENCHMARK(BM_AttachCopy_Buffered)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AttachCopy_Streaming)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AttachInPlace_Buffered)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_AttachInPlace_Streaming)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,160 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 从打包文件中解压 jar：原先整文件读入内存的实现与当前只读尾部、按区间复制的实现对比
+             WholeFile 按原实现把整个 jar 读入 vector，逐字节向前查找 EOCD，修改注释长度后整体写出；
+             Tail 只读取最后 MAX_SEARCH_SIZE 字节定位 EOCD，其前的数据交给 FileCopy 分块复制，EOCD 与时间戳作为尾部写入；
+             Stamped 为打包时已写入时间戳的 jar，直接按区间复制
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include "filecopy.h"
+#include "jarlayout.h"
+#include "testutil.h"
+#include "ziptail.h"
+
+using TestUtil::Bytes;
+using Path = std::filesystem::path;
+
+namespace {
+    constexpr std::uint64_t PREFIX_SIZE = 1 << 20;
+
+    // 启动器 + jar 的打包文件，jar 带有原始注释，需要替换为时间戳
+    struct Package {
+        Path path;
+        std::uint64_t jarSize = 0;
+    };
+
+    struct Fixture {
+        TestUtil::TempDir dir;
+        std::map<std::size_t, Package> packages;
+
+        const Package &package(const std::size_t mib) {
+            auto &package = packages[mib];
+            if (package.path.empty()) {
+                const Bytes comment(200, 'c');
+                const auto jar = TestUtil::ZipBuilder()
+                        .add("META-INF/MANIFEST.MF", "Manifest-Version: 1.0\r\n")
+                        .add("big.bin", TestUtil::randomBytes(mib << 20, 5))
+                        .build(comment);
+                Bytes file(PREFIX_SIZE, 0x90);
+                file.insert(file.end(), jar.begin(), jar.end());
+                package.path = dir / std::format("package-{}.exe", mib);
+                TestUtil::writeFile(package.path, file);
+                package.jarSize = jar.size();
+            }
+            return package;
+        }
+    };
+
+    Fixture &fixture() {
+        static Fixture instance;
+        return instance;
+    }
+
+    // 原实现：逐字节向前查找 EOCD 签名
+    std::optional<std::size_t> legacyFindEocd(const Bytes &data) {
+        constexpr std::size_t MIN_EOCD_SIZE = 22;
+        if (data.size() < MIN_EOCD_SIZE) {
+            return std::nullopt;
+        }
+        const std::size_t searchStart = data.size() > 65557 ? data.size() - 65557 : 0;
+        for (std::size_t i = data.size() - MIN_EOCD_SIZE; i >= searchStart; --i) {
+            if (TestUtil::read<std::uint32_t>(data, i) == ZipTail::EOCD_SIGNATURE &&
+                i + MIN_EOCD_SIZE + TestUtil::read<std::uint16_t>(data, i + 20) == data.size()) {
+                return i;
+            }
+            if (i == searchStart) {
+                break;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool wholeFileExtract(const Package &package, const Path &output, const JarLayout::JarStamp &stamp) {
+        std::ifstream in(package.path, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(PREFIX_SIZE));
+        Bytes jarData(package.jarSize);
+        in.read(reinterpret_cast<char *>(jarData.data()), static_cast<std::streamsize>(jarData.size()));
+        if (in.gcount() != static_cast<std::streamsize>(jarData.size())) {
+            return false;
+        }
+        const auto eocd = legacyFindEocd(jarData);
+        if (!eocd) {
+            return false;
+        }
+        const auto oldCommentLength = TestUtil::read<std::uint16_t>(jarData, *eocd + 20);
+        const auto newCommentLength = static_cast<std::uint16_t>(sizeof(stamp));
+        std::memcpy(jarData.data() + *eocd + 20, &newCommentLength, sizeof(newCommentLength));
+
+        std::ofstream out(output, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(jarData.data()),
+                  static_cast<std::streamsize>(jarData.size() - oldCommentLength));
+        out.write(reinterpret_cast<const char *>(&stamp), sizeof(stamp));
+        return static_cast<bool>(out);
+    }
+
+    bool tailExtract(const Package &package, const Path &output, const JarLayout::JarStamp &stamp) {
+        const auto tailSize = std::min<std::uint64_t>(package.jarSize, ZipTail::MAX_SEARCH_SIZE);
+        const auto tailOffset = package.jarSize - tailSize;
+        Bytes tail(tailSize);
+        std::ifstream in(package.path, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(PREFIX_SIZE + tailOffset));
+        in.read(reinterpret_cast<char *>(tail.data()), static_cast<std::streamsize>(tail.size()));
+        const auto end = ZipTail::locate(tail, tailOffset);
+        if (!end) {
+            return false;
+        }
+
+        struct {
+            ZipTail::EndOfCentralDirectory eocd;
+            JarLayout::JarStamp stamp;
+        } trailer{end->eocd, stamp};
+        trailer.eocd.commentLength = sizeof(JarLayout::JarStamp);
+        return FileCopy::copyRange(package.path, PREFIX_SIZE, end->eocdOffset, output,
+                                   {reinterpret_cast<const std::uint8_t *>(&trailer), sizeof(trailer)}).has_value();
+    }
+
+    bool stampedExtract(const Package &package, const Path &output, const JarLayout::JarStamp &) {
+        return FileCopy::copyRange(package.path, PREFIX_SIZE, package.jarSize, output).has_value();
+    }
+
+    // range(0)：jar 大小（MiB）
+    template<bool (*extract)(const Package &, const Path &, const JarLayout::JarStamp &)>
+    void run(benchmark::State &state) {
+        auto &f = fixture();
+        const auto &package = f.package(static_cast<std::size_t>(state.range(0)));
+        const auto output = f.dir / "out.jar";
+        for (auto _: state) {
+            if (!extract(package, output, {42})) {
+                state.SkipWithError("解压失败");
+                break;
+            }
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                                static_cast<std::int64_t>(package.jarSize));
+        std::filesystem::remove(output);
+    }
+} // namespace
+
+static void BM_Extract_WholeFile(benchmark::State &state) {
+    run<wholeFileExtract>(state);
+}
+
+static void BM_Extract_Tail(benchmark::State &state) {
+    run<tailExtract>(state);
+}
+
+static void BM_Extract_Stamped(benchmark::State &state) {
+    run<stampedExtract>(state);
+}
+
+BENCHMARK(BM_Extract_WholeFile)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Extract_Tail)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Extract_Stamped)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,274 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 启动元数据解码：原先 extractJarInfo 的实现与 LaunchManifest 的对比
+             Legacy 按原实现打开 ifstream 两次定位读取尾部，每个字符串复制为 std::string 后用 wstring_convert 转换，
+             参数用 wstringstream 拆分，设置逐项复制到输出参数；
+             启动器只映射一次可执行文件，各阶段共用映射视图，因此 Manifest 系列在已有映射上测量：
+             ManifestLoad 为启动器 extractJarInfo 阶段实际执行的部分，只解析段目录，字符串按需再转换；
+             Manifest 在此基础上取出原实现输出的全部字符串，与 Legacy 的工作量相同；
+             MapAndManifest 额外包含映射与解除映射，作为不共用映射时的上限
+             非 Windows 平台宽字符转换使用 LaunchManifest 内的 UTF-8 解码，结果与 MultiByteToWideChar 一致但耗时不可直接比较
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <codecvt>
+#include <locale>
+
+#include "jarlayout.h"
+#include "launchmanifest.h"
+#include "mappedfile.h"
+#include "testutil.h"
+
+using TestUtil::Bytes;
+using namespace JarLayout;
+
+namespace {
+    // 典型的打包文件：1 MiB 启动器、4 MiB jar、启动图片、十余个 JVM 参数
+    struct Fixture {
+        TestUtil::TempDir dir;
+        std::filesystem::path path = dir / "app.exe";
+
+        Fixture() {
+            Bytes file(1 << 20, 0x90);
+            const auto jar = TestUtil::ZipBuilder().add("big.bin", TestUtil::randomBytes(4 << 20, 1)).build();
+            const auto jarOffset = file.size();
+            file.insert(file.end(), jar.begin(), jar.end());
+            const auto image = TestUtil::randomBytes(200 * 1024, 2);
+            const auto imageOffset = file.size();
+            file.insert(file.end(), image.begin(), image.end());
+
+            SectionTableWriter writer;
+            writer.add(SectionType::Jar, jarOffset, jar.size(), JAR_ALIGNMENT, hash(jar), SECTION_FLAG_JAR_STAMPED);
+            writer.add(SectionType::SplashImage, imageOffset, image.size(), 1, hash(image));
+
+            const auto metadataOffset = file.size();
+            LaunchSettings settings;
+            settings.javaVersion = 17;
+            settings.launchTime = 1500;
+            Bytes settingsData;
+            TestUtil::append(settingsData, settings);
+            writer.add(SectionType::Settings, file.size(), settingsData.size(), 1, hash(settingsData));
+            file.insert(file.end(), settingsData.begin(), settingsData.end());
+
+            const std::array<std::string_view, STRING_COUNT> strings{
+                "com.example.desktop.Main",
+                "-Xms256m\n-Xmx2g\n-XX:+UseG1GC\n-XX:MaxGCPauseMillis=50\n-Dfile.encoding=UTF-8\n"
+                "-Dsun.java2d.uiScale=1.5\n-Djava.net.preferIPv4Stack=true\n--add-opens=java.base/java.lang=ALL-UNNAMED\n"
+                "--add-opens=java.desktop/sun.awt=ALL-UNNAMED\n-Dapp.home=%LOCALAPPDATA%\\示例程序\n"
+                "-Dlog.dir=%TEMP%\\示例程序\\logs\n-XX:+HeapDumpOnOutOfMemoryError",
+                "--profile=default\n--lang=zh_CN\n--no-update-check",
+                "%ProgramFiles%\\Java\\jdk-17\\bin\\javaw.exe",
+                "%LOCALAPPDATA%\\示例程序\\jar",
+                "示例程序 Desktop",
+                "3.14.159",
+            };
+            const auto table = encodeStrings(strings);
+            writer.add(SectionType::Strings, file.size(), table.size(), 1, hash(table));
+            file.insert(file.end(), table.begin(), table.end());
+            const auto sections = writer.finish(metadataOffset, file.size());
+            file.insert(file.end(), sections.begin(), sections.end());
+            TestUtil::writeFile(path, file);
+        }
+    };
+
+    const Fixture &fixture() {
+        static const Fixture instance;
+        return instance;
+    }
+
+    // 原实现的全部输出参数
+    struct LegacyInfo {
+        std::uint64_t jarOffset, jarSize, splashImageOffset, splashImageSize, timestamp;
+        bool splashShowProgress, splashShowProgressText;
+        int launchTime;
+        std::uint32_t javaVersion;
+        std::wstring mainClass, javaPath, jarExtractPath, splashProgramName, splashProgramVersion;
+        std::vector<std::wstring> jvmArgs, programArgs;
+        JarCommon::LaunchMode launchMode;
+        float titlePosX, titlePosY, versionPosX, versionPosY, statusPosX, statusPosY;
+        float titleFontSizePercent, versionFontSizePercent, statusFontSizePercent;
+    };
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    std::wstring utf8ToWstring(const std::string &utf8) {
+        return std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(utf8);
+    }
+#pragma GCC diagnostic pop
+
+    std::vector<std::wstring> splitWString(const std::wstring &str, const wchar_t delimiter) {
+        std::vector<std::wstring> result;
+        std::wstringstream ss(str);
+        std::wstring item;
+        while (std::getline(ss, item, delimiter)) {
+            if (!item.empty()) {
+                result.push_back(item);
+            }
+        }
+        return result;
+    }
+
+    bool legacyDecode(const std::filesystem::path &filePath, LegacyInfo &out) {
+        std::ifstream file(filePath, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.seekg(0, std::ios::end);
+        const std::uint64_t fileSize = file.tellg();
+        std::vector<std::uint8_t> tail(PROBE_SIZE);
+        file.seekg(static_cast<std::streamoff>(fileSize - tail.size()));
+        file.read(reinterpret_cast<char *>(tail.data()), static_cast<std::streamsize>(tail.size()));
+        const auto sizeResult = metadataSize(tail, fileSize);
+        if (!file.good() || !sizeResult) {
+            return false;
+        }
+        if (sizeResult.value() > tail.size()) {
+            tail.resize(sizeResult.value());
+            file.seekg(static_cast<std::streamoff>(fileSize - tail.size()));
+            file.read(reinterpret_cast<char *>(tail.data()), static_cast<std::streamsize>(tail.size()));
+        }
+        const auto infoResult = parse(tail, fileSize);
+        if (!infoResult) {
+            return false;
+        }
+        const auto &info = infoResult.value();
+        const auto readUtf8String = [&](const StringId id) -> std::wstring {
+            const auto view = stringView(info, tail, fileSize, id);
+            return view.empty() ? L"" : utf8ToWstring(std::string(view));
+        };
+
+        out.mainClass = readUtf8String(StringId::MainClass);
+        out.jvmArgs = splitWString(readUtf8String(StringId::JvmArgs), L'\n');
+        out.programArgs = splitWString(readUtf8String(StringId::ProgramArgs), L'\n');
+        out.javaPath = readUtf8String(StringId::JavaPath);
+        out.jarExtractPath = readUtf8String(StringId::JarExtractPath);
+        out.splashProgramName = readUtf8String(StringId::SplashProgramName);
+        out.splashProgramVersion = readUtf8String(StringId::SplashProgramVersion);
+
+        const auto jarRange = info.range(SectionType::Jar);
+        const auto imageRange = info.range(SectionType::SplashImage);
+        const auto &settings = info.settings;
+        out.jarOffset = jarRange.offset;
+        out.jarSize = jarRange.size;
+        out.splashImageOffset = imageRange.offset;
+        out.splashImageSize = imageRange.size;
+        out.splashShowProgress = settings.splashShowProgress != 0;
+        out.splashShowProgressText = settings.splashShowProgressText != 0;
+        out.launchTime = settings.launchTime;
+        out.javaVersion = settings.javaVersion;
+        out.launchMode = settings.launchMode;
+        out.titlePosX = settings.titlePosX;
+        out.titlePosY = settings.titlePosY;
+        out.versionPosX = settings.versionPosX;
+        out.versionPosY = settings.versionPosY;
+        out.statusPosX = settings.statusPosX;
+        out.statusPosY = settings.statusPosY;
+        out.titleFontSizePercent = settings.titleFontSizePercent;
+        out.versionFontSizePercent = settings.versionFontSizePercent;
+        out.statusFontSizePercent = settings.statusFontSizePercent;
+        out.timestamp = settings.timestamp;
+        return true;
+    }
+} // namespace
+
+static void BM_Decode_Legacy(benchmark::State &state) {
+    const auto &f = fixture();
+    for (auto _: state) {
+        LegacyInfo info{};
+        if (!legacyDecode(f.path, info)) {
+            state.SkipWithError("解码失败");
+            break;
+        }
+        benchmark::DoNotOptimize(info);
+    }
+}
+
+namespace {
+    bool decodeAll(const std::span<const std::uint8_t> file) {
+        const auto manifest = LaunchManifest::load(file);
+        if (!manifest) {
+            return false;
+        }
+        auto mainClass = manifest->wide(StringId::MainClass);
+        auto javaPath = manifest->wide(StringId::JavaPath);
+        auto jarExtractPath = manifest->wide(StringId::JarExtractPath);
+        auto splashProgramName = manifest->wide(StringId::SplashProgramName);
+        auto splashProgramVersion = manifest->wide(StringId::SplashProgramVersion);
+        auto jvmArgs = manifest->lines(StringId::JvmArgs);
+        auto programArgs = manifest->lines(StringId::ProgramArgs);
+        benchmark::DoNotOptimize(mainClass);
+        benchmark::DoNotOptimize(javaPath);
+        benchmark::DoNotOptimize(jarExtractPath);
+        benchmark::DoNotOptimize(splashProgramName);
+        benchmark::DoNotOptimize(splashProgramVersion);
+        benchmark::DoNotOptimize(jvmArgs);
+        benchmark::DoNotOptimize(programArgs);
+        return true;
+    }
+} // namespace
+
+static void BM_Decode_ManifestLoad(benchmark::State &state) {
+    const auto mapping = MappedFile::open(fixture().path);
+    if (!mapping) {
+        state.SkipWithError("映射失败");
+        return;
+    }
+    for (auto _: state) {
+        auto manifest = LaunchManifest::load(mapping->data());
+        if (!manifest) {
+            state.SkipWithError("解码失败");
+            break;
+        }
+        benchmark::DoNotOptimize(manifest);
+    }
+}
+
+static void BM_Decode_Manifest(benchmark::State &state) {
+    const auto mapping = MappedFile::open(fixture().path);
+    if (!mapping) {
+        state.SkipWithError("映射失败");
+        return;
+    }
+    // 两种实现的输出必须一致，否则对比没有意义
+    LegacyInfo legacy{};
+    const auto manifest = LaunchManifest::load(mapping->data());
+    if (!legacyDecode(fixture().path, legacy) || !manifest ||
+        legacy.mainClass != manifest->wide(StringId::MainClass) ||
+        legacy.jarExtractPath != manifest->wide(StringId::JarExtractPath) ||
+        legacy.splashProgramName != manifest->wide(StringId::SplashProgramName) ||
+        legacy.jvmArgs != manifest->lines(StringId::JvmArgs) ||
+        legacy.programArgs != manifest->lines(StringId::ProgramArgs) ||
+        legacy.jarOffset != manifest->jar().offset) {
+        state.SkipWithError("两种实现的解码结果不一致");
+        return;
+    }
+    for (auto _: state) {
+        if (!decodeAll(mapping->data())) {
+            state.SkipWithError("解码失败");
+            break;
+        }
+    }
+}
+
+static void BM_Decode_MapAndManifest(benchmark::State &state) {
+    const auto &f = fixture();
+    for (auto _: state) {
+        const auto mapping = MappedFile::open(f.path);
+        if (!mapping || !decodeAll(mapping->data())) {
+            state.SkipWithError("解码失败");
+            break;
+        }
+    }
+}
+
+BENCHMARK(BM_Decode_Legacy)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Decode_ManifestLoad)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Decode_Manifest)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Decode_MapAndManifest)->Unit(benchmark::kMicrosecond);
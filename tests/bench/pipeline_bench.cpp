@@ -0,0 +1,147 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 启动阶段图基准：jar 获取与 Java 运行时查找串行执行与并行执行的对比
+             两个阶段按启动器的方式组合：jar 阶段定位 ZIP 尾部后按内容摘要获取缓存，
+             缺失时复制区间并写入 JarStamp；查找阶段使用查找缓存，缺失时扫描安装目录
+             启动图片解码与 jvm.dll 预加载只在 Windows 上存在，不在此基准中
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+
+#include "filecopy.h"
+#include "jarcache.h"
+#include "jarlayout.h"
+#include "javadiscovery.h"
+#include "mappedfile.h"
+#include "testutil.h"
+#include "ziptail.h"
+
+using TestUtil::Bytes;
+
+namespace {
+    // 打包文件、缓存目录与假 JDK 安装目录，同一进程内的各个基准共用
+    struct Fixture {
+        TestUtil::TempDir dir;
+        std::filesystem::path package = dir / "app.exe";
+        std::filesystem::path cacheRoot = dir / "cache";
+        std::filesystem::path discoveryCache = dir / "jvm-discovery.cache";
+        std::vector<std::filesystem::path> roots{dir / "jvm", dir / "opt", dir / "corretto"};
+        std::uint64_t jarSize = 0;
+
+        explicit Fixture(const std::size_t jarMiB) {
+            Bytes comment;
+            TestUtil::append(comment, JarLayout::JarStamp{1});
+            const auto jar = TestUtil::ZipBuilder().add("big.bin", TestUtil::randomBytes(jarMiB << 20, 3)).build(comment);
+            Bytes file(JarLayout::JAR_ALIGNMENT, 0x90);
+            file.insert(file.end(), jar.begin(), jar.end());
+            TestUtil::writeFile(package, file);
+            jarSize = jar.size();
+
+            int index = 0;
+            for (const auto &root: roots) {
+                for (const auto version: {"1.8.0_392", "11.0.21", "17.0.9", "21.0.1"}) {
+                    const auto home = root / std::format("jdk{}", index++);
+                    TestUtil::writeFile(home / "release", std::format("JAVA_VERSION=\"{}\"\nOS_ARCH=\"amd64\"\n",
+                                                                      version));
+                    TestUtil::writeFile(home / "bin" / "java", "#!/bin/sh\n");
+                    TestUtil::writeFile(home / "lib" / "server" / "libjvm.so", "ELF");
+                }
+            }
+            unsetenv("JAVA_HOME");
+        }
+
+        void reset(const bool cold) const {
+            if (cold) {
+                std::filesystem::remove_all(cacheRoot);
+                std::filesystem::remove(discoveryCache);
+            }
+        }
+    };
+
+    const Fixture &fixture() {
+        static const Fixture instance(16);
+        return instance;
+    }
+
+    bool prepareJar(const Fixture &f) {
+        JarCache::Digest digest{};
+        digest.fill(0x5A);
+        const auto entry = JarCache::acquire(f.cacheRoot, digest, f.jarSize, f.package,
+                                             [&](const JarCache::Path &tmpPath) -> std::expected<bool, std::wstring> {
+                                                 const auto mapped = MappedFile::open(f.package);
+                                                 if (!mapped) {
+                                                     return std::unexpected{mapped.error()};
+                                                 }
+                                                 const auto record = ZipTail::locate(
+                                                     mapped->view(JarLayout::JAR_ALIGNMENT, f.jarSize));
+                                                 if (!record) {
+                                                     return std::unexpected{record.error()};
+                                                 }
+                                                 struct {
+                                                     ZipTail::EndOfCentralDirectory eocd;
+                                                     JarLayout::JarStamp stamp;
+                                                 } trailer{record->eocd, {1}};
+                                                 trailer.eocd.commentLength = sizeof(JarLayout::JarStamp);
+                                                 const auto copied = FileCopy::copyRange(
+                                                     f.package, JarLayout::JAR_ALIGNMENT, record->eocdOffset, tmpPath,
+                                                     {reinterpret_cast<const std::uint8_t *>(&trailer),
+                                                      sizeof(trailer)});
+                                                 if (!copied) {
+                                                     return std::unexpected{copied.error()};
+                                                 }
+                                                 return true;
+                                             });
+        return entry && JarLayout::readStamp(entry->jarPath, f.jarSize).has_value();
+    }
+
+    bool discoverRuntime(const Fixture &f) {
+        return JavaDiscovery::find(JavaDiscovery::Binary::Jvm, L"", 0x00110000, f.discoveryCache, f.roots)
+                .has_value();
+    }
+
+    // 修改前：jar 阶段完成后再查找运行时
+    void serial(const Fixture &f) {
+        const bool jar = prepareJar(f);
+        const bool runtime = discoverRuntime(f);
+        benchmark::DoNotOptimize(jar && runtime);
+    }
+
+    // 修改后：两个阶段各自在线程上执行，主线程等待两者完成
+    void parallel(const Fixture &f) {
+        auto jarTask = std::async(std::launch::async, prepareJar, std::cref(f));
+        auto runtimeTask = std::async(std::launch::async, discoverRuntime, std::cref(f));
+        benchmark::DoNotOptimize(jarTask.get() && runtimeTask.get());
+    }
+
+    void runStages(benchmark::State &state, void (*stages)(const Fixture &)) {
+        const auto &f = fixture();
+        const bool cold = state.range(0) != 0;
+        for (auto _: state) {
+            state.PauseTiming();
+            f.reset(cold);
+            state.ResumeTiming();
+            stages(f);
+        }
+        state.SetLabel(cold ? "cold cache" : "warm cache");
+    }
+} // namespace
+
+static void BM_StagesSerial(benchmark::State &state) {
+    runStages(state, serial);
+}
+
+BENCHMARK(BM_StagesSerial)->Arg(1)->Arg(0)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+static void BM_StagesParallel(benchmark::State &state) {
+    runStages(state, parallel);
+}
+
+BENCHMARK(BM_StagesParallel)->Arg(1)->Arg(0)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,134 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 类数据共享归档的启动耗时对比：同一个程序不带归档与带 SharedArchive::options 生成的归档各启动一次
+             需要 JDK 13 及以上（含 javac 与 jar），未找到时跳过
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+
+#include "javadiscovery.h"
+#include "sharedarchive.h"
+#include "testutil.h"
+
+namespace {
+    // 示例程序加载若干常用模块中的类，模拟普通桌面程序的启动
+    constexpr auto MAIN_SOURCE = R"(
+import java.time.*;
+import java.util.*;
+import java.util.concurrent.*;
+import java.util.stream.*;
+
+public class Main {
+    public static void main(String[] args) throws Exception {
+        var pool = Executors.newFixedThreadPool(2);
+        var sum = pool.submit(() -> IntStream.range(0, 1000).boxed().collect(Collectors.toList())
+                .stream().mapToInt(Integer::intValue).sum()).get();
+        var map = new ConcurrentHashMap<String, Object>();
+        map.put("time", LocalDateTime.now().plus(Duration.ofMinutes(sum % 60)));
+        map.put("text", String.format(Locale.ROOT, "%s-%d", UUID.randomUUID(), sum));
+        pool.shutdown();
+    }
+}
+)";
+
+    std::string quote(const std::filesystem::path &path) {
+        return std::format("'{}'", path.string());
+    }
+
+    std::string join(const std::vector<std::wstring> &args) {
+        std::string result;
+        for (const auto &arg: args) {
+            result += std::format(" {}", quote(arg));
+        }
+        return result;
+    }
+
+    struct Fixture {
+        TestUtil::TempDir dir;
+        std::filesystem::path java;
+        std::filesystem::path jar = dir / "app.jar";
+        std::string error;
+        std::vector<std::wstring> archiveArgs;
+
+        Fixture() {
+            const auto found = JavaDiscovery::scan(JavaDiscovery::Binary::Java, 0x000D0000);
+            if (!found) {
+                error = "未找到 JDK 13 及以上版本";
+                return;
+            }
+            java = *found;
+            const auto bin = java.parent_path();
+            if (!std::filesystem::exists(bin / "javac") || !std::filesystem::exists(bin / "jar")) {
+                error = "JDK 中缺少 javac 或 jar";
+                return;
+            }
+            TestUtil::writeFile(dir / "src" / "Main.java", MAIN_SOURCE);
+            const auto build = std::format("{} -d {} {} && {} --create --file {} --main-class Main -C {} .",
+                                           quote(bin / "javac"), quote(dir / "classes"),
+                                           quote(dir / "src" / "Main.java"), quote(bin / "jar"), quote(jar),
+                                           quote(dir / "classes"));
+            if (std::system(build.c_str()) != 0) {
+                error = "编译示例程序失败";
+                return;
+            }
+
+            // 第一次启动生成归档，之后的启动使用
+            const auto archiveDir = dir / "archives";
+            const auto stem = SharedArchive::appStem(jar);
+            const auto javaHome = bin.parent_path();
+            run(SharedArchive::options(javaHome, archiveDir, stem, 1, {}, false));
+            archiveArgs = SharedArchive::options(javaHome, archiveDir, stem, 1, {}, false);
+            run(archiveArgs);
+            std::error_code ec;
+            if (std::filesystem::is_empty(archiveDir, ec) || ec) {
+                error = "归档未生成";
+            }
+        }
+
+        bool run(const std::vector<std::wstring> &args) const {
+            const auto command = std::format("{}{} -jar {} >/dev/null 2>&1", quote(java), join(args), quote(jar));
+            return std::system(command.c_str()) == 0;
+        }
+    };
+
+    const Fixture &fixture() {
+        static const Fixture instance;
+        return instance;
+    }
+
+    void launch(benchmark::State &state, const bool withArchive) {
+        const auto &f = fixture();
+        if (!f.error.empty()) {
+            state.SkipWithError(f.error.c_str());
+            return;
+        }
+        // 不带归档时只使用 JDK 自带的默认 CDS 归档
+        const auto &args = withArchive ? f.archiveArgs : std::vector<std::wstring>{};
+        for (auto _: state) {
+            if (!f.run(args)) {
+                state.SkipWithError("启动失败");
+                return;
+            }
+        }
+    }
+} // namespace
+
+static void BM_LaunchWithoutArchive(benchmark::State &state) {
+    launch(state, false);
+}
+
+BENCHMARK(BM_LaunchWithoutArchive)->Unit(benchmark::kMillisecond)->UseRealTime()->MinTime(2.0);
+
+static void BM_LaunchWithArchive(benchmark::State &state) {
+    launch(state, true);
+}
+
+BENCHMARK(BM_LaunchWithArchive)->Unit(benchmark::kMillisecond)->UseRealTime()->MinTime(2.0);
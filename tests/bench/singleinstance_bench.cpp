@@ -0,0 +1,66 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 单实例参数转发延迟：从 forward 调用开始到已运行实例的回调收到参数为止
+             本进程同时作为已运行的实例与后续启动，只在 Windows 上构建
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <windows.h>
+
+#include <condition_variable>
+#include <format>
+#include <mutex>
+
+#include "singleinstance.h"
+
+namespace {
+    // 每个进程使用不同的 exe 路径，避免与正在运行的其他实例冲突
+    const std::wstring &executablePath() {
+        static const std::wstring path = std::format(L"C:\\bench\\singleinstance-{}.exe", GetCurrentProcessId());
+        return path;
+    }
+
+    struct Delivery {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::uint64_t count = 0;
+    };
+} // namespace
+
+static void BM_ForwardLatency(benchmark::State &state) {
+    static const bool owner = SingleInstance::acquire(executablePath());
+    if (!owner) {
+        state.SkipWithError("无法获取实例锁");
+        return;
+    }
+    Delivery delivery;
+    SingleInstance::setHandler([&](const std::vector<std::wstring> &) {
+        {
+            std::lock_guard lock(delivery.mutex);
+            ++delivery.count;
+        }
+        delivery.cv.notify_one();
+    });
+
+    std::vector<std::wstring> args(static_cast<std::size_t>(state.range(0)), L"C:\\Users\\user\\Documents\\file.txt");
+    std::uint64_t expected = 0;
+    for (auto _: state) {
+        if (!SingleInstance::forward(executablePath(), args)) {
+            state.SkipWithError("转发失败");
+            break;
+        }
+        ++expected;
+        std::unique_lock lock(delivery.mutex);
+        delivery.cv.wait(lock, [&] { return delivery.count == expected; });
+    }
+    SingleInstance::clearHandler();
+}
+
+BENCHMARK(BM_ForwardLatency)->Arg(1)->Arg(64)->Unit(benchmark::kMicrosecond)->UseRealTime();
@@ -0,0 +1,142 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 热启动时校验已解压 jar：原先读入整个文件的两种校验与当前只读尾部的校验对比
+             MD5WholeFile 按原实现读入整个文件计算 MD5（原实现使用 CryptoAPI，这里使用 OpenSSL EVP）；
+             StampWholeFile 按原实现读入整个文件，逐字节查找 EOCD 后比较注释中的时间戳；
+             Tail 为 JarLayout::readStamp，比较文件大小后只读取 EOCD 可能存在的尾部区域
+             文件在页缓存中，测得的是热启动时的开销
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include <openssl/evp.h>
+
+#include "jarlayout.h"
+#include "testutil.h"
+#include "ziptail.h"
+
+using TestUtil::Bytes;
+using Path = std::filesystem::path;
+
+namespace {
+    constexpr std::uint64_t TIMESTAMP = 0x1234567890ABCDEFULL;
+
+    struct Fixture {
+        TestUtil::TempDir dir;
+        std::map<std::size_t, Path> jars;
+        std::map<Path, std::uint64_t> sizes; // 启动器从启动清单得到的预期大小
+
+        // 解压后的 jar，注释为 JarStamp
+        const Path &jar(const std::size_t mib) {
+            auto &path = jars[mib];
+            if (path.empty()) {
+                Bytes comment;
+                TestUtil::append(comment, JarLayout::JarStamp{TIMESTAMP});
+                path = dir / std::format("app-{}.jar", mib);
+                TestUtil::writeFile(path, TestUtil::ZipBuilder()
+                                    .add("META-INF/MANIFEST.MF", "Manifest-Version: 1.0\r\n")
+                                    .add("big.bin", TestUtil::randomBytes(mib << 20, 7))
+                                    .build(comment));
+                sizes[path] = std::filesystem::file_size(path);
+            }
+            return path;
+        }
+    };
+
+    Fixture &fixture() {
+        static Fixture instance;
+        return instance;
+    }
+
+    Bytes readAll(const Path &path) {
+        std::ifstream in(path, std::ios::binary);
+        in.seekg(0, std::ios::end);
+        Bytes data(static_cast<std::size_t>(in.tellg()));
+        in.seekg(0, std::ios::beg);
+        in.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        return data;
+    }
+
+    std::string md5Hex(const Bytes &data) {
+        std::array<unsigned char, EVP_MAX_MD_SIZE> digest{};
+        unsigned int size = 0;
+        EVP_Digest(data.data(), data.size(), digest.data(), &size, EVP_md5(), nullptr);
+        std::string hex;
+        for (unsigned int i = 0; i < size; ++i) {
+            hex += std::format("{:02x}", digest[i]);
+        }
+        return hex;
+    }
+
+    // 原实现：逐字节向前查找 EOCD 签名
+    std::optional<std::size_t> legacyFindEocd(const Bytes &data) {
+        constexpr std::size_t MIN_EOCD_SIZE = 22;
+        if (data.size() < MIN_EOCD_SIZE) {
+            return std::nullopt;
+        }
+        const std::size_t searchStart = data.size() > 65557 ? data.size() - 65557 : 0;
+        for (std::size_t i = data.size() - MIN_EOCD_SIZE; i >= searchStart; --i) {
+            if (TestUtil::read<std::uint32_t>(data, i) == ZipTail::EOCD_SIGNATURE &&
+                i + MIN_EOCD_SIZE + TestUtil::read<std::uint16_t>(data, i + 20) == data.size()) {
+                return i;
+            }
+            if (i == searchStart) {
+                break;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool stampWholeFile(const Path &jar, const std::string &) {
+        const auto data = readAll(jar);
+        const auto eocd = legacyFindEocd(data);
+        if (!eocd || TestUtil::read<std::uint16_t>(data, *eocd + 20) != sizeof(JarLayout::JarStamp)) {
+            return false;
+        }
+        return TestUtil::read<JarLayout::JarStamp>(data, *eocd + ZipTail::EOCD_SIZE).timestamp == TIMESTAMP;
+    }
+
+    bool md5WholeFile(const Path &jar, const std::string &expected) {
+        return md5Hex(readAll(jar)) == expected;
+    }
+
+    bool tail(const Path &jar, const std::string &) {
+        const auto stamp = JarLayout::readStamp(jar, fixture().sizes.at(jar));
+        return stamp && stamp->timestamp == TIMESTAMP;
+    }
+
+    // range(0)：jar 大小（MiB）
+    template<bool (*verify)(const Path &, const std::string &)>
+    void run(benchmark::State &state) {
+        const auto &jar = fixture().jar(static_cast<std::size_t>(state.range(0)));
+        const auto expectedMd5 = md5Hex(readAll(jar));
+        for (auto _: state) {
+            if (!verify(jar, expectedMd5)) {
+                state.SkipWithError("校验失败");
+                break;
+            }
+        }
+    }
+} // namespace
+
+static void BM_Verify_MD5WholeFile(benchmark::State &state) {
+    run<md5WholeFile>(state);
+}
+
+static void BM_Verify_StampWholeFile(benchmark::State &state) {
+    run<stampWholeFile>(state);
+}
+
+static void BM_Verify_Tail(benchmark::State &state) {
+    run<tail>(state);
+}
+
+BENCHMARK(BM_Verify_MD5WholeFile)->Arg(1)->Arg(16)->Arg(256)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_Verify_StampWholeFile)->Arg(1)->Arg(16)->Arg(256)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_Verify_Tail)->Arg(1)->Arg(16)->Arg(256)->Unit(benchmark::kMicrosecond)->UseRealTime();
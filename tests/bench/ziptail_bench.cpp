@@ -0,0 +1,75 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: ZipTail 基准，同一份基准分别链接标量、SSE2、AVX2 实现运行
+
+**************************************************************************/
+#include <benchmark/benchmark.h>
+
+#include "testutil.h"
+#include "ziptail.h"
+
+using TestUtil::Bytes;
+
+namespace {
+    // 最大注释全部由 "PK\5" + 非 \6 字节组成：每个位置都匹配前三个字节，是逐字节比较的最坏情况
+    Bytes nearMissZip() {
+        Bytes comment;
+        while (comment.size() + 4 <= ZipTail::MAX_COMMENT_SIZE) {
+            TestUtil::append(comment, std::string_view("PK\x05\x07"));
+        }
+        comment.resize(ZipTail::MAX_COMMENT_SIZE, 'P');
+        return TestUtil::ZipBuilder().add("a.txt", "hello").build(comment);
+    }
+
+    // 注释中每 22 字节一个完整的 EOCD 签名，但注释长度都对不上，定位需要逐个排除
+    Bytes falseSignatureZip() {
+        Bytes comment(ZipTail::MAX_COMMENT_SIZE, 0);
+        for (std::size_t pos = 0; pos + 4 <= comment.size(); pos += ZipTail::EOCD_SIZE) {
+            std::memcpy(comment.data() + pos, &ZipTail::EOCD_SIGNATURE, 4);
+        }
+        return TestUtil::ZipBuilder().add("a.txt", "hello").build(comment);
+    }
+
+    void locateTail(benchmark::State &state, const Bytes &zip) {
+        const std::size_t tailOffset = zip.size() - ZipTail::MAX_SEARCH_SIZE;
+        const auto tail = std::span(zip).subspan(tailOffset);
+        for (auto _: state) {
+            auto record = ZipTail::locate(tail, tailOffset);
+            benchmark::DoNotOptimize(record);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * tail.size()));
+    }
+} // namespace
+
+static void BM_LocateNearMiss(benchmark::State &state) {
+    locateTail(state, nearMissZip());
+}
+
+BENCHMARK(BM_LocateNearMiss);
+
+static void BM_LocateFalseSignatures(benchmark::State &state) {
+    locateTail(state, falseSignatureZip());
+}
+
+BENCHMARK(BM_LocateFalseSignatures);
+
+static void BM_FindLastRandom(benchmark::State &state) {
+    auto data = TestUtil::randomBytes(static_cast<std::size_t>(state.range(0)), 42);
+    for (auto &b: data) {
+        if (b == 'P') {
+            b = 'Q';
+        }
+    }
+    for (auto _: state) {
+        benchmark::DoNotOptimize(ZipTail::findLastSignature(data, ZipTail::EOCD_SIGNATURE));
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * data.size()));
+}
+
+BENCHMARK(BM_FindLastRandom)->Arg(ZipTail::MAX_SEARCH_SIZE)->Arg(1 << 20);
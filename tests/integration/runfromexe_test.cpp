@@ -0,0 +1,230 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 直接运行模式的集成测试：按打包器的步骤把 zip 命令生成的 jar 拼接到启动器桩之后，
+             用 unzip -t 校验整个 exe 是合法 ZIP，找到 JDK 时再用 java -jar 与 -cp 直接运行 exe；
+             Zip64 jar 与超出 ZIP 注释上限的元数据必须被拒绝
+             打包器依赖 Qt，这里复刻 Packager::packageJar 中直接运行模式的拼接顺序，ZIP 处理调用同一组 ZipTail 函数
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include "javadiscovery.h"
+#include "jarlayout.h"
+#include "launchmanifest.h"
+#include "mappedfile.h"
+#include "testutil.h"
+#include "ziptail.h"
+
+using TestUtil::Bytes;
+using Path = std::filesystem::path;
+using namespace JarLayout;
+
+namespace {
+    constexpr auto MAIN_SOURCE = R"(
+import java.io.*;
+import java.nio.charset.StandardCharsets;
+
+public class Main {
+    public static void main(String[] args) throws Exception {
+        try (var in = Main.class.getResourceAsStream("/data/hello.txt")) {
+            System.out.print(new String(in.readAllBytes(), StandardCharsets.UTF_8));
+        }
+    }
+}
+)";
+
+    std::string quote(const Path &path) {
+        return std::format("'{}'", path.string());
+    }
+
+    bool hasCommand(const std::string_view name) {
+        return std::system(std::format("command -v {} >/dev/null 2>&1", name).c_str()) == 0;
+    }
+
+    bool run(const std::string &command) {
+        return std::system(command.c_str()) == 0;
+    }
+
+    // 在 dir 下用 zip 命令打包 files，zip64 为 true 时强制使用 Zip64 格式
+    Bytes zipFiles(const Path &dir, const std::string_view files, const bool zip64 = false) {
+        const auto output = dir / "input.jar";
+        std::filesystem::remove(output);
+        if (!run(std::format("cd {} && zip -q -r -X {} {} {}", quote(dir), zip64 ? "-fz" : "", quote(output),
+                             files))) {
+            return {};
+        }
+        return TestUtil::readFile(output);
+    }
+
+    struct Packaged {
+        Bytes file;
+        std::uint64_t jarOffset = 0;
+    };
+
+    /**
+     * 按 Packager::packageJar 的直接运行模式拼接：启动器 + 启动图片 + 对齐填充 + jar + 元数据块，
+     * 元数据块即 jar 的 ZIP 注释
+     */
+    std::expected<Packaged, std::wstring> packageRunFromExe(const Bytes &launcher, const Bytes &image, Bytes jar,
+                                                            const std::array<std::string_view, STRING_COUNT> &strings) {
+        const auto jarTailSize = std::min<std::size_t>(jar.size(), ZipTail::MAX_SEARCH_SIZE);
+        const auto eocd = ZipTail::locate(std::span(jar).last(jarTailSize), jar.size() - jarTailSize);
+        if (!eocd) {
+            return std::unexpected{eocd.error()};
+        }
+        jar.resize(static_cast<std::size_t>(eocd->eocdOffset) + ZipTail::EOCD_SIZE);
+
+        Packaged packaged;
+        packaged.file = launcher;
+        SectionTableWriter sections;
+        if (!image.empty()) {
+            sections.add(SectionType::SplashImage, packaged.file.size(), image.size(), 1, hash(image));
+            packaged.file.insert(packaged.file.end(), image.begin(), image.end());
+        }
+        packaged.file.resize((packaged.file.size() + JAR_ALIGNMENT - 1) / JAR_ALIGNMENT * JAR_ALIGNMENT, 0);
+        packaged.jarOffset = packaged.file.size();
+
+        if (auto result = ZipTail::setCommentLength(jar, eocd->eocdOffset, 0); !result) {
+            return std::unexpected{result.error()};
+        }
+        if (auto result = ZipTail::rebase(jar, packaged.jarOffset); !result) {
+            return std::unexpected{result.error()};
+        }
+
+        LaunchSettings settings;
+        settings.javaVersion = 17;
+        Bytes settingsData;
+        TestUtil::append(settingsData, settings);
+        const auto stringTable = encodeStrings(strings);
+        const auto metadataOffset = packaged.jarOffset + jar.size();
+        sections.add(SectionType::Jar, packaged.jarOffset, jar.size(), JAR_ALIGNMENT, 0, SECTION_FLAG_RUN_FROM_EXE);
+        sections.add(SectionType::Settings, metadataOffset, settingsData.size(), 1, hash(settingsData));
+        sections.add(SectionType::Strings, metadataOffset + settingsData.size(), stringTable.size(), 1,
+                     hash(stringTable));
+        const std::size_t metadataSize = settingsData.size() + stringTable.size() + sections.tableSize();
+        if (auto result = ZipTail::setCommentLength(jar, eocd->eocdOffset, metadataSize); !result) {
+            return std::unexpected{result.error()};
+        }
+        sections.setHash(SectionType::Jar, hash(jar));
+
+        packaged.file.insert(packaged.file.end(), jar.begin(), jar.end());
+        packaged.file.insert(packaged.file.end(), settingsData.begin(), settingsData.end());
+        packaged.file.insert(packaged.file.end(), stringTable.begin(), stringTable.end());
+        const auto table = sections.finish(metadataOffset, packaged.file.size());
+        packaged.file.insert(packaged.file.end(), table.begin(), table.end());
+        return packaged;
+    }
+
+    std::array<std::string_view, STRING_COUNT> sampleStrings(const std::string_view programArgs = "--verbose") {
+        return {"Main", "-Xmx256m", programArgs, "", "", "示例程序", "1.0.0"};
+    }
+
+    class RunFromExeTest : public testing::Test {
+    protected:
+        void SetUp() override {
+            if (!hasCommand("zip") || !hasCommand("unzip")) {
+                GTEST_SKIP() << "未找到 zip/unzip 命令";
+            }
+            TestUtil::writeFile(dir / "src" / "META-INF" / "MANIFEST.MF",
+                                "Manifest-Version: 1.0\r\nMain-Class: Main\r\n\r\n");
+            TestUtil::writeFile(dir / "src" / "data" / "hello.txt", "hello from exe\n");
+            TestUtil::writeFile(dir / "src" / "data" / "big.bin", TestUtil::randomBytes(256 * 1024, 3));
+        }
+
+        // 启动器桩：MZ 头 + 随机数据，长度不按对齐值取整
+        static Bytes launcherStub() {
+            auto stub = TestUtil::randomBytes(100 * 1024 + 123, 1);
+            stub[0] = 'M';
+            stub[1] = 'Z';
+            return stub;
+        }
+
+        Path writeExe(const Packaged &packaged) const {
+            const auto exe = dir / "app.exe";
+            TestUtil::writeFile(exe, packaged.file);
+            return exe;
+        }
+
+        TestUtil::TempDir dir;
+    };
+} // namespace
+
+TEST_F(RunFromExeTest, PackagedExeIsValidZip) {
+    const auto jar = zipFiles(dir / "src", "META-INF data");
+    ASSERT_FALSE(jar.empty());
+    const auto packaged = packageRunFromExe(launcherStub(), TestUtil::randomBytes(5000, 2), jar, sampleStrings());
+    ASSERT_TRUE(packaged) << std::filesystem::path(packaged.error()).string();
+    const auto exe = writeExe(*packaged);
+
+    EXPECT_TRUE(run(std::format("unzip -tq {} >/dev/null 2>&1", quote(exe))));
+    const auto extractDir = dir / "out";
+    ASSERT_TRUE(run(std::format("unzip -q {} -d {} >/dev/null 2>&1", quote(exe), quote(extractDir))));
+    EXPECT_EQ(TestUtil::readFile(extractDir / "data" / "big.bin"), TestUtil::readFile(dir / "src" / "data" / "big.bin"));
+
+    // 启动器看到的是同一个文件：元数据块完整，jar 段标记为直接运行
+    const auto mapping = MappedFile::open(exe);
+    ASSERT_TRUE(mapping);
+    const auto manifest = LaunchManifest::load(mapping->data());
+    ASSERT_TRUE(manifest);
+    EXPECT_TRUE(manifest->runFromExe());
+    EXPECT_EQ(manifest->jar().offset, packaged->jarOffset);
+    EXPECT_EQ(manifest->jar().offset % JAR_ALIGNMENT, 0U);
+    EXPECT_EQ(manifest->jarHash(), hash(std::span(packaged->file).subspan(packaged->jarOffset, manifest->jar().size)));
+    EXPECT_EQ(manifest->utf8(StringId::MainClass), "Main");
+    EXPECT_EQ(manifest->utf8(StringId::SplashProgramName), "示例程序");
+}
+
+TEST_F(RunFromExeTest, JavaRunsPackagedExe) {
+    const auto java = JavaDiscovery::scan(JavaDiscovery::Binary::Java);
+    if (!java || !std::filesystem::exists(java->parent_path() / "javac")) {
+        GTEST_SKIP() << "未找到 JDK";
+    }
+    TestUtil::writeFile(dir / "Main.java", MAIN_SOURCE);
+    ASSERT_TRUE(run(std::format("{} -d {} {}", quote(java->parent_path() / "javac"), quote(dir / "src"),
+                                quote(dir / "Main.java"))));
+    const auto jar = zipFiles(dir / "src", "META-INF data Main.class");
+    ASSERT_FALSE(jar.empty());
+    const auto packaged = packageRunFromExe(launcherStub(), {}, jar, sampleStrings());
+    ASSERT_TRUE(packaged);
+    const auto exe = writeExe(*packaged);
+
+    // 启动器使用 -jar（java.exe 模式）或类路径（DirectJVM 模式），两种方式都必须能加载 exe 中的类和资源
+    const auto output = dir / "stdout.txt";
+    ASSERT_TRUE(run(std::format("{} -jar {} > {}", quote(*java), quote(exe), quote(output))));
+    EXPECT_EQ(TestUtil::readFile(output), TestUtil::readFile(dir / "src" / "data" / "hello.txt"));
+    ASSERT_TRUE(run(std::format("{} -cp {} Main > {}", quote(*java), quote(exe), quote(output))));
+    EXPECT_EQ(TestUtil::readFile(output), TestUtil::readFile(dir / "src" / "data" / "hello.txt"));
+}
+
+TEST_F(RunFromExeTest, RejectsZip64Jar) {
+    const auto jar = zipFiles(dir / "src", "META-INF data", true);
+    ASSERT_FALSE(jar.empty());
+    ASSERT_TRUE(ZipTail::locate(jar)->zip64);
+    EXPECT_FALSE(packageRunFromExe(launcherStub(), {}, jar, sampleStrings()));
+}
+
+TEST_F(RunFromExeTest, RejectsMetadataBeyondCommentLimit) {
+    const auto jar = zipFiles(dir / "src", "META-INF data");
+    ASSERT_FALSE(jar.empty());
+
+    // 元数据块大小随程序参数长度线性增长，据此构造恰好等于与超出注释上限的参数
+    const auto base = packageRunFromExe(launcherStub(), {}, jar, sampleStrings(""));
+    ASSERT_TRUE(base);
+    const std::size_t baseMetadata = ZipTail::locate(base->file)->commentLength;
+    const std::string args(ZipTail::MAX_COMMENT_SIZE - baseMetadata, 'a');
+
+    const auto fits = packageRunFromExe(launcherStub(), {}, jar, sampleStrings(args));
+    ASSERT_TRUE(fits);
+    EXPECT_EQ(ZipTail::locate(fits->file)->commentLength, ZipTail::MAX_COMMENT_SIZE);
+    EXPECT_TRUE(run(std::format("unzip -tq {} >/dev/null 2>&1", quote(writeExe(*fits)))));
+
+    EXPECT_FALSE(packageRunFromExe(launcherStub(), {}, jar, sampleStrings(args + "a")));
+}
@@ -0,0 +1,159 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 并发启动压力测试：N 个进程同时从同一打包文件获取缓存 jar，
+             检查只解压一次、没有进程读到不完整的 jar，并输出延迟分位数
+             用法: extract_stress [进程数=32] [轮数=5] [jar MiB=32]
+
+**************************************************************************/
+#include "filecopy.h"
+#include "jarcache.h"
+#include "jarlayout.h"
+#include "mappedfile.h"
+#include "testutil.h"
+#include "ziptail.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using TestUtil::Bytes;
+
+namespace {
+    struct Report {
+        double latencyMs;
+        bool hit;
+        bool valid;
+    };
+
+    // 启动器核心流程：定位 jar 尾部，按内容摘要获取缓存，解压时复制区间并写入 JarStamp
+    Report launch(const std::filesystem::path &package, const std::uint64_t jarOffset, const std::uint64_t jarSize,
+                  const std::filesystem::path &cacheRoot, const std::filesystem::path &owner) {
+        const auto start = std::chrono::steady_clock::now();
+        JarCache::Digest digest{};
+        digest.fill(0x5A);
+
+        const auto fill = [&](const JarCache::Path &tmpPath) -> std::expected<bool, std::wstring> {
+            const auto mapped = MappedFile::open(package);
+            if (!mapped) {
+                return std::unexpected{mapped.error()};
+            }
+            const auto record = ZipTail::locate(mapped->view(jarOffset, jarSize));
+            if (!record) {
+                return std::unexpected{record.error()};
+            }
+            struct {
+                ZipTail::EndOfCentralDirectory eocd;
+                JarLayout::JarStamp stamp;
+            } trailer{record->eocd, {1}};
+            trailer.eocd.commentLength = sizeof(JarLayout::JarStamp);
+            const auto copied = FileCopy::copyRange(package, jarOffset, record->eocdOffset, tmpPath,
+                                                    {reinterpret_cast<const std::uint8_t *>(&trailer),
+                                                     sizeof(trailer)});
+            if (!copied) {
+                return std::unexpected{copied.error()};
+            }
+            return true;
+        };
+        const auto entry = JarCache::acquire(cacheRoot, digest, jarSize, owner, fill);
+        // 模拟 JVM 打开 jar：必须是完整的 ZIP
+        const bool valid = entry && JarLayout::readStamp(entry->jarPath, jarSize).has_value();
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        return {elapsed.count(), entry && entry->hit, valid};
+    }
+
+    double percentile(std::vector<double> values, const double p) {
+        std::ranges::sort(values);
+        const auto index = static_cast<std::size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+} // namespace
+
+int main(const int argc, char **argv) {
+    const int processes = argc > 1 ? std::atoi(argv[1]) : 32;
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    const std::size_t jarMiB = argc > 3 ? static_cast<std::size_t>(std::atoi(argv[3])) : 32;
+
+    const TestUtil::TempDir dir;
+    // 打包文件：4 KiB 的 exe + jar（注释已是 JarStamp，与打包器一致）
+    Bytes comment;
+    TestUtil::append(comment, JarLayout::JarStamp{1});
+    const auto jar = TestUtil::ZipBuilder().add("big.bin", TestUtil::randomBytes(jarMiB << 20, 3)).build(comment);
+    Bytes package(JarLayout::JAR_ALIGNMENT, 0x90);
+    package.insert(package.end(), jar.begin(), jar.end());
+    const auto packagePath = dir / "app.exe";
+    TestUtil::writeFile(packagePath, package);
+
+    bool ok = true;
+    for (const bool cold: {true, false}) {
+        std::vector<double> latencies;
+        int fills = 0;
+        int invalid = 0;
+        const auto cacheRoot = dir / "cache";
+        for (int round = 0; round < rounds; ++round) {
+            if (cold) {
+                std::filesystem::remove_all(cacheRoot);
+            }
+            int startPipe[2];
+            int reportPipe[2];
+            if (pipe(startPipe) != 0 || pipe(reportPipe) != 0) {
+                std::perror("pipe");
+                return 2;
+            }
+            std::vector<pid_t> children;
+            for (int i = 0; i < processes; ++i) {
+                const pid_t pid = fork();
+                if (pid < 0) {
+                    std::perror("fork");
+                    return 2;
+                }
+                if (pid == 0) {
+                    close(startPipe[1]);
+                    close(reportPipe[0]);
+                    char go;
+                    // 父进程关闭写端后所有子进程同时开始
+                    [[maybe_unused]] const auto n = read(startPipe[0], &go, 1);
+                    const auto report = launch(packagePath, JarLayout::JAR_ALIGNMENT, jar.size(), cacheRoot,
+                                               packagePath);
+                    [[maybe_unused]] const auto w = write(reportPipe[1], &report, sizeof(report));
+                    _exit(0);
+                }
+                children.push_back(pid);
+            }
+            close(startPipe[0]);
+            close(reportPipe[1]);
+            close(startPipe[1]);
+
+            Report report{};
+            while (read(reportPipe[0], &report, sizeof(report)) == sizeof(report)) {
+                latencies.push_back(report.latencyMs);
+                fills += report.hit ? 0 : 1;
+                invalid += report.valid ? 0 : 1;
+            }
+            close(reportPipe[0]);
+            for (const auto pid: children) {
+                int status = 0;
+                waitpid(pid, &status, 0);
+            }
+        }
+
+        const int expectedFills = cold ? rounds : 0;
+        const int expectedReports = processes * rounds;
+        std::cout << std::format("{} cache, {} processes x {} rounds, {} MiB jar\n", cold ? "cold" : "warm",
+                                 processes, rounds, jarMiB);
+        std::cout << std::format("  reports={} fills={} (expected {}) invalid={}\n", latencies.size(), fills,
+                                 expectedFills, invalid);
+        if (!latencies.empty()) {
+            std::cout << std::format("  p50={:.2f}ms p90={:.2f}ms p99={:.2f}ms max={:.2f}ms\n",
+                                     percentile(latencies, 0.5), percentile(latencies, 0.9),
+                                     percentile(latencies, 0.99), percentile(latencies, 1.0));
+        }
+        ok = ok && static_cast<int>(latencies.size()) == expectedReports && fills == expectedFills && invalid == 0;
+    }
+    std::cout << (ok ? "PASS" : "FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
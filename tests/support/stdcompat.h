@@ -0,0 +1,210 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 测试工程中替代 import std; 的标准库头文件集合
+
+**************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <deque>
+#include <exception>
+#include <expected>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <regex>
+#include <set>
+#include <shared_mutex>
+#include <span>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if __has_include(<format>)
+#include <format>
+#else
+// 工具链缺少 <format> 时（如 GCC 12）提供仅覆盖本仓库用法的 std::format：
+// 位置顺序的 {}、{{/}} 转义，以及 [填充][对齐][0][宽度][.精度][类型] 格式说明
+namespace std {
+    namespace stdcompat_detail {
+        struct Spec {
+            char fill = ' ';
+            char align = 0;
+            bool zero = false;
+            std::size_t width = 0;
+            int precision = -1;
+            char type = 0;
+        };
+
+        template<typename CharT>
+        Spec parseSpec(const basic_string_view<CharT> text) {
+            Spec spec;
+            std::size_t i = 0;
+            const auto isAlign = [](const CharT c) { return c == '<' || c == '>' || c == '^'; };
+            if (text.size() >= 2 && isAlign(text[1])) {
+                spec.fill = static_cast<char>(text[0]);
+                spec.align = static_cast<char>(text[1]);
+                i = 2;
+            } else if (!text.empty() && isAlign(text[0])) {
+                spec.align = static_cast<char>(text[0]);
+                i = 1;
+            }
+            if (i < text.size() && text[i] == '0') {
+                spec.zero = true;
+                ++i;
+            }
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                spec.width = spec.width * 10 + static_cast<std::size_t>(text[i] - '0');
+                ++i;
+            }
+            if (i < text.size() && text[i] == '.') {
+                spec.precision = 0;
+                ++i;
+                while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                    spec.precision = spec.precision * 10 + (text[i] - '0');
+                    ++i;
+                }
+            }
+            if (i < text.size()) {
+                spec.type = static_cast<char>(text[i]);
+            }
+            return spec;
+        }
+
+        template<typename CharT>
+        void pad(basic_string<CharT> &out, const basic_string<CharT> &value, const Spec &spec, const bool numeric) {
+            if (value.size() >= spec.width) {
+                out += value;
+                return;
+            }
+            const std::size_t padding = spec.width - value.size();
+            if (numeric && spec.zero && spec.align == 0) {
+                std::size_t sign = !value.empty() && value[0] == '-' ? 1 : 0;
+                out += value.substr(0, sign);
+                out.append(padding, static_cast<CharT>('0'));
+                out += value.substr(sign);
+                return;
+            }
+            const char align = spec.align != 0 ? spec.align : (numeric ? '>' : '<');
+            const std::size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+            out.append(before, static_cast<CharT>(spec.fill));
+            out += value;
+            out.append(padding - before, static_cast<CharT>(spec.fill));
+        }
+
+        template<typename CharT>
+        basic_string<CharT> widen(const string_view text) {
+            return basic_string<CharT>(text.begin(), text.end());
+        }
+
+        template<typename CharT, typename T>
+        void append(basic_string<CharT> &out, const Spec &spec, const T &value) {
+            using U = remove_cvref_t<T>;
+            if constexpr (is_same_v<U, bool>) {
+                pad(out, widen<CharT>(value ? "true" : "false"), spec, false);
+            } else if constexpr (is_same_v<U, CharT>) {
+                pad(out, basic_string<CharT>(1, value), spec, false);
+            } else if constexpr (is_integral_v<U>) {
+                char buffer[80];
+                const int base = spec.type == 'x' || spec.type == 'X' ? 16 : spec.type == 'b' ? 2 : 10;
+                auto [end, ec] = to_chars(buffer, buffer + sizeof(buffer), value, base);
+                if (spec.type == 'X') {
+                    std::transform(buffer, end, buffer, [](const char c) { return static_cast<char>(std::toupper(c)); });
+                }
+                pad(out, widen<CharT>(string_view(buffer, end)), spec, true);
+            } else if constexpr (is_floating_point_v<U>) {
+                char buffer[128];
+                auto [end, ec] = spec.precision >= 0
+                                     ? to_chars(buffer, buffer + sizeof(buffer), value, chars_format::fixed,
+                                                spec.precision)
+                                     : to_chars(buffer, buffer + sizeof(buffer), value);
+                pad(out, widen<CharT>(string_view(buffer, end)), spec, true);
+            } else if constexpr (is_convertible_v<const U &, basic_string_view<CharT>>) {
+                pad(out, basic_string<CharT>(basic_string_view<CharT>(value)), spec, false);
+            } else {
+                static_assert(is_same_v<U, void>, "stdcompat format: unsupported argument type");
+            }
+        }
+
+        template<typename CharT, typename... Args>
+        basic_string<CharT> format(const basic_string_view<CharT> fmt, const Args &... args) {
+            basic_string<CharT> out;
+            std::size_t next = 0;
+            for (std::size_t i = 0; i < fmt.size(); ++i) {
+                const CharT c = fmt[i];
+                if (c == '{' && i + 1 < fmt.size() && fmt[i + 1] == '{') {
+                    out += c;
+                    ++i;
+                } else if (c == '}' && i + 1 < fmt.size() && fmt[i + 1] == '}') {
+                    out += c;
+                    ++i;
+                } else if (c == '{') {
+                    const std::size_t close = fmt.find(static_cast<CharT>('}'), i);
+                    auto field = fmt.substr(i + 1, close - i - 1);
+                    const std::size_t colon = field.find(static_cast<CharT>(':'));
+                    const Spec spec = colon == basic_string_view<CharT>::npos
+                                          ? Spec{}
+                                          : parseSpec(field.substr(colon + 1));
+                    std::size_t index = 0;
+                    ((index++ == next ? (append(out, spec, args), 0) : 0), ...);
+                    ++next;
+                    i = close;
+                } else {
+                    out += c;
+                }
+            }
+            return out;
+        }
+    } // namespace stdcompat_detail
+
+    template<typename... Args>
+    string format(const string_view fmt, const Args &... args) {
+        return stdcompat_detail::format<char>(fmt, args...);
+    }
+
+    template<typename... Args>
+    wstring format(const wstring_view fmt, const Args &... args) {
+        return stdcompat_detail::format<wchar_t>(fmt, args...);
+    }
+} // namespace std
+#endif
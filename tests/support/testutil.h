@@ -0,0 +1,203 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: 测试公用工具：临时目录、文件读写与最小 ZIP 构造
+
+**************************************************************************/
+#pragma once
+
+#include "stdcompat.h"
+
+namespace TestUtil {
+    using Bytes = std::vector<std::uint8_t>;
+
+    // 析构时删除的临时目录
+    class TempDir {
+    public:
+        TempDir() {
+            static std::atomic<unsigned> counter{0};
+            const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+            m_path = std::filesystem::temp_directory_path() /
+                     std::format("jarpackager-test-{}-{}", stamp, counter.fetch_add(1));
+            std::filesystem::create_directories(m_path);
+        }
+
+        ~TempDir() {
+            std::error_code ec;
+            std::filesystem::remove_all(m_path, ec);
+        }
+
+        TempDir(const TempDir &) = delete;
+
+        TempDir &operator=(const TempDir &) = delete;
+
+        const std::filesystem::path &path() const { return m_path; }
+
+        std::filesystem::path operator/(const std::filesystem::path &name) const { return m_path / name; }
+
+    private:
+        std::filesystem::path m_path;
+    };
+
+    inline void writeFile(const std::filesystem::path &path, const std::span<const std::uint8_t> data) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    inline void writeFile(const std::filesystem::path &path, const std::string_view text) {
+        writeFile(path, std::span(reinterpret_cast<const std::uint8_t *>(text.data()), text.size()));
+    }
+
+    inline Bytes readFile(const std::filesystem::path &path) {
+        std::ifstream in(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    template<typename T> requires std::is_trivially_copyable_v<T>
+    void append(Bytes &out, const T &value) {
+        const auto *p = reinterpret_cast<const std::uint8_t *>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    inline void append(Bytes &out, const std::string_view text) {
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    template<typename T>
+    T read(const std::span<const std::uint8_t> data, const std::size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    inline std::uint32_t crc32(const std::span<const std::uint8_t> data) {
+        static const auto table = [] {
+            std::array<std::uint32_t, 256> t{};
+            for (std::uint32_t i = 0; i < 256; ++i) {
+                std::uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+        std::uint32_t crc = 0xFFFFFFFFU;
+        for (const auto b: data) {
+            crc = table[(crc ^ b) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFU;
+    }
+
+    inline Bytes randomBytes(const std::size_t size, const std::uint32_t seed) {
+        std::mt19937 rng(seed);
+        Bytes data(size);
+        for (auto &b: data) {
+            b = static_cast<std::uint8_t>(rng());
+        }
+        return data;
+    }
+
+    // 只用 STORED 方式写入条目的最小 ZIP，可选 Zip64 结束记录与任意注释
+    class ZipBuilder {
+    public:
+        ZipBuilder &add(const std::string &name, const std::string_view content) {
+            m_entries.push_back({name, Bytes(content.begin(), content.end())});
+            return *this;
+        }
+
+        ZipBuilder &add(const std::string &name, Bytes content) {
+            m_entries.push_back({name, std::move(content)});
+            return *this;
+        }
+
+        Bytes build(const std::span<const std::uint8_t> comment = {}, const bool zip64 = false) const {
+            Bytes out;
+            std::vector<std::uint32_t> offsets;
+            for (const auto &[name, data]: m_entries) {
+                offsets.push_back(static_cast<std::uint32_t>(out.size()));
+                append(out, std::uint32_t{0x04034b50});
+                append(out, std::uint16_t{10});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0x21});
+                append(out, crc32(data));
+                append(out, static_cast<std::uint32_t>(data.size()));
+                append(out, static_cast<std::uint32_t>(data.size()));
+                append(out, static_cast<std::uint16_t>(name.size()));
+                append(out, std::uint16_t{0});
+                append(out, name);
+                out.insert(out.end(), data.begin(), data.end());
+            }
+
+            const auto cdOffset = static_cast<std::uint32_t>(out.size());
+            for (std::size_t i = 0; i < m_entries.size(); ++i) {
+                const auto &[name, data] = m_entries[i];
+                append(out, std::uint32_t{0x02014b50});
+                append(out, std::uint16_t{20});
+                append(out, std::uint16_t{10});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0x21});
+                append(out, crc32(data));
+                append(out, static_cast<std::uint32_t>(data.size()));
+                append(out, static_cast<std::uint32_t>(data.size()));
+                append(out, static_cast<std::uint16_t>(name.size()));
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint16_t{0});
+                append(out, std::uint32_t{0});
+                append(out, offsets[i]);
+                append(out, name);
+            }
+            const auto cdSize = static_cast<std::uint32_t>(out.size() - cdOffset);
+            const auto count = static_cast<std::uint16_t>(m_entries.size());
+
+            if (zip64) {
+                const auto zip64Offset = static_cast<std::uint64_t>(out.size());
+                append(out, std::uint32_t{0x06064b50});
+                append(out, std::uint64_t{44});
+                append(out, std::uint16_t{45});
+                append(out, std::uint16_t{45});
+                append(out, std::uint32_t{0});
+                append(out, std::uint32_t{0});
+                append(out, std::uint64_t{count});
+                append(out, std::uint64_t{count});
+                append(out, std::uint64_t{cdSize});
+                append(out, std::uint64_t{cdOffset});
+                append(out, std::uint32_t{0x07064b50});
+                append(out, std::uint32_t{0});
+                append(out, zip64Offset);
+                append(out, std::uint32_t{1});
+            }
+
+            append(out, std::uint32_t{0x06054b50});
+            append(out, std::uint16_t{0});
+            append(out, std::uint16_t{0});
+            append(out, zip64 ? std::uint16_t{0xFFFF} : count);
+            append(out, zip64 ? std::uint16_t{0xFFFF} : count);
+            append(out, zip64 ? std::uint32_t{0xFFFFFFFF} : cdSize);
+            append(out, zip64 ? std::uint32_t{0xFFFFFFFF} : cdOffset);
+            append(out, static_cast<std::uint16_t>(comment.size()));
+            out.insert(out.end(), comment.begin(), comment.end());
+            return out;
+        }
+
+    private:
+        struct Entry {
+            std::string name;
+            Bytes data;
+        };
+
+        std::vector<Entry> m_entries;
+    };
+} // namespace TestUtil
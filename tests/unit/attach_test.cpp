@@ -0,0 +1,359 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: Attach 流式附加、原地附加、中断日志恢复与多模板索引测试
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "attach.h"
+#include "testutil.h"
+
+using Path = Attach::Path;
+using TestUtil::Bytes;
+using TestUtil::TempDir;
+
+namespace {
+    constexpr unsigned int JOURNAL_MAGIC = 0x6578654A; // "EXEJ"
+
+#pragma pack(push, 1)
+    // 与 attach.cpp 中的日志头部一致
+    struct ExeJournal {
+        unsigned int magic;
+        unsigned long long fileSize;
+        unsigned long long exeOffset;
+    };
+#pragma pack(pop)
+
+    // 附加后的预期内容：原程序 + 附加 EXE + ExeFooter
+    Bytes attached(const Bytes &program, const Bytes &launcher) {
+        Bytes out = program;
+        out.insert(out.end(), launcher.begin(), launcher.end());
+        TestUtil::append(out, ExeFooter{.magic = EXE_MAGIC, .exeOffset = program.size(), .exeSize = launcher.size()});
+        return out;
+    }
+
+    Bytes toBytes(const Attach::ByteArray &data) {
+        Bytes out(data.size());
+        std::memcpy(out.data(), data.data(), data.size());
+        return out;
+    }
+
+    Path journalOf(const Path &exe) {
+        auto path = exe;
+        path += ".journal";
+        return path;
+    }
+
+    // 手工构造多模板文件：原程序 + 各模板 + entries + ExeIndex + ExeFooter，footer 指向第一个模板
+    Bytes indexed(const Bytes &program, const std::vector<Bytes> &templates, std::vector<ExeIndexEntry> entries,
+                  const unsigned int count) {
+        Bytes out = program;
+        for (const auto &data: templates) {
+            out.insert(out.end(), data.begin(), data.end());
+        }
+        for (const auto &entry: entries) {
+            TestUtil::append(out, entry);
+        }
+        TestUtil::append(out, ExeIndex{.magic = EXE_INDEX_MAGIC, .count = count});
+        TestUtil::append(out, ExeFooter{.magic = EXE_MAGIC, .exeOffset = program.size(),
+                                        .exeSize = templates.front().size()});
+        return out;
+    }
+
+    std::expected<Bytes, std::wstring> mapped(const Path &path, const LauncherVariant variant) {
+        const auto exe = Attach::mapAttachedExe(path, variant);
+        if (!exe) {
+            return std::unexpected(exe.error());
+        }
+        return Bytes(exe->data().begin(), exe->data().end());
+    }
+
+    class AttachTest : public testing::Test {
+    protected:
+        void SetUp() override {
+            TestUtil::writeFile(m_program, m_programData);
+            TestUtil::writeFile(m_launcher, m_launcherData);
+            TestUtil::writeFile(m_launcher2, m_launcher2Data);
+        }
+
+        TempDir m_dir;
+        const Bytes m_programData = TestUtil::randomBytes(300 * 1024 + 17, 1);
+        const Bytes m_launcherData = TestUtil::randomBytes(70 * 1024 + 3, 2);
+        const Bytes m_launcher2Data = TestUtil::randomBytes(50 * 1024 + 9, 3);
+        const Path m_program = m_dir / "program.exe";
+        const Path m_launcher = m_dir / "launcher.exe";
+        const Path m_launcher2 = m_dir / "launcher2.exe";
+    };
+} // namespace
+
+TEST_F(AttachTest, AttachesToNewFile) {
+    const auto output = m_dir / "out.exe";
+    const auto result = Attach::attachExe(m_program, m_launcher, output);
+    ASSERT_TRUE(result) << std::filesystem::path(result.error()).string();
+    EXPECT_EQ(result.value(), output);
+    EXPECT_EQ(TestUtil::readFile(output), attached(m_programData, m_launcherData));
+    // 源文件不变
+    EXPECT_EQ(TestUtil::readFile(m_program), m_programData);
+
+    const auto read = Attach::readAttachedExe(output);
+    ASSERT_TRUE(read);
+    EXPECT_EQ(toBytes(read.value()), m_launcherData);
+
+    const auto mapped = Attach::mapAttachedExe(output);
+    ASSERT_TRUE(mapped);
+    EXPECT_TRUE(std::ranges::equal(mapped->data(), m_launcherData));
+    EXPECT_FALSE(mapped->variant());
+}
+
+TEST_F(AttachTest, DefaultOutputName) {
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher, {}));
+    EXPECT_EQ(TestUtil::readFile(m_dir / "program_attached.exe"), attached(m_programData, m_launcherData));
+}
+
+TEST_F(AttachTest, ReplacesExistingAttachment) {
+    const auto first = m_dir / "first.exe";
+    const auto second = m_dir / "second.exe";
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher, first));
+    // 已附加的文件作为源时只保留原程序部分
+    ASSERT_TRUE(Attach::attachExe(first, m_launcher2, second));
+    EXPECT_EQ(TestUtil::readFile(second), attached(m_programData, m_launcher2Data));
+}
+
+TEST_F(AttachTest, AttachesInPlace) {
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher, m_program));
+    EXPECT_EQ(TestUtil::readFile(m_program), attached(m_programData, m_launcherData));
+
+    // 再次原地附加，较短的模板替换旧内容
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher2, m_program));
+    EXPECT_EQ(TestUtil::readFile(m_program), attached(m_programData, m_launcher2Data));
+    EXPECT_FALSE(std::filesystem::exists(journalOf(m_program)));
+    EXPECT_FALSE(std::filesystem::exists(m_dir / "program.exe.backup"));
+}
+
+TEST_F(AttachTest, InPlaceFailureLeavesSourceUntouched) {
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher, m_program));
+    const auto before = TestUtil::readFile(m_program);
+    EXPECT_FALSE(Attach::attachExe(m_program, m_dir / "missing.exe", m_program));
+    EXPECT_EQ(TestUtil::readFile(m_program), before);
+    EXPECT_FALSE(std::filesystem::exists(journalOf(m_program)));
+}
+
+TEST_F(AttachTest, RecoversInterruptedInPlaceAttach) {
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher, m_program));
+    const auto before = TestUtil::readFile(m_program);
+
+    // 模拟原地附加在截断并写入一半新模板后中断：日志已完整写出，源文件尾部不完整
+    Bytes journal;
+    TestUtil::append(journal, ExeJournal{.magic = JOURNAL_MAGIC, .fileSize = before.size(),
+                                         .exeOffset = m_programData.size()});
+    journal.insert(journal.end(), before.begin() + static_cast<std::ptrdiff_t>(m_programData.size()), before.end());
+    TestUtil::writeFile(journalOf(m_program), journal);
+    Bytes interrupted = m_programData;
+    interrupted.insert(interrupted.end(), m_launcher2Data.begin(), m_launcher2Data.begin() + 1000);
+    TestUtil::writeFile(m_program, interrupted);
+
+    // 以该文件为源附加到其他位置前，先按日志还原
+    const auto output = m_dir / "out.exe";
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher2, output));
+    EXPECT_EQ(TestUtil::readFile(m_program), before);
+    EXPECT_EQ(TestUtil::readFile(output), attached(m_programData, m_launcher2Data));
+    EXPECT_FALSE(std::filesystem::exists(journalOf(m_program)));
+
+    // 原地附加同样先恢复
+    TestUtil::writeFile(journalOf(m_program), journal);
+    TestUtil::writeFile(m_program, interrupted);
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher2, m_program));
+    EXPECT_EQ(TestUtil::readFile(m_program), attached(m_programData, m_launcher2Data));
+    EXPECT_FALSE(std::filesystem::exists(journalOf(m_program)));
+}
+
+TEST_F(AttachTest, DiscardsIncompleteJournal) {
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher, m_program));
+    const auto before = TestUtil::readFile(m_program);
+
+    // 日志长度与头部记录不符：中断发生在截断源文件之前，源文件仍完整
+    Bytes journal;
+    TestUtil::append(journal, ExeJournal{.magic = JOURNAL_MAGIC, .fileSize = before.size(),
+                                         .exeOffset = m_programData.size()});
+    journal.insert(journal.end(), before.begin() + static_cast<std::ptrdiff_t>(m_programData.size()),
+                   before.begin() + static_cast<std::ptrdiff_t>(m_programData.size()) + 100);
+    TestUtil::writeFile(journalOf(m_program), journal);
+
+    const auto output = m_dir / "out.exe";
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher2, output));
+    EXPECT_EQ(TestUtil::readFile(m_program), before);
+    EXPECT_FALSE(std::filesystem::exists(journalOf(m_program)));
+
+    // magic 不符同样丢弃
+    TestUtil::writeFile(journalOf(m_program), "not a journal");
+    ASSERT_TRUE(Attach::attachExe(m_program, m_launcher2, m_program));
+    EXPECT_EQ(TestUtil::readFile(m_program), attached(m_programData, m_launcher2Data));
+    EXPECT_FALSE(std::filesystem::exists(journalOf(m_program)));
+}
+
+TEST_F(AttachTest, RejectsEmptyPaths) {
+    EXPECT_FALSE(Attach::attachExe(m_program, Path{}, m_dir / "out.exe"));
+    EXPECT_FALSE(Attach::attachExe(Path{}, m_launcher, m_dir / "out.exe"));
+    EXPECT_FALSE(Attach::readAttachedExe(m_program));
+}
+
+TEST(LauncherVariantTest, IndexFromFlags) {
+    EXPECT_EQ(launcherVariant(false, false), LauncherVariant::Gui);
+    EXPECT_EQ(launcherVariant(true, false), LauncherVariant::Console);
+    EXPECT_EQ(launcherVariant(false, true), LauncherVariant::GuiAdmin);
+    EXPECT_EQ(launcherVariant(true, true), LauncherVariant::ConsoleAdmin);
+    EXPECT_EQ(sizeof(ExeIndexEntry), 16U);
+    EXPECT_EQ(sizeof(ExeIndex), 8U);
+    EXPECT_EQ(sizeof(ExeFooter), 20U);
+}
+
+TEST_F(AttachTest, VariantsRoundTrip) {
+    std::vector<Path> paths;
+    std::vector<Bytes> templates;
+    for (unsigned int i = 0; i < LAUNCHER_VARIANT_COUNT; ++i) {
+        templates.push_back(TestUtil::randomBytes(10 * 1024 + i * 333, 10 + i));
+        paths.push_back(m_dir / std::format("variant{}.exe", i));
+        TestUtil::writeFile(paths.back(), templates.back());
+    }
+    const auto output = m_dir / "out.exe";
+    ASSERT_TRUE(Attach::attachVariants(m_program, paths, output));
+
+    for (unsigned int i = 0; i < LAUNCHER_VARIANT_COUNT; ++i) {
+        const auto variant = static_cast<LauncherVariant>(i);
+        const auto exe = Attach::mapAttachedExe(output, variant);
+        ASSERT_TRUE(exe);
+        EXPECT_TRUE(std::ranges::equal(exe->data(), templates[i])) << i;
+        EXPECT_EQ(exe->variant(), variant);
+    }
+
+    // 只认识 ExeFooter 的读取方得到默认模板
+    const auto legacy = Attach::readAttachedExe(output);
+    ASSERT_TRUE(legacy);
+    EXPECT_EQ(toBytes(legacy.value()), templates[0]);
+
+    // 按 ExeFooter.exeOffset 截断即移除全部模板和索引
+    const auto reattached = m_dir / "reattached.exe";
+    ASSERT_TRUE(Attach::attachExe(output, m_launcher, reattached));
+    EXPECT_EQ(TestUtil::readFile(reattached), attached(m_programData, m_launcherData));
+
+    // 原地替换为另一组模板
+    ASSERT_TRUE(Attach::attachVariants(output, std::span(paths).first(2), output));
+    for (unsigned int i = 0; i < LAUNCHER_VARIANT_COUNT; ++i) {
+        const auto data = mapped(output, static_cast<LauncherVariant>(i));
+        ASSERT_TRUE(data);
+        EXPECT_EQ(data.value(), templates[i < 2 ? i : 0]) << i;
+    }
+}
+
+TEST_F(AttachTest, MissingVariantFallsBackToDefault) {
+    const std::vector<Path> paths{m_launcher, {}, m_launcher2, {}};
+    const auto output = m_dir / "out.exe";
+    ASSERT_TRUE(Attach::attachVariants(m_program, paths, output));
+
+    // 没有的变体在索引中 exeSize 为 0
+    const auto file = TestUtil::readFile(output);
+    const auto entries = file.size() - sizeof(ExeFooter) - sizeof(ExeIndex) - 4 * sizeof(ExeIndexEntry);
+    EXPECT_EQ(TestUtil::read<ExeIndexEntry>(file, entries + sizeof(ExeIndexEntry)).exeSize, 0U);
+    EXPECT_EQ(TestUtil::read<ExeIndexEntry>(file, entries + 3 * sizeof(ExeIndexEntry)).exeSize, 0U);
+
+    const auto console = Attach::mapAttachedExe(output, LauncherVariant::Console);
+    ASSERT_TRUE(console);
+    EXPECT_TRUE(std::ranges::equal(console->data(), m_launcherData));
+    EXPECT_FALSE(console->variant());
+    EXPECT_EQ(mapped(output, LauncherVariant::GuiAdmin).value(), m_launcher2Data);
+    EXPECT_EQ(mapped(output, LauncherVariant::ConsoleAdmin).value(), m_launcherData);
+}
+
+TEST_F(AttachTest, VariantsRequireDefaultTemplate) {
+    const std::vector<Path> noDefault{{}, m_launcher};
+    EXPECT_FALSE(Attach::attachVariants(m_program, noDefault, m_dir / "out.exe"));
+    const std::vector<Path> tooMany(LAUNCHER_VARIANT_COUNT + 1, m_launcher);
+    EXPECT_FALSE(Attach::attachVariants(m_program, tooMany, m_dir / "out.exe"));
+    EXPECT_FALSE(std::filesystem::exists(m_dir / "out.exe"));
+}
+
+TEST_F(AttachTest, LegacySingleTemplate) {
+    // 没有索引的旧格式文件，任何变体都得到唯一的模板
+    const auto output = m_dir / "legacy.exe";
+    TestUtil::writeFile(output, attached(m_programData, m_launcherData));
+    for (unsigned int i = 0; i < LAUNCHER_VARIANT_COUNT; ++i) {
+        const auto exe = Attach::mapAttachedExe(output, static_cast<LauncherVariant>(i));
+        ASSERT_TRUE(exe);
+        EXPECT_TRUE(std::ranges::equal(exe->data(), m_launcherData));
+        EXPECT_FALSE(exe->variant());
+    }
+
+    // 模板尾部恰好出现索引 magic 时，条目范围无效，仍取整个模板
+    Bytes tricky = m_launcherData;
+    TestUtil::append(tricky, ExeIndex{.magic = EXE_INDEX_MAGIC, .count = 1});
+    TestUtil::writeFile(output, attached(m_programData, tricky));
+    const auto exe = Attach::mapAttachedExe(output, LauncherVariant::Gui);
+    ASSERT_TRUE(exe);
+    EXPECT_TRUE(std::ranges::equal(exe->data(), tricky));
+}
+
+TEST_F(AttachTest, IndexCountBeyondVariantCountIsIgnored) {
+    const auto offset = m_programData.size();
+    std::vector<ExeIndexEntry> entries;
+    for (unsigned int i = 0; i < LAUNCHER_VARIANT_COUNT + 1; ++i) {
+        entries.push_back({.exeOffset = i == 1 ? offset + m_launcherData.size() : offset,
+                           .exeSize = i == 1 ? m_launcher2Data.size() : m_launcherData.size()});
+    }
+    const auto output = m_dir / "out.exe";
+    TestUtil::writeFile(output, indexed(m_programData, {m_launcherData, m_launcher2Data}, entries,
+                                        LAUNCHER_VARIANT_COUNT + 1));
+    const auto exe = Attach::mapAttachedExe(output, LauncherVariant::Console);
+    ASSERT_TRUE(exe);
+    EXPECT_TRUE(std::ranges::equal(exe->data(), m_launcherData));
+    EXPECT_FALSE(exe->variant());
+
+    // 同样的条目在合法数量下生效
+    entries.resize(2);
+    TestUtil::writeFile(output, indexed(m_programData, {m_launcherData, m_launcher2Data}, entries, 2));
+    EXPECT_EQ(mapped(output, LauncherVariant::Console).value(), m_launcher2Data);
+}
+
+TEST_F(AttachTest, IndexEntryOutsideTemplatesIsIgnored) {
+    const auto offset = m_programData.size();
+    const auto output = m_dir / "out.exe";
+    const auto expectDefault = [&](const std::vector<ExeIndexEntry> &entries, const char *what) {
+        TestUtil::writeFile(output, indexed(m_programData, {m_launcherData, m_launcher2Data}, entries, 2));
+        const auto exe = Attach::mapAttachedExe(output, LauncherVariant::Console);
+        ASSERT_TRUE(exe) << what;
+        EXPECT_TRUE(std::ranges::equal(exe->data(), m_launcherData)) << what;
+        EXPECT_FALSE(exe->variant()) << what;
+    };
+    const ExeIndexEntry first{.exeOffset = offset, .exeSize = m_launcherData.size()};
+    const auto fileSize = offset + m_launcherData.size() + m_launcher2Data.size() + 2 * sizeof(ExeIndexEntry) +
+                          sizeof(ExeIndex) + sizeof(ExeFooter);
+
+    // 越过 ExeFooter 与文件末尾
+    expectDefault({first, {.exeOffset = fileSize - 10, .exeSize = 100}}, "past footer");
+    expectDefault({first, {.exeOffset = fileSize + 100, .exeSize = 100}}, "past end");
+    // 覆盖索引本身
+    expectDefault({first, {.exeOffset = offset + m_launcherData.size(), .exeSize = m_launcher2Data.size() + 1}},
+                  "overlaps index");
+    // 位于原程序部分
+    expectDefault({first, {.exeOffset = 0, .exeSize = 100}}, "before attachment");
+    // 偏移加长度溢出
+    expectDefault({first, {.exeOffset = ~0ULL - 10, .exeSize = 100}}, "overflow");
+}
+
+TEST_F(AttachTest, RejectsInvalidFooter) {
+    const auto output = m_dir / "out.exe";
+    // ExeFooter 范围越过自身
+    Bytes data = m_programData;
+    TestUtil::append(data, ExeFooter{.magic = EXE_MAGIC, .exeOffset = 100, .exeSize = m_programData.size()});
+    TestUtil::writeFile(output, data);
+    EXPECT_FALSE(Attach::mapAttachedExe(output));
+
+    TestUtil::writeFile(output, "tiny");
+    EXPECT_FALSE(Attach::mapAttachedExe(output));
+    EXPECT_FALSE(Attach::mapAttachedExe(m_program));
+}
@@ -0,0 +1,200 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: DaemonProtocol 请求编码测试，通过 socketpair 模拟守护进程管道上的读写
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "daemonprotocol.h"
+#include "testutil.h"
+
+using namespace DaemonProtocol;
+using TestUtil::Bytes;
+
+namespace {
+    // 连接的一对套接字，析构时关闭
+    class SocketPair {
+    public:
+        SocketPair() {
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, m_fds) != 0) {
+                m_fds[0] = m_fds[1] = -1;
+            }
+        }
+
+        ~SocketPair() {
+            for (const int fd: m_fds) {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+        }
+
+        SocketPair(const SocketPair &) = delete;
+
+        SocketPair &operator=(const SocketPair &) = delete;
+
+        [[nodiscard]] int client() const { return m_fds[0]; }
+
+        [[nodiscard]] int server() const { return m_fds[1]; }
+
+    private:
+        int m_fds[2];
+    };
+
+    // 与守护进程的 transfer 相同：循环直到完整读写 size 字节
+    bool transfer(const int fd, void *data, std::size_t size, const bool write) {
+        auto *bytes = static_cast<std::uint8_t *>(data);
+        while (size > 0) {
+            const auto done = write ? ::write(fd, bytes, size) : ::read(fd, bytes, size);
+            if (done <= 0) {
+                return false;
+            }
+            bytes += done;
+            size -= static_cast<std::size_t>(done);
+        }
+        return true;
+    }
+
+    // 守护进程一侧：读长度、校验、读消息体、解码、回复退出码
+    std::expected<Request, std::wstring> serveOne(const int fd, const std::int32_t exitCode) {
+        std::uint32_t size = 0;
+        if (!transfer(fd, &size, sizeof(size), false) || !validRequestSize(size)) {
+            return std::unexpected{L"size"};
+        }
+        Bytes buffer(size);
+        if (!transfer(fd, buffer.data(), buffer.size(), false)) {
+            return std::unexpected{L"short read"};
+        }
+        auto request = decodeRequest(buffer);
+        if (request) {
+            Response response{RESPONSE_MAGIC, exitCode};
+            transfer(fd, &response, sizeof(response), true);
+        }
+        return request;
+    }
+
+    Request sampleRequest() {
+        Request request;
+        request.cwd = L"C:\\Users\\用户\\项目";
+        request.args = {L"--open", L"", L"带空格 的 参数", std::wstring(L"a\0b", 3), L"\U0001F600 emoji"};
+        request.stdIn = 0x10;
+        request.stdOut = 0x20;
+        request.stdErr = 0xFFFFFFFFFFFFFFFFULL;
+        return request;
+    }
+
+    // 跳过长度前缀的消息体
+    Bytes payloadOf(const Request &request) {
+        const auto message = encodeRequest(request);
+        return {message.begin() + sizeof(std::uint32_t), message.end()};
+    }
+} // namespace
+
+TEST(DaemonProtocolTest, RoundTripOverSocket) {
+    const SocketPair pair;
+    ASSERT_GE(pair.client(), 0);
+    const auto request = sampleRequest();
+
+    std::expected<Request, std::wstring> received = std::unexpected{L""};
+    std::thread server([&] { received = serveOne(pair.server(), -3); });
+
+    auto message = encodeRequest(request);
+    Response response{};
+    // 分两次写入，读取方必须按长度前缀拼接
+    const std::size_t half = message.size() / 2;
+    ASSERT_TRUE(transfer(pair.client(), message.data(), half, true));
+    ASSERT_TRUE(transfer(pair.client(), message.data() + half, message.size() - half, true));
+    ASSERT_TRUE(transfer(pair.client(), &response, sizeof(response), false));
+    server.join();
+
+    ASSERT_TRUE(received);
+    EXPECT_EQ(received->cwd, request.cwd);
+    EXPECT_EQ(received->args, request.args);
+    EXPECT_EQ(received->stdIn, request.stdIn);
+    EXPECT_EQ(received->stdOut, request.stdOut);
+    EXPECT_EQ(received->stdErr, request.stdErr);
+    EXPECT_EQ(response.magic, RESPONSE_MAGIC);
+    EXPECT_EQ(response.exitCode, -3);
+}
+
+TEST(DaemonProtocolTest, WireFormatIsUtf16) {
+    Request request;
+    request.cwd = L"d";
+    request.args = {L"\U0001F600"};
+    const auto message = encodeRequest(request);
+    // 长度 + 头 + (4 + 2) + (4 + 4)：补充平面字符为一个代理对
+    ASSERT_EQ(message.size(), sizeof(std::uint32_t) + sizeof(RequestHeader) + 6 + 8);
+    EXPECT_EQ(TestUtil::read<std::uint32_t>(message, 0), message.size() - sizeof(std::uint32_t));
+    const std::size_t arg = sizeof(std::uint32_t) + sizeof(RequestHeader) + 6;
+    EXPECT_EQ(TestUtil::read<std::uint32_t>(message, arg), 2U);
+    EXPECT_EQ(TestUtil::read<char16_t>(message, arg + 4), 0xD83D);
+    EXPECT_EQ(TestUtil::read<char16_t>(message, arg + 6), 0xDE00);
+}
+
+TEST(DaemonProtocolTest, RejectsInvalidSize) {
+    EXPECT_FALSE(validRequestSize(0));
+    EXPECT_FALSE(validRequestSize(sizeof(RequestHeader) - 1));
+    EXPECT_TRUE(validRequestSize(sizeof(RequestHeader)));
+    EXPECT_TRUE(validRequestSize(MAX_REQUEST_SIZE));
+    EXPECT_FALSE(validRequestSize(MAX_REQUEST_SIZE + 1));
+
+    // 长度不合法时守护进程不读取消息体
+    const SocketPair pair;
+    ASSERT_GE(pair.client(), 0);
+    std::uint32_t huge = MAX_REQUEST_SIZE + 1;
+    ASSERT_TRUE(transfer(pair.client(), &huge, sizeof(huge), true));
+    EXPECT_EQ(serveOne(pair.server(), 0).error(), L"size");
+}
+
+TEST(DaemonProtocolTest, RejectsMalformedPayload) {
+    const auto valid = payloadOf(sampleRequest());
+    ASSERT_TRUE(decodeRequest(valid));
+
+    auto badMagic = valid;
+    badMagic[0] ^= 0xFF;
+    EXPECT_FALSE(decodeRequest(badMagic));
+
+    auto badVersion = valid;
+    badVersion[offsetof(RequestHeader, version)] = 2;
+    EXPECT_FALSE(decodeRequest(badVersion));
+
+    // 在每个位置截断都应被拒绝，不能越界读取
+    for (std::size_t size = 0; size < valid.size(); ++size) {
+        EXPECT_FALSE(decodeRequest(std::span(valid).first(size))) << size;
+    }
+
+    // 参数数量远大于数据
+    auto manyArgs = valid;
+    const std::uint32_t count = 0x7FFFFFFF;
+    std::memcpy(manyArgs.data() + offsetof(RequestHeader, argCount), &count, sizeof(count));
+    EXPECT_FALSE(decodeRequest(manyArgs));
+
+    // 字符串长度超过剩余数据
+    auto longString = valid;
+    const std::uint32_t length = 0xFFFFFFFF;
+    std::memcpy(longString.data() + sizeof(RequestHeader), &length, sizeof(length));
+    EXPECT_FALSE(decodeRequest(longString));
+}
+
+TEST(DaemonProtocolTest, ClientSeesClosedDaemon) {
+    // 守护进程读完请求后退出（例如 System.exit 之前没有回复），客户端读取响应失败
+    const SocketPair pair;
+    ASSERT_GE(pair.client(), 0);
+    auto message = encodeRequest(sampleRequest());
+    ASSERT_TRUE(transfer(pair.client(), message.data(), message.size(), true));
+    Bytes received(message.size());
+    ASSERT_TRUE(transfer(pair.server(), received.data(), received.size(), false));
+    shutdown(pair.server(), SHUT_RDWR);
+
+    Response response{};
+    EXPECT_FALSE(transfer(pair.client(), &response, sizeof(response), false));
+}
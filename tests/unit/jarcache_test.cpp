@@ -0,0 +1,347 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: JarCache 命中判断、清理范围与并发获取测试，以及清理依赖的锁文件删除语义
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "filelock.h"
+#include "jarcache.h"
+#include "jarlayout.h"
+#include "testutil.h"
+
+using TestUtil::Bytes;
+using TestUtil::TempDir;
+using JarCache::Digest;
+using JarCache::Path;
+
+namespace {
+    Digest digestOf(const std::uint8_t seed) {
+        Digest digest{};
+        digest.fill(seed);
+        return digest;
+    }
+
+    std::wstring hexOf(const Digest &digest) {
+        std::wstring result;
+        for (const auto byte: digest) {
+            result += std::format(L"{:02x}", byte);
+        }
+        return result;
+    }
+
+    // 与启动器解压结果相同：ZIP 注释为 JarStamp
+    Bytes stampedJar(const std::size_t payload = 1000) {
+        Bytes comment;
+        TestUtil::append(comment, JarLayout::JarStamp{42});
+        return TestUtil::ZipBuilder().add("payload.bin", TestUtil::randomBytes(payload, 7)).build(comment);
+    }
+
+    struct CountingFill {
+        Bytes jar;
+        std::shared_ptr<std::atomic<int>> calls = std::make_shared<std::atomic<int>>(0);
+
+        std::expected<bool, std::wstring> operator()(const Path &tmpPath) const {
+            calls->fetch_add(1);
+            TestUtil::writeFile(tmpPath, jar);
+            return true;
+        }
+    };
+
+    void setAge(const Path &path, const std::chrono::hours age) {
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now() - age);
+    }
+} // namespace
+
+TEST(JarCacheTest, RootUsesDedicatedSubdirectory) {
+    EXPECT_EQ(JarCache::root({}), JarCache::defaultRoot());
+    EXPECT_EQ(JarCache::root("/opt/app"), Path("/opt/app") / JarCache::CACHE_DIR_NAME);
+}
+
+TEST(JarCacheTest, AcquireFillsOnceThenHits) {
+    const TempDir dir;
+    const TempDir owners;
+    const auto owner = owners / "app.exe";
+    TestUtil::writeFile(owner, "exe");
+    const CountingFill fill{stampedJar()};
+    const auto digest = digestOf(1);
+
+    const auto first = JarCache::acquire(dir.path(), digest, fill.jar.size(), owner, fill);
+    ASSERT_TRUE(first);
+    EXPECT_FALSE(first->hit);
+    EXPECT_EQ(first->jarPath, dir / (hexOf(digest) + L".jar"));
+    EXPECT_EQ(TestUtil::readFile(first->jarPath), fill.jar);
+
+    const auto second = JarCache::acquire(dir.path(), digest, fill.jar.size(), owner, fill);
+    ASSERT_TRUE(second);
+    EXPECT_TRUE(second->hit);
+    EXPECT_EQ(fill.calls->load(), 1);
+    // 引用目录中记录了 owner
+    EXPECT_FALSE(std::filesystem::is_empty(dir / "refs" / hexOf(digest)));
+}
+
+TEST(JarCacheTest, AcquireRefillsDamagedJar) {
+    const TempDir dir;
+    const CountingFill fill{stampedJar()};
+    const auto digest = digestOf(2);
+    const auto jarPath = dir / (hexOf(digest) + L".jar");
+
+    // 大小相同但尾部不是完整的 EOCD + JarStamp，例如写入中断后被其他工具补齐的文件
+    TestUtil::writeFile(jarPath, Bytes(fill.jar.size(), 0));
+    auto entry = JarCache::acquire(dir.path(), digest, fill.jar.size(), dir / "owner", fill);
+    ASSERT_TRUE(entry);
+    EXPECT_FALSE(entry->hit);
+    EXPECT_EQ(TestUtil::readFile(jarPath), fill.jar);
+
+    // 大小不符
+    TestUtil::writeFile(jarPath, Bytes(fill.jar.begin(), fill.jar.end() - 1));
+    entry = JarCache::acquire(dir.path(), digest, fill.jar.size(), dir / "owner", fill);
+    ASSERT_TRUE(entry);
+    EXPECT_FALSE(entry->hit);
+
+    // 注释不是 JarStamp
+    auto unstamped = TestUtil::ZipBuilder().add("a", "b").build(Bytes(4, 'x'));
+    unstamped.resize(fill.jar.size(), 0);
+    TestUtil::writeFile(jarPath, unstamped);
+    entry = JarCache::acquire(dir.path(), digest, fill.jar.size(), dir / "owner", fill);
+    ASSERT_TRUE(entry);
+    EXPECT_FALSE(entry->hit);
+    EXPECT_EQ(fill.calls->load(), 3);
+}
+
+TEST(JarCacheTest, FillFailureLeavesNoFiles) {
+    const TempDir dir;
+    const auto digest = digestOf(3);
+    const auto result = JarCache::acquire(dir.path(), digest, 100, dir / "owner", [](const Path &tmpPath) {
+        TestUtil::writeFile(tmpPath, "partial");
+        return std::expected<bool, std::wstring>{std::unexpected{L"磁盘已满"}};
+    });
+    ASSERT_FALSE(result);
+    EXPECT_EQ(result.error(), L"磁盘已满");
+    for (const auto &item: std::filesystem::directory_iterator(dir.path())) {
+        EXPECT_NE(item.path().extension(), ".tmp");
+        EXPECT_NE(item.path().extension(), ".jar");
+    }
+}
+
+TEST(JarCacheTest, EvictOnlyTouchesCacheNames) {
+    const TempDir dir;
+    const auto orphan = hexOf(digestOf(4));
+    const auto foreign = {
+        std::wstring(L"notes.jar"), std::wstring(L"app.jsa"), std::wstring(L"build.tmp"),
+        std::wstring(L"123.tmp"), orphan.substr(1) + L".jar", orphan + L"x.jar", orphan + L".x.tmp",
+        L"ABCDEF" + orphan.substr(6) + L".jar",
+    };
+    for (const auto &name: foreign) {
+        TestUtil::writeFile(dir / name, "user file");
+        setAge(dir / name, std::chrono::hours(48));
+    }
+    TestUtil::writeFile(dir / (orphan + L".jar"), stampedJar());
+    TestUtil::writeFile(dir / (orphan + L".0123456789abcdef-0123456789abcdef.jsa"), "archive");
+    TestUtil::writeFile(dir / (orphan + L".4242.tmp"), "stale");
+    setAge(dir / (orphan + L".4242.tmp"), std::chrono::hours(2));
+    TestUtil::writeFile(dir / (orphan + L".4343.tmp"), "in progress");
+
+    JarCache::evict(dir.path(), digestOf(0));
+
+    for (const auto &name: foreign) {
+        EXPECT_TRUE(std::filesystem::exists(dir / name)) << std::string(name.begin(), name.end());
+    }
+    EXPECT_FALSE(std::filesystem::exists(dir / (orphan + L".jar")));
+    EXPECT_FALSE(std::filesystem::exists(dir / (orphan + L".0123456789abcdef-0123456789abcdef.jsa")));
+    EXPECT_FALSE(std::filesystem::exists(dir / (orphan + L".4242.tmp")));
+    EXPECT_TRUE(std::filesystem::exists(dir / (orphan + L".4343.tmp")));
+}
+
+TEST(JarCacheTest, EvictKeepsReferencedAndRemovesLeastRecentlyUsed) {
+    const TempDir dir;
+    const TempDir owners;
+    const auto jar = stampedJar(4000);
+    std::vector<Digest> digests;
+    for (std::uint8_t i = 0; i < 3; ++i) {
+        const auto owner = owners / std::format("app{}.exe", i);
+        TestUtil::writeFile(owner, "exe");
+        digests.push_back(digestOf(static_cast<std::uint8_t>(10 + i)));
+        ASSERT_TRUE(JarCache::acquire(dir.path(), digests.back(), jar.size(), owner, CountingFill{jar}));
+        // 越早的 jar 最近使用时间越早
+        for (const auto &ref: std::filesystem::directory_iterator(dir / "refs" / hexOf(digests.back()))) {
+            setAge(ref.path(), std::chrono::hours(10 - i));
+        }
+    }
+
+    // 容量足够时全部保留
+    JarCache::evict(dir.path(), digests[2]);
+    for (const auto &digest: digests) {
+        EXPECT_TRUE(std::filesystem::exists(dir / (hexOf(digest) + L".jar")));
+    }
+
+    // 只够放两个时淘汰最早使用的一个
+    JarCache::evict(dir.path(), digests[2], jar.size() * 2);
+    EXPECT_FALSE(std::filesystem::exists(dir / (hexOf(digests[0]) + L".jar")));
+    EXPECT_FALSE(std::filesystem::exists(dir / "refs" / hexOf(digests[0])));
+    EXPECT_TRUE(std::filesystem::exists(dir / (hexOf(digests[1]) + L".jar")));
+    EXPECT_TRUE(std::filesystem::exists(dir / (hexOf(digests[2]) + L".jar")));
+
+    // exe 被删除后 jar 成为无主文件，keep 仍然保留
+    std::filesystem::remove(owners / "app1.exe");
+    std::filesystem::remove(owners / "app2.exe");
+    JarCache::evict(dir.path(), digests[2]);
+    EXPECT_FALSE(std::filesystem::exists(dir / (hexOf(digests[1]) + L".jar")));
+    EXPECT_TRUE(std::filesystem::exists(dir / (hexOf(digests[2]) + L".jar")));
+}
+
+TEST(JarCacheTest, EvictIfDueHonoursInterval) {
+    const TempDir dir;
+    const auto orphan = dir / (hexOf(digestOf(20)) + L".jar");
+
+    TestUtil::writeFile(orphan, "orphan");
+    JarCache::evictIfDue(dir.path(), digestOf(0));
+    EXPECT_FALSE(std::filesystem::exists(orphan));
+
+    // 间隔内不再清理
+    TestUtil::writeFile(orphan, "orphan");
+    JarCache::evictIfDue(dir.path(), digestOf(0));
+    EXPECT_TRUE(std::filesystem::exists(orphan));
+
+    // 标记过期后再次清理
+    setAge(dir / "last-evict", std::chrono::hours(25));
+    JarCache::evictIfDue(dir.path(), digestOf(0));
+    EXPECT_FALSE(std::filesystem::exists(orphan));
+}
+
+TEST(JarCacheTest, ConcurrentAcquireFillsOnce) {
+    const TempDir dir;
+    const TempDir owners;
+    const CountingFill fill{stampedJar(1 << 20)};
+    const auto digest = digestOf(30);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> hits{0};
+    std::atomic<int> failures{0};
+    for (int i = 0; i < 16; ++i) {
+        threads.emplace_back([&, i] {
+            const auto owner = owners / std::format("app{}.exe", i);
+            TestUtil::writeFile(owner, "exe");
+            const auto entry = JarCache::acquire(dir.path(), digest, fill.jar.size(), owner, fill);
+            if (!entry) {
+                failures.fetch_add(1);
+            } else if (entry->hit) {
+                hits.fetch_add(1);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(fill.calls->load(), 1);
+    EXPECT_EQ(hits.load(), 15);
+    EXPECT_EQ(TestUtil::readFile(dir / (hexOf(digest) + L".jar")), fill.jar);
+}
+
+TEST(JarCacheTest, EvictDuringAcquireKeepsReferencedJar) {
+    const TempDir dir;
+    const TempDir owners;
+    const auto owner = owners / "app.exe";
+    TestUtil::writeFile(owner, "exe");
+    const CountingFill fill{stampedJar()};
+    const auto digest = digestOf(40);
+
+    std::atomic<bool> stop{false};
+    std::thread evictor([&] {
+        while (!stop.load()) {
+            JarCache::evict(dir.path(), digestOf(0));
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        const auto entry = JarCache::acquire(dir.path(), digest, fill.jar.size(), owner, fill);
+        ASSERT_TRUE(entry);
+        ASSERT_TRUE(JarLayout::readStamp(entry->jarPath, fill.jar.size())) << "iteration " << i;
+    }
+    stop = true;
+    evictor.join();
+    EXPECT_EQ(fill.calls->load(), 1);
+}
+
+TEST(JarCacheTest, EvictRemovesLockFiles) {
+    const TempDir dir;
+    const TempDir owners;
+    const auto jar = stampedJar();
+    for (std::uint8_t i = 0; i < 3; ++i) {
+        const auto owner = owners / std::format("app{}.exe", i);
+        TestUtil::writeFile(owner, "exe");
+        ASSERT_TRUE(JarCache::acquire(dir.path(), digestOf(50 + i), jar.size(), owner, CountingFill{jar}));
+        std::filesystem::remove(owner);
+    }
+    // 解压失败后残留的锁文件，没有对应的 jar
+    TestUtil::writeFile(dir / (hexOf(digestOf(60)) + L".lock"), "");
+    ASSERT_TRUE(std::filesystem::exists(dir / (hexOf(digestOf(50)) + L".lock")));
+
+    JarCache::evict(dir.path(), digestOf(0));
+    for (const auto &item: std::filesystem::directory_iterator(dir.path())) {
+        EXPECT_NE(item.path().extension(), L".lock") << item.path().string();
+        EXPECT_NE(item.path().extension(), L".jar") << item.path().string();
+    }
+}
+
+TEST(JarCacheTest, EvictSkipsJarWhoseLockIsHeld) {
+    const TempDir dir;
+    const TempDir owners;
+    const auto owner = owners / "app.exe";
+    TestUtil::writeFile(owner, "exe");
+    const auto jar = stampedJar();
+    const auto digest = digestOf(70);
+    const auto entry = JarCache::acquire(dir.path(), digest, jar.size(), owner, CountingFill{jar});
+    ASSERT_TRUE(entry);
+    std::filesystem::remove(owner);
+    const auto lockPath = dir / (hexOf(digest) + L".lock");
+
+    {
+        // 其他进程正在解压或判断命中
+        const auto held = FileLock::acquire(lockPath);
+        ASSERT_TRUE(held);
+        JarCache::evict(dir.path(), digestOf(0));
+        EXPECT_TRUE(std::filesystem::exists(entry->jarPath));
+        EXPECT_TRUE(std::filesystem::exists(lockPath));
+    }
+
+    JarCache::evict(dir.path(), digestOf(0));
+    EXPECT_FALSE(std::filesystem::exists(entry->jarPath));
+    EXPECT_FALSE(std::filesystem::exists(lockPath));
+}
+
+TEST(FileLockTest, WaiterRelocksAfterHolderDeletesLockFile) {
+    const TempDir dir;
+    const auto path = dir / "a.lock";
+    auto holder = FileLock::acquire(path);
+    ASSERT_TRUE(holder);
+    EXPECT_FALSE(FileLock::tryAcquire(path));
+
+    std::atomic<bool> locked{false};
+    std::promise<void> release;
+    std::thread waiter([&, released = release.get_future()]() mutable {
+        const auto lock = FileLock::acquire(path);
+        locked = lock.has_value();
+        released.wait();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(locked.load());
+
+    // 持有者删除锁文件后释放，等待者必须锁住路径上的新文件，而不是已删除的旧文件
+    std::filesystem::remove(path);
+    *holder = FileLock();
+    while (!locked.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(std::filesystem::exists(path));
+    EXPECT_FALSE(FileLock::tryAcquire(path));
+    release.set_value();
+    waiter.join();
+    EXPECT_TRUE(FileLock::tryAcquire(path));
+}
@@ -0,0 +1,396 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: JarLayout 段目录读写与旧版布局兼容测试
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "jarlayout.h"
+#include "testutil.h"
+
+using TestUtil::Bytes;
+using namespace JarLayout;
+
+namespace {
+    const std::array<std::string_view, STRING_COUNT> STRINGS{
+        "com.example.Main", "-Xmx512m -Dfile.encoding=UTF-8", "--verbose", "", "%TEMP%/app", "示例程序", "1.2.3",
+    };
+
+    // 按打包器的顺序拼出完整文件：exe、对齐填充、jar、图片、设置、字符串表、段目录
+    struct Package {
+        Bytes file;
+        std::uint64_t jarOffset = 0;
+        std::uint64_t jarSize = 0;
+        std::uint64_t imageOffset = 0;
+        std::uint64_t metadataOffset = 0;
+        std::uint64_t tableOffset = 0;
+    };
+
+    struct PackageOptions {
+        Bytes settings; // 为空时使用默认 LaunchSettings
+        std::uint16_t entrySize = sizeof(SectionEntry);
+        bool unknownSection = false;
+    };
+
+    Bytes settingsBytes(const LaunchSettings &settings) {
+        Bytes out;
+        TestUtil::append(out, settings);
+        return out;
+    }
+
+    LaunchSettings sampleSettings() {
+        LaunchSettings settings;
+        settings.javaVersion = 17;
+        settings.launchTime = 1500;
+        settings.launchMode = JarCommon::LaunchMode::DirectJVM;
+        settings.timestamp = 0x0123456789ABCDEFULL;
+        settings.splashShowProgress = 1;
+        settings.titlePosX = 12.5f;
+        for (std::size_t i = 0; i < settings.jarDigest.size(); ++i) {
+            settings.jarDigest[i] = static_cast<std::uint8_t>(i + 1);
+        }
+        settings.singleInstance = 1;
+        return settings;
+    }
+
+    Package buildPackage(const PackageOptions &options = {}) {
+        Package pkg;
+        pkg.file = TestUtil::randomBytes(1234, 1);
+        pkg.file.resize((pkg.file.size() + JAR_ALIGNMENT - 1) / JAR_ALIGNMENT * JAR_ALIGNMENT, 0);
+
+        const auto jar = TestUtil::ZipBuilder().add("a.txt", "hello").build();
+        pkg.jarOffset = pkg.file.size();
+        pkg.jarSize = jar.size();
+        pkg.file.insert(pkg.file.end(), jar.begin(), jar.end());
+
+        const auto image = TestUtil::randomBytes(300, 2);
+        pkg.imageOffset = pkg.file.size();
+        pkg.file.insert(pkg.file.end(), image.begin(), image.end());
+
+        SectionTableWriter writer;
+        writer.add(SectionType::Jar, pkg.jarOffset, jar.size(), JAR_ALIGNMENT, hash(jar), SECTION_FLAG_JAR_STAMPED);
+        writer.add(SectionType::SplashImage, pkg.imageOffset, image.size(), 1, hash(image));
+
+        pkg.metadataOffset = pkg.file.size();
+        const auto settings = options.settings.empty() ? settingsBytes(sampleSettings()) : options.settings;
+        writer.add(SectionType::Settings, pkg.file.size(), settings.size(), 1, hash(settings));
+        pkg.file.insert(pkg.file.end(), settings.begin(), settings.end());
+
+        const auto strings = encodeStrings(STRINGS);
+        writer.add(SectionType::Strings, pkg.file.size(), strings.size(), 1, hash(strings));
+        pkg.file.insert(pkg.file.end(), strings.begin(), strings.end());
+        if (options.unknownSection) {
+            writer.add(static_cast<SectionType>(42), 0, 16, 1, 0);
+        }
+
+        pkg.tableOffset = pkg.file.size();
+        auto table = writer.finish(pkg.metadataOffset, pkg.tableOffset);
+        if (options.entrySize != sizeof(SectionEntry)) {
+            // 模拟更新版本的段目录项：每项末尾多出新版字段
+            Bytes widened;
+            const std::size_t count = (table.size() - sizeof(SectionFooter)) / sizeof(SectionEntry);
+            for (std::size_t i = 0; i < count; ++i) {
+                widened.insert(widened.end(), table.begin() + i * sizeof(SectionEntry),
+                               table.begin() + (i + 1) * sizeof(SectionEntry));
+                widened.resize(widened.size() + options.entrySize - sizeof(SectionEntry), 0xEE);
+            }
+            auto footer = TestUtil::read<SectionFooter>(table, table.size() - sizeof(SectionFooter));
+            footer.entrySize = options.entrySize;
+            footer.metadataSize = pkg.tableOffset + widened.size() + sizeof(SectionFooter) - pkg.metadataOffset;
+            TestUtil::append(widened, footer);
+            table = std::move(widened);
+        }
+        pkg.file.insert(pkg.file.end(), table.begin(), table.end());
+        return pkg;
+    }
+
+    std::span<const std::uint8_t> tailOf(const Bytes &file, const std::uint64_t size) {
+        return std::span(file).subspan(file.size() - static_cast<std::size_t>(size));
+    }
+
+    // 模拟启动器：先读 PROBE_SIZE 字节求元数据大小，再读元数据块解析
+    std::expected<PackageInfo, std::wstring> load(const Bytes &file) {
+        const auto size = metadataSize(tailOf(file, std::min<std::uint64_t>(PROBE_SIZE, file.size())), file.size());
+        if (!size) {
+            return std::unexpected{size.error()};
+        }
+        return parse(tailOf(file, *size), file.size());
+    }
+
+    void patchEntry(Package &pkg, const std::size_t index, const std::function<void(SectionEntry &)> &patch) {
+        const std::size_t pos = pkg.tableOffset + index * sizeof(SectionEntry);
+        auto entry = TestUtil::read<SectionEntry>(pkg.file, pos);
+        patch(entry);
+        std::memcpy(pkg.file.data() + pos, &entry, sizeof(entry));
+    }
+} // namespace
+
+TEST(JarLayoutTest, SectionTableRoundTrip) {
+    const auto pkg = buildPackage();
+    const auto size = metadataSize(tailOf(pkg.file, PROBE_SIZE), pkg.file.size());
+    ASSERT_TRUE(size);
+    EXPECT_EQ(*size, pkg.file.size() - pkg.metadataOffset);
+
+    const auto tail = tailOf(pkg.file, *size);
+    const auto info = parse(tail, pkg.file.size());
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->version, SECTION_TABLE_VERSION);
+    EXPECT_EQ(info->metadataOffset, pkg.metadataOffset);
+
+    const auto jar = info->find(SectionType::Jar);
+    ASSERT_NE(jar, nullptr);
+    EXPECT_EQ(jar->offset, pkg.jarOffset);
+    EXPECT_EQ(jar->size, pkg.jarSize);
+    EXPECT_EQ(jar->alignment, JAR_ALIGNMENT);
+    EXPECT_EQ(jar->flags, SECTION_FLAG_JAR_STAMPED);
+    EXPECT_EQ(jar->hash, hash(std::span(pkg.file).subspan(pkg.jarOffset, pkg.jarSize)));
+    EXPECT_EQ(info->range(SectionType::SplashImage).offset, pkg.imageOffset);
+
+    const auto expected = sampleSettings();
+    EXPECT_EQ(info->settings.size, sizeof(LaunchSettings));
+    EXPECT_EQ(info->settings.javaVersion, expected.javaVersion);
+    EXPECT_EQ(info->settings.launchMode, expected.launchMode);
+    EXPECT_EQ(info->settings.timestamp, expected.timestamp);
+    EXPECT_EQ(info->settings.titlePosX, expected.titlePosX);
+    EXPECT_EQ(info->settings.jarDigest, expected.jarDigest);
+    EXPECT_EQ(info->settings.singleInstance, 1);
+
+    for (std::size_t i = 0; i < STRING_COUNT; ++i) {
+        EXPECT_EQ(stringView(*info, tail, pkg.file.size(), static_cast<StringId>(i)), STRINGS[i]);
+    }
+}
+
+TEST(JarLayoutTest, SectionTableWriterSizeAndHash) {
+    const auto settings = settingsBytes(sampleSettings());
+    constexpr std::uint64_t metadataOffset = 4096 + 100;
+    SectionTableWriter writer;
+    EXPECT_EQ(writer.tableSize(), writer.finish(0, 0).size());
+    writer.add(SectionType::Jar, 4096, 100, JAR_ALIGNMENT, 7, SECTION_FLAG_RUN_FROM_EXE);
+    writer.add(SectionType::Settings, metadataOffset, settings.size(), 1, 0);
+    EXPECT_EQ(writer.tableSize(), writer.finish(metadataOffset, metadataOffset + settings.size()).size());
+
+    // 先登记段、再补上哈希，只改变对应类型的段
+    writer.setHash(SectionType::Settings, hash(settings));
+    Bytes file(metadataOffset, 0);
+    file.insert(file.end(), settings.begin(), settings.end());
+    const auto table = writer.finish(metadataOffset, file.size());
+    file.insert(file.end(), table.begin(), table.end());
+    const auto info = parse(tailOf(file, file.size() - metadataOffset), file.size());
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->find(SectionType::Jar)->hash, 7U);
+    EXPECT_EQ(info->find(SectionType::Jar)->flags, SECTION_FLAG_RUN_FROM_EXE);
+    EXPECT_EQ(info->metadataOffset, metadataOffset);
+}
+
+TEST(JarLayoutTest, LegacyFooter) {
+    Bytes file = TestUtil::randomBytes(777, 3);
+    const auto jar = TestUtil::ZipBuilder().add("a.txt", "hello").build();
+    const std::uint64_t jarOffset = file.size();
+    file.insert(file.end(), jar.begin(), jar.end());
+    file.resize(file.size() + 50, 0x89); // 启动图片
+
+    const std::uint64_t metadataOffset = file.size();
+    for (const auto str: STRINGS) {
+        TestUtil::append(file, str);
+    }
+    JarCommon::JarFooter footer{};
+    footer.magic = JarCommon::JAR_MAGIC;
+    footer.jarOffset = jarOffset;
+    footer.jarSize = jar.size();
+    footer.splashImageSize = 50;
+    footer.launchTime = 800;
+    footer.timestamp = 99;
+    footer.javaVersion = 8;
+    footer.launchMode = JarCommon::LaunchMode::DirectJVM;
+    footer.titlePosX = 1.0f;
+    footer.mainClassLength = static_cast<unsigned>(STRINGS[0].size());
+    footer.jvmArgsLength = static_cast<unsigned>(STRINGS[1].size());
+    footer.programArgsLength = static_cast<unsigned>(STRINGS[2].size());
+    footer.javaPathLength = static_cast<unsigned>(STRINGS[3].size());
+    footer.jarExtractPathLength = static_cast<unsigned>(STRINGS[4].size());
+    footer.splashProgramNameLength = static_cast<unsigned>(STRINGS[5].size());
+    footer.splashProgramVersionLength = static_cast<unsigned>(STRINGS[6].size());
+    TestUtil::append(file, footer);
+
+    const auto info = load(file);
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->version, LEGACY_VERSION);
+    EXPECT_EQ(info->metadataOffset, metadataOffset);
+    EXPECT_EQ(info->range(SectionType::Jar).offset, jarOffset);
+    EXPECT_EQ(info->range(SectionType::Jar).size, jar.size());
+    EXPECT_EQ(info->range(SectionType::SplashImage).size, 50U);
+    EXPECT_EQ(info->settings.launchTime, 800);
+    EXPECT_EQ(info->settings.timestamp, 99U);
+    EXPECT_EQ(info->settings.javaVersion, 8U);
+    EXPECT_EQ(info->settings.titlePosX, 1.0f);
+    EXPECT_EQ(info->settings.jarDigest, (std::array<std::uint8_t, 32>{}));
+
+    const auto tail = tailOf(file, file.size() - metadataOffset);
+    for (std::size_t i = 0; i < STRING_COUNT; ++i) {
+        EXPECT_EQ(stringView(*info, tail, file.size(), static_cast<StringId>(i)), STRINGS[i]);
+    }
+
+    // jar 超出文件范围
+    auto broken = file;
+    footer.jarSize = file.size();
+    std::memcpy(broken.data() + broken.size() - sizeof(footer), &footer, sizeof(footer));
+    EXPECT_FALSE(load(broken));
+}
+
+TEST(JarLayoutTest, TruncatedInput) {
+    const auto pkg = buildPackage();
+    const auto size = metadataSize(tailOf(pkg.file, PROBE_SIZE), pkg.file.size());
+    ASSERT_TRUE(size);
+
+    // 尾部数据不足元数据块
+    EXPECT_FALSE(parse(tailOf(pkg.file, *size - 1), pkg.file.size()));
+    // 尾部数据比声明的文件还大
+    EXPECT_FALSE(metadataSize(tailOf(pkg.file, PROBE_SIZE), PROBE_SIZE - 1));
+    // 只剩 footer 的一部分
+    EXPECT_FALSE(metadataSize(tailOf(pkg.file, sizeof(SectionFooter) - 1), pkg.file.size()));
+    // 截断到元数据块内部的文件，footer 声明的大小超过文件
+    const Bytes truncated(pkg.file.end() - 64, pkg.file.end());
+    EXPECT_FALSE(load(truncated));
+    // 没有任何魔数
+    EXPECT_FALSE(load(TestUtil::randomBytes(4096, 9)));
+}
+
+TEST(JarLayoutTest, OutOfRangeEntries) {
+    {
+        auto pkg = buildPackage();
+        patchEntry(pkg, 0, [&](SectionEntry &e) { e.size = pkg.file.size() - e.offset + 1; });
+        EXPECT_FALSE(load(pkg.file));
+    }
+    {
+        auto pkg = buildPackage();
+        patchEntry(pkg, 0, [](SectionEntry &e) { e.offset = ~0ULL - 4; });
+        EXPECT_FALSE(load(pkg.file));
+    }
+    {
+        // 设置段指向元数据块之外，读取的尾部数据中找不到
+        auto pkg = buildPackage();
+        patchEntry(pkg, 2, [](SectionEntry &e) { e.offset = 0; });
+        EXPECT_FALSE(load(pkg.file));
+    }
+    {
+        // 设置段内容被改动，哈希不符
+        auto pkg = buildPackage();
+        pkg.file[pkg.metadataOffset + 8] ^= 0xFF;
+        EXPECT_FALSE(load(pkg.file));
+    }
+    {
+        // 字符串引用越过字符串表末尾，需同步更新哈希才能走到范围检查
+        auto pkg = buildPackage();
+        const auto stringsEntry = TestUtil::read<SectionEntry>(pkg.file, pkg.tableOffset + 3 * sizeof(SectionEntry));
+        auto ref = TestUtil::read<StringRef>(pkg.file, stringsEntry.offset + sizeof(StringTableHeader));
+        ref.size = static_cast<std::uint32_t>(stringsEntry.size);
+        std::memcpy(pkg.file.data() + stringsEntry.offset + sizeof(StringTableHeader), &ref, sizeof(ref));
+        patchEntry(pkg, 3, [&](SectionEntry &e) {
+            e.hash = hash(std::span(pkg.file).subspan(e.offset, e.size));
+        });
+        EXPECT_FALSE(load(pkg.file));
+    }
+    {
+        // footer 中的段数量与元数据大小矛盾
+        auto pkg = buildPackage();
+        auto footer = TestUtil::read<SectionFooter>(pkg.file, pkg.file.size() - sizeof(SectionFooter));
+        footer.sectionCount = 1000;
+        std::memcpy(pkg.file.data() + pkg.file.size() - sizeof(footer), &footer, sizeof(footer));
+        EXPECT_FALSE(load(pkg.file));
+    }
+}
+
+TEST(JarLayoutTest, LargerEntrySizeAndUnknownSections) {
+    PackageOptions options;
+    options.entrySize = sizeof(SectionEntry) + 24;
+    options.unknownSection = true;
+    const auto pkg = buildPackage(options);
+    const auto info = load(pkg.file);
+    ASSERT_TRUE(info) << std::string(info.error().begin(), info.error().end());
+    EXPECT_EQ(info->range(SectionType::Jar).offset, pkg.jarOffset);
+    EXPECT_EQ(info->settings.timestamp, sampleSettings().timestamp);
+    EXPECT_EQ(stringView(*info, tailOf(pkg.file, pkg.file.size() - info->metadataOffset), pkg.file.size(),
+                         StringId::MainClass), STRINGS[0]);
+}
+
+TEST(JarLayoutTest, OlderSettingsKeepDefaults) {
+    // 旧版设置段在 jarDigest 之前结束，缺少的字段保持默认值
+    auto settings = settingsBytes(sampleSettings());
+    const auto oldSize = static_cast<std::uint32_t>(offsetof(LaunchSettings, jarDigest));
+    settings.resize(oldSize);
+    std::memcpy(settings.data(), &oldSize, sizeof(oldSize));
+
+    const auto info = load(buildPackage({.settings = settings}).file);
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->settings.size, sizeof(LaunchSettings));
+    EXPECT_EQ(info->settings.timestamp, sampleSettings().timestamp);
+    EXPECT_EQ(info->settings.jarDigest, (std::array<std::uint8_t, 32>{}));
+    EXPECT_EQ(info->settings.singleInstance, 0);
+}
+
+TEST(JarLayoutTest, NewerSettingsIgnoreUnknownTail) {
+    // 新版设置段更长，只读取认识的部分
+    auto settings = settingsBytes(sampleSettings());
+    const auto newSize = static_cast<std::uint32_t>(settings.size() + 64);
+    settings.resize(newSize, 0xAB);
+    std::memcpy(settings.data(), &newSize, sizeof(newSize));
+
+    const auto info = load(buildPackage({.settings = settings}).file);
+    ASSERT_TRUE(info);
+    EXPECT_EQ(info->settings.size, sizeof(LaunchSettings));
+    EXPECT_EQ(info->settings.singleInstance, 1);
+    EXPECT_EQ(info->settings.jarDigest, sampleSettings().jarDigest);
+
+    // 声明的大小比段本身还大时按段大小截断
+    auto lying = settingsBytes(sampleSettings());
+    lying.resize(offsetof(LaunchSettings, jarDigest));
+    const auto info2 = load(buildPackage({.settings = lying}).file);
+    ASSERT_TRUE(info2);
+    EXPECT_EQ(info2->settings.jarDigest, (std::array<std::uint8_t, 32>{}));
+}
+
+TEST(JarLayoutTest, HashIsIncremental) {
+    const auto data = TestUtil::randomBytes(1000, 5);
+    const auto whole = hash(data);
+    EXPECT_EQ(hash(std::span(data).subspan(400), hash(std::span(data).first(400))), whole);
+    EXPECT_EQ(hash({}), FNV_OFFSET_BASIS);
+}
+
+TEST(JarLayoutTest, ExtractedSize) {
+    Bytes stamp;
+    TestUtil::append(stamp, JarStamp{42});
+    const auto stamped = TestUtil::ZipBuilder().add("a.txt", "hello").build(stamp);
+    EXPECT_EQ(extractedSize(stamped, true), stamped.size());
+
+    // 旧版打包文件：原有注释被 JarStamp 替换
+    const auto legacy = TestUtil::ZipBuilder().add("a.txt", "hello").build(Bytes(300, 'c'));
+    EXPECT_EQ(extractedSize(legacy, false), legacy.size() - 300 + sizeof(JarStamp));
+    EXPECT_FALSE(extractedSize(Bytes(100, 0), false));
+}
+
+TEST(JarLayoutTest, ReadStampChecksFileSize) {
+    const TestUtil::TempDir dir;
+    const auto path = dir / "app.jar";
+    Bytes stamp;
+    TestUtil::append(stamp, JarStamp{42});
+    const auto jar = TestUtil::ZipBuilder().add("a.txt", TestUtil::randomBytes(5000, 3)).build(stamp);
+    TestUtil::writeFile(path, jar);
+
+    const auto result = readStamp(path, jar.size());
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->timestamp, 42U);
+    EXPECT_FALSE(readStamp(path, jar.size() + 1));
+    EXPECT_FALSE(readStamp(path, jar.size() - 1));
+
+    // 开头多出数据：EOCD 与中央目录仍可解析，中央目录也位于 EOCD 之前，只有大小能发现
+    Bytes prefixed(100, 0xCC);
+    prefixed.insert(prefixed.end(), jar.begin(), jar.end());
+    TestUtil::writeFile(path, prefixed);
+    EXPECT_FALSE(readStamp(path, jar.size()));
+}
@@ -0,0 +1,258 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: JavaDiscovery 测试，使用临时目录中的假 JDK 目录树
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+#include "javadiscovery.h"
+#include "testutil.h"
+
+using JavaDiscovery::Binary;
+using JavaDiscovery::Path;
+using TestUtil::TempDir;
+
+namespace {
+    constexpr std::uint32_t JNI_VERSION_1_8 = 0x00010008;
+    constexpr std::uint32_t JNI_VERSION_17 = 0x00110000;
+
+    // 测试期间修改环境变量，析构时恢复
+    class ScopedEnv {
+    public:
+        ScopedEnv(const char *name, const std::optional<std::string> &value) : m_name(name) {
+            if (const char *old = std::getenv(name)) {
+                m_old = old;
+            }
+            set(value);
+        }
+
+        ~ScopedEnv() { set(m_old); }
+
+        ScopedEnv(const ScopedEnv &) = delete;
+
+        ScopedEnv &operator=(const ScopedEnv &) = delete;
+
+    private:
+        void set(const std::optional<std::string> &value) const {
+            if (value) {
+                setenv(m_name, value->c_str(), 1);
+            } else {
+                unsetenv(m_name);
+            }
+        }
+
+        const char *m_name;
+        std::optional<std::string> m_old;
+    };
+
+    struct JdkSpec {
+        std::string version;
+        std::string arch = "x86_64";
+        bool java = true;
+        bool jvm = true;
+        bool release = true;
+    };
+
+    // <home>/release、<home>/bin/java、<home>/lib/server/libjvm.so
+    Path makeJdk(const Path &home, const JdkSpec &spec) {
+        std::filesystem::create_directories(home);
+        if (spec.release) {
+            TestUtil::writeFile(home / "release", std::format("IMPLEMENTOR=\"Test\"\nJAVA_VERSION=\"{}\"\r\n"
+                                                              "OS_ARCH=\"{}\"\n", spec.version, spec.arch));
+        }
+        if (spec.java) {
+            TestUtil::writeFile(home / "bin" / "java", "#!/bin/sh\n");
+        }
+        if (spec.jvm) {
+            TestUtil::writeFile(home / "lib" / "server" / "libjvm.so", "ELF");
+        }
+        return home;
+    }
+
+    std::vector<std::string> versions(const std::vector<JavaDiscovery::Runtime> &runtimes) {
+        std::vector<std::string> result;
+        for (const auto &runtime: runtimes) {
+            const auto version = runtime.version;
+            result.emplace_back(version.begin(), version.end());
+        }
+        return result;
+    }
+
+    // 每个用例都在干净的 JAVA_HOME/PATH 下运行，避免受到机器上真实 JDK 的影响
+    class JavaDiscoveryTest : public testing::Test {
+    protected:
+        TempDir m_dir;
+        ScopedEnv m_javaHome{"JAVA_HOME", std::nullopt};
+        ScopedEnv m_path{"PATH", std::string("/nonexistent")};
+        std::vector<Path> m_roots{m_dir / "jvm"};
+    };
+} // namespace
+
+TEST_F(JavaDiscoveryTest, FeatureVersion) {
+    EXPECT_EQ(JavaDiscovery::featureVersion(JNI_VERSION_1_8), 8U);
+    EXPECT_EQ(JavaDiscovery::featureVersion(0x00010006), 6U);
+    EXPECT_EQ(JavaDiscovery::featureVersion(JNI_VERSION_17), 17U);
+    EXPECT_EQ(JavaDiscovery::featureVersion(0x00150000), 21U);
+}
+
+TEST_F(JavaDiscoveryTest, ReadReleaseParsesLegacyVersion) {
+    const auto home = makeJdk(m_dir / "jdk8", {.version = "1.8.0_392", .arch = "amd64"});
+    const auto runtime = JavaDiscovery::readRelease(home);
+    EXPECT_EQ(runtime.home, home);
+    EXPECT_EQ(runtime.version, L"1.8.0_392");
+    EXPECT_EQ(runtime.feature, 8U);
+    EXPECT_EQ(runtime.implementor, L"Test");
+    EXPECT_EQ(runtime.arch, L"amd64");
+
+    EXPECT_EQ(JavaDiscovery::readRelease(makeJdk(m_dir / "jdk21", {.version = "21.0.2"})).feature, 21U);
+    // x86_64 规范化为 amd64，CRLF 行尾被去掉
+    EXPECT_EQ(JavaDiscovery::readRelease(m_dir / "jdk21").arch, L"amd64");
+
+    const auto missing = JavaDiscovery::readRelease(m_dir / "nothing");
+    EXPECT_EQ(missing.feature, 0U);
+    EXPECT_TRUE(missing.version.empty());
+}
+
+TEST_F(JavaDiscoveryTest, RanksByReleaseVersion) {
+    makeJdk(m_roots[0] / "jdk-17", {.version = "17.0.9"});
+    makeJdk(m_roots[0] / "jdk-8", {.version = "1.8.0_392"});
+    makeJdk(m_roots[0] / "jdk-21.0.10", {.version = "21.0.10"});
+    makeJdk(m_roots[0] / "jdk-21.0.2", {.version = "21.0.2"});
+    makeJdk(m_roots[0] / "unknown", {.version = "", .release = false});
+    std::filesystem::create_directories(m_roots[0] / "not-a-jdk");
+
+    const auto runtimes = JavaDiscovery::index(Binary::Java, 0, m_roots);
+    // 1.8.0_392 按 8.0.392 比较，版本未知的排在最后
+    EXPECT_EQ(versions(runtimes), (std::vector<std::string>{"21.0.10", "21.0.2", "17.0.9", "1.8.0_392", ""}));
+    EXPECT_EQ(runtimes.front().binary, m_roots[0] / "jdk-21.0.10" / "bin" / "java");
+
+    // 要求 17 及以上时排除 8，版本未知的保留
+    EXPECT_EQ(versions(JavaDiscovery::index(Binary::Java, JNI_VERSION_17, m_roots)),
+              (std::vector<std::string>{"21.0.10", "21.0.2", "17.0.9", ""}));
+}
+
+TEST_F(JavaDiscoveryTest, JvmRequiresMatchingArch) {
+    makeJdk(m_roots[0] / "arm", {.version = "22", .arch = "aarch64"});
+    makeJdk(m_roots[0] / "x64", {.version = "11.0.1", .arch = "x86_64"});
+    makeJdk(m_roots[0] / "jre-only", {.version = "21", .jvm = false});
+
+#if defined(__x86_64__)
+    // jvm 动态库在进程内加载，架构不符的直接排除
+    const auto jvms = JavaDiscovery::index(Binary::Jvm, 0, m_roots);
+    EXPECT_EQ(versions(jvms), (std::vector<std::string>{"11.0.1"}));
+    EXPECT_EQ(jvms.front().binary, m_roots[0] / "x64" / "lib" / "server" / "libjvm.so");
+
+    // java 在子进程中运行，架构不符只降低优先级
+    EXPECT_EQ(versions(JavaDiscovery::index(Binary::Java, 0, m_roots)),
+              (std::vector<std::string>{"21", "11.0.1", "22"}));
+#else
+    GTEST_SKIP() << "用例按 x86_64 主机编写";
+#endif
+}
+
+TEST_F(JavaDiscoveryTest, JavaHomeBeatsPathBeatsInstallRoots) {
+    const auto home = makeJdk(m_dir / "home-jdk", {.version = "11.0.20"});
+    const auto onPath = makeJdk(m_dir / "path-jdk", {.version = "17.0.1"});
+    makeJdk(m_roots[0] / "jdk-21", {.version = "21.0.1"});
+
+    ScopedEnv javaHome("JAVA_HOME", home.string());
+    // JAVA_HOME 同时出现在 PATH 中时只保留一项
+    ScopedEnv path("PATH", std::format("{}:/nonexistent:{}", (onPath / "bin").string(), (home / "bin").string()));
+
+    const auto java = JavaDiscovery::index(Binary::Java, 0, m_roots);
+    EXPECT_EQ(versions(java), (std::vector<std::string>{"11.0.20", "17.0.1", "21.0.1"}));
+    EXPECT_EQ(java[0].binary, home / "bin" / "java");
+    EXPECT_EQ(java[1].binary, onPath / "bin" / "java");
+
+    // jvm 从 PATH 中 bin 目录的上级查找
+    const auto jvm = JavaDiscovery::index(Binary::Jvm, 0, m_roots);
+    EXPECT_EQ(versions(jvm), (std::vector<std::string>{"11.0.20", "17.0.1", "21.0.1"}));
+
+    // JAVA_HOME 版本过低时被排除，PATH 中的满足要求
+    EXPECT_EQ(JavaDiscovery::scan(Binary::Java, JNI_VERSION_17, m_roots).value(), onPath / "bin" / "java");
+}
+
+TEST_F(JavaDiscoveryTest, ScanReportsRequiredVersion) {
+    makeJdk(m_roots[0] / "jdk-8", {.version = "1.8.0_392"});
+    const auto result = JavaDiscovery::scan(Binary::Java, JNI_VERSION_17, m_roots);
+    ASSERT_FALSE(result);
+    EXPECT_NE(result.error().find(L"17"), std::wstring::npos);
+
+    EXPECT_FALSE(JavaDiscovery::scan(Binary::Jvm, 0, {}));
+}
+
+TEST_F(JavaDiscoveryTest, FindUsesCacheUntilBinaryChanges) {
+    const auto cacheFile = m_dir / "cache" / "jvm-discovery.cache";
+    const auto old = makeJdk(m_roots[0] / "jdk-17", {.version = "17.0.9"});
+
+    const auto first = JavaDiscovery::find(Binary::Java, L"", JNI_VERSION_17, cacheFile, m_roots);
+    ASSERT_TRUE(first);
+    EXPECT_EQ(*first, old / "bin" / "java");
+    ASSERT_TRUE(std::filesystem::exists(cacheFile));
+
+    // 命中时不扫描：即使出现更新的 JDK、安装目录为空也返回缓存的路径
+    makeJdk(m_roots[0] / "jdk-21", {.version = "21.0.1"});
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", JNI_VERSION_17, cacheFile, {}).value(), old / "bin" / "java");
+
+    // 键不同（java 路径、版本、类型）各自独立缓存
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", 0, cacheFile, m_roots).value(),
+              m_roots[0] / "jdk-21" / "bin" / "java");
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", JNI_VERSION_17, cacheFile, {}).value(), old / "bin" / "java");
+
+    // 文件大小变化（升级后被替换）时重新扫描并更新缓存
+    TestUtil::writeFile(old / "bin" / "java", "#!/bin/sh\nexec real-java \"$@\"\n");
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", JNI_VERSION_17, cacheFile, m_roots).value(),
+              m_roots[0] / "jdk-21" / "bin" / "java");
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", JNI_VERSION_17, cacheFile, {}).value(),
+              m_roots[0] / "jdk-21" / "bin" / "java");
+}
+
+TEST_F(JavaDiscoveryTest, FindRescansWhenMtimeChangesOrBinaryIsRemoved) {
+    const auto cacheFile = m_dir / "jvm-discovery.cache";
+    const auto jdk17 = makeJdk(m_roots[0] / "jdk-17", {.version = "17.0.9"});
+    const auto jvm17 = jdk17 / "lib" / "server" / "libjvm.so";
+    ASSERT_EQ(JavaDiscovery::find(Binary::Jvm, L"", 0, cacheFile, m_roots).value(), jvm17);
+
+    // 大小不变只有修改时间变化
+    makeJdk(m_roots[0] / "jdk-21", {.version = "21.0.1"});
+    std::filesystem::last_write_time(jvm17, std::filesystem::last_write_time(jvm17) - std::chrono::hours(1));
+    EXPECT_EQ(JavaDiscovery::find(Binary::Jvm, L"", 0, cacheFile, m_roots).value(),
+              m_roots[0] / "jdk-21" / "lib" / "server" / "libjvm.so");
+
+    // 缓存的文件被删除，扫描也找不到时返回错误
+    std::filesystem::remove_all(m_roots[0]);
+    EXPECT_FALSE(JavaDiscovery::find(Binary::Jvm, L"", 0, cacheFile, m_roots));
+    EXPECT_EQ(JavaDiscovery::find(Binary::Jvm, L"", 0, cacheFile, {}).error(), L"未找到JVM动态库");
+}
+
+TEST_F(JavaDiscoveryTest, FindToleratesCorruptCache) {
+    const auto cacheFile = m_dir / "jvm-discovery.cache";
+    const auto jdk = makeJdk(m_roots[0] / "jdk-21", {.version = "21.0.1"});
+    const auto java = jdk / "bin" / "java";
+
+    // 字段不足、数字无法解析、二进制垃圾、截断的最后一行
+    TestUtil::writeFile(cacheFile, std::format("garbage\njava|0|\t{}\tNaN\t1\njava|0|\t{}\n\x01\x02\xff\t\t\t\n"
+                                               "java|0|\t{}\t12", java.string(), java.string(), java.string()));
+    ASSERT_EQ(JavaDiscovery::find(Binary::Java, L"", 0, cacheFile, m_roots).value(), java);
+
+    // 缓存被重写为有效内容，之后直接命中
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", 0, cacheFile, {}).value(), java);
+
+    // 指向另一个文件且 stat 恰好不同的记录不会被采用
+    const auto size = std::filesystem::file_size(java);
+    TestUtil::writeFile(cacheFile, std::format("java|0|\t{}\t{}\t0\n", (m_dir / "missing").string(), size));
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", 0, cacheFile, m_roots).value(), java);
+
+    // 缓存路径是目录等无法写入的情况不影响查找结果
+    const auto blocked = m_dir / "blocked";
+    std::filesystem::create_directories(blocked);
+    EXPECT_EQ(JavaDiscovery::find(Binary::Java, L"", 0, blocked, m_roots).value(), java);
+}
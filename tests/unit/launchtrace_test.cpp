@@ -0,0 +1,169 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: LaunchTrace 缓冲区、JSON 输出与记录开销测试
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "launchtrace.h"
+#include "testutil.h"
+
+using LaunchTrace::Clock;
+
+namespace {
+    class LaunchTraceTest : public testing::Test {
+    protected:
+        void SetUp() override {
+            LaunchTrace::reset();
+        }
+
+        void TearDown() override {
+            LaunchTrace::reset();
+        }
+    };
+
+    std::size_t countOf(const std::string &text, const std::string_view needle) {
+        std::size_t count = 0;
+        for (auto pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + needle.size())) {
+            ++count;
+        }
+        return count;
+    }
+
+    // 完整事件（ph=X）的数量，不含进程名元数据
+    std::size_t eventCount(const std::string &json) {
+        return countOf(json, R"("ph":"X")");
+    }
+} // namespace
+
+TEST_F(LaunchTraceTest, DisabledSpanRecordsNothing) {
+    {
+        LaunchTrace::Span span("disabled");
+    }
+    EXPECT_FALSE(LaunchTrace::enabled());
+    EXPECT_EQ(eventCount(LaunchTrace::json()), 0U);
+    EXPECT_FALSE(LaunchTrace::flush());
+}
+
+TEST_F(LaunchTraceTest, SpanRecordsDuration) {
+    LaunchTrace::enable();
+    {
+        LaunchTrace::Span span("sleep");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    const auto json = LaunchTrace::json();
+    EXPECT_EQ(eventCount(json), 1U);
+    EXPECT_NE(json.find(R"("name":"sleep")"), std::string::npos);
+    const auto dur = json.find(R"("dur":)");
+    ASSERT_NE(dur, std::string::npos);
+    EXPECT_GE(std::stoll(json.substr(dur + 6)), 2000);
+    EXPECT_TRUE(json.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+    EXPECT_TRUE(json.ends_with("\n]}\n"));
+}
+
+TEST_F(LaunchTraceTest, EscapesNames) {
+    LaunchTrace::enable();
+    const auto now = Clock::now();
+    LaunchTrace::record("quote\" backslash\\ newline\n tab\t ctrl\x01 阶段", now, now);
+    const auto json = LaunchTrace::json();
+    EXPECT_NE(json.find(R"("name":"quote\" backslash\\ newline\u000a tab\u0009 ctrl\u0001 阶段")"),
+              std::string::npos) << json;
+    // 转义后名称中不再有原始控制字符，每个事件占一行
+    EXPECT_EQ(countOf(json, "\n"), 4U);
+}
+
+TEST_F(LaunchTraceTest, DropsEventsBeyondCapacity) {
+    LaunchTrace::enable();
+    const auto now = Clock::now();
+    for (std::size_t i = 0; i < LaunchTrace::CAPACITY + 100; ++i) {
+        LaunchTrace::record("event", now, now);
+    }
+    EXPECT_EQ(LaunchTrace::reserve(), LaunchTrace::CAPACITY);
+    EXPECT_EQ(eventCount(LaunchTrace::json()), LaunchTrace::CAPACITY);
+
+    // 写入已满的槽位编号被忽略
+    LaunchTrace::commit(LaunchTrace::CAPACITY, "late", now, now);
+    EXPECT_EQ(LaunchTrace::json().find("late"), std::string::npos);
+}
+
+TEST_F(LaunchTraceTest, SkipsEventsInProgress) {
+    LaunchTrace::enable();
+    const auto now = Clock::now();
+    const auto pending = LaunchTrace::reserve();
+    LaunchTrace::record("done", now, now + std::chrono::microseconds(5));
+
+    auto json = LaunchTrace::json();
+    EXPECT_EQ(eventCount(json), 1U);
+    EXPECT_NE(json.find(R"("name":"done")"), std::string::npos);
+
+    LaunchTrace::commit(pending, "pending", now, now);
+    json = LaunchTrace::json();
+    EXPECT_EQ(eventCount(json), 2U);
+    EXPECT_NE(json.find(R"("name":"pending")"), std::string::npos);
+}
+
+TEST_F(LaunchTraceTest, ConcurrentRecordKeepsEveryEvent) {
+    LaunchTrace::enable();
+    constexpr int THREADS = 8;
+    constexpr int PER_THREAD = 400;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < PER_THREAD; ++i) {
+                LaunchTrace::Span span("worker");
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    const auto json = LaunchTrace::json();
+    EXPECT_EQ(eventCount(json), static_cast<std::size_t>(THREADS * PER_THREAD));
+
+    // 每个线程有自己的 tid
+    std::set<std::string> tids;
+    for (auto pos = json.find(R"("tid":)"); pos != std::string::npos; pos = json.find(R"("tid":)", pos + 1)) {
+        tids.insert(json.substr(pos + 6, json.find('}', pos) - pos - 6));
+    }
+    EXPECT_EQ(tids.size(), static_cast<std::size_t>(THREADS));
+}
+
+TEST_F(LaunchTraceTest, FlushWritesFile) {
+    const TestUtil::TempDir dir;
+    LaunchTrace::enable(dir / "trace.json");
+    LaunchTrace::record("flushed", Clock::now(), Clock::now());
+    ASSERT_TRUE(LaunchTrace::flush());
+    const auto content = TestUtil::readFile(dir / "trace.json");
+    EXPECT_EQ(std::string(content.begin(), content.end()), LaunchTrace::json());
+
+    // 启用但没有输出文件时只记录
+    LaunchTrace::reset();
+    LaunchTrace::enable();
+    EXPECT_FALSE(LaunchTrace::flush());
+}
+
+TEST_F(LaunchTraceTest, SpanCostsLessThanOneMicrosecond) {
+    LaunchTrace::enable();
+    // 取多批中最快的一批，减少调度抖动的影响；每批不超过缓冲区容量，都走真实的写入路径
+    constexpr int BATCH = static_cast<int>(LaunchTrace::CAPACITY) - 1;
+    double best = std::numeric_limits<double>::max();
+    for (int round = 0; round < 5; ++round) {
+        LaunchTrace::reset();
+        LaunchTrace::enable();
+        const auto start = Clock::now();
+        for (int i = 0; i < BATCH; ++i) {
+            LaunchTrace::Span span("cost");
+        }
+        const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        best = std::min(best, elapsed / BATCH);
+    }
+    EXPECT_EQ(eventCount(LaunchTrace::json()), static_cast<std::size_t>(BATCH));
+    std::cout << std::format("enabled span: {:.1f} ns\n", best);
+    EXPECT_LT(best, 1000.0);
+}
@@ -0,0 +1,106 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: MappedFile 映射内容、越界视图与移动语义测试
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "mappedfile.h"
+#include "testutil.h"
+
+using TestUtil::Bytes;
+using TestUtil::TempDir;
+
+TEST(MappedFileTest, DataMatchesFile) {
+    const TempDir dir;
+    const auto content = TestUtil::randomBytes(3 * 4096 + 17, 1);
+    TestUtil::writeFile(dir / "a.bin", content);
+
+    const auto file = MappedFile::open(dir / "a.bin");
+    ASSERT_TRUE(file);
+    ASSERT_EQ(file->size(), content.size());
+    EXPECT_TRUE(std::ranges::equal(file->data(), content));
+    EXPECT_TRUE(std::ranges::equal(file->view(4096, 100), std::span(content).subspan(4096, 100)));
+    EXPECT_TRUE(std::ranges::equal(file->view(0, content.size()), content));
+    EXPECT_EQ(file->view(content.size(), 0).size(), 0U);
+}
+
+TEST(MappedFileTest, ViewRemainsValidAfterFileIsRemoved) {
+    const TempDir dir;
+    const auto content = TestUtil::randomBytes(10000, 2);
+    TestUtil::writeFile(dir / "a.bin", content);
+
+    const auto file = MappedFile::open(dir / "a.bin");
+    ASSERT_TRUE(file);
+    std::filesystem::remove(dir / "a.bin");
+    EXPECT_TRUE(std::ranges::equal(file->data(), content));
+}
+
+TEST(MappedFileTest, EmptyFile) {
+    const TempDir dir;
+    TestUtil::writeFile(dir / "empty.bin", Bytes{});
+
+    const auto file = MappedFile::open(dir / "empty.bin");
+    ASSERT_TRUE(file);
+    EXPECT_EQ(file->size(), 0U);
+    EXPECT_TRUE(file->data().empty());
+    EXPECT_TRUE(file->view(0, 0).empty());
+    EXPECT_TRUE(file->view(0, 1).empty());
+}
+
+TEST(MappedFileTest, OutOfRangeViewIsEmpty) {
+    const TempDir dir;
+    TestUtil::writeFile(dir / "a.bin", TestUtil::randomBytes(1000, 3));
+    const auto file = MappedFile::open(dir / "a.bin");
+    ASSERT_TRUE(file);
+
+    EXPECT_TRUE(file->view(0, 1001).empty());
+    EXPECT_TRUE(file->view(1001, 0).empty());
+    EXPECT_TRUE(file->view(999, 2).empty());
+    EXPECT_TRUE(file->view(2000, 10).empty());
+    // offset + size 溢出 64 位时不能绕回到文件范围内
+    EXPECT_TRUE(file->view(~0ULL, 2).empty());
+    EXPECT_TRUE(file->view(2, ~0ULL).empty());
+    EXPECT_TRUE(file->view(~0ULL - 10, 20).empty());
+    EXPECT_EQ(file->view(999, 1).size(), 1U);
+}
+
+TEST(MappedFileTest, MoveLeavesSourceEmpty) {
+    const TempDir dir;
+    const auto content = TestUtil::randomBytes(5000, 4);
+    TestUtil::writeFile(dir / "a.bin", content);
+    TestUtil::writeFile(dir / "b.bin", TestUtil::randomBytes(100, 5));
+
+    auto opened = MappedFile::open(dir / "a.bin");
+    ASSERT_TRUE(opened);
+    MappedFile first = std::move(*opened);
+    EXPECT_EQ(opened->size(), 0U);
+    EXPECT_TRUE(opened->data().empty());
+    EXPECT_TRUE(std::ranges::equal(first.data(), content));
+
+    // 移动赋值释放目标原有的映射，接管源的映射
+    auto second = MappedFile::open(dir / "b.bin");
+    ASSERT_TRUE(second);
+    *second = std::move(first);
+    EXPECT_EQ(first.size(), 0U);
+    EXPECT_TRUE(first.data().empty());
+    EXPECT_TRUE(first.view(0, 0).empty());
+    EXPECT_TRUE(std::ranges::equal(second->data(), content));
+
+    MappedFile empty;
+    *second = std::move(empty);
+    EXPECT_TRUE(second->data().empty());
+}
+
+TEST(MappedFileTest, OpenMissingFileFails) {
+    const TempDir dir;
+    const auto file = MappedFile::open(dir / "missing.bin");
+    ASSERT_FALSE(file);
+    EXPECT_NE(file.error().find(L"missing.bin"), std::wstring::npos);
+}
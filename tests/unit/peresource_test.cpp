@@ -0,0 +1,711 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: PeResource 解析与重建测试
+             样例 PE 由测试按 PE 规范独立构造，资源树按深度优先布局（与被测序列化的分层布局不同），
+             重建结果再由测试中独立的遍历代码读回检查
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "peresource.h"
+#include "testutil.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using PeResource::Id;
+using PeResource::Image;
+using PeResource::Resource;
+using TestUtil::Bytes;
+
+namespace {
+    constexpr std::uint32_t FILE_ALIGNMENT = 0x200;
+    constexpr std::uint32_t SECTION_ALIGNMENT = 0x1000;
+    constexpr std::uint32_t HEADERS_SIZE = 0x400;
+    constexpr std::uint32_t PE_OFFSET = 0x40;
+    constexpr std::uint32_t HIGH_BIT = 0x80000000;
+    constexpr std::uint16_t LANG_EN_US = 0x409;
+
+    constexpr std::uint32_t DIR_RESOURCE = 2;
+    constexpr std::uint32_t DIR_SECURITY = 4;
+    constexpr std::uint32_t DIR_BASERELOC = 5;
+
+    std::uint32_t alignUp(const std::uint64_t value, const std::uint32_t alignment) {
+        return static_cast<std::uint32_t>((value + alignment - 1) / alignment * alignment);
+    }
+
+    template<typename T>
+    void put(Bytes &data, const std::size_t offset, const T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(T));
+    }
+
+    template<typename T>
+    T get(const Bytes &data, const std::size_t offset) {
+        return TestUtil::read<T>(data, offset);
+    }
+
+    // 按深度优先布局的资源节：每个目录后紧跟其子目录，数据项紧跟语言目录，随后是名称字符串和 4 字节对齐的数据
+    Bytes resourceSection(const std::uint32_t baseRva, const std::vector<Resource> &resources) {
+        std::map<Id, std::map<Id, std::map<std::uint16_t, const Resource *>>> tree;
+        for (const auto &resource: resources) {
+            tree[resource.type][resource.name][resource.language] = &resource;
+        }
+
+        Bytes out;
+        std::vector<std::pair<std::size_t, std::u16string>> names; // 目录项偏移与名称
+        std::vector<std::pair<std::size_t, const Resource *>> leaves; // 数据项偏移与资源
+        const auto directory = [&](const auto &entries) {
+            const auto offset = out.size();
+            out.resize(offset + 16 + entries.size() * 8);
+            std::uint16_t named = 0;
+            std::size_t entry = offset + 16;
+            for (const auto &key: entries | std::views::keys) {
+                if constexpr (std::is_same_v<std::decay_t<decltype(key)>, Id>) {
+                    if (key.isName()) {
+                        ++named;
+                        names.emplace_back(entry, key.name);
+                    } else {
+                        put<std::uint32_t>(out, entry, key.id);
+                    }
+                } else {
+                    put<std::uint32_t>(out, entry, key);
+                }
+                entry += 8;
+            }
+            put<std::uint16_t>(out, offset + 12, named);
+            put<std::uint16_t>(out, offset + 14, static_cast<std::uint16_t>(entries.size() - named));
+            return offset;
+        };
+        const auto link = [&](const std::size_t entry, const std::uint32_t target) {
+            put<std::uint32_t>(out, entry + 4, target);
+        };
+
+        const auto root = directory(tree);
+        std::size_t typeEntry = root + 16;
+        for (const auto &typeNames: tree | std::views::values) {
+            link(typeEntry, static_cast<std::uint32_t>(directory(typeNames)) | HIGH_BIT);
+            std::size_t nameEntry = get<std::uint32_t>(out, typeEntry + 4) - HIGH_BIT + 16;
+            typeEntry += 8;
+            for (const auto &languages: typeNames | std::views::values) {
+                const auto languageDir = directory(languages);
+                link(nameEntry, static_cast<std::uint32_t>(languageDir) | HIGH_BIT);
+                nameEntry += 8;
+                std::size_t languageEntry = languageDir + 16;
+                for (const auto *resource: languages | std::views::values) {
+                    link(languageEntry, static_cast<std::uint32_t>(out.size()));
+                    leaves.emplace_back(out.size(), resource);
+                    out.resize(out.size() + 16);
+                    languageEntry += 8;
+                }
+            }
+        }
+        for (const auto &[entry, name]: names) {
+            put<std::uint32_t>(out, entry, static_cast<std::uint32_t>(out.size()) | HIGH_BIT);
+            TestUtil::append(out, static_cast<std::uint16_t>(name.size()));
+            out.resize(out.size() + name.size() * 2);
+            std::memcpy(out.data() + out.size() - name.size() * 2, name.data(), name.size() * 2);
+        }
+        for (const auto &[leaf, resource]: leaves) {
+            out.resize(alignUp(out.size(), 4));
+            put<std::uint32_t>(out, leaf, baseRva + static_cast<std::uint32_t>(out.size()));
+            put<std::uint32_t>(out, leaf + 4, static_cast<std::uint32_t>(resource->data.size()));
+            put<std::uint32_t>(out, leaf + 8, resource->codePage);
+            out.insert(out.end(), resource->data.begin(), resource->data.end());
+        }
+        return out;
+    }
+
+    enum class After {
+        Nothing, // .rsrc 是最后一个节
+        Reloc, // .rsrc 之后是基址重定位节
+        Data, // .rsrc 之后是不能移动的数据节
+    };
+
+    struct PeSpec {
+        bool pe32Plus = true;
+        After after = After::Reloc;
+        std::uint16_t subsystem = 2;
+        std::vector<Resource> resources;
+        Bytes overlay; // 最后一个节之后的附加数据
+        Bytes certificate; // 非空时追加在附加数据之后，由证书目录引用
+    };
+
+    struct SectionInfo {
+        std::string name;
+        std::uint32_t virtualSize;
+        std::uint32_t virtualAddress;
+        std::uint32_t rawSize;
+        std::uint32_t rawOffset;
+        std::uint32_t characteristics;
+    };
+
+    // 独立读取 PE 头部，用于检查重建结果
+    struct PeView {
+        std::size_t opt = 0;
+        bool pe32Plus = false;
+        std::vector<SectionInfo> sections;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> directories;
+
+        explicit PeView(const Bytes &file) {
+            const auto pe = get<std::uint32_t>(file, 0x3C);
+            const auto count = get<std::uint16_t>(file, pe + 6);
+            const auto optSize = get<std::uint16_t>(file, pe + 20);
+            opt = pe + 24;
+            pe32Plus = get<std::uint16_t>(file, opt) == 0x20B;
+            const std::size_t dirs = opt + (pe32Plus ? 112 : 96);
+            for (std::uint32_t i = 0; i < get<std::uint32_t>(file, dirs - 4); ++i) {
+                directories.emplace_back(get<std::uint32_t>(file, dirs + i * 8), get<std::uint32_t>(file, dirs + i * 8 + 4));
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::size_t header = opt + optSize + i * 40;
+                sections.push_back({
+                    std::string(reinterpret_cast<const char *>(file.data() + header),
+                                strnlen(reinterpret_cast<const char *>(file.data() + header), 8)),
+                    get<std::uint32_t>(file, header + 8), get<std::uint32_t>(file, header + 12),
+                    get<std::uint32_t>(file, header + 16), get<std::uint32_t>(file, header + 20),
+                    get<std::uint32_t>(file, header + 36),
+                });
+            }
+        }
+
+        const SectionInfo &section(const std::string_view name) const {
+            return *std::ranges::find(sections, name, &SectionInfo::name);
+        }
+
+        std::uint32_t rvaToOffset(const std::uint32_t rva) const {
+            for (const auto &s: sections) {
+                if (rva >= s.virtualAddress && rva < s.virtualAddress + std::max(s.virtualSize, s.rawSize)) {
+                    return s.rawOffset + (rva - s.virtualAddress);
+                }
+            }
+            return 0;
+        }
+    };
+
+    Bytes buildPe(const PeSpec &spec) {
+        const std::uint16_t optSize = spec.pe32Plus ? 240 : 224;
+        const std::uint16_t sectionCount = spec.after == After::Nothing ? 2 : 3;
+
+        // .text 固定，.rsrc 紧随其后，最后是可选的 .reloc 或 .data
+        const Bytes text(0x180, 0xCC);
+        const auto rsrc = resourceSection(0x2000, spec.resources);
+        Bytes reloc;
+        TestUtil::append(reloc, std::uint32_t{0x1000}); // 页 RVA
+        TestUtil::append(reloc, std::uint32_t{12}); // 块大小
+        TestUtil::append(reloc, std::uint16_t{0xA010});
+        TestUtil::append(reloc, std::uint16_t{0});
+
+        struct Raw {
+            const char *name;
+            const Bytes *data;
+            std::uint32_t characteristics;
+        };
+        std::vector<Raw> raws{{".text", &text, 0x60000020}, {".rsrc", &rsrc, 0x40000040}};
+        if (spec.after == After::Reloc) {
+            raws.push_back({".reloc", &reloc, 0x42000040});
+        } else if (spec.after == After::Data) {
+            raws.push_back({".data", &reloc, 0xC0000040});
+        }
+
+        Bytes file(HEADERS_SIZE, 0);
+        put<std::uint16_t>(file, 0, 0x5A4D);
+        put<std::uint32_t>(file, 0x3C, PE_OFFSET);
+        put<std::uint32_t>(file, PE_OFFSET, 0x00004550);
+        put<std::uint16_t>(file, PE_OFFSET + 4, spec.pe32Plus ? 0x8664 : 0x14C);
+        put<std::uint16_t>(file, PE_OFFSET + 6, sectionCount);
+        put<std::uint16_t>(file, PE_OFFSET + 20, optSize);
+        put<std::uint16_t>(file, PE_OFFSET + 22, spec.pe32Plus ? 0x22 : 0x102);
+
+        const std::size_t opt = PE_OFFSET + 24;
+        const std::size_t dirs = opt + (spec.pe32Plus ? 112 : 96);
+        put<std::uint16_t>(file, opt, spec.pe32Plus ? 0x20B : 0x10B);
+        put<std::uint32_t>(file, opt + 32, SECTION_ALIGNMENT);
+        put<std::uint32_t>(file, opt + 36, FILE_ALIGNMENT);
+        put<std::uint32_t>(file, opt + 60, HEADERS_SIZE);
+        put<std::uint16_t>(file, opt + 68, spec.subsystem);
+        put<std::uint32_t>(file, dirs - 4, 16);
+
+        std::uint32_t va = SECTION_ALIGNMENT;
+        std::uint32_t initializedData = 0;
+        for (std::size_t i = 0; i < raws.size(); ++i) {
+            const auto &[name, data, characteristics] = raws[i];
+            const std::size_t header = opt + optSize + i * 40;
+            const auto rawSize = alignUp(data->size(), FILE_ALIGNMENT);
+            std::memcpy(file.data() + header, name, std::strlen(name));
+            put<std::uint32_t>(file, header + 8, static_cast<std::uint32_t>(data->size()));
+            put<std::uint32_t>(file, header + 12, va);
+            put<std::uint32_t>(file, header + 16, rawSize);
+            put<std::uint32_t>(file, header + 20, static_cast<std::uint32_t>(file.size()));
+            put<std::uint32_t>(file, header + 36, characteristics);
+            if (std::string_view(name) == ".rsrc") {
+                put<std::uint32_t>(file, dirs + DIR_RESOURCE * 8, va);
+                put<std::uint32_t>(file, dirs + DIR_RESOURCE * 8 + 4, static_cast<std::uint32_t>(data->size()));
+            } else if (std::string_view(name) == ".reloc") {
+                put<std::uint32_t>(file, dirs + DIR_BASERELOC * 8, va);
+                put<std::uint32_t>(file, dirs + DIR_BASERELOC * 8 + 4, static_cast<std::uint32_t>(data->size()));
+            }
+            if (characteristics & 0x40) {
+                initializedData += rawSize;
+            }
+            file.insert(file.end(), data->begin(), data->end());
+            file.resize(file.size() + rawSize - data->size(), 0);
+            va = alignUp(va + data->size(), SECTION_ALIGNMENT);
+        }
+        put<std::uint32_t>(file, opt + 8, initializedData);
+        put<std::uint32_t>(file, opt + 56, va);
+
+        file.insert(file.end(), spec.overlay.begin(), spec.overlay.end());
+        if (!spec.certificate.empty()) {
+            file.resize(alignUp(file.size(), 8), 0);
+            put<std::uint32_t>(file, dirs + DIR_SECURITY * 8, static_cast<std::uint32_t>(file.size()));
+            put<std::uint32_t>(file, dirs + DIR_SECURITY * 8 + 4, static_cast<std::uint32_t>(spec.certificate.size()));
+            file.insert(file.end(), spec.certificate.begin(), spec.certificate.end());
+        }
+        return file;
+    }
+
+    // 独立遍历资源树，返回按类型/名称/语言排序的资源
+    std::vector<Resource> walkResources(const Bytes &file) {
+        const PeView view(file);
+        const std::uint32_t rva = view.directories[DIR_RESOURCE].first;
+        const std::uint32_t size = view.directories[DIR_RESOURCE].second;
+        const std::size_t base = view.rvaToOffset(rva);
+        const auto idAt = [&](const std::size_t entry) {
+            const auto field = get<std::uint32_t>(file, entry);
+            if (!(field & HIGH_BIT)) {
+                return Id(static_cast<std::uint16_t>(field));
+            }
+            const std::size_t at = base + (field & ~HIGH_BIT);
+            std::u16string name(get<std::uint16_t>(file, at), u'\0');
+            std::memcpy(name.data(), file.data() + at + 2, name.size() * 2);
+            return Id(std::move(name));
+        };
+        const auto entries = [&](const std::uint32_t dir) {
+            std::vector<std::pair<Id, std::uint32_t>> result;
+            const std::size_t at = base + dir;
+            const std::size_t count = get<std::uint16_t>(file, at + 12) + get<std::uint16_t>(file, at + 14);
+            for (std::size_t i = 0; i < count; ++i) {
+                result.emplace_back(idAt(at + 16 + i * 8), get<std::uint32_t>(file, at + 16 + i * 8 + 4));
+            }
+            return result;
+        };
+
+        std::vector<Resource> resources;
+        for (const auto &[type, typeTarget]: entries(0)) {
+            EXPECT_TRUE(typeTarget & HIGH_BIT);
+            for (const auto &[name, nameTarget]: entries(typeTarget & ~HIGH_BIT)) {
+                EXPECT_TRUE(nameTarget & HIGH_BIT);
+                for (const auto &[language, leaf]: entries(nameTarget & ~HIGH_BIT)) {
+                    EXPECT_FALSE(leaf & HIGH_BIT);
+                    const auto dataRva = get<std::uint32_t>(file, base + leaf);
+                    const auto dataSize = get<std::uint32_t>(file, base + leaf + 4);
+                    // 资源数据位于资源目录范围内
+                    EXPECT_GE(dataRva, rva);
+                    EXPECT_LE(dataRva + dataSize, rva + size);
+                    const auto offset = view.rvaToOffset(dataRva);
+                    resources.push_back({
+                        .type = type, .name = name, .language = language.id,
+                        .codePage = get<std::uint32_t>(file, base + leaf + 8),
+                        .data = Bytes(file.begin() + offset, file.begin() + offset + dataSize),
+                    });
+                }
+            }
+        }
+        return resources;
+    }
+
+    auto resourceKey(const Resource &resource) {
+        return std::tie(resource.type, resource.name, resource.language);
+    }
+
+    std::vector<Resource> sorted(std::vector<Resource> resources) {
+        std::ranges::sort(resources, [](const Resource &a, const Resource &b) { return resourceKey(a) < resourceKey(b); });
+        return resources;
+    }
+
+    void expectSameResources(const std::vector<Resource> &actual, const std::vector<Resource> &expected) {
+        const auto a = sorted(actual);
+        const auto e = sorted(expected);
+        ASSERT_EQ(a.size(), e.size());
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            EXPECT_TRUE(resourceKey(a[i]) == resourceKey(e[i])) << i;
+            EXPECT_EQ(a[i].codePage, e[i].codePage) << i;
+            EXPECT_EQ(a[i].data, e[i].data) << i;
+        }
+    }
+
+    // 参考实现：16 位反码累加，跳过校验和字段，最后加上文件长度
+    std::uint32_t referenceChecksum(const Bytes &file, const std::size_t checksumOffset) {
+        std::uint32_t sum = 0;
+        for (std::size_t i = 0; i < file.size(); i += 2) {
+            if (i >= checksumOffset && i < checksumOffset + 4) {
+                continue;
+            }
+            sum += file[i] | (i + 1 < file.size() ? file[i + 1] << 8 : 0);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+        }
+        return (sum & 0xFFFF) + static_cast<std::uint32_t>(file.size());
+    }
+
+    // 检查重建后的头部：节连续、按对齐排列，SizeOfImage、SizeOfInitializedData、资源目录与校验和正确
+    void expectConsistentHeaders(const Bytes &file) {
+        const PeView view(file);
+        std::uint32_t rawOffset = HEADERS_SIZE;
+        std::uint32_t va = SECTION_ALIGNMENT;
+        std::uint32_t initializedData = 0;
+        for (const auto &section: view.sections) {
+            EXPECT_EQ(section.rawOffset, rawOffset) << section.name;
+            EXPECT_EQ(section.virtualAddress, va) << section.name;
+            EXPECT_EQ(section.rawSize % FILE_ALIGNMENT, 0U) << section.name;
+            EXPECT_GE(section.rawSize, section.virtualSize) << section.name;
+            rawOffset += section.rawSize;
+            va = alignUp(va + section.virtualSize, SECTION_ALIGNMENT);
+            if (section.characteristics & 0x40) {
+                initializedData += section.rawSize;
+            }
+        }
+        EXPECT_EQ(get<std::uint32_t>(file, view.opt + 56), va);
+        EXPECT_EQ(get<std::uint32_t>(file, view.opt + 8), initializedData);
+        const auto &rsrc = view.section(".rsrc");
+        EXPECT_EQ(view.directories[DIR_RESOURCE].first, rsrc.virtualAddress);
+        EXPECT_EQ(view.directories[DIR_RESOURCE].second, rsrc.virtualSize);
+        EXPECT_EQ(get<std::uint32_t>(file, view.opt + 64), referenceChecksum(file, view.opt + 64));
+    }
+
+    Bytes bytesOf(const std::string_view text) {
+        return {text.begin(), text.end()};
+    }
+
+    const std::string_view MANIFEST = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<assembly xmlns="urn:schemas-microsoft-com:asm.v1" manifestVersion="1.0">
+  <trustInfo xmlns="urn:schemas-microsoft-com:asm.v3">
+    <security><requestedPrivileges><requestedExecutionLevel level="asInvoker" uiAccess="false"/></requestedPrivileges></security>
+  </trustInfo>
+</assembly>
+)";
+
+    // 启动器模板中常见的资源：两个尺寸的图标、命名图标组、清单、版本信息和一个命名类型
+    std::vector<Resource> launcherResources() {
+        Bytes group;
+        TestUtil::append(group, std::uint16_t{0});
+        TestUtil::append(group, std::uint16_t{1});
+        TestUtil::append(group, std::uint16_t{2});
+        for (const std::uint16_t id: {1, 2}) {
+            TestUtil::append(group, std::uint8_t{static_cast<std::uint8_t>(id * 16)});
+            TestUtil::append(group, std::uint8_t{static_cast<std::uint8_t>(id * 16)});
+            TestUtil::append(group, std::uint16_t{0});
+            TestUtil::append(group, std::uint16_t{1});
+            TestUtil::append(group, std::uint16_t{32});
+            TestUtil::append(group, std::uint32_t{id * 100U});
+            TestUtil::append(group, id);
+        }
+        return {
+            {.type = PeResource::TYPE_ICON, .name = 1, .language = LANG_EN_US, .data = TestUtil::randomBytes(100, 1)},
+            {.type = PeResource::TYPE_ICON, .name = 2, .language = LANG_EN_US, .data = TestUtil::randomBytes(200, 2)},
+            {.type = PeResource::TYPE_GROUP_ICON, .name = Id(u"MAINICON"), .language = LANG_EN_US, .data = group},
+            {.type = PeResource::TYPE_MANIFEST, .name = 1, .language = LANG_EN_US, .data = bytesOf(MANIFEST)},
+            {.type = 16, .name = 1, .language = 0, .codePage = 1200, .data = TestUtil::randomBytes(37, 3)},
+            {.type = 16, .name = 1, .language = 0x804, .codePage = 936, .data = TestUtil::randomBytes(41, 4)},
+            {.type = Id(u"JARINFO"), .name = Id(u"CONFIG"), .language = 0, .data = bytesOf("key=value")},
+        };
+    }
+
+    PeSpec launcherSpec() {
+        PeSpec spec;
+        spec.resources = launcherResources();
+        spec.overlay = TestUtil::randomBytes(5000, 9);
+        return spec;
+    }
+
+    // 由若干图像组成的 ICO 文件
+    Bytes icoFile(const std::vector<std::pair<std::uint8_t, Bytes>> &images) {
+        Bytes out;
+        TestUtil::append(out, std::uint16_t{0});
+        TestUtil::append(out, std::uint16_t{1});
+        TestUtil::append(out, static_cast<std::uint16_t>(images.size()));
+        auto offset = static_cast<std::uint32_t>(6 + images.size() * 16);
+        for (const auto &[size, data]: images) {
+            TestUtil::append(out, size);
+            TestUtil::append(out, size);
+            TestUtil::append(out, std::uint16_t{0});
+            TestUtil::append(out, std::uint16_t{1});
+            TestUtil::append(out, std::uint16_t{32});
+            TestUtil::append(out, static_cast<std::uint32_t>(data.size()));
+            TestUtil::append(out, offset);
+            offset += static_cast<std::uint32_t>(data.size());
+        }
+        for (const auto &data: images | std::views::values) {
+            out.insert(out.end(), data.begin(), data.end());
+        }
+        return out;
+    }
+
+    Image parse(const Bytes &file) {
+        auto image = Image::parse(file);
+        EXPECT_TRUE(image) << (image ? "" : std::filesystem::path(image.error()).string());
+        return std::move(image.value());
+    }
+
+    Bytes build(const Image &image) {
+        auto output = image.build();
+        EXPECT_TRUE(output) << (output ? "" : std::filesystem::path(output.error()).string());
+        return output ? std::move(output.value()) : Bytes{};
+    }
+
+    bool endsWith(const Bytes &file, const Bytes &tail) {
+        return file.size() >= tail.size() && std::equal(tail.begin(), tail.end(), file.end() - static_cast<std::ptrdiff_t>(tail.size()));
+    }
+} // namespace
+
+TEST(PeResourceTest, ParsesDepthFirstTree) {
+    for (const bool pe32Plus: {true, false}) {
+        auto spec = launcherSpec();
+        spec.pe32Plus = pe32Plus;
+        const auto file = buildPe(spec);
+        const auto image = parse(file);
+        expectSameResources(image.resources(), spec.resources);
+        EXPECT_EQ(image.subsystem(), PeResource::SUBSYSTEM_WINDOWS_GUI);
+        EXPECT_EQ(image.overlayOffset(), file.size() - spec.overlay.size());
+        EXPECT_EQ(image.manifest(), MANIFEST);
+        ASSERT_NE(image.find(16, 1, 0x804), nullptr);
+        EXPECT_EQ(image.find(16, 1, 0x804)->codePage, 936U);
+        EXPECT_EQ(image.find(16, 1, 0x407), nullptr);
+        EXPECT_NE(image.find(Id(u"JARINFO"), Id(u"CONFIG")), nullptr);
+    }
+}
+
+TEST(PeResourceTest, UnchangedRebuildKeepsResourcesAndOverlay) {
+    for (const auto after: {After::Nothing, After::Reloc}) {
+        auto spec = launcherSpec();
+        spec.after = after;
+        const auto file = buildPe(spec);
+        const auto output = build(parse(file));
+        expectConsistentHeaders(output);
+        expectSameResources(walkResources(output), spec.resources);
+        EXPECT_TRUE(endsWith(output, spec.overlay));
+        // 资源节之前的内容不变
+        EXPECT_TRUE(std::equal(file.begin() + 0x400, file.begin() + 0x600, output.begin() + 0x400));
+    }
+}
+
+TEST(PeResourceTest, GrowsLastResourceSection) {
+    auto spec = launcherSpec();
+    spec.after = After::Nothing;
+    const auto file = buildPe(spec);
+    auto image = parse(file);
+    const std::string manifest = std::string(MANIFEST) + std::string(20000, ' ');
+    image.setManifest(manifest);
+    const auto output = build(image);
+
+    expectConsistentHeaders(output);
+    const PeView view(output);
+    EXPECT_GT(view.section(".rsrc").rawSize, PeView(file).section(".rsrc").rawSize);
+    EXPECT_EQ(parse(output).manifest(), manifest);
+    EXPECT_TRUE(endsWith(output, spec.overlay));
+    EXPECT_EQ(output.size() - spec.overlay.size(), parse(output).overlayOffset());
+}
+
+TEST(PeResourceTest, MovesRelocSectionWhenManifestGrows) {
+    const auto spec = launcherSpec();
+    const auto file = buildPe(spec);
+    const PeView before(file);
+    const auto &oldReloc = before.section(".reloc");
+    const Bytes relocData(file.begin() + oldReloc.rawOffset, file.begin() + oldReloc.rawOffset + oldReloc.rawSize);
+
+    auto image = parse(file);
+    const std::string manifest = std::string(MANIFEST) + std::string(3 * SECTION_ALIGNMENT, '\n');
+    image.setManifest(manifest);
+    const auto output = build(image);
+    expectConsistentHeaders(output);
+
+    // .reloc 整体后移，内容不变，重定位目录跟随
+    const PeView after(output);
+    const auto &reloc = after.section(".reloc");
+    EXPECT_GT(reloc.virtualAddress, oldReloc.virtualAddress);
+    EXPECT_GT(reloc.rawOffset, oldReloc.rawOffset);
+    EXPECT_TRUE(std::equal(relocData.begin(), relocData.end(), output.begin() + reloc.rawOffset));
+    EXPECT_EQ(after.directories[DIR_BASERELOC].first, reloc.virtualAddress);
+    EXPECT_EQ(after.directories[DIR_BASERELOC].second, before.directories[DIR_BASERELOC].second);
+
+    auto expected = spec.resources;
+    std::ranges::find(expected, Id(PeResource::TYPE_MANIFEST), &Resource::type)->data = bytesOf(manifest);
+    expectSameResources(walkResources(output), expected);
+    EXPECT_TRUE(endsWith(output, spec.overlay));
+}
+
+TEST(PeResourceTest, ShrinksResourceSection) {
+    auto spec = launcherSpec();
+    spec.resources.push_back({.type = 10, .name = 7, .data = TestUtil::randomBytes(3 * SECTION_ALIGNMENT, 5)});
+    const auto file = buildPe(spec);
+    auto image = parse(file);
+    image.remove(10, 7);
+    const auto output = build(image);
+    expectConsistentHeaders(output);
+    EXPECT_LT(output.size(), file.size());
+    EXPECT_LT(PeView(output).section(".reloc").virtualAddress, PeView(file).section(".reloc").virtualAddress);
+    spec.resources.pop_back();
+    expectSameResources(walkResources(output), spec.resources);
+    EXPECT_TRUE(endsWith(output, spec.overlay));
+}
+
+TEST(PeResourceTest, RejectsImmovableSectionAfterResources) {
+    auto spec = launcherSpec();
+    spec.after = After::Data;
+    auto image = parse(buildPe(spec));
+    image.setManifest(MANIFEST);
+    EXPECT_FALSE(image.build());
+}
+
+TEST(PeResourceTest, SignedImageKeepsCertificateReachable) {
+    auto spec = launcherSpec();
+    spec.certificate = TestUtil::randomBytes(1234, 7);
+    const auto file = buildPe(spec);
+    auto image = parse(file);
+    // 证书在附加数据中
+    EXPECT_LE(image.overlayOffset(), file.size() - spec.certificate.size());
+    image.setManifest(std::string(MANIFEST) + std::string(5000, ' '));
+    const auto output = build(image);
+    expectConsistentHeaders(output);
+
+    // 证书目录的文件偏移随资源节增长而后移，仍指向原证书
+    const auto [offset, size] = PeView(output).directories[DIR_SECURITY];
+    ASSERT_EQ(size, spec.certificate.size());
+    EXPECT_GT(offset, PeView(file).directories[DIR_SECURITY].first);
+    EXPECT_TRUE(std::equal(spec.certificate.begin(), spec.certificate.end(), output.begin() + offset));
+    EXPECT_TRUE(endsWith(output, spec.certificate));
+}
+
+TEST(PeResourceTest, SetsMultiSizeIcon) {
+    const auto spec = launcherSpec();
+    auto image = parse(buildPe(spec));
+    const std::vector<std::pair<std::uint8_t, Bytes>> images{
+        {16, TestUtil::randomBytes(300, 11)},
+        {32, TestUtil::randomBytes(1100, 12)},
+        {48, TestUtil::randomBytes(2300, 13)},
+        {0, TestUtil::randomBytes(9000, 14)}, // 256 像素的 PNG 图像，宽高记为 0
+    };
+    const auto ico = icoFile(images);
+    ASSERT_TRUE(image.setIcon(ico));
+    const auto output = build(image);
+    expectConsistentHeaders(output);
+    const auto resources = walkResources(output);
+
+    // 原图标组的名称和语言保留，旧图标被移除
+    const auto group = std::ranges::find(resources, Id(PeResource::TYPE_GROUP_ICON), &Resource::type);
+    ASSERT_NE(group, resources.end());
+    EXPECT_EQ(group->name, Id(u"MAINICON"));
+    EXPECT_EQ(group->language, LANG_EN_US);
+    EXPECT_EQ(std::ranges::count(resources, Id(PeResource::TYPE_ICON), &Resource::type),
+              static_cast<std::ptrdiff_t>(images.size()));
+    EXPECT_EQ(std::ranges::count(resources, Id(PeResource::TYPE_GROUP_ICON), &Resource::type), 1);
+
+    // 图标组的每一项引用对应图像
+    const Bytes &groupData = group->data;
+    ASSERT_EQ(groupData.size(), 6 + images.size() * 14);
+    EXPECT_EQ(get<std::uint16_t>(groupData, 4), images.size());
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        const std::size_t entry = 6 + i * 14;
+        EXPECT_EQ(groupData[entry], images[i].first);
+        EXPECT_EQ(get<std::uint32_t>(groupData, entry + 8), images[i].second.size());
+        const auto id = get<std::uint16_t>(groupData, entry + 12);
+        const auto icon = std::ranges::find_if(resources, [&](const Resource &r) {
+            return r.type == Id(PeResource::TYPE_ICON) && r.name == Id(id);
+        });
+        ASSERT_NE(icon, resources.end()) << i;
+        EXPECT_EQ(icon->data, images[i].second) << i;
+        EXPECT_EQ(icon->language, LANG_EN_US);
+    }
+
+    // 其他资源不变
+    for (const auto &resource: spec.resources) {
+        if (resource.type != Id(PeResource::TYPE_ICON) && resource.type != Id(PeResource::TYPE_GROUP_ICON)) {
+            const auto found = std::ranges::find_if(resources, [&](const Resource &r) {
+                return resourceKey(r) == resourceKey(resource);
+            });
+            ASSERT_NE(found, resources.end());
+            EXPECT_EQ(found->data, resource.data);
+        }
+    }
+}
+
+TEST(PeResourceTest, RejectsMalformedIcon) {
+    auto image = parse(buildPe(launcherSpec()));
+    EXPECT_FALSE(image.setIcon(Bytes{0, 0, 1, 0}));
+    auto ico = icoFile({{16, TestUtil::randomBytes(300, 1)}});
+    ico.resize(ico.size() - 1); // 图像越过文件末尾
+    EXPECT_FALSE(image.setIcon(ico));
+    ico = icoFile({{16, TestUtil::randomBytes(300, 1)}});
+    put<std::uint16_t>(ico, 2, 2); // 光标文件
+    EXPECT_FALSE(image.setIcon(ico));
+    expectSameResources(image.resources(), launcherResources());
+}
+
+TEST(PeResourceTest, ChangesSubsystemInSamePass) {
+    const auto spec = launcherSpec();
+    auto image = parse(buildPe(spec));
+    image.setSubsystem(PeResource::SUBSYSTEM_WINDOWS_CUI);
+    ASSERT_TRUE(image.setIcon(icoFile({{32, TestUtil::randomBytes(500, 1)}})));
+    image.setManifest(std::string(MANIFEST) + "<!-- requireAdministrator -->");
+    const auto output = build(image);
+    expectConsistentHeaders(output);
+    const auto reparsed = parse(output);
+    EXPECT_EQ(reparsed.subsystem(), PeResource::SUBSYSTEM_WINDOWS_CUI);
+    EXPECT_TRUE(reparsed.manifest()->ends_with("<!-- requireAdministrator -->"));
+    EXPECT_EQ(get<std::uint16_t>(output, PeView(output).opt + 68), PeResource::SUBSYSTEM_WINDOWS_CUI);
+}
+
+TEST(PeResourceTest, RejectsMalformedImages) {
+    const auto file = buildPe(launcherSpec());
+    EXPECT_FALSE(Image::parse(Bytes(file.begin(), file.begin() + 0x30)));
+
+    auto bad = file;
+    put<std::uint32_t>(bad, PE_OFFSET, 0);
+    EXPECT_FALSE(Image::parse(bad));
+
+    // 节数据越过文件末尾
+    bad = Bytes(file.begin(), file.begin() + 0x700);
+    EXPECT_FALSE(Image::parse(bad));
+
+    // 资源目录项指向资源节之外
+    const auto rsrcOffset = PeView(file).section(".rsrc").rawOffset;
+    bad = file;
+    put<std::uint32_t>(bad, rsrcOffset + 16 + 4, HIGH_BIT | 0x7FFF0);
+    EXPECT_FALSE(Image::parse(bad));
+}
+
+TEST(PeResourceTest, ChecksumMatchesReference) {
+    for (const std::size_t size: {0x400, 0x401, 0x1001}) {
+        const auto data = TestUtil::randomBytes(size, static_cast<std::uint32_t>(size));
+        EXPECT_EQ(PeResource::checksum(data, 0x100), referenceChecksum(data, 0x100)) << size;
+    }
+}
+
+#ifdef _WIN32
+// 与 BeginUpdateResource/UpdateResource/EndUpdateResource 的结果比较资源树，只在 Windows 上运行
+TEST(PeResourceWindowsTest, MatchesUpdateResource) {
+    const TestUtil::TempDir dir;
+    const auto spec = launcherSpec();
+    const auto file = buildPe(spec);
+    const auto path = dir / "reference.exe";
+    TestUtil::writeFile(path, file);
+
+    const std::string manifest = std::string(MANIFEST) + std::string(4000, ' ');
+    const HANDLE update = BeginUpdateResourceW(path.c_str(), FALSE);
+    ASSERT_NE(update, nullptr);
+    ASSERT_TRUE(UpdateResourceW(update, MAKEINTRESOURCEW(PeResource::TYPE_MANIFEST), MAKEINTRESOURCEW(1), LANG_EN_US,
+                                const_cast<char *>(manifest.data()), static_cast<DWORD>(manifest.size())));
+    ASSERT_TRUE(EndUpdateResourceW(update, FALSE));
+
+    auto image = parse(file);
+    image.setManifest(manifest);
+    const auto output = build(image);
+    expectSameResources(walkResources(output), walkResources(TestUtil::readFile(path)));
+}
+#endif
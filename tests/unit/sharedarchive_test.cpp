@@ -0,0 +1,112 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: SharedArchive 启动参数、归档命名与旧归档清理范围测试
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "sharedarchive.h"
+#include "testutil.h"
+
+using SharedArchive::Path;
+using TestUtil::TempDir;
+
+namespace {
+    Path makeJdk(const Path &home, const std::string_view version) {
+        TestUtil::writeFile(home / "release", std::format("JAVA_VERSION=\"{}\"\n", version));
+        return home;
+    }
+
+    std::vector<std::wstring> listDir(const Path &dir) {
+        std::vector<std::wstring> names;
+        for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+            names.push_back(entry.path().filename().wstring());
+        }
+        std::ranges::sort(names);
+        return names;
+    }
+} // namespace
+
+TEST(SharedArchiveTest, AppStemDependsOnFullPath) {
+    const TempDir dir;
+    const auto a = dir / "a" / "app.exe";
+    const auto b = dir / "b" / "app.exe";
+    TestUtil::writeFile(a, "exe");
+    TestUtil::writeFile(b, "exe");
+
+    EXPECT_NE(SharedArchive::appStem(a), SharedArchive::appStem(b));
+    EXPECT_EQ(SharedArchive::appStem(a), SharedArchive::appStem(dir / "b" / ".." / "a" / "app.exe"));
+    EXPECT_TRUE(SharedArchive::appStem(a).starts_with(L"app-"));
+    EXPECT_EQ(SharedArchive::appStem(a).size(), 4U + 16U);
+    // 尚不存在的路径同样可以计算
+    EXPECT_NE(SharedArchive::appStem(dir / "c" / "app.exe"), SharedArchive::appStem(a));
+}
+
+TEST(SharedArchiveTest, OptionsByFeatureVersion) {
+    const TempDir dir;
+    const auto archives = dir / "archives";
+
+    EXPECT_TRUE(SharedArchive::options(makeJdk(dir / "jdk11", "11.0.21"), archives, L"app", 1, {}, false).empty());
+
+    const auto jdk17 = SharedArchive::options(makeJdk(dir / "jdk17", "17.0.9"), archives, L"app", 1, {}, false);
+    ASSERT_EQ(jdk17.size(), 1U);
+    EXPECT_TRUE(jdk17[0].starts_with(L"-XX:ArchiveClassesAtExit=")) << std::string(jdk17[0].begin(), jdk17[0].end());
+    EXPECT_TRUE(jdk17[0].ends_with(L".jsa"));
+
+    const auto jdk21 = SharedArchive::options(makeJdk(dir / "jdk21", "21.0.1"), archives, L"app", 1, {}, true);
+    ASSERT_EQ(jdk21.size(), 2U);
+    EXPECT_EQ(jdk21[0], L"-XX:+AutoCreateSharedArchive");
+    EXPECT_TRUE(jdk21[1].starts_with(L"-XX:SharedArchiveFile=\""));
+    EXPECT_TRUE(jdk21[1].ends_with(L".jsa\""));
+
+    // 归档已存在时改为使用
+    const auto jdk25 = makeJdk(dir / "jdk25", "25");
+    const auto output = SharedArchive::options(jdk25, archives, L"app", 1, {}, false);
+    ASSERT_EQ(output.size(), 1U);
+    const std::wstring prefix = L"-XX:AOTCacheOutput=";
+    ASSERT_TRUE(output[0].starts_with(prefix));
+    TestUtil::writeFile(Path(output[0].substr(prefix.size())), "aot");
+    const auto use = SharedArchive::options(jdk25, archives, L"app", 1, {}, false);
+    ASSERT_EQ(use.size(), 1U);
+    EXPECT_EQ(use[0], L"-XX:AOTCache=" + output[0].substr(prefix.size()));
+
+    // 用户自行配置时不添加
+    EXPECT_TRUE(SharedArchive::options(jdk25, archives, L"app", 1, {L"-Xshare:off"}, false).empty());
+}
+
+TEST(SharedArchiveTest, StaleRemovalStaysWithinStem) {
+    const TempDir dir;
+    const auto archives = dir / "archives";
+    const auto jdk = makeJdk(dir / "jdk17", "17.0.9");
+    const auto first = dir / "one" / "app.exe";
+    const auto second = dir / "two" / "app.exe";
+    const auto stemA = SharedArchive::appStem(first);
+    const auto stemB = SharedArchive::appStem(second);
+
+    const auto archiveOf = [&](const std::wstring &stem, const std::uint64_t jarKey) {
+        const auto args = SharedArchive::options(jdk, archives, stem, jarKey, {}, false);
+        const auto path = Path(args.at(0).substr(args.at(0).find(L'=') + 1));
+        TestUtil::writeFile(path, "jsa");
+        return path.filename().wstring();
+    };
+    // 两个同名的程序各自生成归档
+    const auto oldA = archiveOf(stemA, 1);
+    const auto oldB = archiveOf(stemB, 1);
+    TestUtil::writeFile(archives / (stemA + L"x.jsa"), "other");
+    TestUtil::writeFile(archives / "notes.jsa", "user");
+
+    // A 的 jar 更新后只删除 A 的旧归档
+    const auto newA = archiveOf(stemA, 2);
+    const auto names = listDir(archives);
+    EXPECT_EQ(std::ranges::count(names, oldA), 0);
+    EXPECT_EQ(std::ranges::count(names, newA), 1);
+    EXPECT_EQ(std::ranges::count(names, oldB), 1);
+    EXPECT_EQ(std::ranges::count(names, stemA + L"x.jsa"), 1);
+    EXPECT_EQ(std::ranges::count(names, std::wstring(L"notes.jsa")), 1);
+}
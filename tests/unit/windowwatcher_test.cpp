@@ -0,0 +1,147 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: WindowWatcher 等待逻辑测试，使用按脚本推进虚拟时钟的假 Provider
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "windowwatcher.h"
+
+using WindowWatcher::Result;
+
+namespace {
+    constexpr std::uint64_t NEVER = ~0ULL;
+
+    // 虚拟时钟上的子进程：在指定时刻进入输入空闲、显示窗口或退出，等待调用直接推进时钟
+    class FakeProvider final : public WindowWatcher::Provider {
+    public:
+        std::uint64_t idleAt = 0;
+        std::uint64_t windowAt = NEVER;
+        std::uint64_t exitAt = NEVER;
+        // 第 stopAfter 次 waitForChange 返回时请求取消
+        std::size_t stopAfter = 0;
+        std::stop_source stop;
+
+        std::uint64_t clock = 1000; // 起点不为 0，检查按相对时间计算
+        std::vector<std::uint32_t> idleWaits;
+        std::vector<std::uint32_t> changeWaits;
+
+        std::uint64_t elapsed() const { return clock - 1000; }
+
+        std::uint64_t now() override { return clock; }
+
+        void waitForInputIdle(const std::uint32_t timeoutMs) override {
+            idleWaits.push_back(timeoutMs);
+            clock = std::min(clock + timeoutMs, std::max(clock, at(idleAt)));
+        }
+
+        bool hasVisibleWindow() override { return clock >= at(windowAt); }
+
+        bool exited() override { return clock >= at(exitAt); }
+
+        void waitForChange(const std::uint32_t timeoutMs) override {
+            changeWaits.push_back(timeoutMs);
+            // 窗口显示或进程退出时提前唤醒
+            const auto wake = std::min(at(windowAt), at(exitAt));
+            clock = wake > clock ? std::min(clock + timeoutMs, wake) : clock + timeoutMs;
+            if (stopAfter != 0 && changeWaits.size() == stopAfter) {
+                stop.request_stop();
+            }
+        }
+
+    private:
+        static std::uint64_t at(const std::uint64_t offset) {
+            return offset == NEVER ? NEVER : 1000 + offset;
+        }
+    };
+} // namespace
+
+TEST(WindowWatcherTest, WindowAlreadyShown) {
+    FakeProvider provider;
+    provider.windowAt = 0;
+    EXPECT_EQ(WindowWatcher::wait(provider, 5000), Result::WindowShown);
+    EXPECT_TRUE(provider.changeWaits.empty());
+    EXPECT_EQ(provider.idleWaits, (std::vector<std::uint32_t>{WindowWatcher::POLL_INTERVAL_MS * 10}));
+}
+
+TEST(WindowWatcherTest, WindowShownAfterInputIdle) {
+    FakeProvider provider;
+    provider.idleAt = 400;
+    provider.windowAt = 650;
+    EXPECT_EQ(WindowWatcher::wait(provider, 5000), Result::WindowShown);
+    // 输入空闲后轮询，窗口出现时立即唤醒，不必等满轮询间隔
+    EXPECT_EQ(provider.elapsed(), 650U);
+    EXPECT_EQ(provider.changeWaits.size(), 3U);
+    for (const auto wait: provider.changeWaits) {
+        EXPECT_LE(wait, WindowWatcher::POLL_INTERVAL_MS);
+    }
+}
+
+TEST(WindowWatcherTest, WindowBeatsExitAtSameCheck) {
+    FakeProvider provider;
+    provider.windowAt = 200;
+    provider.exitAt = 200;
+    EXPECT_EQ(WindowWatcher::wait(provider, 5000), Result::WindowShown);
+}
+
+TEST(WindowWatcherTest, ProcessExited) {
+    FakeProvider provider;
+    provider.exitAt = 250;
+    EXPECT_EQ(WindowWatcher::wait(provider, 5000), Result::ProcessExited);
+    EXPECT_EQ(provider.elapsed(), 250U);
+
+    // 进程在输入空闲之前就退出（例如 java.exe 参数错误）
+    FakeProvider early;
+    early.idleAt = NEVER;
+    early.exitAt = 0;
+    EXPECT_EQ(WindowWatcher::wait(early, 5000), Result::ProcessExited);
+}
+
+TEST(WindowWatcherTest, TimedOut) {
+    FakeProvider provider;
+    provider.idleAt = NEVER; // 控制台程序没有输入空闲状态，等满上限
+    EXPECT_EQ(WindowWatcher::wait(provider, 1550), Result::TimedOut);
+    EXPECT_EQ(provider.elapsed(), 1550U);
+    EXPECT_EQ(provider.idleWaits, (std::vector<std::uint32_t>{WindowWatcher::POLL_INTERVAL_MS * 10}));
+    // 最后一次等待截断到剩余时间，不超出总时限
+    ASSERT_FALSE(provider.changeWaits.empty());
+    EXPECT_EQ(provider.changeWaits.back(), 50U);
+    for (const auto wait: provider.changeWaits) {
+        EXPECT_LE(wait, WindowWatcher::POLL_INTERVAL_MS);
+    }
+
+    // 总时限小于输入空闲等待上限
+    FakeProvider shortWait;
+    shortWait.idleAt = NEVER;
+    EXPECT_EQ(WindowWatcher::wait(shortWait, 30), Result::TimedOut);
+    EXPECT_EQ(shortWait.idleWaits, (std::vector<std::uint32_t>{30}));
+    EXPECT_EQ(shortWait.elapsed(), 30U);
+
+    // 时限为 0 时只检查一次
+    FakeProvider zero;
+    EXPECT_EQ(WindowWatcher::wait(zero, 0), Result::TimedOut);
+    EXPECT_TRUE(zero.changeWaits.empty());
+    zero.windowAt = 0;
+    EXPECT_EQ(WindowWatcher::wait(zero, 0), Result::WindowShown);
+}
+
+TEST(WindowWatcherTest, Stopped) {
+    FakeProvider provider;
+    provider.stopAfter = 3;
+    EXPECT_EQ(WindowWatcher::wait(provider, 5000, provider.stop.get_token()), Result::Stopped);
+    EXPECT_EQ(provider.changeWaits.size(), 3U);
+
+    // 调用前已取消：仍先检查一次窗口与进程状态
+    FakeProvider cancelled;
+    cancelled.stop.request_stop();
+    EXPECT_EQ(WindowWatcher::wait(cancelled, 5000, cancelled.stop.get_token()), Result::Stopped);
+    EXPECT_TRUE(cancelled.changeWaits.empty());
+    cancelled.exitAt = 0;
+    EXPECT_EQ(WindowWatcher::wait(cancelled, 5000, cancelled.stop.get_token()), Result::ProcessExited);
+}
@@ -0,0 +1,203 @@
+﻿/**************************************************************************
+
+Author:肖嘉威
+
+Version:1.0.0
+
+Date:2026/10/16
+
+Description: ZipTail 测试，同一份用例分别链接标量、SSE2、AVX2 实现运行
+
+**************************************************************************/
+#include <gtest/gtest.h>
+
+#include "testutil.h"
+#include "ziptail.h"
+
+using TestUtil::Bytes;
+
+namespace {
+    constexpr auto npos = static_cast<std::size_t>(-1);
+
+    // 逐字节比较的参照实现
+    std::size_t referenceFindLast(const std::span<const std::uint8_t> data, const std::uint32_t signature,
+                                  const std::size_t end) {
+        if (data.size() < 4) {
+            return npos;
+        }
+        std::size_t i = std::min(end, data.size() - 3);
+        while (i > 0) {
+            --i;
+            if (TestUtil::read<std::uint32_t>(data, i) == signature) {
+                return i;
+            }
+        }
+        return npos;
+    }
+
+    void plant(Bytes &data, const std::size_t pos, const std::uint32_t signature) {
+        std::memcpy(data.data() + pos, &signature, sizeof(signature));
+    }
+
+    class ZipTailTest : public testing::Test {
+    protected:
+        void SetUp() override {
+#if defined(ZIPTAIL_EXPECT_AVX2) && (defined(__GNUC__) || defined(__clang__))
+            if (!__builtin_cpu_supports("avx2")) {
+                GTEST_SKIP() << "CPU 不支持 AVX2";
+            }
+#endif
+        }
+    };
+} // namespace
+
+TEST_F(ZipTailTest, FindLastMatchesReferenceOnRandomData) {
+    std::mt19937 rng(12345);
+    for (std::size_t size = 0; size < 300; ++size) {
+        auto data = TestUtil::randomBytes(size, static_cast<std::uint32_t>(size));
+        // 随机埋入若干个完整签名和只差最后一个字节的近似签名
+        for (int k = 0; k < 3 && size >= 4; ++k) {
+            plant(data, rng() % (size - 3), ZipTail::EOCD_SIGNATURE);
+            plant(data, rng() % (size - 3), ZipTail::EOCD_SIGNATURE ^ 0x01000000U);
+        }
+        for (std::size_t end = 0; end <= size + 1; ++end) {
+            ASSERT_EQ(ZipTail::findLastSignature(data, ZipTail::EOCD_SIGNATURE, end),
+                      referenceFindLast(data, ZipTail::EOCD_SIGNATURE, end))
+                    << "size=" << size << " end=" << end;
+        }
+    }
+}
+
+TEST_F(ZipTailTest, FindLastSignatureSplitAcrossVectorBoundaries) {
+    // 签名逐个位置移动，覆盖跨越 16/32 字节分块边界的所有情况
+    constexpr std::size_t size = 130;
+    for (std::size_t pos = 0; pos + 4 <= size; ++pos) {
+        Bytes data(size, 0);
+        plant(data, pos, ZipTail::EOCD_SIGNATURE);
+        for (std::size_t end = 0; end <= size; ++end) {
+            const auto expected = end > pos ? pos : npos;
+            ASSERT_EQ(ZipTail::findLastSignature(data, ZipTail::EOCD_SIGNATURE, end), expected)
+                    << "pos=" << pos << " end=" << end;
+        }
+    }
+}
+
+TEST_F(ZipTailTest, FindLastIgnoresNearMisses) {
+    // 全部由 "PK\5" 与各种第四字节组成，不含完整签名
+    Bytes data;
+    for (int i = 0; i < 4096; ++i) {
+        TestUtil::append(data, std::string_view("PK\x05"));
+        data.push_back(static_cast<std::uint8_t>(i % 5 == 0 ? 0x05 : 0x07));
+    }
+    EXPECT_EQ(ZipTail::findLastSignature(data, ZipTail::EOCD_SIGNATURE), npos);
+    plant(data, 17, ZipTail::EOCD_SIGNATURE);
+    EXPECT_EQ(ZipTail::findLastSignature(data, ZipTail::EOCD_SIGNATURE), 17U);
+}
+
+TEST_F(ZipTailTest, LocatePlainZip) {
+    const auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").add("b/c.txt", "world").build();
+    const auto record = ZipTail::locate(zip);
+    ASSERT_TRUE(record) << std::string(record.error().begin(), record.error().end());
+    EXPECT_EQ(record->eocdOffset, zip.size() - ZipTail::EOCD_SIZE);
+    EXPECT_EQ(record->totalRecords, 2U);
+    EXPECT_FALSE(record->zip64);
+    EXPECT_EQ(record->commentLength, 0);
+    EXPECT_EQ(record->centralDirOffset + record->centralDirSize, record->eocdOffset);
+}
+
+TEST_F(ZipTailTest, LocateWithCommentNearMaximum) {
+    for (const std::size_t length: {ZipTail::MAX_COMMENT_SIZE - 1, ZipTail::MAX_COMMENT_SIZE}) {
+        // 注释里塞满注释长度对不上的假 EOCD，定位必须继续向前找到真正的记录
+        Bytes comment(length, 'x');
+        for (std::size_t pos = 0; pos + ZipTail::EOCD_SIZE <= length; pos += 1000) {
+            plant(comment, pos, ZipTail::EOCD_SIGNATURE);
+        }
+        const auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").build(comment);
+        const auto eocdOffset = zip.size() - length - ZipTail::EOCD_SIZE;
+
+        const auto whole = ZipTail::locate(zip);
+        ASSERT_TRUE(whole);
+        EXPECT_EQ(whole->eocdOffset, eocdOffset);
+        EXPECT_EQ(whole->commentLength, length);
+        EXPECT_EQ(whole->comment.size(), length);
+
+        // 只传入最后 MAX_SEARCH_SIZE 字节，EOCD 正好位于窗口起点附近
+        const std::size_t tailOffset = zip.size() - ZipTail::MAX_SEARCH_SIZE;
+        const auto tail = ZipTail::locate(std::span(zip).subspan(tailOffset), tailOffset);
+        ASSERT_TRUE(tail);
+        EXPECT_EQ(tail->eocdOffset, eocdOffset);
+        EXPECT_EQ(tail->totalRecords, 1U);
+    }
+}
+
+TEST_F(ZipTailTest, LocateRejectsCommentLengthMismatch) {
+    auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").build(Bytes(10, 'c'));
+    zip.pop_back();
+    EXPECT_FALSE(ZipTail::locate(zip));
+    EXPECT_FALSE(ZipTail::locate(Bytes(ZipTail::EOCD_SIZE - 1, 0)));
+}
+
+TEST_F(ZipTailTest, LocateZip64) {
+    const auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").add("b.txt", "x").build({}, true);
+    const auto record = ZipTail::locate(zip);
+    ASSERT_TRUE(record);
+    EXPECT_TRUE(record->zip64);
+    EXPECT_EQ(record->totalRecords, 2U);
+    EXPECT_EQ(record->eocd.centralDirOffset, 0xFFFFFFFFU);
+    EXPECT_EQ(record->centralDirOffset + record->centralDirSize, record->zip64EocdOffset);
+
+    // 只给出定位器之后的数据时，Zip64 结束记录不在范围内
+    const std::size_t tailOffset = record->zip64EocdOffset + 1;
+    EXPECT_FALSE(ZipTail::locate(std::span(zip).subspan(tailOffset), tailOffset));
+
+    auto broken = zip;
+    broken[record->zip64EocdOffset] ^= 0xFF;
+    EXPECT_FALSE(ZipTail::locate(broken));
+}
+
+TEST_F(ZipTailTest, RebaseShiftsAllOffsets) {
+    constexpr std::size_t prefixSize = 4096 + 7;
+    auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").add("dir/b.txt", "world").add("c", "").build();
+    ASSERT_TRUE(ZipTail::rebase(zip, prefixSize));
+
+    Bytes combined(prefixSize, 0xCC);
+    combined.insert(combined.end(), zip.begin(), zip.end());
+    const auto record = ZipTail::locate(combined);
+    ASSERT_TRUE(record);
+    EXPECT_EQ(record->centralDirOffset + record->centralDirSize, record->eocdOffset);
+
+    std::size_t pos = static_cast<std::size_t>(record->centralDirOffset);
+    for (std::uint64_t i = 0; i < record->totalRecords; ++i) {
+        const auto header = TestUtil::read<ZipTail::CentralDirHeader>(combined, pos);
+        ASSERT_EQ(header.signature, ZipTail::CENTRAL_DIR_SIGNATURE);
+        EXPECT_EQ(TestUtil::read<std::uint32_t>(combined, header.localHeaderOffset), 0x04034b50U);
+        pos += sizeof(header) + header.fileNameLength + header.extraFieldLength + header.fileCommentLength;
+    }
+}
+
+TEST_F(ZipTailTest, RebaseRejectsZip64AndOverflow) {
+    auto zip64 = TestUtil::ZipBuilder().add("a.txt", "hello").build({}, true);
+    EXPECT_FALSE(ZipTail::rebase(zip64, 16));
+
+    auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").build();
+    const auto original = zip;
+    EXPECT_FALSE(ZipTail::rebase(zip, 0xFFFFFFFFULL));
+    EXPECT_EQ(ZipTail::locate(zip)->centralDirOffset, ZipTail::locate(original)->centralDirOffset);
+}
+
+TEST_F(ZipTailTest, SetCommentLength) {
+    auto zip = TestUtil::ZipBuilder().add("a.txt", "hello").build();
+    const auto eocdOffset = ZipTail::locate(zip)->eocdOffset;
+
+    ASSERT_TRUE(ZipTail::setCommentLength(zip, eocdOffset, ZipTail::MAX_COMMENT_SIZE));
+    zip.resize(zip.size() + ZipTail::MAX_COMMENT_SIZE, 'c');
+    const auto record = ZipTail::locate(zip);
+    ASSERT_TRUE(record);
+    EXPECT_EQ(record->commentLength, ZipTail::MAX_COMMENT_SIZE);
+
+    const auto original = zip;
+    EXPECT_FALSE(ZipTail::setCommentLength(zip, eocdOffset, ZipTail::MAX_COMMENT_SIZE + 1));
+    EXPECT_FALSE(ZipTail::setCommentLength(zip, eocdOffset + 1, 0));
+    EXPECT_FALSE(ZipTail::setCommentLength(zip, zip.size() - ZipTail::EOCD_SIZE + 1, 0));
+    EXPECT_EQ(zip, original);
+}